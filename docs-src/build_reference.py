@@ -76,6 +76,9 @@ SIDEBAR = """<aside class="ref-nav">
   <a href="connecting.html#on">on()</a>
   <a href="connecting.html#disconnect">disconnect()</a>
   <a href="connecting.html#getstatus">getStatus()</a>
+  <a href="connecting.html#clock">clock</a>
+  <a href="connecting.html#at">at()</a>
+  <a href="connecting.html#stats">stats()</a>
   <a href="pins.html#pinmode">pinMode()</a>
   <a href="pins.html#digitalwrite">digitalWrite()</a>
   <a href="pins.html#analogwrite">analogWrite()</a>
@@ -83,11 +86,14 @@ SIDEBAR = """<aside class="ref-nav">
   <a href="pins.html#analogread">analogRead()</a>
   <a href="pins.html#digitalread">digitalRead()</a>
   <a href="pins.html#setreadinterval--setreadthreshold">setReadInterval() / setReadThreshold()</a>
+  <a href="pins.html#setreadedges">setReadEdges()</a>
+  <a href="pins.html#analogstream">analogStream()</a>
   <a href="pins.html#pin--the-listening-handle">pin() — the listening handle</a>
   <a href="pins.html#end--endall">end() / endAll()</a>
   <a href="pins.html#pin-aliases">Pin aliases</a>
   <h4><a href="arduino.html">Core — Arduino</a></h4>
   <a href="arduino.html#pardalotebegin">Pardalote.begin()</a>
+  <a href="arduino.html#pardalotesplitcores">Pardalote.splitCores()</a>
   <a href="arduino.html#pardaloterun">Pardalote.run()</a>
   <a href="arduino.html#pardaloteshare">Pardalote.share()</a>
   <a href="arduino.html#pardalotesend">Pardalote.send()</a>
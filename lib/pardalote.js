@@ -50,6 +50,36 @@ const CMD_SERIAL_BUSY   = 0x0D;  // Arduino → JS (serial): a WiFi-active board
 const CMD_REBOOT        = 0x0E;  // Arduino → JS (serial): sent at boot. A browser still holding the
                                  // port resumes takeover-probing so the board switches straight back
                                  // to serial — fast recovery from a reset while USB-connected.
+const CMD_FEATURES      = 0x0F;  // JS → Arduino (protocol 1.1): [mask] — optional encodings this
+                                 // page understands, from the HELLO's advertised set. No reply.
+
+// Second core block (0x00–0x0F is full) — see defs.h.
+const CMD_ANALOG_STREAM = 0x70;  // JS → Arduino: [rateHz, blockFrames, pin0, pin1?…] — rate 0 stops.
+                                 // Arduino → JS: [status, rateHz, blockFrames, bits] (see STREAM_*)
+const CMD_ANALOG_BLOCK  = 0x71;  // Arduino → JS: [seq, pinCount, dropped] + payload: u16 BE samples,
+                                 // interleaved per frame (pin0, pin1, … pin0, pin1, …)
+const CMD_CLOCK         = 0x72;  // Arduino → JS (FEATURE_CLOCK): [micros] — board time of the frames
+                                 // after it in the same message
+const CMD_AT            = 0x73;  // JS → Arduino: [atMicros] + payload: frames to run at that board
+                                 // time (see arduino.at). Arduino → JS, on refusal: [AT_ERR_*]
+const CMD_STATS         = 0x74;  // JS → Arduino: [flags] (STATS_RESET). Arduino → JS: a run of
+                                 // [kind, …] + record frames ending in STATS_KIND_END (see stats())
+const CMD_ACK           = 0x75;  // JS → Arduino (FEATURE_ACK): [bytes] — message bytes received
+                                 // since our previous ACK; the board pauses periodic reads to a
+                                 // page that falls behind
+const CMD_BAUD          = 0x76;  // JS → Arduino (USB serial): [baud] — switch the line rate.
+                                 // Arduino → JS: [baud], or [0] if refused — its last message
+                                 // at the old rate
+
+// Feature bits (HELLO param 4 / CMD_FEATURES) — must match defs.h FEATURE_*.
+const FEATURE_COMPACT   = 0x01;  // compact frame layout (see compactFrame)
+const FEATURE_CLOCK     = 0x02;  // CMD_CLOCK stamps — events carry the board's `time`
+const FEATURE_ACK       = 0x04;  // we acknowledge received bytes with CMD_ACK
+const FEATURE_RELIABLE  = 0x08;  // USB serial: sequenced, acknowledged envelopes (see _SerialLink)
+
+// Bytes received between two CMD_ACKs — well under the board's
+// PARDALOTE_TX_BACKLOG (4096), so an up-to-date page never looks behind.
+const ACK_STEP          = 1024;
 
 // Device-scoped share command — the VALUE is reserved across all extension
 // device IDs. Ar→JS: [logicalId] + payload: name. The core intercepts it
@@ -71,6 +101,29 @@ const HIGH = 1;
 // Pass as interval to stop a periodic read
 const END = -1;
 
+// Read flags (CMD_DIGITAL_READ param 2) — see setReadEdges()
+const READ_EDGES = 0x01;
+
+// CMD_AT refusals — must match defs.h AT_ERR_*.
+const AT_ERR_FULL  = -1;
+const AT_ERR_RANGE = -2;
+const AT_MAX_BYTES = 244;   // payload room in one CMD_AT frame
+
+// CMD_STATS — must match defs.h STATS_*.
+const STATS_RESET = 0x01;
+const STATS_KIND_LOOP = 0, STATS_KIND_SECTION = 1, STATS_KIND_EXT_LOOP = 2,
+      STATS_KIND_COMMAND = 3, STATS_KIND_CLIENT = 4, STATS_KIND_END = 5;
+const _STATS_SECTIONS = ['transport', 'atQueue', 'extLoops', 'yield',
+                         'clients', 'pins', 'stream', 'flush', 'inbound'];
+
+// Analog stream status (CMD_ANALOG_STREAM reply param 0) — must match defs.h STREAM_*.
+const STREAM_STOPPED         =  0;
+const STREAM_RUNNING         =  1;
+const STREAM_ERR_UNSUPPORTED = -1;
+const STREAM_ERR_PIN         = -2;
+const STREAM_ERR_BUSY        = -3;
+const STREAM_ERR_DRIVER      = -4;
+
 // Pass to connectSerial() to always show the port picker (vs silently reusing a
 // previously-granted port): arduino.connectSerial(PROMPT). Just { prompt: true }.
 const PROMPT = Object.freeze({ prompt: true });
@@ -228,7 +281,11 @@ const _FRAME_NAMES = {
     'core:3':  'DIGITAL_WRITE', 'core:4': 'DIGITAL_READ', 'core:5': 'ANALOG_WRITE',
     'core:6':  'ANALOG_READ', 'core:7': 'END',           'core:8': 'PING',
     'core:9':  'PONG',       'core:10': 'SYNC_COMPLETE',  'core:11': 'MESSAGE',
-    'core:12': 'AUTH',
+    'core:12': 'AUTH',       'core:13': 'SERIAL_BUSY',    'core:14': 'REBOOT',
+    'core:15': 'FEATURES',
+    'core:112': 'ANALOG_STREAM', 'core:113': 'ANALOG_BLOCK', 'core:114': 'CLOCK',
+    'core:115': 'AT',          'core:116': 'STATS',       'core:117': 'ACK',
+    'core:118': 'BAUD',        'core:119': 'DATAGRAM',
     '200:92': 'NEO_INIT', '200:93': 'NEO_SET_PIXEL', '200:94': 'NEO_FILL',
     '200:95': 'NEO_CLEAR', '200:96': 'NEO_BRIGHTNESS', '200:97': 'NEO_SHOW',
     '201:20': 'SERVO_ATTACH', '201:21': 'SERVO_DETACH', '201:22': 'SERVO_WRITE',
@@ -317,11 +374,115 @@ function encodeFrame(cmd, target, params = [], payload = null) {
 }
 
 // -------------------------------------------------------------------
-// Frame decoding — returns null if the buffer is too short.
+// Compact frame layout (protocol 1.1, FEATURE_COMPACT) — see the
+// layout table in the firmware's internal/protocol.h:
+//
+//   [0x80 | ext<<6 | nparams] [cmd] varint(target)
+//   (ext: varint(typeMask) varint(payloadLen)) params… payload
+//
+// Int params are zigzag varints, float params 4 bytes big-endian.
+// compactFrame() re-encodes one standard frame and returns it unchanged
+// when compact would not be shorter, or when the standard frame is
+// larger than the board's frame buffer (the board may have to expand
+// it again to relay a broadcast message).
+// -------------------------------------------------------------------
+const FRAME_COMPACT       = 0x80;
+const FRAME_COMPACT_EXT   = 0x40;
+const COMPACT_MAX_FRAME   = 256;    // FRAME_MAX_SIZE in protocol.h
+
+function _pushVarint(out, v) {
+    v >>>= 0;
+    while (v >= 0x80) { out.push((v & 0x7F) | 0x80); v >>>= 7; }
+    out.push(v);
+}
+
+function compactFrame(buf) {
+    if (buf.byteLength < 8 || buf.byteLength > COMPACT_MAX_FRAME) return buf;
+    const v = new DataView(buf);
+    const cmd = v.getUint8(0);
+    if (cmd & FRAME_COMPACT) return buf;
+    const nparams    = v.getUint8(3);
+    const typeMask   = v.getUint16(4, false);
+    const payloadLen = v.getUint16(6, false);
+    const stdHead    = 8 + nparams * 4;
+
+    const ext = typeMask !== 0 || payloadLen !== 0;
+    const out = [FRAME_COMPACT | (ext ? FRAME_COMPACT_EXT : 0) | nparams, cmd];
+    _pushVarint(out, v.getUint16(1, false));
+    if (ext) { _pushVarint(out, typeMask); _pushVarint(out, payloadLen); }
+    for (let i = 0; i < nparams; i++) {
+        const off = 8 + i * 4;
+        if ((typeMask >> i) & 1) {
+            for (let k = 0; k < 4; k++) out.push(v.getUint8(off + k));
+        } else {
+            const n = v.getInt32(off, false);
+            _pushVarint(out, (n << 1) ^ (n >> 31));   // zigzag
+        }
+    }
+    if (out.length >= stdHead) return buf;
+
+    const res = new Uint8Array(out.length + payloadLen);
+    res.set(out);
+    if (payloadLen) res.set(new Uint8Array(buf, stdHead, payloadLen), out.length);
+    return res.buffer;
+}
+
+// Returns { value, pos } or null when the varint runs off the buffer.
+function _readVarint(v, pos, end, maxBytes) {
+    let value = 0;
+    for (let i = 0; i < maxBytes; i++) {
+        if (pos >= end) return null;
+        const b = v.getUint8(pos++);
+        value += (b & 0x7F) * 2 ** (7 * i);
+        if (!(b & 0x80)) return { value, pos };
+    }
+    return null;
+}
+
+function _decodeCompactFrame(buf, v, pos) {
+    const end  = buf.byteLength;
+    if (pos + 2 > end) return null;
+    const lead = v.getUint8(pos);
+    const cmd  = v.getUint8(pos + 1);
+    const nparams = lead & 0x1F;
+    let r = _readVarint(v, pos + 2, end, 3);
+    if (!r) return null;
+    const target = r.value;
+    let typeMask = 0, payloadLen = 0, p = r.pos;
+    if (lead & FRAME_COMPACT_EXT) {
+        if (!(r = _readVarint(v, p, end, 3))) return null;
+        typeMask = r.value;
+        if (!(r = _readVarint(v, r.pos, end, 3))) return null;
+        payloadLen = r.value;
+        p = r.pos;
+    }
+    const params = [];
+    for (let i = 0; i < nparams; i++) {
+        if ((typeMask >> i) & 1) {
+            if (p + 4 > end) return null;
+            params.push(v.getFloat32(p, false));
+            p += 4;
+        } else {
+            if (!(r = _readVarint(v, p, end, 5))) return null;
+            const z = r.value >>> 0;
+            params.push((z >>> 1) ^ -(z & 1));   // un-zigzag
+            p = r.pos;
+        }
+    }
+    if (p + payloadLen > end) return null;
+    const payload = payloadLen > 0 ? buf.slice(p, p + payloadLen) : null;
+    return { cmd, target, params, payload, totalLen: p + payloadLen - pos };
+}
+
+// -------------------------------------------------------------------
+// Frame decoding — either layout; returns null if the buffer is too
+// short.
 // -------------------------------------------------------------------
 function decodeFrame(buf, pos) {
-    if (pos + 8 > buf.byteLength) return null;
+    if (pos >= buf.byteLength) return null;
     const v = new DataView(buf);
+    if (v.getUint8(pos) & FRAME_COMPACT) return _decodeCompactFrame(buf, v, pos);
+    if (pos + 8 > buf.byteLength) return null;
 
     const cmd        = v.getUint8(pos);
     const target     = v.getUint16(pos + 1, false);
@@ -460,8 +621,69 @@ function decodeMessage(frame) {
 // Serial.print output: collected line by line and surfaced as the
 // 'log' event, so students see their debug prints in the browser
 // without opening the IDE.
+//
+// With FEATURE_RELIABLE both directions switch to a sequenced envelope
+// that gets each message there, in order:
+//
+//   0x00  0xA6  COBS( seq, ack, flags, message bytes + CRC8 )  0x00
+//
+// seq numbers the messages (mod 256); ack is cumulative — the next seq
+// we expect — and rides on every 0xA6 envelope we send, or on a bare
+// one (header only) when we have nothing to send. Up to REL_WINDOW
+// messages are in flight; a repeated bare ACK or REL_RTO_MS without
+// progress sends everything unacknowledged again.
+//
+// The port opens at SERIAL_BAUD. A board whose HELLO offers a higher
+// ceiling (param 5) is asked for min(ceiling, what the USB bridge
+// manages) with CMD_BAUD; once it agrees both ends reopen at the new
+// rate and sync again. A board silent at the new rate (the reopen
+// reset it, say) sends us back to SERIAL_BAUD for good on that port.
 // ===================================================================
 
+const SERIAL_MAGIC     = 0xA5;
+const SERIAL_REL_MAGIC = 0xA6;
+const REL_SYN          = 0x01;   // the session's first message — start counting here
+const REL_ACK          = 0x02;   // the ack byte is valid
+const REL_WINDOW       = 16;     // messages in flight (as the firmware's PARDALOTE_SERIAL_WINDOW)
+const REL_RTO_MS       = 50;
+const REL_RTO_MAX_MS   = 1000;
+const REL_ACK_DELAY_MS = 2;      // wait this long for a message to carry an ACK
+
+const SERIAL_BAUD          = 115200;   // every board starts here (PARDALOTE_SERIAL_BAUD)
+const SERIAL_BAUD_REPLY_MS = 1000;     // CMD_BAUD unanswered — carry on at the old rate
+const SERIAL_BAUD_TRIAL_MS = 2500;     // silent at the new rate — fall back (the board
+                                       // gives up after its own 2 s)
+
+// Fastest rate worth asking for, by the USB bridge's vendor id. Native
+// USB boards report -1 in HELLO and never switch, so this only matters
+// for UART bridges.
+const SERIAL_BRIDGE_BAUD = {
+    0x1A86: 2000000,   // WCH CH340 / CH343
+    0x0403: 2000000,   // FTDI
+    0x10C4:  921600,   // Silicon Labs CP210x
+};
+const SERIAL_BRIDGE_BAUD_DEFAULT = 921600;
+
+// Ceiling for CMD_BAUD: connectSerial({ baud }) if given (false or 0
+// keeps SERIAL_BAUD), else the bridge's entry above.
+function _serialBaudCap(port, baud) {
+    if (baud === false || baud === 0) return SERIAL_BAUD;
+    if (typeof baud === 'number') return baud;
+    let vid = 0;
+    try { vid = port.getInfo().usbVendorId || 0; } catch (_) {}
+    return SERIAL_BRIDGE_BAUD[vid] || SERIAL_BRIDGE_BAUD_DEFAULT;
+}
+
+// The first frame with `cmd` in a message, or null.
+function _findFrame(bytes, cmd) {
+    const buf = bytes.slice().buffer;
+    try {
+        for (let pos = 0, f; (f = decodeFrame(buf, pos)); pos += f.totalLen)
+            if (f.cmd === cmd) return f;
+    } catch (_) {}
+    return null;
+}
+
 // CRC8, poly 0x07, init 0x00 — must match the firmware.
 function _crc8(bytes) {
     let crc = 0;
@@ -508,15 +730,18 @@ function _cobsDecode(src) {
     return Uint8Array.from(out);
 }
 
-// Wrap one outbound message (ArrayBuffer or Uint8Array) in the envelope.
-function _serialEnvelope(msg) {
+// Wrap one outbound message (ArrayBuffer or Uint8Array) in the envelope;
+// `head` is the 0xA6 envelope's [seq, ack, flags].
+function _serialEnvelope(msg, head = null) {
     const bytes = msg instanceof Uint8Array ? msg : new Uint8Array(msg);
-    const withCrc = new Uint8Array(bytes.length + 1);
-    withCrc.set(bytes);
-    withCrc[bytes.length] = _crc8(bytes);
+    const hl = head ? head.length : 0;
+    const withCrc = new Uint8Array(hl + bytes.length + 1);
+    if (head) withCrc.set(head);
+    withCrc.set(bytes, hl);
+    withCrc[withCrc.length - 1] = _crc8(withCrc.subarray(0, withCrc.length - 1));
     const body = _cobsEncode(withCrc);
     const out  = new Uint8Array(body.length + 3);
-    out[0] = 0x00; out[1] = 0xA5;
+    out[0] = 0x00; out[1] = head ? SERIAL_REL_MAGIC : SERIAL_MAGIC;
     out.set(body, 2);
     out[out.length - 1] = 0x00;
     return out;
@@ -556,8 +781,26 @@ class _SerialLink {
 
         // Envelope decoder state: 0 = text, 1 = just saw 0x00, 2 = in frame.
         this._state = 0;
+        this._magic = 0;
         this._frame = [];
         this._text  = [];
+
+        // FEATURE_RELIABLE: our sending side (null = plain envelopes), and
+        // the receiving side, which answers sequenced envelopes whenever
+        // the board sends them.
+        this._rel = null;
+        this._rx  = { synced: false, next: 0, due: false };
+        this._relTimer = null;
+        this._ackTimer = null;
+
+        // Line rate (see CMD_BAUD above). baud: the rate we're open at.
+        this.baud        = SERIAL_BAUD;
+        this._baudCap    = _serialBaudCap(port, opts.baud);
+        this._baudTried  = false;   // asked (or had no reason to) — once per link
+        this._baudTimer  = null;    // CMD_BAUD reply, or the first HELLO at a new rate
+        this._awaitHello = false;   // reopened: drop everything until a HELLO
+        this._reopening  = null;    // promise while the port is being reopened
+        this._lastWrite  = Promise.resolve();
     }
 
     async open() {
@@ -566,7 +809,7 @@ class _SerialLink {
             await this.port._pardaloteClosing.catch(() => {});
             this.port._pardaloteClosing = null;
         }
-        await this.port.open({ baudRate: 115200 });
+        await this.port.open({ baudRate: SERIAL_BAUD });
         this._writer = this.port.writable.getWriter();
         this._readPromise = this._readLoop();   // deliberately not awaited here
         if (this.onopen) this.onopen();
@@ -588,10 +831,12 @@ class _SerialLink {
         }, 4500);
     }
 
+    // Probes are always plain envelopes — the board that answers may be
+    // a fresh one, outside any session.
     _probe() {
         try {
-            if (this._key) this.send(encodeFrame(CMD_AUTH, 0, [], this._key));
-            this.send(encodeFrame(CMD_HELLO, 0, this._takeover ? [1] : []));
+            if (this._key) this._write(_serialEnvelope(encodeFrame(CMD_AUTH, 0, [], this._key)));
+            this._write(_serialEnvelope(encodeFrame(CMD_HELLO, 0, this._takeover ? [1] : [])));
         } catch (_) {}
     }
 
@@ -608,7 +853,7 @@ class _SerialLink {
         } finally {
             try { if (this._reader) this._reader.releaseLock(); } catch (_) {}
             this._reader = null;
-            if (!this._closed) {
+            if (!this._closed && !this._reopening) {
                 this._teardown();
                 if (this.onclose) this.onclose({ code: 0 });
             }
@@ -625,7 +870,9 @@ class _SerialLink {
                     else if (b !== 0x0D) { this._text.push(b); }
                     break;
                 case 1:   // just consumed a delimiter
-                    if (b === 0xA5)      { this._state = 2; this._frame.length = 0; }
+                    if (b === SERIAL_MAGIC || b === SERIAL_REL_MAGIC) {
+                        this._state = 2; this._magic = b; this._frame.length = 0;
+                    }
                     else if (b !== 0x00) {
                         this._state = 0;
                         if (b === 0x0A)      { this._flushText(); }
@@ -651,14 +898,205 @@ class _SerialLink {
         const decoded = _cobsDecode(Uint8Array.from(this._frame));
         this._frame.length = 0;
         if (!decoded || decoded.length < 1) return;
-        const msg = decoded.subarray(0, decoded.length - 1);
+        let msg = decoded.subarray(0, decoded.length - 1);
         if (_crc8(msg) !== decoded[decoded.length - 1]) return;   // corrupted — drop, stay synced
+        if (this._magic === SERIAL_REL_MAGIC) {
+            if (msg.length < 3) return;
+            if (!this._relAccept(msg[0], msg[1], msg[2], msg.length - 3)) return;
+            msg = msg.subarray(3);
+        }
+        if (this._baudFilter(msg)) return;
         this._sawReply = true;
         this._stopProbe();   // the board is talking — stop knocking
         if (this.onmessage && msg.length)
             this.onmessage({ data: msg.slice().buffer });
     }
 
+    // -------------------------------------------------------------------
+    // Line rate negotiation. Returns true to swallow `msg`: the board's
+    // first HELLO (we answer it with CMD_BAUD instead), everything up to
+    // the reply, and after a reopen everything up to the next HELLO —
+    // leftovers from the old rate.
+    // -------------------------------------------------------------------
+    _baudFilter(msg) {
+        if (this._awaitHello) {
+            if (!_findFrame(msg, CMD_HELLO)) return true;
+            this._awaitHello = false;
+            this._stopBaudTimer();
+            if (this.onlog) this.onlog(`Serial link at ${this.baud} baud`);
+            return false;
+        }
+        if (this._baudTimer) {
+            const f = _findFrame(msg, CMD_BAUD);
+            if (!f) return true;
+            this._stopBaudTimer();
+            const rate = f.params[0] || 0;
+            if (rate > this.baud) this._reopen(rate);
+            else this.resumeProbe();   // refused — sync again at this rate
+            return true;
+        }
+        if (this._baudTried) return false;
+        const hello = _findFrame(msg, CMD_HELLO);
+        if (!hello) return false;
+        this._baudTried = true;
+        const max  = hello.params.length > 5 ? hello.params[5] : 0;   // -1: native USB
+        const rate = Math.min(max, this._baudCap);
+        if (rate <= this.baud || this.port._pardaloteBaudFailed) return false;
+        this._stopProbe();
+        this._write(_serialEnvelope(encodeFrame(CMD_BAUD, 0, [rate])));
+        this._baudTimer = setTimeout(() => { this._baudTimer = null; this.resumeProbe(); },
+                                     SERIAL_BAUD_REPLY_MS);
+        return true;
+    }
+
+    // Close and reopen the port at `rate` (Web Serial can't change the
+    // rate of an open port), then probe again.
+    _reopen(rate) {
+        this._reopening = (async () => {
+            const reader = this._reader, writer = this._writer;
+            this._writer = null;
+            try {
+                await this._lastWrite;
+                if (reader) await reader.cancel().catch(() => {});
+                await this._readPromise;
+                if (writer) writer.releaseLock();
+                await this.port.close();
+                if (this._closed) return;
+                await this.port.open({ baudRate: rate });
+                if (this._closed) { await this.port.close(); return; }
+            } catch (_) {
+                this._reopening = null;
+                if (!this._closed) {
+                    this._teardown();
+                    if (this.onclose) this.onclose({ code: 0 });
+                }
+                return;
+            }
+            this.baud = rate;
+            this._state = 0;
+            this._frame.length = 0;
+            this._writer = this.port.writable.getWriter();
+            this._reopening = null;
+            this._readPromise = this._readLoop();
+            if (rate !== SERIAL_BAUD) {
+                this._awaitHello = true;
+                this._baudTimer = setTimeout(() => this._baudFallback(), SERIAL_BAUD_TRIAL_MS);
+            }
+            this.resumeProbe();
+        })();
+    }
+
+    _baudFallback() {
+        this._baudTimer  = null;
+        this._awaitHello = false;
+        this.port._pardaloteBaudFailed = true;   // don't ask again on this port
+        if (this.onlog) this.onlog(`No reply at ${this.baud} baud — staying at ${SERIAL_BAUD}`);
+        this._stopProbe();
+        this._reopen(SERIAL_BAUD);
+    }
+
+    _stopBaudTimer() {
+        if (this._baudTimer) { clearTimeout(this._baudTimer); this._baudTimer = null; }
+    }
+
+    // -------------------------------------------------------------------
+    // FEATURE_RELIABLE (mirrors internal/serial_transport.cpp).
+    // -------------------------------------------------------------------
+
+    // Switch our sending side on (a fresh session from seq 0, and a fresh
+    // receive side — a HELLO starts one on the board too) or off.
+    setReliable(on) {
+        this._rel = on ? { base: 0, sent: 0, high: 0, store: [], syn: true,
+                           dup: 0, fast: false, rto: REL_RTO_MS, at: 0 } : null;
+        this._rx = { synced: false, next: 0, due: false };
+        if (on && !this._relTimer)
+            this._relTimer = setInterval(() => this._relTick(), REL_RTO_MS / 2);
+        if (!on) this._stopRel();
+    }
+
+    // An inbound 0xA6 envelope: take its ack, then say whether its
+    // message is the next one in order (and so to be delivered).
+    _relAccept(seq, ack, flags, len) {
+        if (flags & REL_ACK) this._relAck(ack, len === 0);
+        if (len === 0) return false;                     // a bare ACK
+        const rx = this._rx;
+        if ((flags & REL_SYN) && !rx.synced) { rx.synced = true; rx.next = seq; }
+        if (!rx.synced || seq !== rx.next) {             // gap or duplicate — ACK at once
+            if (rx.synced) this._sendAck();
+            return false;
+        }
+        rx.next = (rx.next + 1) & 0xFF;
+        rx.due = true;
+        if (!this._ackTimer)
+            this._ackTimer = setTimeout(() => { this._ackTimer = null; if (this._rx.due) this._sendAck(); },
+                                        REL_ACK_DELAY_MS);
+        return true;
+    }
+
+    // Cumulative ACK. Only bare ACKs count as duplicates — a piggybacked
+    // one repeats on every message.
+    _relAck(ack, bare) {
+        const r = this._rel;
+        if (!r) return;
+        const n = (ack - r.base) & 0xFF;
+        if (n > ((r.high - r.base) & 0xFF)) return;     // not for anything we sent
+        if (n === 0) {
+            if (bare && r.sent !== r.base && !r.fast && ++r.dup >= 2) {
+                r.fast = true;
+                this._relResend();
+            }
+            return;
+        }
+        if (((r.sent - r.base) & 0xFF) < n) r.sent = ack;   // acked past what we're resending
+        r.store.splice(0, n);
+        r.base = ack;
+        r.syn = false; r.fast = false; r.dup = 0;
+        r.rto = REL_RTO_MS;
+        r.at  = performance.now();
+        this._relPump();
+    }
+
+    // Go-back-N: the next message out is the oldest unacknowledged one.
+    _relResend() {
+        const r = this._rel;
+        r.sent = r.base;
+        r.at = performance.now();
+        this._relPump();
+    }
+
+    _relTick() {
+        const r = this._rel;
+        if (!r || r.sent === r.base || performance.now() - r.at < r.rto) return;
+        r.rto = Math.min(r.rto * 2, REL_RTO_MAX_MS);
+        this._relResend();
+    }
+
+    // Sends stored messages while the window has room; each carries our ack.
+    _relPump() {
+        const r = this._rel;
+        for (let i; (i = (r.sent - r.base) & 0xFF) < REL_WINDOW && i < r.store.length; ) {
+            if (r.sent === r.base) r.at = performance.now();
+            const flags = (this._rx.synced ? REL_ACK : 0) | (r.syn && r.sent === 0 ? REL_SYN : 0);
+            this._write(_serialEnvelope(r.store[i], [r.sent, this._rx.next, flags]));
+            this._rx.due = false;
+            r.sent = (r.sent + 1) & 0xFF;
+            if (((r.sent - r.base) & 0xFF) > ((r.high - r.base) & 0xFF)) r.high = r.sent;
+        }
+    }
+
+    // A bare ACK — header only, no seq used.
+    _sendAck() {
+        const rx = this._rx;
+        rx.due = false;
+        if (!rx.synced) return;
+        this._write(_serialEnvelope(new Uint8Array(0), [this._rel ? this._rel.sent : 0, rx.next, REL_ACK]));
+    }
+
+    _stopRel() {
+        if (this._relTimer) { clearInterval(this._relTimer); this._relTimer = null; }
+        if (this._ackTimer) { clearTimeout(this._ackTimer); this._ackTimer = null; }
+    }
+
     _stopProbe() {
         if (this._probeTimer)   { clearInterval(this._probeTimer); this._probeTimer = null; }
         if (this._noReplyTimer) { clearTimeout(this._noReplyTimer); this._noReplyTimer = null; }
@@ -671,24 +1109,39 @@ class _SerialLink {
     resumeProbe() {
         if (this._closed || this._probeTimer) return;   // gone, or already probing
         this._sawReply = false;
+        this.setReliable(false);   // the rebooted board's session is gone
         this._probeTimer = setInterval(() => this._probe(), 500);
         this._probe();
     }
 
     send(buf) {
         if (!this._writer || this._closed) return;
-        this._writer.write(_serialEnvelope(buf)).catch(() => {});
+        if (this._rel) {
+            this._rel.store.push(buf instanceof Uint8Array ? buf : new Uint8Array(buf));
+            this._relPump();
+            return;
+        }
+        this._write(_serialEnvelope(buf));
+    }
+
+    _write(bytes) {
+        if (!this._writer || this._closed) return;
+        this._lastWrite = this._writer.write(bytes).catch(() => {});
     }
 
     close() {
         if (this._closed) return;
         this._closed = true;
         this._stopProbe();
+        this._stopRel();
+        this._stopBaudTimer();
+        const reopening = this._reopening;
         const reader = this._reader, writer = this._writer, port = this.port;
         this._writer = null;
         // Release both locks, then close the port. Stored on the port so
         // the NEXT link (auto-reconnect) can await it before reopening.
         port._pardaloteClosing = (async () => {
+            if (reopening) { await reopening; return; }   // it sees _closed and closes the port
             try { if (reader) await reader.cancel().catch(() => {}); } catch (_) {}
             try { if (this._readPromise) await this._readPromise; } catch (_) {}   // read lock released
             try { if (writer) { writer.releaseLock(); } } catch (_) {}
@@ -698,6 +1151,8 @@ class _SerialLink {
 
     _teardown() {
         this._stopProbe();
+        this._stopRel();
+        this._stopBaudTimer();
         try { if (this._writer) this._writer.releaseLock(); } catch (_) {}
         this._writer = null;
         // Best-effort close so a later auto-reconnect can reopen the port.
@@ -749,7 +1204,17 @@ class Extension {
         return this.on(event, wrap);
     }
 
-    _emit(event, data) { (this._cbs[event] || []).forEach(fn => fn(data)); }
+    // An event raised while a clock-stamped board frame dispatches (DONE,
+    // LIMIT, read replies…) carries `time`: the board's micros() — see
+    // arduino.clock.
+    _emit(event, data) {
+        const list = this._cbs[event];
+        if (!list) return;
+        const t = this.arduino?._frameTime;
+        if (t != null && data && typeof data === 'object' && data.time === undefined)
+            data = { ...data, time: t };
+        list.forEach(fn => fn(data));
+    }
 
     // "Servo 'pan'" / "Ultrasonic 2" — who is speaking, for warn/error events.
     _label() {
@@ -794,6 +1259,8 @@ class Extension {
 //                                             from any client or the sketch
 //   pin.off('change', fn)                     unsubscribe (fn omitted: all)
 //   pin.setReadInterval(ms) / setReadThreshold(t)
+//   pin.setReadEdges()                        interrupt-timed edges: 'change'
+//                                             payloads gain `time` (board µs)
 //   pin.value                                 the mirrored value
 //   pin.read()/.write()/.mode()               conveniences over the verbs
 //
@@ -881,6 +1348,13 @@ class Pin {
         return this;
     }
 
+    setReadEdges(on = true) {
+        const n = this.number;
+        if (n === null) (this._pending ||= {}).edges = on;
+        else this.arduino.setReadEdges(n, on);
+        return this;
+    }
+
     // Conveniences over the Arduino-mirroring verbs (which remain the
     // documented way to DO things — see pinMode/digitalWrite/…Read).
     mode(m, interval, threshold) { this.arduino.pinMode(this._ref, m, interval, threshold); return this; }
@@ -908,6 +1382,211 @@ class Pin {
         this._pending = null;
         if (p.interval  !== undefined) this.setReadInterval(p.interval);
         if (p.threshold !== undefined) this.setReadThreshold(p.threshold);
+        if (p.edges     !== undefined) this.setReadEdges(p.edges);
+    }
+}
+
+// -------------------------------------------------------------------
+// AnalogStream — continuous ADC sampling, via arduino.analogStream().
+// The board samples at a fixed rate (ESP32 on Arduino core 3.x; other
+// boards answer STREAM_ERR_UNSUPPORTED) and ships blocks of samples;
+// each 'block' carries one Uint16Array per pin.
+//
+//   const mic = arduino.analogStream(['A0'], { rate: 8000, block: 64 });
+//   mic.on('block', ({ samples, index, dropped }) => scope(samples[0]));
+//   mic.on('error', ({ message }) => console.warn(message));
+//   mic.stop();
+//
+// One stream per board, owned by the page that started it. The handle
+// is permanent: a running stream is re-requested after a reconnect
+// (the board stops it when its client goes away).
+// -------------------------------------------------------------------
+class AnalogStream {
+    constructor(arduino) {
+        this.arduino = arduino;
+        this._cbs    = {};
+        this._want   = null;    // { refs, rate, block } while a stream is wanted
+        this.pins    = [];      // resolved pin numbers, in sample order
+        this.rate    = 0;       // board's actual settings (from the status reply)
+        this.block   = 0;
+        this.bits    = 0;
+        this.running = false;
+    }
+
+    on(event, fn) { (this._cbs[event] ||= []).push(fn); return this; }
+
+    off(event, fn) {
+        const list = this._cbs[event];
+        if (!list) return this;
+        if (fn) { const i = list.indexOf(fn); if (i >= 0) list.splice(i, 1); }
+        else    delete this._cbs[event];
+        return this;
+    }
+
+    once(event, fn) {
+        const wrap = (data) => { this.off(event, wrap); fn(data); };
+        return this.on(event, wrap);
+    }
+
+    _emit(event, data) { (this._cbs[event] || []).forEach(fn => fn(data)); }
+
+    // Start — or reconfigure — the stream. `block` 0 lets the board pick
+    // the largest block that fits one frame.
+    start(pins, { rate = 1000, block = 0 } = {}) {
+        const refs = Array.isArray(pins) ? pins : [pins];
+        this._want = { refs, rate, block };
+        if (this.arduino.connected) this._request();
+        return this;
+    }
+
+    stop() {
+        this._want = null;
+        if (this.arduino.connected)
+            this.arduino.send(encodeFrame(CMD_ANALOG_STREAM, 0, [0]));
+        return this;
+    }
+
+    _request() {
+        const { refs, rate, block } = this._want;
+        this.pins = refs.map(r => this.arduino._resolvePin(r));
+        this.arduino.send(encodeFrame(CMD_ANALOG_STREAM, 0, [rate, block, ...this.pins]));
+    }
+
+    _onStatus(frame) {
+        const [status, rate, block, bits] = frame.params;
+        if (status === STREAM_RUNNING) {
+            Object.assign(this, { rate, block, bits, running: true });
+            this._emit('start', { rate, block, bits, pins: this.pins });
+            return;
+        }
+        this.running = false;
+        if (status === STREAM_STOPPED) { this._emit('stop', {}); return; }
+
+        // Refused — don't retry it on the next reconnect either.
+        this._want = null;
+        const message = AnalogStream._errors[status] || `analog stream refused (${status})`;
+        this.arduino._warn(message);
+        this._emit('error', { code: status, message });
+    }
+
+    _onBlock(frame) {
+        const [seq, n, dropped] = frame.params;
+        const bytes = frame.payload;
+        if (!bytes || n < 1) return;
+        const frames  = Math.floor(bytes.length / (2 * n));
+        const samples = Array.from({ length: n }, () => new Uint16Array(frames));
+        const v = new DataView(bytes.buffer, bytes.byteOffset, bytes.byteLength);
+        for (let f = 0, off = 0; f < frames; f++)
+            for (let k = 0; k < n; k++, off += 2) samples[k][f] = v.getUint16(off, false);
+        this._emit('block', {
+            samples, pins: this.pins, seq,
+            index: seq * this.block,     // first sample's position in the stream
+            dropped, rate: this.rate,
+        });
+    }
+}
+
+AnalogStream._errors = {
+    [STREAM_ERR_UNSUPPORTED]: 'analog streaming is not supported on this board',
+    [STREAM_ERR_PIN]:         'analog stream: a pin is not on a streamable ADC (ESP32: ADC1 pins only)',
+    [STREAM_ERR_BUSY]:        'analog stream: another client is already streaming',
+    [STREAM_ERR_DRIVER]:      'analog stream: the ADC driver rejected the configuration',
+};
+
+// -------------------------------------------------------------------
+// BoardClock — maps board micros() onto this page's performance.now(),
+// as arduino.clock. Every heartbeat PING is a sample: the PONG carries
+// the board's micros() when it handled the ping, assumed to sit halfway
+// through the round trip. The map is a line fitted to the samples with
+// the shortest round trips (the least network queueing), so both the
+// offset and the crystal drift are tracked.
+//
+//   arduino.pin(2).on('change', ({ time }) => {
+//       const age = performance.now() - arduino.clock.toLocal(time);
+//   });
+//
+// Board times are uint32 micros (they wrap every ~71 min); the clock
+// unwraps them against the most recent sample. Reset when the board
+// reboots or a different board connects.
+// -------------------------------------------------------------------
+class BoardClock {
+    constructor() {
+        this._max     = 32;     // samples kept (~100 s of heartbeats)
+        this._minSpan = 20000;  // ms of board time before drift is fitted
+        this.reset();
+    }
+
+    reset() {
+        this._samples = [];     // { board: unwrapped ms, local: ms, rtt: ms }
+        this._raw     = null;   // latest raw micros seen, and its unwrapped value
+        this._ext     = 0;
+        this._ref     = 0;      // fit: local = _local + _slope * (board - _ref)
+        this._local   = 0;
+        this._slope   = 1;
+        this.rtt      = null;   // shortest round trip in the window, ms
+    }
+
+    get ready()  { return this._samples.length > 0; }
+
+    // Page time minus board time, in ms, at the latest sample.
+    get offset() {
+        if (!this.ready) return null;
+        const b = this._samples[this._samples.length - 1].board;
+        return this._local + this._slope * (b - this._ref) - b;
+    }
+
+    // How fast the board's clock runs against ours, parts per million
+    // (positive: the board is slow).
+    get drift() { return (this._slope - 1) * 1e6; }
+
+    // Board micros → performance.now() ms. NaN until the first sample.
+    toLocal(boardUs) {
+        if (!this.ready) return NaN;
+        return this._local + this._slope * (this._unwrap(boardUs) / 1000 - this._ref);
+    }
+
+    // performance.now() ms → board micros (uint32).
+    toBoard(localMs) {
+        if (!this.ready) return NaN;
+        return Math.round(((localMs - this._local) / this._slope + this._ref) * 1000) >>> 0;
+    }
+
+    // Nearest-in-time unwrap of a uint32 micros value. Only moves the
+    // reference forward, so an edge stamped before the latest sample
+    // still maps correctly.
+    _unwrap(us) {
+        us >>>= 0;
+        if (this._raw === null) { this._raw = us; this._ext = us; return us; }
+        const d = (us - this._raw) | 0;
+        const v = this._ext + d;
+        if (d > 0) { this._raw = us; this._ext = v; }
+        return v;
+    }
+
+    _sample(sentMs, recvMs, boardUs) {
+        const rtt = recvMs - sentMs;
+        this._samples.push({ board: this._unwrap(boardUs) / 1000, local: (sentMs + recvMs) / 2, rtt });
+        if (this._samples.length > this._max) this._samples.shift();
+
+        // Fit over the better half by round trip.
+        const best = [...this._samples].sort((a, b) => a.rtt - b.rtt)
+                                       .slice(0, Math.ceil(this._samples.length / 2));
+        this.rtt = best[0].rtt;
+        const n = best.length;
+        const mb = best.reduce((t, p) => t + p.board, 0) / n;
+        const ml = best.reduce((t, p) => t + p.local, 0) / n;
+        let sbb = 0, sbl = 0, lo = Infinity, hi = -Infinity;
+        for (const p of best) {
+            sbb += (p.board - mb) ** 2;
+            sbl += (p.board - mb) * (p.local - ml);
+            lo = Math.min(lo, p.board); hi = Math.max(hi, p.board);
+        }
+        let slope = 1;
+        if (n >= 3 && hi - lo >= this._minSpan) {
+            slope = sbl / sbb;
+            if (Math.abs(slope - 1) > 0.02) slope = 1;   // implausible (>2%) — a bad sample set
+        }
+        this._ref = mb; this._local = ml; this._slope = slope;
     }
 }
 
@@ -927,6 +1606,7 @@ class Arduino {
         // _SerialLink; both expose the same handler surface.
         this._transportKind = 'ws';
         this._serialPort    = null;   // granted Web Serial port, kept for reconnects
+        this._serialBaud    = undefined; // connectSerial({ baud }): CMD_BAUD ceiling
         this._serialTakeover = false; // gesture authorised a WiFi→USB switch (one-shot)
 
         // Connection key — sent as the first frame after a WS socket opens, or
@@ -984,6 +1664,9 @@ class Arduino {
         // extensions, retained messages) is dropped before the announce
         // repopulates whatever actually exists now.
         this._bootId = 0;
+        this._compact = false;   // compact frame layout negotiated (HELLO features)
+        this._acking  = false;   // FEATURE_ACK negotiated — see _receive
+        this._unacked = 0;       // bytes received since our last CMD_ACK
 
         // Board identity, alias table, and ADC range — populated from the HELLO handshake
         this.board    = 'unknown';
@@ -1000,10 +1683,25 @@ class Arduino {
         this._pingMs        = 3000;   // send a ping every 3 s
         this._pongTimeoutMs = 5000;   // declare the link dead if no pong for 5 s
 
+        // Board clock (see BoardClock) — every PING carries a seq; the
+        // matching PONG's board time becomes a sample. _frameTime is the
+        // CMD_CLOCK stamp in force while a message's frames dispatch.
+        this.clock       = new BoardClock();
+        this._pingSeq    = 0;
+        this._pingsOut   = new Map();   // seq → performance.now() at send
+        this._clockBurst = [];          // timers for the quick samples after HELLO
+        this._frameTime  = null;
+        this._atCapture  = null;        // frames collected inside an at() callback
+        this._statsReply = null;        // { report, resolve, reject, timer } while stats() waits
+
         // Pin handles (see arduino.pin()): Map<number|aliasString, Pin>.
         // Permanent, like extension instances — listeners survive connect().
         this._pinHandles = new Map();
 
+        // Analog stream handle (see arduino.analogStream()) — created on
+        // first use, permanent like pin handles.
+        this._stream = null;
+
         // True after CMD_SYNC_COMPLETE; false during the announce phase.
         // Guards against write callbacks firing on announce state-sync frames.
         this._synced   = false;
@@ -1073,6 +1771,10 @@ class Arduino {
     //                                    opts.key sets a board-identity key
     //                                    (see requireKey() on the board): a
     //                                    wrong key is refused with 'authFail'.
+    //                                    opts.baud caps the line rate asked
+    //                                    for after HELLO (default: what the
+    //                                    USB bridge manages); false stays at
+    //                                    115200.
     // -------------------------------------------------------------------
     connect(ip, portOrOpts = 81) {
         const opts = (typeof portOrOpts === 'object' && portOrOpts !== null)
@@ -1134,6 +1836,7 @@ class Arduino {
         // check above. Either way, a deliberate connect authorises the switch.
         this._serialTakeover = usedPicker || gesture;
         this._key      = opts.key || null;   // board-identity key (optional, both transports)
+        this._serialBaud = opts.baud;
         this.deviceIP  = 'serial';
         this._reconnectAttempts = 0;
         this._reconnectDisabled = false;
@@ -1154,6 +1857,7 @@ class Arduino {
         this._pinOrigins.clear();
         this._staleBoardPins = null;
         this._bootId = 0;
+        this.clock.reset();
         this._reads.clear();
         this._available.clear();
         this.messages = {};                                     // cached message values are board state
@@ -1297,7 +2001,7 @@ class Arduino {
         // page load or a background tab still starts with no authority — a
         // silent auto-connect can't recapture a WiFi board.
         const takeover = this._serialTakeover;
-        const link = new _SerialLink(this._serialPort, { takeover, key: this._key });
+        const link = new _SerialLink(this._serialPort, { takeover, key: this._key, baud: this._serialBaud });
         this.socket = link;
 
         link.onopen = () => {
@@ -1450,11 +2154,13 @@ class Arduino {
             return this;
         }
         const frames = Array.isArray(frameOrArray) ? frameOrArray : [frameOrArray];
+        if (this._atCapture) { this._atCapture.push(...frames); return this; }
         this._queue.push(...frames);
         if (this.connected && !this._flushing) this._flush();
     }
 
     _queueFrame(buf) {
+        if (this._atCapture) { this._atCapture.push(buf); return; }
         this._queue.push(buf);
         if (this.connected && !this._flushing) this._flush();
     }
@@ -1470,7 +2176,7 @@ class Arduino {
                     if (decoded) this._emitFrame('out', decoded);
                 }
             }
-            this.socket.send(encodeBatch(frames));
+            this.socket.send(encodeBatch(this._compact ? frames.map(compactFrame) : frames));
         } catch (e) {
             this._error(`send failed: ${e.message || e}`);
         } finally {
@@ -1478,6 +2184,146 @@ class Arduino {
         }
     }
 
+    // -------------------------------------------------------------------
+    // at(time, fn) — run fn's commands at a board time instead of on
+    // arrival. Every frame fn sends (synchronously) is wrapped in CMD_AT
+    // frames; the board parks them and dispatches them when its clock
+    // reaches `time` (performance.now() ms, mapped with arduino.clock).
+    // One page can start several boards together:
+    //
+    //   const t = performance.now() + 250;
+    //   left.at(t,  () => left.servo.writeTimed(90, 1000));
+    //   right.at(t, () => right.arm.write({ shoulder: 10, elbow: 80 }));
+    //
+    // Without a clock sample yet (or older firmware) the frames are sent
+    // at once, with a warning.
+    // -------------------------------------------------------------------
+    at(time, fn) {
+        const outer = this._atCapture;
+        const frames = this._atCapture = [];
+        try { fn(); } finally { this._atCapture = outer; }
+        if (!frames.length) return this;
+
+        if (!this.clock.ready) {
+            this._warn('at(): no board clock yet — sending now');
+            return this.send(frames);
+        }
+        const due = this.clock.toBoard(time);
+        const wrapped = [];
+        let chunk = [], size = 0;
+        const close = () => {
+            if (chunk.length) wrapped.push(encodeFrame(CMD_AT, 0, [due | 0], encodeBatch(chunk)));
+            chunk = []; size = 0;
+        };
+        for (const f of frames) {
+            const inner = this._compact ? compactFrame(f) : f;
+            if (inner.byteLength > AT_MAX_BYTES) {
+                this._warn(`at(): a ${inner.byteLength}-byte frame is too big to schedule — sending now`);
+                wrapped.push(f);
+                continue;
+            }
+            if (size + inner.byteLength > AT_MAX_BYTES) close();
+            chunk.push(inner);
+            size += inner.byteLength;
+        }
+        close();
+        return this.send(wrapped);
+    }
+
+    _onAtRefused(frame) {
+        const code = frame.params[0];
+        this._warn(code === AT_ERR_RANGE ? 'at(): time is too far ahead — the board refused it'
+                 : code === AT_ERR_FULL  ? 'at(): the board\'s schedule is full — command dropped'
+                 : `at(): refused (${code})`);
+    }
+
+    // -------------------------------------------------------------------
+    // stats({ reset }) — the board's loop and command timing (CMD_STATS).
+    // Resolves with:
+    //
+    //   { windowMs, passes,
+    //     period:   { maxUs, bins },         // run() period; bins[0] is 0 µs,
+    //                                        // bins[k] [2^(k-1), 2^k) µs
+    //     sections: { transport, atQueue, extLoops, yield, clients, pins,
+    //                 stream, flush, inbound }, // each { calls, totalUs, maxUs, avgUs }
+    //     extLoops: [{ deviceId, calls, totalUs, maxUs, avgUs }],
+    //     commands: [{ deviceId, cmd, name, calls, totalUs, maxUs, avgUs }],
+    //     commandOverflow,                   // handlers past the board's table
+    //     coalesced,                         // inbound frames a newer one replaced
+    //     clients:  [{ client, framesIn, bytesIn, framesOut, bytesOut }] }
+    //
+    // { reset: true } zeroes the board's counters after reading, so the
+    // next report covers just the time between the two.
+    // -------------------------------------------------------------------
+    stats({ reset = false } = {}) {
+        if (this._statsReply) return this._statsReply.promise;
+        let resolve, reject;
+        const promise = new Promise((res, rej) => { resolve = res; reject = rej; });
+        const timer = setTimeout(() => {
+            this._statsReply = null;
+            reject(new Error('no stats reply — the board firmware may predate CMD_STATS'));
+        }, 3000);
+        this._statsReply = {
+            promise, resolve, reject, timer,
+            report: { sections: {}, extLoops: [], commands: [], clients: [] },
+        };
+        this.send(encodeFrame(CMD_STATS, 0, [reset ? STATS_RESET : 0]));
+        return promise;
+    }
+
+    _onStats(frame) {
+        const pending = this._statsReply;
+        if (!pending) return;
+        const r = pending.report;
+        const kind = frame.params[0];
+        const v = frame.payload ? new DataView(frame.payload) : null;
+        const u32 = (off) => v.getUint32(off, false);
+        const cost = (off) => {
+            const calls = u32(off), totalUs = u32(off + 4), maxUs = u32(off + 8);
+            return { calls, totalUs, maxUs, avgUs: calls ? totalUs / calls : 0 };
+        };
+        const records = (size, fn) => {
+            for (let off = 0; v && off + size <= v.byteLength; off += size) fn(off);
+        };
+
+        switch (kind) {
+            case STATS_KIND_LOOP:
+                r.passes   = frame.params[1] >>> 0;
+                r.period   = { maxUs: frame.params[2] >>> 0, bins: [] };
+                r.windowMs = frame.params[3] >>> 0;
+                r.coalesced = (frame.params[4] ?? 0) >>> 0;
+                records(4, off => r.period.bins.push(u32(off)));
+                break;
+            case STATS_KIND_SECTION:
+                records(13, off => {
+                    r.sections[_STATS_SECTIONS[v.getUint8(off)] ?? v.getUint8(off)] = cost(off + 1);
+                });
+                break;
+            case STATS_KIND_EXT_LOOP:
+                records(14, off => r.extLoops.push({ deviceId: v.getUint16(off, false), ...cost(off + 2) }));
+                break;
+            case STATS_KIND_COMMAND:
+                r.commandOverflow = frame.params[1] >>> 0;
+                records(15, off => {
+                    const deviceId = v.getUint16(off, false), cmd = v.getUint8(off + 2);
+                    r.commands.push({ deviceId, cmd, name: frameName(deviceId, cmd), ...cost(off + 3) });
+                });
+                break;
+            case STATS_KIND_CLIENT:
+                records(17, off => r.clients.push({
+                    client: v.getUint8(off),
+                    framesIn: u32(off + 1), bytesIn: u32(off + 5),
+                    framesOut: u32(off + 9), bytesOut: u32(off + 13),
+                }));
+                break;
+            case STATS_KIND_END:
+                clearTimeout(pending.timer);
+                this._statsReply = null;
+                pending.resolve(r);
+                break;
+        }
+    }
+
     // -------------------------------------------------------------------
     // Message channel — user-defined key/value messages.
     //
@@ -1530,13 +2376,34 @@ class Arduino {
     // -------------------------------------------------------------------
     // Receiving
     // -------------------------------------------------------------------
+    // A CMD_CLOCK stamp dates the frames after it in the same message
+    // only — each message starts unstamped.
     _receive(buf) {
+        // Decided before dispatch: a HELLO (which switches acking on) is
+        // never counted — the board starts counting at our CMD_FEATURES.
+        const acking = this._acking && this.connected;
         let pos = 0;
-        while (pos < buf.byteLength) {
-            const frame = decodeFrame(buf, pos);
-            if (!frame) break;
-            this._dispatch(frame);
-            pos += frame.totalLen;
+        this._frameTime = null;
+        try {
+            while (pos < buf.byteLength) {
+                const frame = decodeFrame(buf, pos);
+                if (!frame) break;
+                this._dispatch(frame);
+                pos += frame.totalLen;
+            }
+        } finally {
+            this._frameTime = null;
+        }
+        // Acknowledged once handled, so a page that's slow to run its
+        // handlers (a throttled background tab) falls behind too. Not
+        // through send(): it must not be captured by at().
+        if (acking) {
+            this._unacked += buf.byteLength;
+            if (this._unacked >= ACK_STEP) {
+                this._queue.push(encodeFrame(CMD_ACK, 0, [this._unacked]));
+                this._unacked = 0;
+                this._flush();
+            }
         }
     }
 
@@ -1548,7 +2415,8 @@ class Arduino {
         // These are checked first — they carry no pin/device context.
         if (frame.cmd === CMD_HELLO)    { this._onHello(frame);    return; }
         if (frame.cmd === CMD_ANNOUNCE) { this._onAnnounce(frame); return; }
-        if (frame.cmd === CMD_PONG)     { this._onPong();          return; }
+        if (frame.cmd === CMD_PONG)     { this._onPong(frame);     return; }
+        if (frame.cmd === CMD_CLOCK)    { this._frameTime = frame.params[0] >>> 0; return; }
         if (frame.cmd === CMD_AUTH)     { this._onAuthFail(frame); return; }
         if (frame.cmd === CMD_SERIAL_BUSY) { this._onUsbBusy();    return; }
         if (frame.cmd === CMD_REBOOT)   { this._onReboot();        return; }
@@ -1569,6 +2437,12 @@ class Arduino {
         // Sync-complete signal — all announce frames have arrived; fire 'ready'.
         if (frame.cmd === CMD_SYNC_COMPLETE) { this._onSyncComplete(); return; }
 
+        // Analog stream — status replies and sample blocks.
+        if (frame.cmd === CMD_ANALOG_STREAM) { this._stream?._onStatus(frame); return; }
+        if (frame.cmd === CMD_ANALOG_BLOCK)  { this._stream?._onBlock(frame);  return; }
+        if (frame.cmd === CMD_AT)            { this._onAtRefused(frame);       return; }
+        if (frame.cmd === CMD_STATS)         { this._onStats(frame);           return; }
+
         // Incoming pin-state frames — from Arduino announce on connect, or
         // from Arduino sketches calling Pardalote.share(pin, mode). For input
         // modes we auto-start a default-interval poll so the browser starts
@@ -1607,17 +2481,23 @@ class Arduino {
             this._pinValues.set(pin, frame.params[0]);
             // Post-announce: fire change events so all browsers stay in sync
             // (announce-phase state sync stays silent).
-            if (this._synced) this._emitPinChange(pin, frame.params[0]);
+            if (this._synced) this._emitPinChange(pin, frame.params[0], this._frameTime ?? undefined);
             return;
         }
 
         // Core read response (CMD_DIGITAL_READ or CMD_ANALOG_READ).
+        // [value, micros] from an interrupt-watched pin (READ_EDGES): the
+        // board's micros() at the edge, uint32. Otherwise the message's
+        // clock stamp, when the board sends them.
         const value = frame.params[0];
+        const time  = frame.params.length > 1 ? frame.params[1] >>> 0
+                                              : this._frameTime ?? undefined;
         const read  = this._reads.get(pin);
 
         if (read) {
             const prev = read.value;
             read.value = value;
+            if (time !== undefined) read.time = time;
             // Announce-phase values (board seeding a new/reconnected client)
             // update the mirror silently — same rule as write callbacks.
             // _forceCallback (set in _onSyncComplete) makes the first
@@ -1626,7 +2506,7 @@ class Arduino {
             if (prev === null || value !== prev || read._forceCallback) {
                 if (this._synced) {
                     read._forceCallback = false;
-                    this._emitPinChange(pin, value);
+                    this._emitPinChange(pin, value, time);
                 }
             }
         } else {
@@ -1655,17 +2535,39 @@ class Arduino {
                 this._scheduleReconnect();
                 return;
             }
-            try { this.socket.send(encodeFrame(CMD_PING, 0, [])); } catch (_) {}
+            this._ping();
         }, this._pingMs);
+
+        // A few quick pings so the clock has samples before the first
+        // heartbeat tick.
+        for (let i = 1; i <= 4; i++)
+            this._clockBurst.push(setTimeout(() => this._ping(), i * 150));
     }
 
     _stopHeartbeat() {
         clearInterval(this._pingInterval);
         this._pingInterval = null;
+        this._clockBurst.forEach(clearTimeout);
+        this._clockBurst = [];
+        this._pingsOut.clear();
+    }
+
+    _ping() {
+        const seq = this._pingSeq = (this._pingSeq + 1) & 0x7FFFFFFF;
+        this._pingsOut.set(seq, performance.now());
+        if (this._pingsOut.size > 8)   // unanswered — forget the oldest
+            this._pingsOut.delete(this._pingsOut.keys().next().value);
+        try { this.socket.send(encodeFrame(CMD_PING, 0, [seq])); } catch (_) {}
     }
 
-    _onPong() {
+    // [seq, micros] from current firmware; older firmware sends no params.
+    _onPong(frame) {
         this._lastPong = Date.now();
+        if (frame.params.length < 2) return;
+        const sent = this._pingsOut.get(frame.params[0]);
+        if (sent === undefined) return;
+        this._pingsOut.delete(frame.params[0]);
+        this.clock._sample(sent, performance.now(), frame.params[1]);
     }
 
     // The board announced (over serial) that it just (re)booted — e.g. a reset
@@ -1723,6 +2625,7 @@ class Arduino {
         }
         const adcBits = frame.params[2] ?? 10;   // default 10 for firmware that omits it
         const bootId  = frame.params[3] ?? 0;    // 0 = firmware predates boot ids
+        const features = frame.params[4] ?? 0;   // 0 = protocol 1.0 firmware
         this.board    = frame.payload ? new TextDecoder().decode(frame.payload) : 'unknown';
         this._aliases  = BOARD_ALIASES[this.board] || {};
         this.analogMax = (1 << adcBits) - 1;
@@ -1742,6 +2645,7 @@ class Arduino {
             this._dropBoardCreated();
             this.messages = {};        // retained messages died with the old run
             this._available.clear();   // re-populated by the announce
+            this.clock.reset();        // micros() restarted with it
         }
         this._bootId = bootId;
 
@@ -1762,6 +2666,20 @@ class Arduino {
         console.log(`Pardalote: connected to ${this.board}, protocol v${major}.${minor}, analogMax=${this.analogMax}`);
         if (rebooted) this._emit('reboot', { bootId });
 
+        // Compact frames both ways when the firmware offers them. Ours may
+        // start at once; the board's follow our CMD_FEATURES. Clock stamps
+        // too, whenever offered — they cost the board one frame a message.
+        this._compact = (features & FEATURE_COMPACT) !== 0;
+        this._acking  = (features & FEATURE_ACK) !== 0;
+        this._unacked = 0;
+        // Over USB, sequenced delivery too: from the CMD_FEATURES on, what
+        // we send is resent until acknowledged, and the board's follows.
+        const serial = this.socket instanceof _SerialLink;
+        const want = features & (FEATURE_COMPACT | FEATURE_CLOCK | FEATURE_ACK |
+                                 (serial ? FEATURE_RELIABLE : 0));
+        if (want) this._queue.unshift(encodeFrame(CMD_FEATURES, 0, [want]));
+        if (serial) this.socket.setReliable((want & FEATURE_RELIABLE) !== 0);
+
         // Open the send queue so announce frames from extensions can be
         // received while we wait for CMD_SYNC_COMPLETE.
         // 'ready' is deferred until _onSyncComplete() — after all announce
@@ -1822,7 +2740,7 @@ class Arduino {
         this._reads.forEach((read, pin) => {
             read._forceCallback = true;
             if (!read.passive && read.interval > 0)
-                this.send(encodeFrame(read.cmd, pin, [read.interval, read.threshold ?? 0]));
+                this.send(encodeFrame(read.cmd, pin, this._readParams(read)));
         });
 
         // Pin handles with 'change' listeners need a poll on this board —
@@ -1836,6 +2754,9 @@ class Arduino {
             else h._ensurePoll();
         });
 
+        // The board stops a stream when its client disconnects — ask again.
+        if (this._stream?._want) this._stream._request();
+
         // Let extensions restore their state.
         // Each extension's _reRegister() checks whether the Arduino announced
         // its state (running) or not (reset) and acts accordingly.
@@ -2160,7 +3081,7 @@ class Arduino {
         interval  ??= cfg?.interval  ?? this.defaultInterval;
         threshold ??= cfg?.threshold ?? this.defaultThreshold;
         if (!read) {
-            read = { cmd, interval, threshold, value: null,
+            read = { cmd, interval, threshold, value: null, edges: !!cfg?.edges,
                      origin: this._pollOrigin ?? 'browser', passive: false };
             this._reads.set(pin, read);
         } else {
@@ -2169,10 +3090,19 @@ class Arduino {
             read.passive   = false;   // we now hold our own registration
             if (!this._pollOrigin) read.origin = 'browser';   // explicit user call claims the poll
         }
-        this.send(encodeFrame(cmd, pin, [interval, threshold]));
+        this.send(encodeFrame(cmd, pin, this._readParams(read)));
         return read.value ?? 0;
     }
 
+    // READ / re-register params: [interval, threshold] plus the flags
+    // when the watch wants interrupt-timed edges (older firmware ignores
+    // the third param and keeps polling).
+    _readParams(read) {
+        const p = [read.interval, read.threshold ?? 0];
+        if (read.edges && read.cmd === CMD_DIGITAL_READ) p.push(READ_EDGES);
+        return p;
+    }
+
     // setReadInterval(pin, ms) / setReadThreshold(pin, t)
     // Set a pin's poll interval / change threshold directly — before polling
     // starts (stored, applied when the read registers) or while it runs
@@ -2180,6 +3110,14 @@ class Arduino {
     setReadInterval(pin, ms)  { return this._setReadConfig(pin, 'interval',  ms); }
     setReadThreshold(pin, t)  { return this._setReadConfig(pin, 'threshold', t);  }
 
+    // setReadEdges(pin, on = true) — have the board watch a digital input
+    // with a pin-change interrupt instead of polling it. Every edge is
+    // sent, undebounced, and 'change' payloads gain `time`: the board's
+    // micros() at the edge (wraps every ~71 min — subtract neighbours for
+    // pulse widths). For measuring timing; a bouncy button shows every
+    // bounce. The pin stays interrupt-watched until every page ends its read.
+    setReadEdges(pin, on = true) { return this._setReadConfig(pin, 'edges', !!on); }
+
     _setReadConfig(pin, key, value) {
         pin = this._resolvePin(pin);
         const cfg = this._readConfig.get(pin) || {};
@@ -2195,7 +3133,7 @@ class Arduino {
             read.threshold ??= this.defaultThreshold;
             read.passive = false;
             read.origin  = 'browser';
-            this.send(encodeFrame(read.cmd, pin, [read.interval, read.threshold]));
+            this.send(encodeFrame(read.cmd, pin, this._readParams(read)));
         }
         return this;
     }
@@ -2225,13 +3163,29 @@ class Arduino {
         return p;
     }
 
+    // -------------------------------------------------------------------
+    // analogStream(pins, { rate, block }) — continuous ADC sampling; see
+    // the AnalogStream class. `pins` is a pin or an array of pins (number
+    // or alias); calling again reconfigures the one stream.
+    //
+    //   const s = arduino.analogStream(['A0', 'A3'], { rate: 2000 });
+    //   s.on('block', ({ samples: [a, b] }) => …);
+    // -------------------------------------------------------------------
+    analogStream(pins, opts) {
+        this._stream ||= new AnalogStream(this);
+        return this._stream.start(pins, opts);
+    }
+
     // Deliver a pin-state change (input reading past threshold, or an
     // output write from any client/the sketch) to the 'change' event and
     // to every matching pin handle.
-    _emitPinChange(pin, value) {
-        this._emit('change', { pin, value });
+    // `time` (board micros): the edge time of an interrupt-watched pin,
+    // else the message's clock stamp; absent from older firmware.
+    _emitPinChange(pin, value, time) {
+        const data = time === undefined ? { pin, value } : { pin, value, time };
+        this._emit('change', data);
         this._pinHandles.forEach(h => {
-            if (h.number === pin) h._emit('change', { value, pin });
+            if (h.number === pin) h._emit('change', data);
         });
     }
 
@@ -0,0 +1,663 @@
+// ==============================================================
+// host/bench/bench.cpp
+// Hot-path microbenchmarks for the Pardalote library, run on the
+// host against the Arduino shim.
+// Part of Pardalote — version in library.properties
+// by Scott Mitchell
+// GPL-3.0-or-later License
+//
+//   pardalote_bench            — every benchmark
+//   pardalote_bench cobs       — only those whose name contains "cobs"
+//
+// The loopback/* runs drive run() end to end through the in-memory
+// transport: a message in, the handler, the batched reply out.
+//
+// The datagram/* runs send the same readings both ways: in the
+// loopback client's WebSocket batch, and by the datagram lane to a UDP
+// socket on this machine.
+//
+// The serial-rate/* runs are throughput, not timing: the board streams
+// readings over a modelled line (hostSerialWire) at each CMD_BAUD rate,
+// and reports the frames per second of simulated time it sustains.
+//
+// Each benchmark runs a warm-up, then REPEATS timed rounds of `iters`
+// calls, and reports the fastest round in ns per call — the least
+// disturbed by the OS, so the number to compare between builds. The
+// absolute figures are a desktop CPU's, not a board's; what matters
+// is the ratio against the previous run on the same machine.
+//
+// The inbound batches are shaped like the ones pardalote.js sends (a
+// group write is one message of several frames; a slider drag is a
+// stream of one-frame messages).
+// ==============================================================
+
+// Standard headers first — the shim's Arduino.h defines min/max.
+#include <chrono>
+#include <cstdio>
+#include <vector>
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <Pardalote.h>
+#include <PardaloteServo.h>
+#include <PardaloteStepper.h>
+#include <PardaloteNeoPixel.h>
+#include "internal/edge_watch.h"
+#include "internal/spsc_queue.h"
+#include "internal/step_engine.h"
+
+// Friend of PardaloteClass under PARDALOTE_HOST — reaches the private
+// inbound path without a transport round trip.
+struct PardaloteHostProbe {
+    static void handleBinary(uint8_t num, uint8_t* buf, size_t len) {
+        Pardalote._handleBinary(num, buf, len);
+    }
+    static void queueInbound(uint8_t num, uint8_t* buf, size_t len) {
+        Pardalote._queueInbound(num, buf, len);
+    }
+    static void drainInbound() { Pardalote._drainInbound(true); }
+    static void batching(bool on) { Pardalote._batching = on; }
+    static void flushTx(uint8_t num) { Pardalote._flushTx(num); }
+    // Swap the active transport after begin(), dropping whoever was on
+    // the old one.
+    static void attach(PardaloteTransport& t) {
+        for (uint8_t c = 0; c < PARDALOTE_MAX_CLIENTS; c++) Pardalote._onClientDisconnected(c);
+        Pardalote._attach(t);
+    }
+    static void datagrams(uint16_t port) {
+        Pardalote._datagramPort = port;
+        Pardalote._startDatagrams();
+    }
+};
+
+// -------------------------------------------------------------------
+// Harness
+// -------------------------------------------------------------------
+static const int REPEATS = 7;
+static const char* _filter = nullptr;
+static volatile uint32_t _sink;   // keeps results observable
+
+template <typename Fn>
+static void bench(const char* name, uint32_t iters, Fn fn) {
+    if (_filter && !strstr(name, _filter)) return;
+    typedef std::chrono::steady_clock Clock;
+
+    for (uint32_t i = 0; i < iters / 10 + 1; i++) fn(i);   // warm-up
+
+    double best = 1e30;
+    for (int r = 0; r < REPEATS; r++) {
+        Clock::time_point t0 = Clock::now();
+        for (uint32_t i = 0; i < iters; i++) fn(i);
+        double ns = std::chrono::duration<double, std::nano>(Clock::now() - t0).count();
+        if (ns < best) best = ns;
+    }
+    printf("%-34s %10.1f ns/op  (%u ops x %d)\n", name, best / iters, iters, REPEATS);
+}
+
+// -------------------------------------------------------------------
+// Message builders — concatenate FrameBuilder frames into one
+// message, the same bytes encodeBatch() produces on the JS side.
+// -------------------------------------------------------------------
+static void appendFrame(std::vector<uint8_t>& msg, FrameBuilder& fb) {
+    size_t n = fb.finish();
+    size_t at = msg.size();
+    msg.resize(at + n);
+    memcpy(msg.data() + at, fb.buf, n);
+}
+
+static std::vector<uint8_t> frame2(uint8_t cmd, uint16_t target, int32_t a, int32_t b) {
+    std::vector<uint8_t> msg;
+    FrameBuilder fb;
+    fb.begin(cmd, target);
+    fb.addInt(a);
+    fb.addInt(b);
+    appendFrame(msg, fb);
+    return msg;
+}
+
+// Reference envelope encoder (0x00 0xA5 COBS(msg + crc8) 0x00) for the
+// decode benchmark's input. Deliberately independent of the library's
+// streaming encoder.
+static std::vector<uint8_t> envelope(const std::vector<uint8_t>& msg) {
+    std::vector<uint8_t> body(msg);
+    uint8_t crc = 0;
+    for (uint8_t b : msg) {
+        crc ^= b;
+        for (int k = 0; k < 8; k++) crc = (crc & 0x80) ? (uint8_t)((crc << 1) ^ 0x07) : (uint8_t)(crc << 1);
+    }
+    body.push_back(crc);
+
+    std::vector<uint8_t> out = { 0x00, PARDALOTE_SERIAL_MAGIC };
+    size_t codeAt = out.size();
+    out.push_back(0);
+    uint8_t code = 1;
+    for (uint8_t b : body) {
+        if (b == 0) {
+            out[codeAt] = code; codeAt = out.size(); out.push_back(0); code = 1;
+        } else {
+            out.push_back(b);
+            if (++code == 0xFF) { out[codeAt] = code; codeAt = out.size(); out.push_back(0); code = 1; }
+        }
+    }
+    out[codeAt] = code;
+    out.push_back(0x00);
+    return out;
+}
+
+// -------------------------------------------------------------------
+// Benchmarks
+// -------------------------------------------------------------------
+static void benchProtocol() {
+    // A group write: four servo writes, a digital write and an analog
+    // write in one message.
+    std::vector<uint8_t> batch;
+    for (int i = 0; i < 4; i++) {
+        std::vector<uint8_t> f = frame2(CMD_SERVO_WRITE, DEVICE_SERVO, i, 30 * i);
+        batch.insert(batch.end(), f.begin(), f.end());
+    }
+    std::vector<uint8_t> dw = frame2(CMD_DIGITAL_WRITE, 13, 1, 0);
+    std::vector<uint8_t> aw = frame2(CMD_ANALOG_WRITE, 9, 128, 0);
+    batch.insert(batch.end(), dw.begin(), dw.end());
+    batch.insert(batch.end(), aw.begin(), aw.end());
+
+    bench("parseFrame/single", 2000000, [&](uint32_t) {
+        Frame f = parseFrame(aw.data(), 0, aw.size());
+        _sink += f.target + paramInt(f.params, 0);
+    });
+
+    bench("parseFrame/group-batch", 500000, [&](uint32_t) {
+        size_t pos = 0;
+        while (pos < batch.size()) {
+            Frame f = parseFrame(batch.data(), pos, batch.size());
+            if (!f.valid) break;
+            _sink += f.cmd;
+            pos += f.totalLen;
+        }
+    });
+
+    // The same analog write in the compact layout (protocol 1.1).
+    std::vector<uint8_t> awc(aw);
+    awc.resize(compactFrame(aw.data(), aw.size(), awc.data()));
+    bench("parseFrame/compact", 2000000, [&](uint32_t) {
+        uint8_t scratch[MAX_PARAMS * 4];
+        Frame f = parseFrame(awc.data(), 0, awc.size(), scratch);
+        _sink += f.target + paramInt(f.params, 0);
+    });
+
+    bench("compactFrame/read-reply", 2000000, [&](uint32_t i) {
+        FrameBuilder fb;
+        fb.begin(CMD_SERVO_READ, DEVICE_SERVO);
+        fb.addInt(3);
+        fb.addInt((int32_t)(i % 180));
+        size_t n = compactFrame(fb.buf, fb.finish(), fb.buf);
+        _sink += fb.buf[n - 1];
+    });
+
+    bench("FrameBuilder/read-reply", 2000000, [&](uint32_t i) {
+        FrameBuilder fb;
+        fb.begin(CMD_SERVO_READ, DEVICE_SERVO);
+        fb.addInt(3);
+        fb.addInt((int32_t)i);
+        size_t n = fb.finish();
+        _sink += fb.buf[n - 1];
+    });
+
+    // A servo attach (id, pin, min, max) decoded through its schema.
+    FrameBuilder attach;
+    attach.begin(CMD_SERVO_ATTACH, DEVICE_SERVO);
+    attach.addInt(2); attach.addInt(5); attach.addInt(500); attach.addInt(2500);
+    attach.finish();
+    bench("ParamSchema/servo-attach", 5000000, [&](uint32_t i) {
+        int id, pin, minP = 544, maxP = 2400;
+        ParamSchema<2, int, int, int, int>::read(attach.buf + FRAME_HEADER_SIZE,
+            (uint8_t)(2 + (i & 2)), attach.typeMask, id, pin, minP, maxP);
+        _sink += id + pin + minP + maxP;
+    });
+
+    // A 16-segment gesture channel walked record by record.
+    uint8_t segs[16 * GestureSegRecord::size];
+    for (uint16_t s = 0; s < 16; s++)
+        GestureSegRecord::write(segs + s * GestureSegRecord::size,
+                                (uint8_t)(s % 5), (uint16_t)(100 * s), (int32_t)(s * 7 - 40));
+    bench("RecordSchema/gesture-16-segs", 1000000, [&](uint32_t) {
+        for (uint16_t s = 0; s < 16; s++) {
+            uint8_t curve; uint16_t dur; int32_t value;
+            GestureSegRecord::read(segs + s * GestureSegRecord::size, curve, dur, value);
+            _sink += curve + dur + (uint32_t)value;
+        }
+    });
+
+    bench("FrameBuilder/message", 1000000, [&](uint32_t i) {
+        FrameBuilder fb;
+        fb.begin(CMD_MESSAGE, 0);
+        fb.addInt((int32_t)i);
+        fb.addFloat(0.5f * (float)i);
+        fb.addString("temperature");
+        size_t n = fb.finish();
+        _sink += fb.buf[n - 1] + fb.buf[FRAME_HEADER_SIZE + 7];
+    });
+}
+
+static void benchInbound() {
+    // Bring up the serial transport and connect client 0 with a probe
+    // envelope, so replies go through the real send path.
+    hostSetMicros(1000000);
+    Pardalote.begin(PARDALOTE_SERIAL);
+    std::vector<uint8_t> hello = envelope(frame2(CMD_HELLO, 0, 0, 0));
+    hostSerialInject(hello.data(), hello.size());
+    for (int i = 0; i < 10; i++) { hostAdvanceMicros(20000); Pardalote.run(); }   // past HELLO_DELAY_MS
+
+    for (int i = 0; i < 4; i++) {
+        FrameBuilder fb;
+        fb.begin(CMD_SERVO_ATTACH, DEVICE_SERVO);
+        fb.addInt(i); fb.addInt(3 + i); fb.addInt(544); fb.addInt(2400);
+        size_t n = fb.finish();
+        PardaloteHostProbe::handleBinary(0, fb.buf, n);
+    }
+
+    std::vector<uint8_t> group;
+    for (int i = 0; i < 4; i++) {
+        std::vector<uint8_t> f = frame2(CMD_SERVO_WRITE, DEVICE_SERVO, i, 0);
+        group.insert(group.end(), f.begin(), f.end());
+    }
+    bench("handleBinary/servo-group", 500000, [&](uint32_t i) {
+        for (int k = 0; k < 4; k++) group[k * 16 + 15] = (uint8_t)((i + k) % 180);   // angle low byte
+        PardaloteHostProbe::handleBinary(0, group.data(), group.size());
+    });
+
+    std::vector<uint8_t> slider = frame2(CMD_ANALOG_WRITE, 9, 0, 0);
+    bench("handleBinary/analog-write", 500000, [&](uint32_t i) {
+        slider[11] = (uint8_t)i;   // value low byte
+        PardaloteHostProbe::handleBinary(0, slider.data(), slider.size());
+    });
+
+    // The transport-callback path: copy into the inbound queue, then
+    // run()'s drain. A slider burst of 10 messages to one pin collapses
+    // to a single analogWrite.
+    bench("queue+drain/analog-write", 500000, [&](uint32_t i) {
+        slider[11] = (uint8_t)i;
+        PardaloteHostProbe::queueInbound(0, slider.data(), slider.size());
+        PardaloteHostProbe::drainInbound();
+    });
+    bench("queue+drain/slider-burst-10", 100000, [&](uint32_t i) {
+        for (int k = 0; k < 10; k++) {
+            slider[11] = (uint8_t)(i + k);
+            PardaloteHostProbe::queueInbound(0, slider.data(), slider.size());
+        }
+        PardaloteHostProbe::drainInbound();
+    });
+
+    std::vector<uint8_t> ping = frame2(CMD_PING, 0, 0, 0);
+    bench("handleBinary/ping-pong", 500000, [&](uint32_t) {
+        PardaloteHostProbe::handleBinary(0, ping.data(), ping.size());
+    });
+
+    bench("PardaloteFrame/send-serial", 500000, [&](uint32_t i) {
+        PardaloteFrame fb(0, CMD_SERVO_READ, DEVICE_SERVO);
+        fb.addInt(3);
+        fb.addInt((int32_t)i);
+        fb.send();
+    });
+
+    // One run() pass's worth of output, batched: eight readings, then a
+    // state echo and a DONE that go in ahead of them, then the flush.
+    bench("PardaloteFrame/pass-mixed-10", 100000, [&](uint32_t i) {
+        PardaloteHostProbe::batching(true);
+        for (int k = 0; k < 8; k++) {
+            PardaloteFrame fb(0, CMD_SERVO_READ, DEVICE_SERVO);
+            fb.addInt(k);
+            fb.addInt((int32_t)i);
+            fb.send();
+        }
+        { PardaloteFrame fb(0, CMD_DIGITAL_WRITE, 7); fb.addInt((int32_t)(i & 1)); fb.send(); }
+        { PardaloteFrame fb(0, CMD_SERVO_DONE, DEVICE_SERVO); fb.addInt(0); fb.addInt(90); fb.send(); }
+        PardaloteHostProbe::batching(false);
+        PardaloteHostProbe::flushTx(0);
+    });
+}
+
+static void benchCobs() {
+    PardaloteSerialTransport t;
+    t.begin(PardaloteTransportSinks());   // nobody listening
+
+    std::vector<uint8_t> small, large;
+    for (int i = 0; i < 24;  i++) small.push_back((uint8_t)(i * 37));   // includes zeros
+    for (int i = 0; i < 256; i++) large.push_back((uint8_t)(i * 37));
+
+    std::vector<uint8_t> envSmall = envelope(small);
+    std::vector<uint8_t> envLarge = envelope(large);
+
+    // Decode: feed one envelope through the byte-wise decoder + CRC.
+    bench("cobs/decode-24B", 200000, [&](uint32_t) {
+        hostSerialInject(envSmall.data(), envSmall.size());
+        t.loop(millis());
+    });
+    bench("cobs/decode-256B", 50000, [&](uint32_t) {
+        hostSerialInject(envLarge.data(), envLarge.size());
+        t.loop(millis());
+    });
+
+    // Encode: the decode runs above left the transport connected. Each
+    // send encodes into the TX ring and goes out in one bulk write (the
+    // host port always has room).
+    bench("cobs/encode-24B", 200000, [&](uint32_t) {
+        t.send(0, small.data(), small.size());
+    });
+    bench("cobs/encode-256B", 50000, [&](uint32_t) {
+        t.send(0, large.data(), large.size());
+    });
+    _sink += (uint32_t)hostSerialTxCount();
+}
+
+static void benchEase() {
+    static const char* names[] = { "ease/linear", "ease/easeIn", "ease/easeOut",
+                                   "ease/easeInOut", "ease/back" };
+    for (uint8_t c = CURVE_LINEAR; c <= CURVE_BACK; c++) {
+        bench(names[c], 5000000, [&](uint32_t i) {
+            float t = (float)(i & 1023) * (1.0f / 1023.0f);
+            float v = pardaloteEase(c, t);
+            uint32_t raw;
+            memcpy(&raw, &v, 4);
+            _sink += raw;
+        });
+    }
+}
+
+static void benchReadPoll() {
+    ExtReadPoll p;
+    p.reset(0);
+    for (uint8_t c = 0; c < PARDALOTE_MAX_CLIENTS; c++) p.setClient(c, 20, 4);
+
+    // Four clients offered a slowly moving value every millisecond —
+    // most offers are gated out, as on a board.
+    bench("ExtReadPoll/gate-4-clients", 1000000, [&](uint32_t i) {
+        int32_t val = (int32_t)(i >> 3);
+        for (uint8_t c = 0; c < PARDALOTE_MAX_CLIENTS; c++)
+            _sink += p.gate(c, val, i);
+    });
+}
+
+static void benchEdges() {
+    // One edge through the ring: the ISR push (fired by the shim's pin
+    // change) and the loop-side pop.
+    int8_t slot = EdgeWatch::attach(40, 0);
+    bench("EdgeWatch/push-pop", 5000000, [&](uint32_t i) {
+        hostSetPin(40, (int)(i & 1));
+        EdgeWatch::Edge e;
+        while (EdgeWatch::pop(e)) _sink += e.level + e.us;
+    });
+    EdgeWatch::detach(slot);
+}
+
+static void benchStats() {
+    // The per-phase cost of instrumentation: one section charge, and a
+    // handler timing that finds its (deviceId, cmd) slot among 8.
+    uint32_t t = Stats::ticks();
+    bench("Stats/section", 5000000, [&](uint32_t) {
+        t = Stats::section(STATS_SEC_PINS, t);
+    });
+    for (uint8_t c = 0; c < 8; c++) Stats::command(DEVICE_SERVO, 0x10 + c, Stats::ticks());
+    bench("Stats/command", 5000000, [&](uint32_t i) {
+        Stats::command(DEVICE_SERVO, 0x10 + (i & 7), Stats::ticks());
+    });
+    _sink += Stats::sections[STATS_SEC_PINS].calls;
+    Stats::reset();
+}
+
+static void benchLoopAll() {
+    // Extension loop hooks with nothing due: the servo's timed hook
+    // sleeps in the registry heap, the stepper's runs every pass.
+    hostSetMicros(5000000);
+    loopAll();
+    bench("loopAll/idle", 2000000, [](uint32_t) {
+        loopAll();
+    });
+}
+
+static void benchSpsc() {
+    // One 64-byte message across the splitCores() queue and back out,
+    // single-threaded — the per-message cost each side pays.
+    static uint8_t ring[4096];
+    SpscQueue q;
+    q.begin(ring, sizeof ring);
+    uint8_t msg[64] = {};
+    bench("spsc/push+pop 64B", 5000000, [&](uint32_t i) {
+        msg[0] = (uint8_t)i;
+        q.push(0, 0, msg, sizeof msg);
+        SpscQueue::Header h;
+        uint8_t* data;
+        if (q.peek(h, data)) { _sink += data[0]; q.pop(); }
+    });
+
+    // Every record type through a small queue that wraps every few
+    // records: each comes back as pushed, and the wrap marker's type is
+    // refused rather than queued. Anything but 0 is a fault.
+    if (_filter && !strstr("spsc/types", _filter)) return;
+    static uint8_t small[256];
+    SpscQueue w;
+    w.begin(small, sizeof small);
+    unsigned bad = 0;
+    for (unsigned t = 0; t < 256; t++) {
+        const bool pushed = w.push(1, (uint8_t)t, msg, 52);
+        if (pushed != (t != SpscQueue::WRAP)) bad++;
+        SpscQueue::Header h;
+        uint8_t* data;
+        if (!pushed) continue;
+        if (!w.peek(h, data) || h.type != t || h.len != 52) bad++;
+        w.pop();
+    }
+    printf("%-34s %10u faults\n", "spsc/types", bad);
+}
+
+// TimerStepper's planner across a loop() stall: the ISR carries the
+// motor to its target at speed, and the next run() finds it there, still
+// fast. Reports the furthest the motor got past the target afterwards —
+// anything but 0 is an overshoot.
+static void benchStepEngine() {
+    if (_filter && !strstr("step-engine", _filter)) return;
+    const uint32_t ticksPerMs = StepEngine::TICK_HZ / 1000;
+    TimerStepper m(TimerStepper::DRIVER, 50, 51);
+    m.setMaxSpeed(4000);
+    m.setAcceleration(4000);
+    m.moveTo(2000);
+    auto ms = [&](bool planner) {
+        if (planner) m.run();
+        hostAdvanceMicros(1000);
+        for (uint32_t t = 0; t < ticksPerMs; t++) StepEngine::tick();
+    };
+    while (m.currentPosition() < 1000) ms(true);
+    for (int i = 0; i < 400; i++) ms(false);   // the stall
+    long furthest = 0;
+    for (int i = 0; i < 1000; i++) {
+        ms(true);
+        const long past = m.currentPosition() - m.targetPosition();
+        if (past > furthest) furthest = past;
+    }
+    printf("%-34s %10ld steps past the target\n", "step-engine/stall-at-target", furthest);
+}
+
+// Sustained telemetry over the USB serial link at each line rate. Each
+// pass batches eight servo readings (compact frames, as a page asks for),
+// costs 100 µs of sketch time, and flushes; a full TX ring makes the pass
+// wait on the line, so the rate settles at what the line carries.
+static void benchSerialRate() {
+    if (_filter && !strstr("serial-rate", _filter)) return;
+    std::vector<uint8_t> feat = envelope(frame2(CMD_FEATURES, 0, FEATURE_COMPACT, 0));
+    hostSerialInject(feat.data(), feat.size());
+    Pardalote.run();
+    hostSerialWire(128);   // a UART FIFO's worth
+
+    const uint32_t rates[] = { 115200, 921600, 2000000 };
+    for (uint32_t rate : rates) {
+        std::vector<uint8_t> baud = envelope(frame2(CMD_BAUD, 0, (int32_t)rate, 0));
+        hostSerialInject(baud.data(), baud.size());
+        for (int i = 0; i < 10 && hostSerialBaud() != rate; i++) { Pardalote.run(); hostAdvanceMicros(1000); }
+        std::vector<uint8_t> ping = envelope(frame2(CMD_PING, 0, 0, 0));   // the page, at the new rate
+        hostSerialInject(ping.data(), ping.size());
+        Pardalote.run();
+
+        const unsigned long t0 = micros();
+        uint32_t frames = 0;
+        const size_t bytes0 = hostSerialTxCount();
+        while (micros() - t0 < 1000000) {
+            PardaloteHostProbe::batching(true);
+            for (int k = 0; k < 8; k++) {
+                PardaloteFrame fb(0, CMD_SERVO_READ, DEVICE_SERVO);
+                fb.addInt(k);
+                fb.addInt((int32_t)(frames + k));
+                fb.send();
+            }
+            frames += 8;
+            hostAdvanceMicros(100);
+            PardaloteHostProbe::batching(false);
+            PardaloteHostProbe::flushTx(0);
+            Pardalote.run();
+        }
+        const double s = (micros() - t0) / 1e6;
+        char name[40];
+        snprintf(name, sizeof name, "serial-rate/%lu", (unsigned long)hostSerialBaud());
+        printf("%-34s %10.0f frames/s  (%.1f KB/s on the wire)\n",
+               name, frames / s, (hostSerialTxCount() - bytes0) / s / 1000);
+    }
+    hostSerialWire(0);
+}
+
+// Whole round trips through run() on the loopback transport: the
+// message is queued by the transport, drained, handled, and the reply
+// batched and handed back — everything but a real link.
+static uint32_t _replies = 0;
+static void _countReply(uint8_t, const uint8_t*, size_t) { _replies++; }
+
+static void benchLoopback() {
+    if (_filter && !strstr("loopback", _filter)) return;
+    static PardaloteLoopbackTransport link;
+    link.onReply(_countReply);
+    PardaloteHostProbe::attach(link);
+    std::vector<uint8_t> hello = frame2(CMD_HELLO, 0, 0, 0);
+    for (uint8_t c = 0; c < 4; c++) {
+        link.connectClient(c);
+        link.inject(c, hello.data(), hello.size());
+    }
+    for (int i = 0; i < 10; i++) { hostAdvanceMicros(20000); Pardalote.run(); }   // past HELLO_DELAY_MS
+
+    std::vector<uint8_t> ping = frame2(CMD_PING, 0, 0, 0);
+    _replies = 0;
+    bench("loopback/ping-round-trip", 500000, [&](uint32_t) {
+        link.inject(0, ping.data(), ping.size());
+        Pardalote.run();
+    });
+    bench("loopback/ping-4-clients", 200000, [&](uint32_t) {
+        for (uint8_t c = 0; c < 4; c++) link.inject(c, ping.data(), ping.size());
+        Pardalote.run();
+    });
+
+    std::vector<uint8_t> group;
+    for (int i = 0; i < 4; i++) {
+        std::vector<uint8_t> f = frame2(CMD_SERVO_WRITE, DEVICE_SERVO, i, 0);
+        group.insert(group.end(), f.begin(), f.end());
+    }
+    bench("loopback/servo-group+ping", 200000, [&](uint32_t i) {
+        for (int k = 0; k < 4; k++) group[k * 16 + 15] = (uint8_t)((i + k) % 180);
+        link.inject(0, group.data(), group.size());
+        link.inject(0, ping.data(), ping.size());
+        Pardalote.run();
+    });
+    _sink += _replies;
+}
+
+// Four watched pins, each with a new reading every pass, to one
+// client: first in its WebSocket batch, then — once it has bound the
+// datagram lane from a local UDP socket — as a datagram. The gap
+// between the two is what sendto() costs run().
+static const uint16_t DATAGRAM_BENCH_PORT = 47810;   // 81 needs root here
+static int32_t _datagramToken = 0;
+static void _watchToken(uint8_t, const uint8_t* d, size_t n) {
+    size_t pos = 0;
+    uint8_t scratch[MAX_PARAMS * 4];
+    while (pos < n) {
+        Frame f = parseFrame((uint8_t*)d, pos, n, scratch);
+        if (!f.valid) break;
+        if (f.cmd == CMD_DATAGRAM && f.nparams >= 1) _datagramToken = paramInt(f.params, 0);
+        pos += f.totalLen;
+    }
+}
+
+static void benchDatagram() {
+    if (_filter && !strstr("datagram", _filter)) return;
+    static PardaloteLoopbackTransport link;
+    link.onReply(_watchToken);
+    PardaloteHostProbe::attach(link);
+    PardaloteHostProbe::datagrams(DATAGRAM_BENCH_PORT);
+
+    const int sock = socket(AF_INET, SOCK_DGRAM, 0);
+    fcntl(sock, F_SETFL, fcntl(sock, F_GETFL) | O_NONBLOCK);
+    sockaddr_in board = {};
+    board.sin_family      = AF_INET;
+    board.sin_port        = htons(DATAGRAM_BENCH_PORT);
+    board.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    uint8_t rx[1500];
+    uint32_t got = 0;
+    auto drain = [&]() {   // readings only — not the header-only keepalive answers
+        ssize_t n;
+        while ((n = recv(sock, rx, sizeof rx, 0)) > 0)
+            if (n > FRAME_HEADER_SIZE + 4) got++;
+    };
+
+    std::vector<uint8_t> hello = frame2(CMD_HELLO, 0, 0, 0);
+    link.connectClient(0);
+    link.inject(0, hello.data(), hello.size());
+    for (int i = 0; i < 10; i++) { hostAdvanceMicros(20000); Pardalote.run(); }
+    for (uint16_t pin = 0; pin < 4; pin++) {
+        std::vector<uint8_t> watch = frame2(CMD_ANALOG_READ, pin, 10, 1);
+        link.inject(0, watch.data(), watch.size());
+    }
+    auto pass = [](uint32_t i) {
+        for (uint8_t pin = 0; pin < 4; pin++) hostSetPin(pin, (int)((i + pin) % 2) * 100);
+        hostAdvanceMicros(10000);   // ANALOG_SAMPLE_MS
+        Pardalote.run();
+    };
+
+    bench("datagram/readings-websocket", 100000, pass);
+
+    std::vector<uint8_t> on = frame2(CMD_FEATURES, 0, FEATURE_DATAGRAM, 0);
+    link.inject(0, on.data(), on.size());
+    Pardalote.run();
+    std::vector<uint8_t> bind = frame2(CMD_DATAGRAM, 0, _datagramToken, 0);
+    sendto(sock, bind.data(), bind.size(), 0, (sockaddr*)&board, sizeof board);
+    usleep(1000);
+    Pardalote.run();
+    uint32_t passes = 0;
+    bench("datagram/readings-udp", 100000, [&](uint32_t i) {
+        pass(i);
+        passes++;
+        drain();
+        if (i % 200 == 0)   // keepalive — simulated time runs faster than real
+            sendto(sock, bind.data(), bind.size(), 0, (sockaddr*)&board, sizeof board);
+    });
+    usleep(1000);
+    drain();
+    printf("%-34s %10u of %u passes\n", "datagram/received", got, passes);
+    close(sock);
+}
+
+int main(int argc, char** argv) {
+    if (argc > 1) _filter = argv[1];
+    printf("Pardalote host microbenchmarks (%s)\n\n", PARDALOTE_VERSION);
+
+    benchProtocol();
+    benchInbound();
+    benchCobs();
+    benchEase();
+    benchReadPoll();
+    benchEdges();
+    benchStats();
+    benchLoopAll();
+    benchSpsc();
+    benchStepEngine();
+    benchSerialRate();
+    benchLoopback();
+    benchDatagram();
+    return 0;
+}
@@ -0,0 +1,89 @@
+// ==============================================================
+// host/shim/AccelStepper.h
+// AccelStepper stand-in for the host build. Motion runs on micros(),
+// like the library: runSpeed() steps once 1/speed s have passed since
+// the last step, and run() ramps the speed toward the target at the
+// set acceleration. At most one step per call, so a run() pass slower
+// than the step rate slows the motor, as it would on a board.
+// ==============================================================
+
+#pragma once
+
+#include "Arduino.h"
+
+class AccelStepper {
+public:
+    enum MotorInterfaceType { FUNCTION = 0, DRIVER = 1, FULL2WIRE = 2, FULL3WIRE = 3,
+                              FULL4WIRE = 4, HALF3WIRE = 6, HALF4WIRE = 8 };
+
+    AccelStepper(uint8_t = FULL4WIRE, uint8_t = 2, uint8_t = 3, uint8_t = 4, uint8_t = 5, bool = true) {}
+
+    long  currentPosition()          { return _pos; }
+    long  targetPosition()           { return _target; }
+    long  distanceToGo()             { return _target - _pos; }
+    float speed()                    { return _speed; }
+    float maxSpeed()                 { return _maxSpeed; }
+
+    void setMaxSpeed(float s)        { _maxSpeed = fabsf(s); }
+    void setAcceleration(float a)    { _accel = fabsf(a); }
+    void setSpeed(float s)           { _speed = constrain(s, -_maxSpeed, _maxSpeed); }
+    void moveTo(long absolute)       { _target = absolute; if (_speed == 0) _rampUs = micros(); }
+    void move(long relative)         { moveTo(_pos + relative); }
+    void setCurrentPosition(long p)  { _pos = _target = p; _speed = 0; }
+    void stop() {   // to rest as fast as the acceleration allows
+        if (_speed == 0) { _target = _pos; return; }
+        const long d = _accel > 0 ? (long)(_speed * _speed / (2 * _accel)) : 0;
+        _target = _pos + (_speed > 0 ? d : -d);
+    }
+
+    bool runSpeed() {
+        if (_speed == 0) return false;
+        const unsigned long now = micros();
+        if (now - _lastStepUs < (unsigned long)(1e6f / fabsf(_speed))) return false;
+        _lastStepUs = now;
+        _pos += _speed > 0 ? 1 : -1;
+        return true;
+    }
+    bool run() {
+        if (_pos == _target) { _speed = 0; _rampUs = micros(); return false; }
+        _ramp();
+        runSpeed();
+        return true;
+    }
+    bool runSpeedToPosition() {
+        if (_pos == _target) return false;
+        if ((_target > _pos) != (_speed > 0)) _speed = -_speed;
+        return runSpeed();
+    }
+    void setPinsInverted(bool, bool, bool) {}
+    void setEnablePin(uint8_t) {}
+    void enableOutputs() {}
+    void disableOutputs() {}
+
+private:
+    // Accelerate toward the target, or brake once the stopping distance
+    // reaches it. Never below the speed of a first step from rest, so a
+    // move always finishes.
+    void _ramp() {
+        const unsigned long now = micros();
+        float dt = (now - _rampUs) / 1e6f;
+        _rampUs = now;
+        if (dt > 0.1f) dt = 0.1f;
+        const float dir = _target > _pos ? 1.0f : -1.0f;
+        if (_accel <= 0) { _speed = dir * _maxSpeed; return; }
+        const float dist  = fabsf((float)(_target - _pos));
+        const bool  brake = _speed * dir > 0 && _speed * _speed / (2 * _accel) >= dist;
+        float v = _speed + (brake ? -dir : dir) * _accel * dt;
+        const float vMin = fminf(_maxSpeed, sqrtf(2 * _accel));
+        if (v * dir < vMin && (brake || _speed * dir >= 0)) v = dir * vMin;
+        _speed = constrain(v, -_maxSpeed, _maxSpeed);
+    }
+
+    long          _pos        = 0;
+    long          _target     = 0;
+    float         _speed      = 0;
+    float         _maxSpeed   = 1;
+    float         _accel      = 0;
+    unsigned long _lastStepUs = 0;
+    unsigned long _rampUs     = 0;
+};
@@ -0,0 +1,46 @@
+// ==============================================================
+// host/shim/Adafruit_NeoPixel.h
+// NeoPixel stub for the host build — a pixel array, no output.
+// ==============================================================
+
+#pragma once
+
+#include "Arduino.h"
+
+#define NEO_GRB    0x52
+#define NEO_RGB    0x06
+#define NEO_GRBW   0xD2
+#define NEO_KHZ800 0x0000
+
+class Adafruit_NeoPixel {
+public:
+    Adafruit_NeoPixel(uint16_t n, int16_t pin = 6, uint16_t type = NEO_GRB + NEO_KHZ800)
+        : _n(n), _px(new uint32_t[n]()) { (void)pin; (void)type; }
+    ~Adafruit_NeoPixel() { delete[] _px; }
+
+    void     begin() {}
+    void     show() {}
+    void     clear()                                  { memset(_px, 0, _n * sizeof(uint32_t)); }
+    void     fill(uint32_t c = 0, uint16_t first = 0, uint16_t count = 0) {
+        uint16_t end = count ? first + count : _n;
+        for (uint16_t i = first; i < end && i < _n; i++) _px[i] = c;
+    }
+    void     setPixelColor(uint16_t i, uint32_t c)    { if (i < _n) _px[i] = c; }
+    void     setPixelColor(uint16_t i, uint8_t r, uint8_t g, uint8_t b) { setPixelColor(i, Color(r, g, b)); }
+    uint32_t getPixelColor(uint16_t i) const          { return i < _n ? _px[i] : 0; }
+    void     setBrightness(uint8_t b)                 { _brightness = b; }
+    uint8_t  getBrightness() const                    { return _brightness; }
+    uint16_t numPixels() const                        { return _n; }
+
+    static uint32_t Color(uint8_t r, uint8_t g, uint8_t b) {
+        return ((uint32_t)r << 16) | ((uint32_t)g << 8) | b;
+    }
+    static uint32_t Color(uint8_t r, uint8_t g, uint8_t b, uint8_t w) {
+        return ((uint32_t)w << 24) | Color(r, g, b);
+    }
+
+private:
+    uint16_t  _n;
+    uint32_t* _px;
+    uint8_t   _brightness = 255;
+};
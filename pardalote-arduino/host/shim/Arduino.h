@@ -0,0 +1,172 @@
+// ==============================================================
+// host/shim/Arduino.h
+// Minimal Arduino core for the host (Linux/macOS) build.
+// Part of Pardalote — version in library.properties
+// by Scott Mitchell
+// GPL-3.0-or-later License
+//
+// Just enough of the Arduino API for the library to compile and run
+// off-board: a controllable clock, pins that read back what the host
+// put there, and a Serial whose RX is fed by the host and whose TX
+// is captured. Nothing here talks to real hardware.
+// ==============================================================
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <stdlib.h>
+#include <math.h>
+
+#define HIGH 0x1
+#define LOW  0x0
+
+#define INPUT          0x0
+#define OUTPUT         0x1
+#define INPUT_PULLUP   0x2
+#define INPUT_PULLDOWN 0x3
+
+#define CHANGE  1
+#define FALLING 2
+#define RISING  3
+
+#define DEC 10
+#define HEX 16
+
+#define PI 3.14159265358979323846
+
+#define PROGMEM
+#define pgm_read_byte(p) (*(const uint8_t*)(p))
+
+class __FlashStringHelper;
+#define F(s) (reinterpret_cast<const __FlashStringHelper*>(s))
+
+#define constrain(x, lo, hi) ((x) < (lo) ? (lo) : ((x) > (hi) ? (hi) : (x)))
+#ifndef min
+  #define min(a, b) ((a) < (b) ? (a) : (b))
+  #define max(a, b) ((a) > (b) ? (a) : (b))
+#endif
+
+typedef uint8_t byte;
+
+// -------------------------------------------------------------------
+// Time. Real elapsed time by default; hostSetMicros() freezes the
+// clock at a value the host controls (hostAdvanceMicros() steps it).
+// -------------------------------------------------------------------
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+inline void yield() {}
+
+void hostSetMicros(unsigned long us);
+void hostAdvanceMicros(unsigned long us);
+
+// -------------------------------------------------------------------
+// Pins. digitalRead/analogRead return whatever hostSetPin() stored.
+// -------------------------------------------------------------------
+#define HOST_NUM_PINS 64
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t val);
+int  digitalRead(uint8_t pin);
+int  analogRead(uint8_t pin);
+void analogWrite(uint8_t pin, int val);
+inline void analogReadResolution(int) {}
+inline void analogWriteResolution(int) {}
+void hostSetPin(uint8_t pin, int value);
+
+inline unsigned long pulseIn(uint8_t, uint8_t, unsigned long = 1000000UL) { return 0; }   // no echo
+
+// Every pin has an interrupt; a CHANGE handler fires from
+// hostSetPin() when the level it stores changes.
+#define NOT_AN_INTERRUPT -1
+inline int digitalPinToInterrupt(uint8_t pin) { return pin < HOST_NUM_PINS ? pin : NOT_AN_INTERRUPT; }
+void attachInterrupt(int irq, void (*isr)(), int mode);
+void detachInterrupt(int irq);
+inline void noInterrupts() {}
+inline void interrupts() {}
+
+long random(long howbig);
+long random(long howsmall, long howbig);
+void randomSeed(unsigned long seed);
+
+inline long map(long x, long inMin, long inMax, long outMin, long outMax) {
+    return (x - inMin) * (outMax - outMin) / (inMax - inMin) + outMin;
+}
+
+// -------------------------------------------------------------------
+// Print / HardwareSerial. Text output goes to stdout only when
+// hostSerialEcho(true) — the bench keeps it quiet. Bytes written are
+// counted, and handed to a hostSerialTap() callback if one is set;
+// available()/read() drain bytes queued with hostSerialInject().
+// availableForWrite() reports whatever hostSerialWriteRoom() last set
+// — or, with hostSerialWire() on, the room left in a modelled line.
+// -------------------------------------------------------------------
+class Print {
+public:
+    virtual ~Print() {}
+    virtual size_t write(uint8_t b) = 0;
+    virtual size_t write(const uint8_t* buf, size_t n) {
+        for (size_t i = 0; i < n; i++) write(buf[i]);
+        return n;
+    }
+
+    size_t print(const __FlashStringHelper* s) { return _text(reinterpret_cast<const char*>(s)); }
+    size_t print(const char* s)                { return _text(s); }
+    size_t print(char c)                       { char s[2] = { c, 0 }; return _text(s); }
+    size_t print(int v, int base = DEC)           { return print((long)v, base); }
+    size_t print(unsigned int v, int base = DEC)  { return print((unsigned long)v, base); }
+    size_t print(long v, int base = DEC);
+    size_t print(unsigned long v, int base = DEC);
+    size_t print(double v, int digits = 2);
+
+    template <typename T> size_t println(T v)          { size_t n = print(v);       return n + println(); }
+    template <typename T> size_t println(T v, int arg) { size_t n = print(v, arg);  return n + println(); }
+    size_t println() { return _text("\n"); }
+
+protected:
+    virtual size_t _text(const char* s) = 0;
+};
+
+#define SERIAL_8N1 0x06
+
+class HardwareSerial : public Print {
+public:
+    void begin(unsigned long baud);
+    void begin(unsigned long baud, uint32_t, int8_t = -1, int8_t = -1) { begin(baud); }
+    void end() {}
+    operator bool() const { return true; }
+
+    int    available();
+    int    read();
+    int    peek();
+    size_t readBytes(uint8_t* buf, size_t n);
+    int    availableForWrite();
+    void   flush();
+    void   setTimeout(unsigned long) {}
+
+    using Print::write;
+    size_t write(uint8_t b) override;
+    size_t write(const uint8_t* buf, size_t n) override;
+
+protected:
+    size_t _text(const char* s) override;
+};
+
+extern HardwareSerial Serial;
+extern HardwareSerial Serial1;
+extern HardwareSerial Serial2;
+
+// Host-side controls for Serial (the USB link).
+void   hostSerialInject(const uint8_t* data, size_t len);   // queue RX bytes
+size_t hostSerialTxCount();                                 // bytes written so far
+void   hostSerialEcho(bool on);                             // print text to stdout
+void   hostSerialWriteRoom(int room);                       // availableForWrite() (default 4096)
+void   hostSerialTap(void (*fn)(const uint8_t* data, size_t len));   // sees every TX byte
+unsigned long hostSerialBaud();                             // rate of the last Serial.begin()
+// Model the line: 10 bits a byte at the Serial.begin() rate, through a
+// `fifo`-byte transmit buffer. availableForWrite() reports its room; a
+// write (or flush) that has to wait moves the frozen clock on instead.
+// 0 turns the model off.
+void   hostSerialWire(size_t fifo);
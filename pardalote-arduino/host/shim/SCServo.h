@@ -0,0 +1,51 @@
+// ==============================================================
+// host/shim/SCServo.h
+// Feetech SCServo stub for the host build — an empty bus: every
+// Ping/FeedBack fails (-1), every write is accepted and dropped.
+// ==============================================================
+
+#pragma once
+
+#include "Arduino.h"
+
+#define SMS_STS_ID                 5
+#define SMS_STS_MIN_ANGLE_LIMIT_L  9
+#define SMS_STS_MAX_ANGLE_LIMIT_L 11
+#define SCSCL_ID                   5
+#define SCSCL_MIN_ANGLE_LIMIT_L    9
+#define SCSCL_MAX_ANGLE_LIMIT_L   11
+
+class SCSBus {
+public:
+    HardwareSerial* pSerial   = nullptr;
+    uint32_t        IOTimeOut = 100;
+
+    int Ping(uint8_t)                          { return -1; }
+    int FeedBack(int)                          { return -1; }
+    int ReadPos(int)                           { return -1; }
+    int ReadSpeed(int)                         { return -1; }
+    int ReadLoad(int)                          { return -1; }
+    int ReadVoltage(int)                       { return -1; }
+    int ReadTemper(int)                        { return -1; }
+    int ReadCurrent(int)                       { return -1; }
+    int ReadMove(int)                          { return -1; }
+    int EnableTorque(uint8_t, uint8_t)         { return 1; }
+    int CalibrationOfs(uint8_t)                { return 1; }
+    int unLockEprom(uint8_t)                   { return 1; }
+    int LockEprom(uint8_t)                     { return 1; }
+    int writeByte(uint8_t, uint8_t, uint8_t)   { return 1; }
+    int readWord(uint8_t, uint8_t)             { return -1; }
+};
+
+class SMS_STS : public SCSBus {
+public:
+    int  WritePosEx(uint8_t, int16_t, uint16_t, uint8_t = 0)             { return 1; }
+    int  WriteSpe(uint8_t, int16_t, uint8_t = 0)                         { return 1; }
+    int  WheelMode(uint8_t)                                              { return 1; }
+    void SyncWritePosEx(uint8_t[], uint8_t, int16_t[], uint16_t[], uint8_t[]) {}
+};
+
+class SCSCL : public SCSBus {
+public:
+    int WritePos(uint8_t, uint16_t, uint16_t, uint16_t = 0)              { return 1; }
+};
@@ -0,0 +1,23 @@
+// ==============================================================
+// host/shim/Servo.h
+// Servo stub for the host build — remembers the last write.
+// ==============================================================
+
+#pragma once
+
+#include "Arduino.h"
+
+class Servo {
+public:
+    uint8_t attach(int pin)                   { _pin = pin; return 1; }
+    uint8_t attach(int pin, int, int)         { _pin = pin; return 1; }
+    void    detach()                          { _pin = -1; }
+    bool    attached()                        { return _pin >= 0; }
+    void    write(int angle)                  { _angle = angle; }
+    void    writeMicroseconds(int us)         { _angle = (int)map(us, 544, 2400, 0, 180); }
+    int     read()                            { return _angle; }
+
+private:
+    int _pin   = -1;
+    int _angle = 90;
+};
@@ -0,0 +1,52 @@
+// ==============================================================
+// host/shim/WiFiUdp.h
+// WiFiUDP for the host build — a real, non-blocking UDP socket, so
+// the datagram lane can be exercised against a local peer. The POSIX
+// side lives in wifi_udp_shim.cpp, out of the sketch's namespace.
+// ==============================================================
+
+#pragma once
+
+#include "Arduino.h"
+
+class IPAddress {
+public:
+    IPAddress() {}
+    IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d)
+        : _addr((uint32_t)a | (uint32_t)b << 8 | (uint32_t)c << 16 | (uint32_t)d << 24) {}
+    explicit IPAddress(uint32_t networkOrder) : _addr(networkOrder) {}
+    operator uint32_t() const { return _addr; }   // network byte order, as on the boards
+    bool operator==(const IPAddress& o) const { return _addr == o._addr; }
+    bool operator!=(const IPAddress& o) const { return _addr != o._addr; }
+
+private:
+    uint32_t _addr = 0;
+};
+
+class WiFiUDP {
+public:
+    ~WiFiUDP() { stop(); }
+
+    uint8_t begin(uint16_t port);   // bound to every local address
+    void    stop();
+
+    int    beginPacket(IPAddress ip, uint16_t port);
+    size_t write(const uint8_t* data, size_t len);
+    int    endPacket();
+
+    // Size of the next datagram, now current for read(); 0 if none.
+    int parsePacket();
+    int read(uint8_t* buf, size_t len);
+
+    IPAddress remoteIP()   const { return _from; }
+    uint16_t  remotePort() const { return _fromPort; }
+
+private:
+    int       _fd = -1;
+    IPAddress _to, _from;
+    uint16_t  _toPort = 0, _fromPort = 0;
+    uint8_t   _out[1472];
+    size_t    _outLen = 0;
+    uint8_t   _in[1472];
+    size_t    _inLen = 0, _inPos = 0;
+};
@@ -0,0 +1,24 @@
+// ==============================================================
+// host/shim/Wire.h
+// I2C stub for the host build — no devices ever answer.
+// ==============================================================
+
+#pragma once
+
+#include "Arduino.h"
+
+class TwoWire {
+public:
+    void    begin() {}
+    void    begin(int, int) {}
+    void    setClock(uint32_t) {}
+    void    setTimeOut(uint16_t) {}
+    void    beginTransmission(uint8_t) {}
+    uint8_t endTransmission(bool = true) { return 2; }   // NACK on address
+    size_t  write(uint8_t) { return 1; }
+    uint8_t requestFrom(uint8_t, uint8_t, bool = true) { return 0; }
+    int     available() { return 0; }
+    int     read() { return -1; }
+};
+
+extern TwoWire Wire;
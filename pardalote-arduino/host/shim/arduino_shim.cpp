@@ -0,0 +1,196 @@
+// ==============================================================
+// host/shim/arduino_shim.cpp
+// Bodies for the host Arduino shim — see Arduino.h.
+// ==============================================================
+
+// Standard headers first — Arduino.h defines min/max as macros.
+#include <chrono>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+#include "Arduino.h"
+
+HardwareSerial Serial;
+HardwareSerial Serial1;
+HardwareSerial Serial2;
+
+// -------------------------------------------------------------------
+// Clock
+// -------------------------------------------------------------------
+static bool          _frozen   = false;
+static unsigned long _frozenUs = 0;
+
+static unsigned long _realMicros() {
+    static const auto t0 = std::chrono::steady_clock::now();
+    return (unsigned long)std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - t0).count();
+}
+
+unsigned long micros() { return _frozen ? _frozenUs : _realMicros(); }
+unsigned long millis() { return micros() / 1000; }
+
+void delay(unsigned long ms) {
+    if (_frozen) { _frozenUs += ms * 1000; return; }
+    std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+void delayMicroseconds(unsigned int us) {
+    if (_frozen) { _frozenUs += us; return; }
+    std::this_thread::sleep_for(std::chrono::microseconds(us));
+}
+
+void hostSetMicros(unsigned long us)     { _frozen = true; _frozenUs = us; }
+void hostAdvanceMicros(unsigned long us) { _frozen = true; _frozenUs += us; }
+
+// -------------------------------------------------------------------
+// Pins
+// -------------------------------------------------------------------
+static int _pins[HOST_NUM_PINS];
+
+void pinMode(uint8_t, uint8_t) {}
+void digitalWrite(uint8_t pin, uint8_t val) { if (pin < HOST_NUM_PINS) _pins[pin] = val; }
+int  digitalRead(uint8_t pin)               { return pin < HOST_NUM_PINS ? (_pins[pin] ? HIGH : LOW) : LOW; }
+int  analogRead(uint8_t pin)                { return pin < HOST_NUM_PINS ? _pins[pin] : 0; }
+void analogWrite(uint8_t pin, int val)      { if (pin < HOST_NUM_PINS) _pins[pin] = val; }
+
+static void (*_isrs[HOST_NUM_PINS])();
+
+void attachInterrupt(int irq, void (*isr)(), int) { if (irq >= 0 && irq < HOST_NUM_PINS) _isrs[irq] = isr; }
+void detachInterrupt(int irq)                     { if (irq >= 0 && irq < HOST_NUM_PINS) _isrs[irq] = nullptr; }
+
+void hostSetPin(uint8_t pin, int value) {
+    if (pin >= HOST_NUM_PINS) return;
+    const bool edge = (_pins[pin] != 0) != (value != 0);
+    _pins[pin] = value;
+    if (edge && _isrs[pin]) _isrs[pin]();
+}
+
+long random(long howbig)                 { return howbig > 0 ? (long)(rand() % howbig) : 0; }
+long random(long howsmall, long howbig)  { return howsmall >= howbig ? howsmall : howsmall + random(howbig - howsmall); }
+void randomSeed(unsigned long seed)      { srand((unsigned)seed); }
+
+// -------------------------------------------------------------------
+// Print
+// -------------------------------------------------------------------
+size_t Print::print(long v, int base) {
+    char s[24];
+    snprintf(s, sizeof(s), base == HEX ? "%lx" : "%ld", v);
+    return _text(s);
+}
+
+size_t Print::print(unsigned long v, int base) {
+    char s[24];
+    snprintf(s, sizeof(s), base == HEX ? "%lx" : "%lu", v);
+    return _text(s);
+}
+
+size_t Print::print(double v, int digits) {
+    char s[40];
+    snprintf(s, sizeof(s), "%.*f", digits, v);
+    return _text(s);
+}
+
+// -------------------------------------------------------------------
+// Serial. Only the global Serial is wired to the host queues; Serial1 /
+// Serial2 (bus servos) swallow writes and never have input.
+// -------------------------------------------------------------------
+static std::vector<uint8_t> _rx;
+static size_t               _rxPos   = 0;
+static size_t               _txCount = 0;
+static bool                 _echo    = false;
+static int                  _txRoom  = 4096;
+static void (*_tap)(const uint8_t*, size_t) = nullptr;
+static unsigned long        _baud    = 0;
+static size_t               _wireFifo = 0;     // 0 = no line model
+static double               _wireDone = 0;     // micros() when what's written is on the wire
+
+static double _usPerByte() { return _baud ? 10e6 / _baud : 0; }
+
+// Bytes written but not yet out.
+static double _wireQueued() {
+    const double left = _wireDone - (double)micros();
+    return left > 0 ? left / _usPerByte() : 0;
+}
+
+// n bytes into the line; waits (on the frozen clock) for the FIFO to
+// take them, as a blocking write does.
+static void _wireWrite(size_t n) {
+    if (!_wireFifo || !_baud) return;
+    const double now = (double)micros();
+    _wireDone = (_wireDone > now ? _wireDone : now) + n * _usPerByte();
+    const double fits = _wireDone - _wireFifo * _usPerByte();
+    if (fits > now) hostSetMicros((unsigned long)fits);
+}
+
+void HardwareSerial::begin(unsigned long baud) {
+    if (this == &Serial) _baud = baud;
+}
+
+void HardwareSerial::flush() {
+    if (this == &Serial && _wireFifo && _wireDone > (double)micros())
+        hostSetMicros((unsigned long)(_wireDone + 0.5));
+}
+
+int HardwareSerial::available() {
+    return this == &Serial ? (int)(_rx.size() - _rxPos) : 0;
+}
+
+int HardwareSerial::read() {
+    if (this != &Serial || _rxPos >= _rx.size()) return -1;
+    int c = _rx[_rxPos++];
+    if (_rxPos == _rx.size()) { _rx.clear(); _rxPos = 0; }
+    return c;
+}
+
+int HardwareSerial::peek() {
+    return (this == &Serial && _rxPos < _rx.size()) ? _rx[_rxPos] : -1;
+}
+
+size_t HardwareSerial::readBytes(uint8_t* buf, size_t n) {
+    size_t got = 0;
+    while (got < n) {
+        int c = read();
+        if (c < 0) break;
+        buf[got++] = (uint8_t)c;
+    }
+    return got;
+}
+
+int HardwareSerial::availableForWrite() {
+    if (this != &Serial) return 4096;
+    if (_wireFifo && _baud) return (int)(_wireFifo - _wireQueued());
+    return _txRoom;
+}
+
+size_t HardwareSerial::write(uint8_t b) {
+    return write(&b, 1);
+}
+
+size_t HardwareSerial::write(const uint8_t* buf, size_t n) {
+    if (this == &Serial) {
+        _txCount += n;
+        if (_tap) _tap(buf, n);
+        _wireWrite(n);
+    }
+    return n;
+}
+
+size_t HardwareSerial::_text(const char* s) {
+    size_t n = strlen(s);
+    if (this == &Serial) {
+        _txCount += n;
+        if (_tap)  _tap(reinterpret_cast<const uint8_t*>(s), n);
+        if (_echo) fputs(s, stdout);
+        _wireWrite(n);
+    }
+    return n;
+}
+
+void hostSerialInject(const uint8_t* data, size_t len) { _rx.insert(_rx.end(), data, data + len); }
+size_t hostSerialTxCount()                             { return _txCount; }
+void hostSerialEcho(bool on)                           { _echo = on; }
+void hostSerialWriteRoom(int room)                     { _txRoom = room; }
+void hostSerialTap(void (*fn)(const uint8_t*, size_t)) { _tap = fn; }
+unsigned long hostSerialBaud()                         { return _baud; }
+void hostSerialWire(size_t fifo)                       { _wireFifo = fifo; _wireDone = 0; }
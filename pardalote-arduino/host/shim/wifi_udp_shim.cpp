@@ -0,0 +1,72 @@
+// ==============================================================
+// host/shim/wifi_udp_shim.cpp
+// WiFiUDP on a POSIX socket. See WiFiUdp.h.
+// ==============================================================
+
+#include "WiFiUdp.h"
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+uint8_t WiFiUDP::begin(uint16_t port) {
+    stop();
+    _fd = ::socket(AF_INET, SOCK_DGRAM, 0);
+    if (_fd < 0) return 0;
+    sockaddr_in a = {};
+    a.sin_family      = AF_INET;
+    a.sin_addr.s_addr = htonl(INADDR_ANY);
+    a.sin_port        = htons(port);
+    if (::bind(_fd, (sockaddr*)&a, sizeof a) < 0) { stop(); return 0; }
+    ::fcntl(_fd, F_SETFL, ::fcntl(_fd, F_GETFL) | O_NONBLOCK);
+    return 1;
+}
+
+void WiFiUDP::stop() {
+    if (_fd >= 0) ::close(_fd);
+    _fd = -1;
+}
+
+int WiFiUDP::beginPacket(IPAddress ip, uint16_t port) {
+    if (_fd < 0) return 0;
+    _to     = ip;
+    _toPort = port;
+    _outLen = 0;
+    return 1;
+}
+
+size_t WiFiUDP::write(const uint8_t* data, size_t len) {
+    if (len > sizeof _out - _outLen) len = sizeof _out - _outLen;
+    memcpy(_out + _outLen, data, len);
+    _outLen += len;
+    return len;
+}
+
+int WiFiUDP::endPacket() {
+    sockaddr_in a = {};
+    a.sin_family      = AF_INET;
+    a.sin_addr.s_addr = (uint32_t)_to;
+    a.sin_port        = htons(_toPort);
+    return ::sendto(_fd, _out, _outLen, 0, (sockaddr*)&a, sizeof a) == (ssize_t)_outLen;
+}
+
+int WiFiUDP::parsePacket() {
+    if (_fd < 0) return 0;
+    sockaddr_in a = {};
+    socklen_t   n = sizeof a;
+    const ssize_t got = ::recvfrom(_fd, _in, sizeof _in, 0, (sockaddr*)&a, &n);
+    if (got <= 0) return 0;
+    _inLen    = (size_t)got;
+    _inPos    = 0;
+    _from     = IPAddress((uint32_t)a.sin_addr.s_addr);
+    _fromPort = ntohs(a.sin_port);
+    return (int)got;
+}
+
+int WiFiUDP::read(uint8_t* buf, size_t len) {
+    if (len > _inLen - _inPos) len = _inLen - _inPos;
+    memcpy(buf, _in + _inPos, len);
+    _inPos += len;
+    return (int)len;
+}
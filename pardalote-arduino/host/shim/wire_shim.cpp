@@ -0,0 +1,8 @@
+// ==============================================================
+// host/shim/wire_shim.cpp
+// The global Wire instance for the host build.
+// ==============================================================
+
+#include "Wire.h"
+
+TwoWire Wire;
@@ -0,0 +1,140 @@
+// ==============================================================
+// host/virtual_board/main.cpp
+// A Pardalote board with no hardware: the whole core on Linux/macOS,
+// serving the real WebSocket protocol on localhost.
+// Part of Pardalote — version in library.properties
+// by Scott Mitchell
+// GPL-3.0-or-later License
+//
+//   pardalote_virtual_board [--port 8081] [--bind 127.0.0.1]
+//                           [--idle-us 200 | --spin] [--datagrams [port]]
+//                           [--trace] [--stats]
+//
+// pardalote.js connects as it would to a board:
+//
+//   arduino.connect('localhost', { port: 8081 });
+//
+// It is the sketch every example would be if they were one: the
+// servo, stepper and NeoPixel extensions are linked in (the shim's
+// Servo, AccelStepper and Adafruit_NeoPixel stand in for the devices),
+// the message channel echoes and publishes, and a few pins move on
+// their own so a page has something to read:
+//
+//   SIM_POT_FIRST..+3  analog, sine waves of different periods (0..1023)
+//   SIM_BUTTON         digital, toggles every SIM_BUTTON_MS — an edge,
+//                      so READ_EDGES watches see it too
+//   "echo"             message key — sent straight back to every client
+//   "uptime"           retained message, seconds, once a second
+//
+// Any other pin reads back what was last written to it.
+//
+// Between run() passes the board waits up to --idle-us for a socket to
+// become ready, so an idle board costs nothing; a pass still comes at
+// least that often for servo interpolation and stepper pulses. --spin
+// never waits — the fastest turnaround, one core flat out, for
+// throughput runs.
+// ==============================================================
+
+// Standard headers first — the shim's Arduino.h defines min/max.
+#include <cmath>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include <Pardalote.h>
+#include <PardaloteServo.h>
+#include <PardaloteStepper.h>
+#include <PardaloteNeoPixel.h>
+#include "ws_server.h"
+
+static constexpr uint8_t       SIM_POT_FIRST = 32;
+static constexpr uint8_t       SIM_BUTTON    = 4;
+static constexpr unsigned long SIM_BUTTON_MS = 500;
+
+static volatile sig_atomic_t stopping = 0;
+static void onSignal(int) { stopping = 1; }
+
+static void simulateInputs(unsigned long nowMs) {
+    for (uint8_t i = 0; i < 4; i++) {
+        const double period = 2000.0 * (i + 1);
+        const double phase  = 2.0 * M_PI * (double)(nowMs % (unsigned long)period) / period;
+        hostSetPin(SIM_POT_FIRST + i, (int)lround(511.5 + 511.5 * sin(phase)));
+    }
+    hostSetPin(SIM_BUTTON, (nowMs / SIM_BUTTON_MS) & 1);
+}
+
+static void onEcho(const Message& m) {
+    switch (m.type) {
+        case MSG_TYPE_INT:   Pardalote.send("echo", m.asInt());   break;
+        case MSG_TYPE_BOOL:  Pardalote.send("echo", m.asBool());  break;
+        case MSG_TYPE_FLOAT: Pardalote.send("echo", (double)m.asFloat()); break;
+        case MSG_TYPE_CHAR:  Pardalote.send("echo", m.asChar());  break;
+        case MSG_TYPE_TEXT:  Pardalote.send("echo", m.text);      break;
+        case MSG_TYPE_BLOB:  Pardalote.sendBlob("echo", m.blob, m.length); break;
+    }
+}
+
+static void onTrace(const FrameEvent& e) {
+    printf("%s %-18s target 0x%04X  %u params\n",
+           e.dir == PARDALOTE_FRAME_IN ? "<-" : "->",
+           e.name ? e.name : "?", e.target, e.nparams);
+}
+
+static void usage(const char* argv0) {
+    fprintf(stderr,
+        "usage: %s [--port N] [--bind ADDR] [--idle-us N | --spin]\n"
+        "          [--datagrams [PORT]] [--trace] [--stats]\n", argv0);
+}
+
+int main(int argc, char** argv) {
+    uint16_t    port      = 8081;
+    const char* address   = "127.0.0.1";
+    uint32_t    idleUs    = 200;
+    long        datagram  = -1;   // -1 = no lane
+    bool        trace     = false;
+    bool        stats     = false;
+
+    for (int i = 1; i < argc; i++) {
+        const char* a = argv[i];
+        const bool  more = i + 1 < argc && argv[i + 1][0] != '-';
+        if      (!strcmp(a, "--port") && more)    port    = (uint16_t)atoi(argv[++i]);
+        else if (!strcmp(a, "--bind") && more)    address = argv[++i];
+        else if (!strcmp(a, "--idle-us") && more) idleUs  = (uint32_t)atol(argv[++i]);
+        else if (!strcmp(a, "--spin"))            idleUs  = 0;
+        else if (!strcmp(a, "--datagrams"))       datagram = more ? atol(argv[++i]) : PARDALOTE_DATAGRAM_PORT;
+        else if (!strcmp(a, "--trace"))           trace   = true;
+        else if (!strcmp(a, "--stats"))           stats   = true;
+        else if (!strcmp(a, "--help"))            { usage(argv[0]); return 0; }
+        else { usage(argv[0]); return 2; }
+    }
+
+    signal(SIGINT,  onSignal);
+    signal(SIGTERM, onSignal);
+    setvbuf(stdout, nullptr, _IOLBF, 0);
+    hostSerialEcho(true);
+
+    static HostWsServer server(address, port);
+    if (datagram >= 0) Pardalote.datagrams((uint16_t)datagram);
+    Pardalote.watch("echo", onEcho);
+    if (trace) Pardalote.onFrame(onTrace);
+    Pardalote.begin(server);
+    if (!server.listening()) return 1;
+    printf("Virtual board on ws://%s:%u/\n", address, port);
+
+    unsigned long lastTick = millis();
+    while (!stopping) {
+        simulateInputs(millis());
+        Pardalote.run();
+        if (millis() - lastTick >= 1000) {
+            lastTick += 1000;
+            Pardalote.send("uptime", (int)(millis() / 1000), MSG_FLAG_RETAIN);
+        }
+        if (idleUs) server.wait(idleUs);
+    }
+
+    if (stats) Pardalote.printStats();
+    server.end();
+    return 0;
+}
@@ -0,0 +1,393 @@
+// ==============================================================
+// host/virtual_board/ws_server.cpp
+// Host WebSocket server. See ws_server.h.
+// ==============================================================
+
+// Standard and POSIX headers first — Arduino.h defines min/max as macros.
+#include <arpa/inet.h>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <string>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "ws_server.h"
+
+// Bytes of an HTTP upgrade request before the client is dropped.
+static constexpr size_t HANDSHAKE_MAX = 4096;
+
+static constexpr uint8_t OP_CONTINUATION = 0x0;
+static constexpr uint8_t OP_TEXT         = 0x1;
+static constexpr uint8_t OP_BINARY       = 0x2;
+static constexpr uint8_t OP_CLOSE        = 0x8;
+static constexpr uint8_t OP_PING         = 0x9;
+static constexpr uint8_t OP_PONG         = 0xA;
+
+// -------------------------------------------------------------------
+// Sec-WebSocket-Accept: base64(SHA-1(key + GUID))
+// -------------------------------------------------------------------
+static void sha1(const uint8_t* data, size_t len, uint8_t out[20]) {
+    uint32_t h[5] = { 0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476, 0xC3D2E1F0 };
+    auto rol = [](uint32_t x, int n) { return (x << n) | (x >> (32 - n)); };
+
+    std::string m((const char*)data, len);
+    m += (char)0x80;
+    while (m.size() % 64 != 56) m += (char)0;
+    const uint64_t bits = (uint64_t)len * 8;
+    for (int i = 7; i >= 0; i--) m += (char)(bits >> (i * 8));
+
+    for (size_t off = 0; off < m.size(); off += 64) {
+        uint32_t w[80];
+        for (int i = 0; i < 16; i++) {
+            const uint8_t* p = (const uint8_t*)m.data() + off + i * 4;
+            w[i] = (uint32_t)p[0] << 24 | (uint32_t)p[1] << 16 | (uint32_t)p[2] << 8 | p[3];
+        }
+        for (int i = 16; i < 80; i++) w[i] = rol(w[i-3] ^ w[i-8] ^ w[i-14] ^ w[i-16], 1);
+        uint32_t a = h[0], b = h[1], c = h[2], d = h[3], e = h[4];
+        for (int i = 0; i < 80; i++) {
+            uint32_t f, k;
+            if      (i < 20) { f = (b & c) | (~b & d);          k = 0x5A827999; }
+            else if (i < 40) { f = b ^ c ^ d;                   k = 0x6ED9EBA1; }
+            else if (i < 60) { f = (b & c) | (b & d) | (c & d); k = 0x8F1BBCDC; }
+            else             { f = b ^ c ^ d;                   k = 0xCA62C1D6; }
+            const uint32_t t = rol(a, 5) + f + e + k + w[i];
+            e = d; d = c; c = rol(b, 30); b = a; a = t;
+        }
+        h[0] += a; h[1] += b; h[2] += c; h[3] += d; h[4] += e;
+    }
+    for (int i = 0; i < 20; i++) out[i] = (uint8_t)(h[i / 4] >> (24 - (i % 4) * 8));
+}
+
+static std::string base64(const uint8_t* data, size_t len) {
+    static const char* abc = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    std::string s;
+    for (size_t i = 0; i < len; i += 3) {
+        const uint32_t n = (uint32_t)data[i] << 16
+                         | (i + 1 < len ? (uint32_t)data[i + 1] << 8 : 0)
+                         | (i + 2 < len ? (uint32_t)data[i + 2] : 0);
+        s += abc[(n >> 18) & 63];
+        s += abc[(n >> 12) & 63];
+        s += i + 1 < len ? abc[(n >> 6) & 63] : '=';
+        s += i + 2 < len ? abc[n & 63] : '=';
+    }
+    return s;
+}
+
+// Value of header `name` (case-insensitive) in an HTTP request, or "".
+static std::string header(const std::string& req, const char* name) {
+    const size_t n = strlen(name);
+    size_t pos = req.find("\r\n");
+    while (pos != std::string::npos) {
+        pos += 2;
+        const size_t eol = req.find("\r\n", pos);
+        if (eol == std::string::npos || eol == pos) break;
+        if (eol - pos > n && req[pos + n] == ':' && strncasecmp(req.c_str() + pos, name, n) == 0) {
+            size_t v = pos + n + 1;
+            while (v < eol && req[v] == ' ') v++;
+            size_t e = eol;
+            while (e > v && req[e - 1] == ' ') e--;
+            return req.substr(v, e - v);
+        }
+        pos = eol;
+    }
+    return "";
+}
+
+// -------------------------------------------------------------------
+// PardaloteTransport
+// -------------------------------------------------------------------
+void HostWsServer::begin(const PardaloteTransportSinks& sinks) {
+    _sinks = sinks;
+    _listenFd = socket(AF_INET, SOCK_STREAM, 0);
+    if (_listenFd < 0) return;
+    const int one = 1;
+    setsockopt(_listenFd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof one);
+
+    sockaddr_in a = {};
+    a.sin_family = AF_INET;
+    a.sin_port   = htons(_port);
+    if (inet_pton(AF_INET, _address, &a.sin_addr) != 1
+        || bind(_listenFd, (sockaddr*)&a, sizeof a) < 0
+        || listen(_listenFd, 16) < 0) {
+        fprintf(stderr, "virtual board: can't listen on %s:%u (%s)\n", _address, _port, strerror(errno));
+        ::close(_listenFd);
+        _listenFd = -1;
+        return;
+    }
+    fcntl(_listenFd, F_SETFL, O_NONBLOCK);
+}
+
+void HostWsServer::end() {
+    for (uint8_t c = 0; c < PARDALOTE_MAX_CLIENTS; c++) _close(c, false);
+    if (_listenFd >= 0) ::close(_listenFd);
+    _listenFd = -1;
+    _sinks = PardaloteTransportSinks();
+}
+
+void HostWsServer::wait(uint32_t us) {
+    // select() rather than poll(): it takes microseconds.
+    fd_set rd, wr;
+    FD_ZERO(&rd);
+    FD_ZERO(&wr);
+    int top = -1;
+    if (_listenFd >= 0) { FD_SET(_listenFd, &rd); top = _listenFd; }
+    for (const Client& cl : _clients) {
+        if (cl.fd < 0) continue;
+        FD_SET(cl.fd, &rd);
+        if (cl.out.size() > cl.outPos) FD_SET(cl.fd, &wr);
+        if (cl.fd > top) top = cl.fd;
+    }
+    timeval tv = { (time_t)(us / 1000000), (suseconds_t)(us % 1000000) };
+    select(top + 1, &rd, &wr, nullptr, &tv);
+}
+
+void HostWsServer::loop(unsigned long now) {
+    if (_listenFd < 0) return;
+    _accept(now);
+    for (uint8_t c = 0; c < PARDALOTE_MAX_CLIENTS; c++) {
+        if (_clients[c].fd < 0) continue;
+        if (_clients[c].state == HANDSHAKE && now - _clients[c].acceptedMs > HOST_WS_HANDSHAKE_MS) {
+            _close(c, false);
+            continue;
+        }
+        _flush(c);
+        if (_clients[c].fd >= 0) _read(c);
+    }
+}
+
+bool HostWsServer::send(uint8_t client, const uint8_t* data, size_t len) {
+    if (client >= PARDALOTE_MAX_CLIENTS || _clients[client].state != OPEN) return false;
+    if (len + 10 > capacity(client)) {
+        // A reader that far behind is gone in all but name — as on the
+        // board, where a full TCP send buffer ends the connection.
+        _close(client, true);
+        return false;
+    }
+    _queue(client, OP_BINARY, data, len);
+    _flush(client);
+    return true;
+}
+
+void HostWsServer::disconnect(uint8_t client) {
+    if (client >= PARDALOTE_MAX_CLIENTS || _clients[client].state == FREE) return;
+    if (_clients[client].state == OPEN) {
+        _queue(client, OP_CLOSE, nullptr, 0);
+        _flush(client);
+    }
+    _close(client, true);
+}
+
+size_t HostWsServer::capacity(uint8_t client) const {
+    if (client >= PARDALOTE_MAX_CLIENTS || _clients[client].state != OPEN) return 0;
+    const size_t queued = _clients[client].out.size() - _clients[client].outPos;
+    return queued < HOST_WS_TX_QUEUE ? HOST_WS_TX_QUEUE - queued : 0;
+}
+
+// -------------------------------------------------------------------
+// Sockets
+// -------------------------------------------------------------------
+void HostWsServer::_accept(unsigned long now) {
+    for (;;) {
+        const int fd = accept(_listenFd, nullptr, nullptr);
+        if (fd < 0) return;
+        fcntl(fd, F_SETFL, O_NONBLOCK);
+        const int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof one);
+
+        uint8_t c = 0;
+        while (c < PARDALOTE_MAX_CLIENTS && _clients[c].fd >= 0) c++;
+        if (c == PARDALOTE_MAX_CLIENTS) {
+            static const char busy[] = "HTTP/1.1 503 Service Unavailable\r\nContent-Length: 0\r\n\r\n";
+            (void)!::write(fd, busy, sizeof busy - 1);
+            ::close(fd);
+            continue;
+        }
+        Client& cl = _clients[c];
+        cl = Client();
+        cl.fd    = fd;
+        cl.state = HANDSHAKE;
+        cl.acceptedMs = now;
+    }
+}
+
+void HostWsServer::_read(uint8_t c) {
+    Client& cl = _clients[c];
+    uint8_t buf[16384];
+    for (;;) {
+        const ssize_t n = ::read(cl.fd, buf, sizeof buf);
+        if (n == 0 || (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)) {
+            _close(c, true);
+            return;
+        }
+        if (n < 0) break;
+        cl.in.insert(cl.in.end(), buf, buf + n);
+        if ((size_t)n < sizeof buf) break;
+    }
+    if (cl.state == HANDSHAKE && !_handshake(c)) return;
+    if (cl.state == OPEN) _frames(c);
+}
+
+bool HostWsServer::_handshake(uint8_t c) {
+    Client& cl = _clients[c];
+    const std::string req(cl.in.begin(), cl.in.end());
+    const size_t end = req.find("\r\n\r\n");
+    if (end == std::string::npos) {
+        if (req.size() > HANDSHAKE_MAX) _close(c, false);
+        return false;
+    }
+    const std::string key = header(req, "Sec-WebSocket-Key");
+    if (req.compare(0, 4, "GET ") != 0 || key.empty()) {
+        static const char bad[] = "HTTP/1.1 400 Bad Request\r\nContent-Length: 0\r\n\r\n";
+        (void)!::write(cl.fd, bad, sizeof bad - 1);
+        _close(c, false);
+        return false;
+    }
+
+    const std::string k = key + "258EAFA5-E914-47DA-95CA-C5AB0DC85B11";
+    uint8_t digest[20];
+    sha1((const uint8_t*)k.data(), k.size(), digest);
+    const std::string reply =
+        "HTTP/1.1 101 Switching Protocols\r\n"
+        "Upgrade: websocket\r\n"
+        "Connection: Upgrade\r\n"
+        "Sec-WebSocket-Accept: " + base64(digest, sizeof digest) + "\r\n\r\n";
+    cl.out.insert(cl.out.end(), reply.begin(), reply.end());
+    cl.in.erase(cl.in.begin(), cl.in.begin() + end + 4);
+    cl.state = OPEN;
+    _flush(c);
+    if (cl.state != OPEN) return false;
+    _emitConnect(c);
+    return _clients[c].state == OPEN;   // the sink may have dropped it
+}
+
+bool HostWsServer::_frames(uint8_t c) {
+    size_t pos = 0;
+    for (;;) {
+        Client& cl = _clients[c];
+        const uint8_t* p = cl.in.data() + pos;
+        const size_t avail = cl.in.size() - pos;
+        if (avail < 2) break;
+
+        const bool    fin    = p[0] & 0x80;
+        const uint8_t opcode = p[0] & 0x0F;
+        const bool    masked = p[1] & 0x80;
+        uint64_t len = p[1] & 0x7F;
+        size_t   hdr = 2;
+        if (len == 126) {
+            if (avail < 4) break;
+            len = (uint64_t)p[2] << 8 | p[3];
+            hdr = 4;
+        } else if (len == 127) {
+            if (avail < 10) break;
+            len = 0;
+            for (int i = 0; i < 8; i++) len = len << 8 | p[2 + i];
+            hdr = 10;
+        }
+        // Clients must mask (RFC 6455 §5.1); an oversized message is a
+        // client we can't serve.
+        if (!masked || len > HOST_WS_MAX_MESSAGE || cl.message.size() + len > HOST_WS_MAX_MESSAGE) {
+            _close(c, true);
+            return false;
+        }
+        if (avail < hdr + 4 + len) break;
+
+        const uint8_t* mask = p + hdr;
+        uint8_t* payload = cl.in.data() + pos + hdr + 4;
+        for (uint64_t i = 0; i < len; i++) payload[i] ^= mask[i & 3];
+        pos += hdr + 4 + len;
+
+        switch (opcode) {
+            case OP_CLOSE:
+                _queue(c, OP_CLOSE, payload, len >= 2 ? 2 : 0);   // echo the status code
+                _flush(c);
+                _close(c, true);
+                return false;
+            case OP_PING:
+                _queue(c, OP_PONG, payload, len);
+                break;
+            case OP_PONG:
+                break;
+            case OP_TEXT:
+            case OP_BINARY:
+            case OP_CONTINUATION:
+                // Text is answered on the board by nothing, so it is
+                // dropped here too — but only once the message is whole.
+                if (opcode != OP_CONTINUATION) {
+                    cl.message.clear();
+                    cl.message.push_back(opcode);
+                } else if (cl.message.empty()) {
+                    _close(c, true);   // continuation with nothing to continue
+                    return false;
+                }
+                cl.message.insert(cl.message.end(), payload, payload + len);
+                if (fin) {
+                    std::vector<uint8_t> msg;
+                    msg.swap(cl.message);
+                    if (msg[0] == OP_BINARY && msg.size() > 1) {
+                        _emitMessage(c, msg.data() + 1, msg.size() - 1);
+                        if (_clients[c].state != OPEN) return false;
+                    }
+                }
+                break;
+            default:
+                _close(c, true);
+                return false;
+        }
+    }
+    Client& cl = _clients[c];
+    cl.in.erase(cl.in.begin(), cl.in.begin() + pos);
+    _flush(c);
+    return _clients[c].state == OPEN;
+}
+
+void HostWsServer::_queue(uint8_t c, uint8_t opcode, const uint8_t* data, size_t len) {
+    std::vector<uint8_t>& out = _clients[c].out;
+    out.push_back(0x80 | opcode);
+    if (len < 126) {
+        out.push_back((uint8_t)len);
+    } else if (len <= 0xFFFF) {
+        out.push_back(126);
+        out.push_back((uint8_t)(len >> 8));
+        out.push_back((uint8_t)len);
+    } else {
+        out.push_back(127);
+        for (int i = 7; i >= 0; i--) out.push_back((uint8_t)((uint64_t)len >> (i * 8)));
+    }
+    if (len) out.insert(out.end(), data, data + len);
+}
+
+void HostWsServer::_flush(uint8_t c) {
+    Client& cl = _clients[c];
+    while (cl.fd >= 0 && cl.outPos < cl.out.size()) {
+        const ssize_t n = ::send(cl.fd, cl.out.data() + cl.outPos, cl.out.size() - cl.outPos, MSG_NOSIGNAL);
+        if (n < 0) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) break;
+            _close(c, true);
+            return;
+        }
+        cl.outPos += (size_t)n;
+    }
+    if (cl.outPos == cl.out.size()) {
+        cl.out.clear();
+        cl.outPos = 0;
+    } else if (cl.outPos > 64 * 1024) {
+        cl.out.erase(cl.out.begin(), cl.out.begin() + cl.outPos);
+        cl.outPos = 0;
+    }
+}
+
+// `notify`: report it to the core — only a client that got as far as
+// the connect sink has anything to report.
+void HostWsServer::_close(uint8_t c, bool notify) {
+    Client& cl = _clients[c];
+    if (cl.fd < 0) return;
+    const bool wasOpen = cl.state == OPEN;
+    ::close(cl.fd);
+    cl = Client();
+    if (notify && wasOpen) _emitDisconnect(c);
+}
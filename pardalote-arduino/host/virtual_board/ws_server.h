@@ -0,0 +1,88 @@
+// ==============================================================
+// host/virtual_board/ws_server.h
+// A WebSocket server on a POSIX socket — the virtual board's
+// stand-in for WebSocketsServer, as a PardaloteTransport.
+// Part of Pardalote — version in library.properties
+// by Scott Mitchell
+// GPL-3.0-or-later License
+//
+// Enough of RFC 6455 for pardalote.js and any other client: the HTTP
+// upgrade, masked client frames, continuation, ping/pong and close.
+// Each WebSocket is a client slot, 0..PARDALOTE_MAX_CLIENTS-1; a
+// connection beyond that is refused with 503.
+//
+// Nothing blocks. loop() accepts, reads and writes whatever the
+// sockets have ready. send() queues behind what the socket hasn't
+// taken yet, and capacity() reports the room left in that queue, so
+// a slow reader backs up its periodic readings on the core side the
+// same way the serial TX ring does.
+// ==============================================================
+
+#pragma once
+
+#include <vector>   // before Arduino.h, which defines min/max
+#include <Arduino.h>
+#include "internal/defs.h"
+#include "internal/transport.h"
+
+// Bytes queued per client before send() starts refusing. A message
+// that doesn't fit is dropped, and the client with it.
+#ifndef HOST_WS_TX_QUEUE
+  #define HOST_WS_TX_QUEUE (256 * 1024)
+#endif
+
+// A connection that hasn't finished its upgrade request by then is
+// dropped, so sockets left half-open can't hold every slot.
+#ifndef HOST_WS_HANDSHAKE_MS
+  #define HOST_WS_HANDSHAKE_MS 2000
+#endif
+
+// Largest message a client may send.
+#ifndef HOST_WS_MAX_MESSAGE
+  #define HOST_WS_MAX_MESSAGE (64 * 1024)
+#endif
+
+class HostWsServer : public PardaloteTransport {
+public:
+    // `address` is the local address to bind — "127.0.0.1" keeps the
+    // board to this machine, "0.0.0.0" opens it to the network.
+    HostWsServer(const char* address, uint16_t port) : _address(address), _port(port) {}
+
+    bool listening() const { return _listenFd >= 0; }
+
+    // Blocks until a socket is ready or `us` have passed — the idle
+    // wait between run() passes.
+    void wait(uint32_t us);
+
+    void   begin(const PardaloteTransportSinks& sinks) override;
+    void   end() override;
+    void   loop(unsigned long now) override;
+    bool   send(uint8_t client, const uint8_t* data, size_t len) override;
+    void   disconnect(uint8_t client) override;
+    size_t capacity(uint8_t client) const override;
+
+private:
+    enum State : uint8_t { FREE, HANDSHAKE, OPEN };
+    struct Client {
+        int                  fd    = -1;
+        State                state = FREE;
+        std::vector<uint8_t> in;        // bytes read, not yet parsed
+        std::vector<uint8_t> message;   // a fragmented message so far
+        std::vector<uint8_t> out;       // bytes queued, not yet written
+        size_t               outPos = 0;
+        unsigned long        acceptedMs = 0;
+    };
+
+    void _accept(unsigned long now);
+    void _read(uint8_t c);
+    bool _handshake(uint8_t c);   // false until the request is complete
+    bool _frames(uint8_t c);      // false once the client is gone
+    void _queue(uint8_t c, uint8_t opcode, const uint8_t* data, size_t len);
+    void _flush(uint8_t c);
+    void _close(uint8_t c, bool notify);
+
+    const char* _address;
+    uint16_t    _port;
+    int         _listenFd = -1;
+    Client      _clients[PARDALOTE_MAX_CLIENTS];
+};
@@ -5,6 +5,8 @@
 
 #include "Pardalote.h"
 #include "internal/led_matrix.h"
+#include "internal/edge_watch.h"
+#include "internal/analog_stream.h"
 
 #ifdef PLATFORM_ESP32
 #include <esp_system.h>   // esp_random() — hardware RNG for the boot id
@@ -19,7 +21,10 @@ PardaloteClass Pardalote;
 // Constructor
 // -------------------------------------------------------------------
 PardaloteClass::PardaloteClass() {
-    for (int i = 0; i < NUM_ACTIONS; i++) _actions[i].id = -1;
+    for (int i = 0; i < NUM_ACTIONS; i++) {
+        _actions[i].id       = -1;
+        _actions[i].edgeSlot = -1;
+    }
     memset(_corePinModes,  0xFF, sizeof(_corePinModes));
     memset(_corePinValues, 0,    sizeof(_corePinValues));
 }
@@ -44,6 +49,13 @@ void PardaloteClass::begin() {
 #endif
 }
 
+void PardaloteClass::begin(PardaloteTransport& transport) {
+    _begun = true;
+    _beginCommon();
+    _attach(transport);
+    _startDatagrams();
+}
+
 void PardaloteClass::begin(int transport) {
     if (transport == PARDALOTE_SERIAL) { _beginSerial(); return; }
 #ifdef PARDALOTE_NO_WIFI
@@ -75,7 +87,9 @@ void PardaloteClass::requireKey(const char* key) {
 
 // Shared by both transports: Serial console + boot id.
 void PardaloteClass::_beginCommon() {
-    Serial.begin(115200);
+    Serial.begin(PARDALOTE_SERIAL_BAUD);
+    _rxQueue.begin(_rxRing, PARDALOTE_RX_QUEUE);
+    _rxPos = 0;
 
     // Boot id — random 31-bit token, new every boot, sent in HELLO so the
     // browser can tell "board rebooted" from "network blip". Masked to 31
@@ -94,8 +108,15 @@ void PardaloteClass::_beginCommon() {
 #endif
     if (_bootId == 0) _bootId = 1;   // 0 is reserved as "unknown" JS-side
 
+    Stats::begin();
+
     Serial.print(F("Board: "));
     Serial.println(F(PARDALOTE_BOARD));
+    if (extensionsDropped()) {
+        Serial.print(F("[Pardalote] Extension registry full — "));
+        Serial.print(extensionsDropped());
+        Serial.println(F(" extension(s) not installed (raise MAX_EXTENSIONS)"));
+    }
 }
 
 // Emit one CMD_REBOOT frame over serial, once per boot (guarded so the
@@ -113,10 +134,9 @@ void PardaloteClass::_announceReboot() {
 
 #ifndef PARDALOTE_NO_WIFI
 void PardaloteClass::_beginWifi() {
-    _transport = TRANSPORT_WIFI;
     _begun = true;
 
-    Serial.begin(115200);
+    Serial.begin(PARDALOTE_SERIAL_BAUD);
     _announceReboot();   // tell a browser still holding the port that we rebooted
 
     // Boot-watch: arm the USB listen so the config window can catch a takeover
@@ -167,9 +187,9 @@ void PardaloteClass::_beginWifi() {
     Serial.print(F("IP: "));
     Serial.println(WiFi.localIP());
 
-    _ws.begin();
-    _ws.onEvent(_wsEventTrampoline);
-    Serial.println(F("WebSocket server started on port 81"));
+    _wsT.setSplitCores(_splitCores);
+    _attach(_wsT);
+    _startDatagrams();
 
 #ifdef PLATFORM_ESP32
     WiFi.setSleep(false);   // disable modem sleep — prevents latency on incoming frames
@@ -187,16 +207,13 @@ void PardaloteClass::_beginWifi() {
 #endif   // PARDALOTE_NO_WIFI
 
 void PardaloteClass::_beginSerial() {
-    _transport = TRANSPORT_SERIAL;
     _begun = true;
     _beginCommon();
     _announceReboot();   // no-op if _beginWifi already announced (boot-takeover path)
     // No _platformInit(): the UNO R4 LED matrix scroll exists to show the
     // IP address — there is no IP here, and the rebuild work it does per
     // loop() is exactly what the R4's WebSocket lesson taught us to avoid.
-    _serialT.begin(_serialMessageTrampoline,
-                   _serialConnectTrampoline,
-                   _serialDisconnectTrampoline);
+    _attach(_serialT);
     if (_keyRequired) Serial.println(F("Connection key required"));
     Serial.println(F("Serial transport ready — connect with arduino.connectSerial()"));
 }
@@ -205,22 +222,68 @@ void PardaloteClass::_beginSerial() {
 // run() — called from loop()
 // -------------------------------------------------------------------
 void PardaloteClass::run() {
-    if (_transport == TRANSPORT_SERIAL) {
-        _serialT.loop(millis());
-    } else {
+    // Everything the pass sends is batched per client and goes out as one
+    // transport message at the end — see _txBuf in Pardalote.h.
+    Stats::passStart();
+    _batching = true;
+    _runPass();
+    _batching = false;
+    const uint32_t t = Stats::ticks();
+    for (int c = 0; c < MAX_WS_CLIENTS; c++) _flushTx((uint8_t)c);
+    Stats::section(STATS_SEC_FLUSH, t);
+}
+
+// Each phase is charged to its STATS_SEC_* section as it ends.
+void PardaloteClass::_runPass() {
+    uint32_t t = Stats::ticks();
+    if (_link) _link->loop(millis());
 #ifndef PARDALOTE_NO_WIFI
-        _ws.loop();
+    if (_link == &_wsT) {
         _platformLoop();
         // Watch USB for a takeover probe (begin() default). A gesture-backed
-        // takeover here calls _switchToSerial(), flipping _transport — the
-        // next run() pass takes the serial branch above.
+        // takeover here calls _switchToSerial(), moving _link to the serial
+        // transport for the next run() pass.
         if (_serialListen) _serialT.loopListen(millis());
+    }
 #endif
+#if PARDALOTE_DATAGRAM
+    // Clients the datagram lane let go of: their telemetry is back in
+    // the WebSocket batch from this pass on.
+    const uint8_t lost = _udpLane.loop(millis());
+    for (uint8_t c = 0; lost && c < MAX_WS_CLIENTS; c++) {
+        if (!(lost & (1 << c))) continue;
+        _features[c] &= ~FEATURE_DATAGRAM;
+        if (!_clientReady(c)) continue;
+        PardaloteFrame fb(c, CMD_DATAGRAM, 0x0000);
+        fb.addInt(0);
+        fb.send();
     }
+#endif
+    for (uint8_t c = 0; c < MAX_WS_CLIENTS; c++)
+        if (_connectedClients & (1 << c)) _refreshBackedUp(c);
+    t = Stats::section(STATS_SEC_TRANSPORT, t);
+    _drainInbound(false);
+    t = Stats::section(STATS_SEC_INBOUND, t);
+    _runDueAt();   // before loopAll — a due command takes effect this pass
+    t = Stats::section(STATS_SEC_AT, t);
     loopAll();
+    t = Stats::section(STATS_SEC_EXT_LOOP, t);
 
 #ifdef PLATFORM_ESP32
-    delay(1);   // yield to FreeRTOS idle task — prevents TG0WDT watchdog reset
+    // The idle task needs a tick now and then, or the watchdog resets the
+    // board (TG0WDT) — but blocking every pass caps run() at the tick rate
+    // and delays every frame and step by up to 1 ms. Block only every
+    // PARDALOTE_YIELD_MS.
+    {
+        const uint32_t ms = millis();
+        if (ms - _lastBlockMs >= PARDALOTE_YIELD_MS) {
+            _lastBlockMs = ms;
+            delay(1);
+        } else {
+            yield();
+        }
+    }
+    t = Stats::section(STATS_SEC_YIELD, t);
 #endif
 
     if (!anyConnected()) return;
@@ -244,15 +307,23 @@ void PardaloteClass::run() {
         if (!_clientReady(c)) continue;
         if (!_pendingHello[c] || now < _helloAfter[c]) continue;
         _pendingHello[c] = false;
+        // One lane for the burst, so the seeds (telemetry, otherwise)
+        // arrive before SYNC_COMPLETE — a page's 'ready' sees them.
+        _inOrder = true;
         _sendHello(c);
         _announcePins(c);
         _seedActions(c);   // current value of every polled pin, this client only
         announceAll(c);
         _announceMessages(c);
         _sendSyncComplete(c);
+        _inOrder = false;
     }
+    t = Stats::section(STATS_SEC_CLIENTS, t);
 
     _pollActions(now);
+    t = Stats::section(STATS_SEC_PINS, t);
+    _pumpStream();
+    Stats::section(STATS_SEC_STREAM, t);
 }
 
 // -------------------------------------------------------------------
@@ -264,7 +335,8 @@ void PardaloteClass::run() {
 //   lockout swallows contact bounce; a change still pending when the
 //   lockout expires is accepted then, so both edges of even a very
 //   short tap are delivered. Edges are transmitted immediately —
-//   client intervals do not delay them.
+//   client intervals do not delay them. A READ_EDGES pin is not read
+//   here at all — its interrupt queues edges and _drainEdges sends them.
 //
 //   ANALOG — read every ANALOG_SAMPLE_MS. Clients hear about changes
 //   through their own gate: at least `interval` ms since that client's
@@ -274,11 +346,14 @@ void PardaloteClass::run() {
 //   and goes out the moment the spacing expires.
 // -------------------------------------------------------------------
 void PardaloteClass::_pollActions(unsigned long now) {
+    _drainEdges(now);
+
     for (int i = 0; i < NUM_ACTIONS; i++) {
         Action& a = _actions[i];
         if (a.id == -1) continue;
 
         if (a.cmd == CMD_DIGITAL_READ) {
+            if (a.edgeSlot >= 0) continue;   // interrupt-watched
             const int32_t val = digitalRead(a.id);
             if (val == a.lastLevel) continue;
             if (a.lastLevel != -1 && now < a.lockoutUntil) continue;  // bouncing
@@ -288,21 +363,64 @@ void PardaloteClass::_pollActions(unsigned long now) {
         } else {
             if (now - a.lastSample < ANALOG_SAMPLE_MS) continue;
             a.lastSample = now;
-            _offerToClients(a, analogRead(a.id), now, true);
+            _offerToClients(a, _analogSample(a.id), now, true);
         }
     }
 }
 
+// Interrupt-watched pins: send every edge the ISRs queued since the last
+// pass, oldest first, each with the micros() the ISR took. Two queued
+// edges with the same level mean the pin toggled faster than the ISR
+// could read it — the repeat is dropped so browsers still see levels
+// alternate. If the ring overflowed, re-read the pins so no browser is
+// left holding a stale level.
+void PardaloteClass::_drainEdges(unsigned long now) {
+    EdgeWatch::Edge e;
+    while (EdgeWatch::pop(e)) {
+        Action& a = _actions[e.tag];
+        if (a.id == -1 || a.edgeSlot < 0) continue;
+        if ((int32_t)e.level == a.lastLevel) continue;
+        a.lastLevel = e.level;
+        _offerToClients(a, e.level, now, false, e.us);
+    }
+
+    if (!EdgeWatch::overflowed()) return;
+    Serial.println(F("[Pardalote] edge ring overflowed — resyncing watched pins"));
+    for (int i = 0; i < NUM_ACTIONS; i++) {
+        Action& a = _actions[i];
+        if (a.id == -1 || a.edgeSlot < 0) continue;
+        const int32_t val = digitalRead(a.id);
+        if (val == a.lastLevel) continue;
+        a.lastLevel = val;
+        _offerToClients(a, val, now, false, micros());
+    }
+}
+
+// An analog reading for a watch or a read reply. A streamed pin belongs
+// to the continuous ADC driver — take its newest sample instead.
+int32_t PardaloteClass::_analogSample(uint8_t pin) {
+    int32_t val;
+    if (AnalogStream::latest(pin, val)) return val;
+    return analogRead(pin);
+}
+
 // Offer a fresh value to every connected client through its own gate.
 // Effective config: the client's own registration, else the sketch's
 // share() settings, else the defaults (passive client following someone
-// else's watch). `respectSpacing` = false for digital edges.
+// else's watch). `respectSpacing` = false for digital edges; `stampUs`
+// is the edge time for an interrupt-watched pin.
 void PardaloteClass::_offerToClients(Action& a, int32_t val,
-                                     unsigned long now, bool respectSpacing) {
+                                     unsigned long now, bool respectSpacing,
+                                     uint32_t stampUs) {
     for (uint8_t c = 0; c < MAX_WS_CLIENTS; c++) {
         const uint8_t bit = 1 << c;
         if (!_clientReady(c)) continue;   // connected AND authed
 
+        // A backed-up client catches up first, then gets the value of
+        // the moment. Interrupt-watched edges are timed events, not
+        // readings — those still go.
+        if (clientBackedUp(c) && a.edgeSlot < 0) continue;
+
         uint16_t interval, threshold;
         if (a.clientMask & bit) {
             interval  = a.interval[c];
@@ -322,7 +440,7 @@ void PardaloteClass::_offerToClients(Action& a, int32_t val,
             if (delta < threshold) continue;
         }
 
-        _sendReadTo(c, a.id, a.cmd, val);
+        _sendReadTo(c, a.id, a.cmd, val, a.edgeSlot >= 0, stampUs);
         a.lastSent[c]     = val;
         a.lastSendTime[c] = now;
         a.seededMask     |= bit;
@@ -342,6 +460,9 @@ void PardaloteClass::_onClientConnected(uint8_t num) {
     // client until AUTH matches.
     _authed[num] = !_keyRequired;
     _authDeadline[num] = millis() + AUTH_TIMEOUT_MS;
+    _features[num] = 0;
+    _setDatagram(num, false);
+    _clearBacklog(num);
     if (_authed[num]) {
         _pendingHello[num] = true;
         _helloAfter[num]   = millis() + HELLO_DELAY_MS;
@@ -354,49 +475,161 @@ void PardaloteClass::_onClientDisconnected(uint8_t num) {
     _connectedClients  &= ~(1 << num);
     _pendingHello[num]  = false;
     _authed[num]        = false;
+    _txLen[num]         = 0;    // nobody left to flush a pending batch to
+    _txLane[num][0]     = _txLane[num][1] = 0;
+    _setDatagram(num, false);
+    _clearBacklog(num);
+    // Its queued inbound messages are now stale. The generation is a
+    // record type, so it skips the queue's wrap marker.
+    if (++_rxGen[num] == SpscQueue::WRAP) _rxGen[num] = 0;
     // Drop this client's read registrations; slots with no remaining
     // registrations are freed. boardOwned actions (sketch share with
     // an interval) survive — the sketch, not a client, owns them.
     _unregisterClient(num);
+    if (_streamClient == num) _stopStream();
+    _atQueue.dropClient(num);
     disconnectAll(num);
     Serial.print('['); Serial.print(num); Serial.println(F("] Disconnected"));
 }
 
+// -------------------------------------------------------------------
+// Inbound queue. A transport callback only copies the message into
+// _rxQueue; run() handles it after the transport has been serviced, so
+// a burst can't hold up the socket or the serial reader, and handling
+// costs stay in one place (STATS_SEC_INBOUND).
+// -------------------------------------------------------------------
+void PardaloteClass::_queueInbound(uint8_t num, uint8_t* payload, size_t length) {
+    if (num >= MAX_WS_CLIENTS) return;
+    if (length <= _rxQueue.maxLen() &&
+        _rxQueue.push(num, _rxGen[num], payload, (uint16_t)length)) return;
+    // Queue full, or the message is bigger than it takes: keep arrival
+    // order by finishing what's queued, then handle this one in place.
+    // Not from inside a drain (a handler that calls run()): what's queued
+    // can't finish until that handler returns, so the message is refused
+    // rather than handled ahead of it.
+    if (_rxDraining) {
+        if (Stats::rxRefused++ % 100 == 0)
+            Serial.println(F("[Pardalote] inbound queue full inside a handler — message dropped"));
+        return;
+    }
+    _drainInbound(true);
+    _handleBinary(num, payload, length);
+}
+
+// Handles queued frames oldest first until the queue is empty or this
+// pass has spent PARDALOTE_RX_BUDGET_US on them (`all` ignores the
+// budget). At least one frame runs per call, and a message left half
+// done resumes at _rxPos next pass.
+void PardaloteClass::_drainInbound(bool all) {
+    if (_rxDraining) return;   // a handler that calls run()
+    _rxDraining = true;
+    const uint32_t start = (uint32_t)micros();
+    uint8_t scratch[MAX_PARAMS * 4];
+    SpscQueue::Header h;
+    uint8_t* data;
+    while (_rxQueue.peek(h, data)) {
+        // The generation check also covers a handler that drops its own
+        // client mid-message (a rejected AUTH).
+        while (_rxPos < h.len && h.type == _rxGen[h.client]) {
+            Frame f = parseFrame(data, _rxPos, h.len, scratch);
+            if (!f.valid) break;
+            const size_t at = _rxPos;
+            _rxPos += f.totalLen;
+            if (_authed[h.client] && _superseded(h.client, f, data, _rxPos, h.len)) {
+                Stats::rx(h.client, (uint16_t)f.totalLen);
+                Stats::coalesced++;
+            } else {
+                _handleFrame(h.client, f, data + at);
+            }
+            if (!all && (uint32_t)micros() - start >= PARDALOTE_RX_BUDGET_US) {
+                _rxDraining = false;
+                return;
+            }
+        }
+        _rxQueue.pop();
+        _rxPos = 0;
+    }
+    _rxDraining = false;
+}
+
+// True when a later queued frame from the same client replaces this one
+// — a command registered with coalesceCommand() (or analogWrite, core)
+// for the same target and, on an extension, the same param 0 (the
+// instance id). Looks at the rest of this message, then at the messages
+// behind it, up to PARDALOTE_COALESCE_WINDOW frames.
+bool PardaloteClass::_superseded(uint8_t num, const Frame& f,
+                                 uint8_t* payload, size_t pos, size_t length) {
+    const bool core = f.target < RESERVED_START;
+    if (f.cmd == CMD_MESSAGE) return false;
+    if (core ? f.cmd != CMD_ANALOG_WRITE : !commandCoalesces(f.target, f.cmd)) return false;
+    if (!core && f.nparams < 1) return false;
+    const int32_t id = core ? 0 : paramInt(f.params, 0);
+
+    uint8_t scratch[MAX_PARAMS * 4];
+    uint16_t window = PARDALOTE_COALESCE_WINDOW;
+    auto replaces = [&](uint8_t* buf, size_t p, size_t len) {
+        while (p < len && window) {
+            window--;
+            Frame g = parseFrame(buf, p, len, scratch);
+            if (!g.valid) return false;
+            if (g.cmd == f.cmd && g.target == f.target &&
+                (core || (g.nparams >= 1 && paramInt(g.params, 0) == id))) return true;
+            p += g.totalLen;
+        }
+        return false;
+    };
+    if (replaces(payload, pos, length)) return true;
+
+    SpscQueue::Header h;
+    uint8_t* data;
+    uint32_t c = _rxQueue.cursor();
+    _rxQueue.next(c, h, data);   // the message f came from
+    while (window && _rxQueue.next(c, h, data)) {
+        if (h.client != num || h.type != _rxGen[num]) continue;
+        if (replaces(data, 0, h.len)) return true;
+    }
+    return false;
+}
+
 // -------------------------------------------------------------------
 // Inbound binary — one message (a frame, or a JS batch of frames),
 // from either transport. Unauthed WS clients get exactly one verb:
 // CMD_AUTH; everything else is dropped until the key checks out.
 // -------------------------------------------------------------------
 void PardaloteClass::_handleBinary(uint8_t num, uint8_t* payload, size_t length) {
+    uint8_t scratch[MAX_PARAMS * 4];   // a compact frame's params, unpacked
     size_t pos = 0;
     while (pos < length) {
-        Frame f = parseFrame(payload, pos, length);
+        Frame f = parseFrame(payload, pos, length, scratch);
         if (!f.valid) break;
+        _handleFrame(num, f, payload + pos);
+        pos += f.totalLen;
+    }
+}
 
-        if (!_authed[num]) {
-            if (f.cmd == CMD_AUTH && f.target < RESERVED_START)
-                _handleAuthFrame(num, f);
-            pos += f.totalLen;
-            continue;
-        }
-
-        _emitFrame(PARDALOTE_FRAME_IN, f);   // frame monitor tap
+void PardaloteClass::_handleFrame(uint8_t num, const Frame& f, uint8_t* frameStart) {
+    if (!_authed[num]) {
+        if (f.cmd == CMD_AUTH && f.target < RESERVED_START)
+            _handleAuthFrame(num, f);
+        return;
+    }
 
-        if (f.cmd == CMD_AUTH) {
-            // Authed already (key matched, or none required) — a repeat
-            // AUTH is harmless; ignore it.
-        } else if (f.cmd == CMD_MESSAGE) {
-            // Routed by cmd, not target range — the flags in the
-            // target high byte can push it past RESERVED_START.
-            _handleMessageFrame(num, f, payload + pos);
-        } else if (f.target < RESERVED_START) {
-            _handleCoreFrame(num, f);
-        } else {
-            dispatchExtension(num, f.target, f.cmd, f.typeMask,
-                              f.params, f.nparams,
-                              f.payload, f.payloadLen);
-        }
-        pos += f.totalLen;
+    _emitFrame(PARDALOTE_FRAME_IN, f);   // frame monitor tap
+    if (!_replayingAt) Stats::rx(num, (uint16_t)f.totalLen);
+
+    if (f.cmd == CMD_AUTH) {
+        // Authed already (key matched, or none required) — a repeat
+        // AUTH is harmless; ignore it.
+    } else if (f.cmd == CMD_MESSAGE) {
+        // Routed by cmd, not target range — the flags in the
+        // target high byte can push it past RESERVED_START.
+        _handleMessageFrame(num, f, frameStart);
+    } else if (f.target < RESERVED_START) {
+        _handleCoreFrame(num, f);
+    } else {
+        dispatchExtension(num, f.target, f.cmd, f.typeMask,
+                          f.params, f.nparams,
+                          f.payload, f.payloadLen);
     }
 }
 
@@ -426,27 +659,32 @@ void PardaloteClass::_rejectClient(uint8_t num, int32_t reason) {
     // Direct raw send — sendFrame() requires _authed, and a rejected client
     // is by definition not authed. _sendRaw routes to the active transport.
     if (len) _sendRaw(num, fb.buf, len);
+    _flushTx(num);   // the reason must reach the client before the close
     Serial.print('['); Serial.print(num);
     Serial.println(reason == 2 ? F("] Rejected: wrong key") : F("] Rejected: no key presented"));
-#ifndef PARDALOTE_NO_WIFI
-    if (_transport == TRANSPORT_WIFI) {
-        _ws.disconnect(num);                  // fires WStype_DISCONNECTED → cleanup
-        return;
-    }
-#endif
-    // Serial: the board can't close the host's port (JS closes it on authFail
-    // and stops reconnecting). Clear board-side state so the slot is clean.
-    _onClientDisconnected(num);
+    // → the disconnect sink, which cleans up. Over serial the board can't
+    // close the host's port (JS closes it on authFail and stops
+    // reconnecting); the transport just forgets the page.
+    if (_link) _link->disconnect(num);
 }
 
 // -------------------------------------------------------------------
-// Serial transport sinks — the serial client is permanently client 0.
+// Transport sinks — every transport reports through these.
 // -------------------------------------------------------------------
-void PardaloteClass::_serialMessageTrampoline(uint8_t* data, size_t len) {
-    Pardalote._handleBinary(0, data, len);
+void PardaloteClass::_attach(PardaloteTransport& t) {
+    PardaloteTransportSinks sinks;
+    sinks.onMessage    = _messageSink;
+    sinks.onConnect    = _connectSink;
+    sinks.onDisconnect = _disconnectSink;
+    _link = &t;
+    t.begin(sinks);
 }
-void PardaloteClass::_serialConnectTrampoline()    { Pardalote._onClientConnected(0); }
-void PardaloteClass::_serialDisconnectTrampoline() { Pardalote._onClientDisconnected(0); }
+
+void PardaloteClass::_messageSink(uint8_t client, uint8_t* data, size_t len) {
+    Pardalote._queueInbound(client, data, len);
+}
+void PardaloteClass::_connectSink(uint8_t client)    { Pardalote._onClientConnected(client); }
+void PardaloteClass::_disconnectSink(uint8_t client) { Pardalote._onClientDisconnected(client); }
 
 #ifndef PARDALOTE_NO_WIFI
 void PardaloteClass::_serialListenTrampoline(uint8_t* data, size_t len) {
@@ -484,7 +722,7 @@ void PardaloteClass::_handleListenMessage(uint8_t* data, size_t len) {
                 // yet). At runtime, do the full WiFi→serial switch.
                 if (_bootWatch) { _bootTakeover = true; return; }
                 _switchToSerial();
-                return;   // _transport changed; stop draining in listen mode
+                return;   // _link changed; stop draining in listen mode
             }
             // Not an authorised takeover. At runtime, nudge the browser; during
             // the boot window stay silent and let WiFi come up — the runtime
@@ -531,7 +769,10 @@ void PardaloteClass::_switchToSerial() {
     for (uint8_t c = 0; c < MAX_WS_CLIENTS; c++)
         if (_connectedClients & (1 << c)) _onClientDisconnected(c);
 
-    _ws.close();          // stop the WebSocket server
+    _wsT.end();           // stop the network task and the WebSocket server
+#if PARDALOTE_DATAGRAM
+    _udpLane.end();
+#endif
     WiFi.disconnect();    // drop the association — radio stays powered so the
                           // sketch can still use WiFi for its own purposes
     Serial.println(F("[Pardalote] USB takeover — WiFi released, switching to serial"));
@@ -539,54 +780,14 @@ void PardaloteClass::_switchToSerial() {
     _serialListen   = false;
     _listenAuthed   = false;
     _listenKeyTried = false;
-    _transport      = TRANSPORT_SERIAL;
 
     // Full connected serial mode. JS keeps probing (and re-sends AUTH if a key
     // is set), so the normal HELLO→announce→SYNC_COMPLETE handshake runs and
     // client 0 comes up — re-authing through the standard path if keyed.
-    _serialT.begin(_serialMessageTrampoline,
-                   _serialConnectTrampoline,
-                   _serialDisconnectTrampoline);
+    _attach(_serialT);
 }
 
 
-// -------------------------------------------------------------------
-// WebSocket trampoline + event handler
-// -------------------------------------------------------------------
-void PardaloteClass::_wsEventTrampoline(uint8_t num, WStype_t type,
-                                        uint8_t* payload, size_t length) {
-    Pardalote._handleWsEvent(num, type, payload, length);
-}
-
-void PardaloteClass::_handleWsEvent(uint8_t num, WStype_t type,
-                                    uint8_t* payload, size_t length) {
-    switch (type) {
-
-        // Deduplicate state changes. The WebSocketsServer library on the
-        // UNO R4's WiFiS3 stack is known to fire spurious DISCONNECTED
-        // events for slots that were never connected (or that we already
-        // processed a disconnect for). Processing them re-clears the action
-        // table, re-fires extension disconnect hooks, and spams Serial —
-        // enough overhead to cause visible lag in NeoPixel updates and
-        // servo sweeps. Only act on actual state transitions.
-        // (The dedupe now lives in _onClientConnected/_onClientDisconnected,
-        // shared with the serial transport's sinks.)
-        case WStype_DISCONNECTED:
-            _onClientDisconnected(num);
-            break;
-
-        case WStype_CONNECTED:
-            _onClientConnected(num);
-            break;
-
-        case WStype_BIN:
-            _handleBinary(num, payload, length);
-            break;
-
-        default:
-            break;
-    }
-}
 #endif   // PARDALOTE_NO_WIFI
 
 // -------------------------------------------------------------------
@@ -604,6 +805,11 @@ void PardaloteClass::_handleCoreFrame(uint8_t clientNum, const Frame& f) {
         // page go away (e.g. a reload inside the rx-timeout window).
         // Harmless from a WS client too.
         case CMD_HELLO: {
+            _features[clientNum] = 0;   // possibly a new page — it negotiates afresh
+            _setDatagram(clientNum, false);
+            _clearBacklog(clientNum);
+            if (_onSerial()) _serialT.setReliable(false);
+            _atQueue.dropClient(clientNum);   // …and the old page's schedule goes with it
             if (!_pendingHello[clientNum]) {
                 _pendingHello[clientNum] = true;
                 _helloAfter[clientNum]   = millis();   // no delay — the link is warm
@@ -642,10 +848,9 @@ void PardaloteClass::_handleCoreFrame(uint8_t clientNum, const Frame& f) {
             if (pin >= 0 && pin < MAX_PIN_NUMBER)
                 _corePinValues[pin] = (uint8_t)wval;
             // Echo back to all clients so every browser sees the new state.
-            FrameBuilder fb;
-            fb.begin(CMD_DIGITAL_WRITE, (uint16_t)pin);
+            PardaloteFrame fb(PARDALOTE_ALL_CLIENTS, CMD_DIGITAL_WRITE, (uint16_t)pin);
             fb.addInt(wval);
-            broadcastFrame(fb);
+            fb.send();
             break;
         }
 
@@ -654,23 +859,25 @@ void PardaloteClass::_handleCoreFrame(uint8_t clientNum, const Frame& f) {
             analogWrite(pin, (int)paramInt(f.params, 0));
             break;
 
-        // Read request/registration: params [interval?, threshold?].
+        // Read request/registration: params [interval?, threshold?, flags?].
         // The requesting client always gets an immediate reading (seeds its
         // mirror); interval > 0 additionally registers a per-client periodic
-        // read. threshold 0 / absent = board default.
+        // read. threshold 0 / absent = board default. flags READ_EDGES
+        // switches a digital pin to interrupt watching.
         case CMD_DIGITAL_READ:
         case CMD_ANALOG_READ: {
             const int32_t val = (f.cmd == CMD_ANALOG_READ)
-                                ? analogRead(pin) : digitalRead(pin);
+                                ? _analogSample(pin) : digitalRead(pin);
             _sendReadTo(clientNum, pin, f.cmd, val);
 
             const long ms  = (f.nparams > 0) ? paramInt(f.params, 0) : 0;
             const long thr = (f.nparams > 1) ? paramInt(f.params, 1) : 0;
+            const uint8_t flags = (f.nparams > 2) ? (uint8_t)paramInt(f.params, 2) : 0;
             if (ms > 0) {
                 _registerClientRead(clientNum, pin, f.cmd,
                                     (uint16_t)constrain(ms, 1, 65535),
                                     (uint16_t)constrain(thr, 0, 65535),
-                                    val);
+                                    val, flags);
             }
             break;
         }
@@ -682,21 +889,326 @@ void PardaloteClass::_handleCoreFrame(uint8_t clientNum, const Frame& f) {
                 Action& a = _actions[i];
                 if (a.id != pin) continue;
                 a.clientMask &= ~(1 << clientNum);
-                if (a.clientMask == 0 && !a.boardOwned) a.id = -1;
+                if (a.clientMask == 0 && !a.boardOwned) _releaseAction(a);
                 break;
             }
             break;
         }
 
-        case CMD_PING: {
+        case CMD_ANALOG_STREAM:
+            _startStream(clientNum, f);
+            break;
+
+        case CMD_AT:
+            _scheduleAt(clientNum, f);
+            break;
+
+        case CMD_STATS:
+            _sendStats(clientNum, f.nparams >= 1 ? (uint8_t)paramInt(f.params, 0) : 0);
+            break;
+
+        // Optional encodings — keep only what this firmware offers.
+        case CMD_FEATURES:
+            if (f.nparams < 1) return;
+            _features[clientNum] = (uint8_t)(paramInt(f.params, 0) & _offeredFeatures());
+            _clearBacklog(clientNum);   // counting starts now, on both sides
+            _setDatagram(clientNum, _features[clientNum] & FEATURE_DATAGRAM);
+            if (_onSerial())
+                _serialT.setReliable(_features[clientNum] & FEATURE_RELIABLE);
+            break;
+
+        // [baud] — the page can run the link faster. The answer goes out
+        // ahead of this pass's batch, as the last message at the old
+        // rate; the transport sends nothing more until it has switched.
+        case CMD_BAUD: {
+            if (f.nparams < 1) return;
+            const uint32_t baud = (uint32_t)paramInt(f.params, 0);
+            if (!_onSerial()) return;
+            const bool ok = _serialT.baudAllowed(baud);
             FrameBuilder fb;
-            fb.begin(CMD_PONG, 0x0000);
-            sendFrame(clientNum, fb);
+            fb.begin(CMD_BAUD, 0x0000);
+            fb.addInt(ok ? (int32_t)baud : 0);
+            const size_t n = fb.finish();
+            if (n) _serialT.send(0, fb.buf, n);
+            if (ok) _serialT.setBaud(baud);
+            break;
+        }
+
+        // FEATURE_ACK: [bytes] received since the client's last ACK.
+        case CMD_ACK:
+            if (f.nparams < 1) return;
+            _addBacklog(clientNum, -paramInt(f.params, 0));
+            break;
+
+        // [seq, micros] — the JS clock estimator's board-side sample.
+        case CMD_PING: {
+            const uint32_t now = micros();
+            PardaloteFrame fb(clientNum, CMD_PONG, 0x0000);
+            fb.addInt(f.nparams >= 1 ? paramInt(f.params, 0) : 0);
+            fb.addInt((int32_t)now);
+            fb.send();
             break;
         }
     }
 }
 
+// -------------------------------------------------------------------
+// Execute-at (CMD_AT). The payload is parked whole and replayed through
+// _handleBinary at the deadline — any frame the client could send now,
+// core or extension, it can send for later. Precision is one run() pass.
+// -------------------------------------------------------------------
+void PardaloteClass::_scheduleAt(uint8_t clientNum, const Frame& f) {
+    if (f.nparams < 1 || _replayingAt || clientNum >= MAX_WS_CLIENTS) return;
+    const uint32_t due = (uint32_t)paramInt(f.params, 0);
+    int32_t status = 0;
+    if ((int32_t)(due - micros()) > (int32_t)PARDALOTE_AT_MAX_AHEAD_MS * 1000)
+        status = AT_ERR_RANGE;
+    else if (!_atQueue.push(due, clientNum, f.payload, f.payloadLen))
+        status = AT_ERR_FULL;
+    if (status == 0) return;
+    PardaloteFrame fb(clientNum, CMD_AT, 0x0000);
+    fb.addInt(status);
+    fb.send();
+}
+
+void PardaloteClass::_runDueAt() {
+    if (_atQueue.size() == 0) return;
+    AtQueue::Entry e;
+    _replayingAt = true;
+    while (_atQueue.popDue(micros(), e)) {
+        if (_clientReady(e.client)) _handleBinary(e.client, e.data, e.len);
+    }
+    _replayingAt = false;
+}
+
+// -------------------------------------------------------------------
+// Stats (CMD_STATS). Each table goes out as records, as many per frame
+// as fit — see the CMD_STATS layout in defs.h.
+// -------------------------------------------------------------------
+using StatSectionRecord = RecordSchema<uint8_t,  uint32_t, uint32_t, uint32_t>;
+using StatExtRecord     = RecordSchema<uint16_t, uint32_t, uint32_t, uint32_t>;
+using StatCmdRecord     = RecordSchema<uint16_t, uint8_t, uint32_t, uint32_t, uint32_t>;
+using StatClientRecord  = RecordSchema<uint8_t,  uint32_t, uint32_t, uint32_t, uint32_t>;
+
+template <typename Rec, typename Fill>
+static void sendStatRecords(uint8_t clientNum, uint8_t kind, uint8_t count, Fill fill) {
+    const uint8_t perFrame = (FRAME_MAX_SIZE - FRAME_HEADER_SIZE - 8) / Rec::size;
+    uint8_t i = 0;
+    do {
+        PardaloteFrame fb(clientNum, CMD_STATS, 0x0000);
+        fb.addInt(kind);
+        if (kind == STATS_KIND_COMMAND) fb.addInt((int32_t)Stats::cmdOverflow);
+        const uint8_t n = (count - i < perFrame) ? count - i : perFrame;
+        uint8_t* p = fb.reserveBytes(n * Rec::size);
+        if (!p) return;
+        for (uint8_t k = 0; k < n; k++) fill(p + k * Rec::size, i + k);
+        fb.send();
+        i += n;
+    } while (i < count);
+}
+
+void PardaloteClass::_sendStats(uint8_t clientNum, uint8_t flags) {
+    {
+        PardaloteFrame fb(clientNum, CMD_STATS, 0x0000);
+        fb.addInt(STATS_KIND_LOOP);
+        fb.addInt((int32_t)Stats::passes);
+        fb.addInt((int32_t)Stats::period.maxUs);
+        fb.addInt((int32_t)(millis() - Stats::sinceMs));
+        fb.addInt((int32_t)Stats::coalesced);
+        uint8_t* p = fb.reserveBytes(STATS_BINS * 4);
+        if (p) for (uint8_t b = 0; b < STATS_BINS; b++)
+            RecordSchema<uint32_t>::write(p + b * 4, Stats::period.bins[b]);
+        fb.send();
+    }
+
+    sendStatRecords<StatSectionRecord>(clientNum, STATS_KIND_SECTION, STATS_SECTIONS,
+        [](uint8_t* p, uint8_t i) {
+            const StatCost& c = Stats::sections[i];
+            StatSectionRecord::write(p, i, c.calls, c.totalUs, c.maxUs);
+        });
+
+    uint8_t ext[MAX_EXTENSIONS], nExt = 0;   // registry slots with a loop hook that ran
+    for (uint8_t i = 0; i < MAX_EXTENSIONS; i++)
+        if (Stats::ext[i].loop.calls) ext[nExt++] = i;
+    sendStatRecords<StatExtRecord>(clientNum, STATS_KIND_EXT_LOOP, nExt,
+        [&](uint8_t* p, uint8_t i) {
+            const Stats::Ext& e = Stats::ext[ext[i]];
+            StatExtRecord::write(p, e.deviceId, e.loop.calls, e.loop.totalUs, e.loop.maxUs);
+        });
+
+    sendStatRecords<StatCmdRecord>(clientNum, STATS_KIND_COMMAND, Stats::cmdCount,
+        [](uint8_t* p, uint8_t i) {
+            const Stats::Cmd& c = Stats::cmds[i];
+            StatCmdRecord::write(p, c.deviceId, c.cmd, c.cost.calls, c.cost.totalUs, c.cost.maxUs);
+        });
+
+    sendStatRecords<StatClientRecord>(clientNum, STATS_KIND_CLIENT, MAX_WS_CLIENTS,
+        [](uint8_t* p, uint8_t i) {
+            const Stats::Client& c = Stats::clients[i];
+            StatClientRecord::write(p, i, c.framesIn, c.bytesIn, c.framesOut, c.bytesOut);
+        });
+
+    PardaloteFrame end(clientNum, CMD_STATS, 0x0000);
+    end.addInt(STATS_KIND_END);
+    end.send();
+
+    if (flags & STATS_RESET) Stats::reset();
+}
+
+static void printCost(Print& out, const StatCost& c) {
+    out.print(c.calls);
+    out.print(F(" calls, avg "));
+    out.print(c.calls ? c.totalUs / c.calls : 0);
+    out.print(F(" us, max "));
+    out.print(c.maxUs);
+    out.println(F(" us"));
+}
+
+void PardaloteClass::printStats(Print& out) {
+    static const char* const sectionNames[STATS_SECTIONS] = {
+        "transport", "at-queue", "ext loops", "yield", "clients", "pins", "stream", "flush",
+        "inbound"
+    };
+    out.print(F("[Pardalote] stats over "));
+    out.print(millis() - Stats::sinceMs);
+    out.print(F(" ms: "));
+    out.print(Stats::passes);
+    out.print(F(" passes, period max "));
+    out.print(Stats::period.maxUs);
+    out.println(F(" us"));
+    out.print(F("  period <=us:"));
+    for (uint8_t b = 0; b < STATS_BINS; b++) {
+        if (!Stats::period.bins[b]) continue;
+        out.print(' ');
+        out.print(b ? (1UL << b) - 1 : 0);
+        out.print('=');
+        out.print(Stats::period.bins[b]);
+    }
+    out.println();
+    for (uint8_t i = 0; i < STATS_SECTIONS; i++) {
+        if (!Stats::sections[i].calls) continue;
+        out.print(F("  "));
+        out.print(sectionNames[i]);
+        out.print(F(": "));
+        printCost(out, Stats::sections[i]);
+    }
+    if (Stats::coalesced) {
+        out.print(F("  coalesced: "));
+        out.print(Stats::coalesced);
+        out.println(F(" frames superseded while queued"));
+    }
+    if (Stats::txDropped) {
+        out.print(F("  dropped: "));
+        out.print(Stats::txDropped);
+        out.println(F(" outbound batches the link refused, with no room to hold them"));
+    }
+    if (Stats::rxRefused) {
+        out.print(F("  refused: "));
+        out.print(Stats::rxRefused);
+        out.println(F(" messages arrived to a full queue inside a handler"));
+    }
+    for (uint8_t i = 0; i < MAX_EXTENSIONS; i++) {
+        if (!Stats::ext[i].loop.calls) continue;
+        out.print(F("  loop "));
+        out.print(Stats::ext[i].deviceId);
+        out.print(F(": "));
+        printCost(out, Stats::ext[i].loop);
+    }
+    for (uint8_t i = 0; i < Stats::cmdCount; i++) {
+        out.print(F("  cmd "));
+        out.print(Stats::cmds[i].deviceId);
+        out.print('/');
+        const char* name = pardaloteFrameName(Stats::cmds[i].deviceId, Stats::cmds[i].cmd);
+        if (name) out.print(name);
+        else      { out.print(F("0x")); out.print(Stats::cmds[i].cmd, HEX); }
+        out.print(F(": "));
+        printCost(out, Stats::cmds[i].cost);
+    }
+    for (uint8_t c = 0; c < MAX_WS_CLIENTS; c++) {
+        const Stats::Client& k = Stats::clients[c];
+        if (!k.framesIn && !k.framesOut) continue;
+        out.print(F("  client "));
+        out.print(c);
+        out.print(F(": in "));
+        out.print(k.framesIn);  out.print(F(" frames / ")); out.print(k.bytesIn);
+        out.print(F(" B, out "));
+        out.print(k.framesOut); out.print(F(" frames / ")); out.print(k.bytesOut);
+        out.println(F(" B"));
+    }
+}
+
+// -------------------------------------------------------------------
+// Continuous analog stream. [rateHz, blockFrames, pins…]; rateHz 0
+// stops. Only the owning client may change or stop a running stream.
+// -------------------------------------------------------------------
+void PardaloteClass::_startStream(uint8_t clientNum, const Frame& f) {
+    if (f.nparams < 1) return;
+    if (_streamClient != NO_STREAM && _streamClient != clientNum) {
+        _sendStreamStatus(clientNum, STREAM_ERR_BUSY);
+        return;
+    }
+    const long rate = paramInt(f.params, 0);
+    if (rate <= 0) {
+        _stopStream();
+        _sendStreamStatus(clientNum, STREAM_STOPPED);
+        return;
+    }
+
+    uint8_t pins[ANALOG_STREAM_MAX_PINS];
+    uint8_t n = 0;
+    for (uint8_t i = 2; i < f.nparams && n < ANALOG_STREAM_MAX_PINS; i++)
+        pins[n++] = (uint8_t)paramInt(f.params, i);
+
+    const int8_t status = AnalogStream::start(pins, n, (uint32_t)rate);
+    if (status != STREAM_RUNNING) {
+        _streamClient = NO_STREAM;
+        _sendStreamStatus(clientNum, status);
+        return;
+    }
+    const long maxBlock = ANALOG_BLOCK_MAX_BYTES / (2 * n);
+    const long block    = (f.nparams > 1) ? paramInt(f.params, 1) : 0;
+    _streamClient = clientNum;
+    _streamBlock  = (uint16_t)constrain(block > 0 ? block : maxBlock, 1, maxBlock);
+    _streamSeq    = 0;
+    _sendStreamStatus(clientNum, STREAM_RUNNING);
+}
+
+void PardaloteClass::_stopStream() {
+    AnalogStream::stop();
+    _streamClient = NO_STREAM;
+}
+
+void PardaloteClass::_sendStreamStatus(uint8_t clientNum, int8_t status) {
+    const bool on = (status == STREAM_RUNNING);
+    PardaloteFrame fb(clientNum, CMD_ANALOG_STREAM, 0x0000);
+    fb.addInt(status);
+    fb.addInt(on ? (int32_t)AnalogStream::rate() : 0);
+    fb.addInt(on ? _streamBlock : 0);
+    fb.addInt(AnalogStream::bits());
+    fb.send();
+}
+
+// Ship every whole block the ring holds. Blocks only leave in whole
+// units, so the browser can lay them end to end by seq.
+void PardaloteClass::_pumpStream() {
+    if (_streamClient == NO_STREAM) return;
+    AnalogStream::poll();
+    if (!_clientReady(_streamClient)) return;
+
+    const uint8_t  n     = AnalogStream::pinCount();
+    const uint16_t bytes = (uint16_t)(_streamBlock * n * 2);
+    while (AnalogStream::available() >= _streamBlock) {
+        PardaloteFrame fb(_streamClient, CMD_ANALOG_BLOCK, 0x0000);
+        fb.addInt((int32_t)_streamSeq++);
+        fb.addInt(n);
+        fb.addInt((int32_t)AnalogStream::dropped());
+        uint8_t* out = fb.reserveBytes(bytes);
+        if (!out) return;
+        AnalogStream::take(out, _streamBlock);
+        fb.send();
+    }
+}
+
 // -------------------------------------------------------------------
 // Periodic-read plumbing
 // -------------------------------------------------------------------
@@ -710,18 +1222,21 @@ uint16_t PardaloteClass::_defaultThreshold(uint8_t cmd) {
     return t > 0 ? t : 1;
 }
 
-// Send one reading to one client.
+// Send one reading to one client. A stamped reading (interrupt-watched
+// pin) carries the edge's micros() as a second param.
 void PardaloteClass::_sendReadTo(uint8_t clientNum, int pin, uint8_t cmd,
-                                 int32_t val) {
-    FrameBuilder fb;
-    fb.begin(cmd, (uint16_t)pin);
+                                 int32_t val, bool stamped, uint32_t stampUs) {
+    PardaloteFrame fb(clientNum, cmd, (uint16_t)pin);
     fb.addInt(val);
-    sendFrame(clientNum, fb);
+    if (stamped) fb.addInt((int32_t)stampUs);
+    fb.send();
 }
 
-// Fresh slot: no registrations yet.
+// Fresh slot: no registrations yet. A slot being reused for a new pin
+// or read kind gives up its interrupt first.
 void PardaloteClass::_initAction(int slot, int pin, uint8_t cmd) {
     Action& a = _actions[slot];
+    if (a.id != -1) _releaseAction(a);
     a.id             = (int16_t)pin;
     a.cmd            = cmd;
     a.lastSample     = 0;
@@ -734,11 +1249,36 @@ void PardaloteClass::_initAction(int slot, int pin, uint8_t cmd) {
     a.seededMask     = 0;
 }
 
+// Free a slot, detaching its pin interrupt if it had one.
+void PardaloteClass::_releaseAction(Action& a) {
+    if (a.edgeSlot >= 0) {
+        EdgeWatch::detach(a.edgeSlot);
+        a.edgeSlot = -1;
+    }
+    a.id = -1;
+}
+
+// Switch a digital watch to interrupt watching (READ_EDGES). Stays that
+// way until the slot is freed, whoever asked. A pin with no interrupt,
+// or no free EdgeWatch slot, keeps being polled.
+void PardaloteClass::_watchEdges(int slot) {
+    Action& a = _actions[slot];
+    if (a.cmd != CMD_DIGITAL_READ || a.edgeSlot >= 0) return;
+    a.edgeSlot = EdgeWatch::attach((uint8_t)a.id, (uint8_t)slot);
+    if (a.edgeSlot < 0) {
+        Serial.print(F("[Pardalote] pin ")); Serial.print(a.id);
+        Serial.println(F(": no interrupt available — polling instead"));
+        return;
+    }
+    a.lastLevel = digitalRead(a.id);
+}
+
 // Register (or update) one client's watch on a pin. seedVal is the
 // reading just sent to the client, so gating starts from it.
 void PardaloteClass::_registerClientRead(uint8_t clientNum, int pin,
                                          uint8_t cmd, uint16_t interval,
-                                         uint16_t threshold, int32_t seedVal) {
+                                         uint16_t threshold, int32_t seedVal,
+                                         uint8_t flags) {
     int slot = _getSlot(pin);
     if (slot < 0) return;
     Action& a = _actions[slot];
@@ -748,6 +1288,7 @@ void PardaloteClass::_registerClientRead(uint8_t clientNum, int pin,
     // ends the old read before registering the new kind.
     if (a.id == -1 || a.cmd != cmd) _initAction(slot, pin, cmd);
     if (cmd == CMD_DIGITAL_READ && a.lastLevel == -1) a.lastLevel = seedVal;
+    if (flags & READ_EDGES) _watchEdges(slot);
 
     const uint8_t bit = 1 << clientNum;
     a.clientMask         |= bit;
@@ -766,7 +1307,7 @@ void PardaloteClass::_unregisterClient(uint8_t clientNum) {
         if (a.id == -1) continue;
         a.clientMask &= ~bit;
         a.seededMask &= ~bit;
-        if (a.clientMask == 0 && !a.boardOwned) a.id = -1;
+        if (a.clientMask == 0 && !a.boardOwned) _releaseAction(a);
     }
 }
 
@@ -778,8 +1319,8 @@ void PardaloteClass::_seedActions(uint8_t clientNum) {
         Action& a = _actions[i];
         if (a.id == -1) continue;
         const int32_t val = (a.cmd == CMD_ANALOG_READ)
-                            ? analogRead(a.id) : digitalRead(a.id);
-        _sendReadTo(clientNum, a.id, a.cmd, val);
+                            ? _analogSample(a.id) : digitalRead(a.id);
+        _sendReadTo(clientNum, a.id, a.cmd, val, a.edgeSlot >= 0, micros());
         a.lastSent[clientNum]     = val;
         a.lastSendTime[clientNum] = millis();
         a.seededMask             |= bit;
@@ -790,22 +1331,27 @@ void PardaloteClass::_seedActions(uint8_t clientNum) {
 // HELLO + announce
 // -------------------------------------------------------------------
 void PardaloteClass::_sendHello(uint8_t clientNum) {
-    FrameBuilder fb;
-    fb.begin(CMD_HELLO, 0x0000);
+    PardaloteFrame fb(clientNum, CMD_HELLO, 0x0000);
     fb.addInt(PROTOCOL_VERSION_MAJOR);
     fb.addInt(PROTOCOL_VERSION_MINOR);
     fb.addInt(ADC_RESOLUTION_BITS);
     fb.addInt((int32_t)_bootId);   // param[3]: boot id (older JS ignores it)
+    fb.addInt(_offeredFeatures()); // param[4]: optional encodings (protocol 1.1)
+    fb.addInt(PARDALOTE_SERIAL_MAX_BAUD);   // param[5]: CMD_BAUD ceiling
+#if PARDALOTE_DATAGRAM
+    fb.addInt(_udpLane.port());    // param[6]: datagram lane, 0 = none
+#else
+    fb.addInt(0);
+#endif
     fb.addString(PARDALOTE_BOARD);
-    sendFrame(clientNum, fb);
+    fb.send();
 }
 
 void PardaloteClass::_announcePins(uint8_t clientNum) {
     for (int pin = 0; pin < MAX_PIN_NUMBER; pin++) {
         if (_corePinModes[pin] == 0xFF) continue;
 
-        FrameBuilder fm;
-        fm.begin(CMD_PIN_MODE, (uint16_t)pin);
+        PardaloteFrame fm(clientNum, CMD_PIN_MODE, (uint16_t)pin);
         fm.addInt(_corePinModes[pin]);
         // Board-owned poll (share with interval): include its settings so
         // the connecting browser registers the pin without a READ round trip.
@@ -816,21 +1362,19 @@ void PardaloteClass::_announcePins(uint8_t clientNum) {
                 break;
             }
         }
-        sendFrame(clientNum, fm);
+        fm.send();
 
         if (_corePinModes[pin] == MODE_OUTPUT) {
-            FrameBuilder fv;
-            fv.begin(CMD_DIGITAL_WRITE, (uint16_t)pin);
+            PardaloteFrame fv(clientNum, CMD_DIGITAL_WRITE, (uint16_t)pin);
             fv.addInt(_corePinValues[pin]);
-            sendFrame(clientNum, fv);
+            fv.send();
         }
     }
 }
 
 void PardaloteClass::_sendSyncComplete(uint8_t clientNum) {
-    FrameBuilder fb;
-    fb.begin(CMD_SYNC_COMPLETE, 0x0000);
-    sendFrame(clientNum, fb);
+    PardaloteFrame fb(clientNum, CMD_SYNC_COMPLETE, 0x0000);
+    fb.send();
 }
 
 // -------------------------------------------------------------------
@@ -838,7 +1382,7 @@ void PardaloteClass::_sendSyncComplete(uint8_t clientNum) {
 // Pardalote.h for the public-facing contract.
 // -------------------------------------------------------------------
 void PardaloteClass::share(uint8_t pin, uint8_t mode,
-                           uint16_t interval, uint16_t threshold) {
+                           uint16_t interval, uint16_t threshold, uint8_t flags) {
     // Map Arduino's mode constants to Pardalote's protocol modes.
     // INPUT / OUTPUT / INPUT_PULLUP happen to align numerically with
     // MODE_INPUT / MODE_OUTPUT / MODE_INPUT_PULLUP — we map explicitly
@@ -861,6 +1405,8 @@ void PardaloteClass::share(uint8_t pin, uint8_t mode,
     // An interval on an input mode registers a board-owned periodic read:
     // the board polls the pin itself and readings flow to every browser,
     // with no JS read call and no round trip. Survives client disconnects.
+    // READ_EDGES implies a watch — edges ignore the interval anyway.
+    if ((flags & READ_EDGES) && interval == 0) interval = 1;
     const bool inputMode = (pardaloteMode == MODE_INPUT ||
                             pardaloteMode == MODE_INPUT_PULLUP ||
                             pardaloteMode == MODE_INPUT_PULLDOWN ||
@@ -875,12 +1421,12 @@ void PardaloteClass::share(uint8_t pin, uint8_t mode,
             a.boardOwned     = true;
             a.boardInterval  = interval;
             a.boardThreshold = threshold > 0 ? threshold : _defaultThreshold(cmd);
+            if (flags & READ_EDGES) _watchEdges(slot);
         }
     }
 
     if (!anyConnected()) return;
-    FrameBuilder fb;
-    fb.begin(CMD_PIN_MODE, (uint16_t)pin);
+    PardaloteFrame fb(PARDALOTE_ALL_CLIENTS, CMD_PIN_MODE, (uint16_t)pin);
     fb.addInt(pardaloteMode);
     if (inputMode && interval > 0) {
         // Tell browsers the board is polling — JS registers the pin
@@ -888,7 +1434,7 @@ void PardaloteClass::share(uint8_t pin, uint8_t mode,
         fb.addInt(interval);
         fb.addInt(threshold);
     }
-    broadcastFrame(fb);
+    fb.send();
 }
 
 void PardaloteClass::send(uint8_t pin, int value) {
@@ -896,10 +1442,9 @@ void PardaloteClass::send(uint8_t pin, int value) {
     if (pin < MAX_PIN_NUMBER) _corePinValues[pin] = (uint8_t)value;
 
     if (!anyConnected()) return;
-    FrameBuilder fb;
-    fb.begin(CMD_DIGITAL_WRITE, (uint16_t)pin);
+    PardaloteFrame fb(PARDALOTE_ALL_CLIENTS, CMD_DIGITAL_WRITE, (uint16_t)pin);
     fb.addInt(value);
-    broadcastFrame(fb);
+    fb.send();
 }
 
 // ===================================================================
@@ -929,7 +1474,7 @@ void PardaloteClass::sendBlob(const char* key, const uint8_t* data, uint16_t len
 }
 
 // Build [header][param?][keyLen][key][value?] for a message frame.
-void PardaloteClass::_buildMessageFrame(FrameBuilder& fb, uint8_t type, uint8_t flags,
+void PardaloteClass::_buildMessageFrame(FrameWriter& fb, uint8_t type, uint8_t flags,
         const char* key, uint8_t keyLen, int32_t intVal, float floatVal,
         const uint8_t* value, uint16_t valueLen) {
     fb.begin(CMD_MESSAGE, MSG_TARGET(type, flags));
@@ -958,9 +1503,9 @@ void PardaloteClass::_emitMessage(uint8_t type, uint8_t flags, const char* key,
         _storeRetained(key, keyLen, type, intVal, floatVal, value, valueLen);
 
     if (!anyConnected()) return;
-    FrameBuilder fb;
+    PardaloteFrame fb(PARDALOTE_ALL_CLIENTS, CMD_MESSAGE, 0);
     _buildMessageFrame(fb, type, flags, key, keyLen, intVal, floatVal, value, valueLen);
-    broadcastFrame(fb);
+    fb.send();
 }
 
 // Browser → board: decode, retain, deliver to watchers, relay if broadcast.
@@ -1015,11 +1560,17 @@ void PardaloteClass::_handleMessageFrame(uint8_t clientNum, const Frame& f, uint
 
     // Relay to the OTHER browsers (the board is the hub). Send the exact
     // received bytes; receivers process it as an ordinary inbound message.
+    // A compact frame is expanded for a browser that didn't negotiate it.
     // (No-op on the serial transport — there are no other browsers.)
     if (flags & MSG_FLAG_BROADCAST) {
         for (int c = 0; c < MAX_WS_CLIENTS; c++) {
-            if (c != clientNum && _clientReady((uint8_t)c))
+            if (c == clientNum || !_clientReady((uint8_t)c)) continue;
+            if (f.compact && !(_features[c] & FEATURE_COMPACT)) {
+                size_t n = expandFrame(f, _frameAlt, sizeof(_frameAlt));
+                if (n) _sendRaw((uint8_t)c, _frameAlt, n);
+            } else {
                 _sendRaw((uint8_t)c, frameStart, f.totalLen);
+            }
         }
     }
 }
@@ -1068,10 +1619,10 @@ void PardaloteClass::_announceMessages(uint8_t clientNum) {
     for (int i = 0; i < NUM_RETAINED; i++) {
         Retained& r = _retained[i];
         if (!r.used) continue;
-        FrameBuilder fb;
+        PardaloteFrame fb(clientNum, CMD_MESSAGE, 0);
         _buildMessageFrame(fb, r.type, MSG_FLAG_RETAIN, r.key, r.keyLen,
                            r.intVal, r.floatVal, r.valueBuf, r.valueLen);
-        sendFrame(clientNum, fb);
+        fb.send();
     }
 }
 
@@ -1106,7 +1657,8 @@ void PardaloteClass::_emitFrame(uint8_t dir, const Frame& f) {
 
 void PardaloteClass::_emitFrameOut(uint8_t* buf, size_t len) {
     if (!_frameHandler) return;
-    Frame f = parseFrame(buf, 0, len);
+    uint8_t scratch[MAX_PARAMS * 4];
+    Frame f = parseFrame(buf, 0, len, scratch);
     if (f.valid) _emitFrame(PARDALOTE_FRAME_OUT, f);
 }
 
@@ -1114,24 +1666,310 @@ void PardaloteClass::_emitFrameOut(uint8_t* buf, size_t len) {
 // Public send methods — extensions call Pardalote.sendFrame /
 // Pardalote.broadcastFrame from phase 5 onward.
 // -------------------------------------------------------------------
-void PardaloteClass::sendFrame(uint8_t clientNum, FrameBuilder& fb) {
+void PardaloteClass::sendFrame(uint8_t clientNum, FrameWriter& fb) {
     if (clientNum >= MAX_WS_CLIENTS) return;   // loopback client (sketch command) has no socket
     if (!_authed[clientNum]) return;           // nothing reaches an unauthed client
     size_t len = fb.finish();
     if (len == 0) return;
     _emitFrameOut(fb.buf, len);
-    _sendRaw(clientNum, fb.buf, len);
+    _sendFrameTo(clientNum, fb.buf, len);
 }
 
-// The ONLY place bytes leave the board — routes to the active transport.
+void PardaloteClass::_sendFrameTo(uint8_t clientNum, uint8_t* buf, size_t len) {
+    if (clientNum < MAX_WS_CLIENTS && (_features[clientNum] & FEATURE_COMPACT)) {
+        const size_t n = compactFrame(buf, len, _frameAlt);
+        if (n) { _sendRaw(clientNum, _frameAlt, n); return; }
+    }
+    _sendRaw(clientNum, buf, len);
+}
+
+// [first, mid) and [mid, last) swap places — three reversals, in place
+// (<algorithm> and Arduino's min/max macros don't mix).
+static void rotateBytes(uint8_t* first, uint8_t* mid, uint8_t* last) {
+    auto rev = [](uint8_t* a, uint8_t* b) { while (a < b) { uint8_t t = *a; *a++ = *--b; *b = t; } };
+    if (first == mid || mid == last) return;
+    rev(first, mid);
+    rev(mid, last);
+    rev(first, last);
+}
+
+// Which TX lane a board → client frame travels in. Core frames are
+// classified here; extension commands by OUTBOUND_LANE. The connect
+// burst keeps to one lane (_inOrder), so it arrives as it was sent.
+uint8_t PardaloteClass::_laneOf(uint8_t cmd, uint16_t target) const {
+    if (_inOrder || cmd == CMD_MESSAGE) return TX_LANE_STATE;
+    if (target >= RESERVED_START) return outboundLane(target, cmd);
+    switch (cmd) {
+        case CMD_AUTH:
+        case CMD_PONG:
+        case CMD_SERIAL_BUSY:
+        case CMD_REBOOT:
+            return TX_LANE_CONTROL;
+        case CMD_ANALOG_READ:
+        case CMD_ANALOG_BLOCK:
+            return TX_LANE_TELEMETRY;
+        default:               // replies, announces, digital edges
+            return TX_LANE_STATE;
+    }
+}
+
+// Every outbound frame passes through here. Inside run() it joins its
+// lane of the client's TX batch; a frame that won't fit makes room
+// first, and one bigger than the whole batch goes out on its own.
+// Outside run() (setup(), sketch calls between passes) it writes
+// straight through — unless the link refused the last batch, which it
+// then queues behind.
 void PardaloteClass::_sendRaw(uint8_t clientNum, uint8_t* buf, size_t len) {
-    if (_transport == TRANSPORT_SERIAL) {
-        if (clientNum == 0) _serialT.send(buf, len);
+    Stats::tx(clientNum, (uint16_t)len);
+    if (clientNum >= MAX_WS_CLIENTS || (!_batching && _txLen[clientNum] == 0)) {
+        _writeRaw(clientNum, buf, len);
         return;
     }
-#ifndef PARDALOTE_NO_WIFI
-    _ws.sendBIN(clientNum, buf, len);
+    if (len > PARDALOTE_TX_BATCH) {
+        _flushTx(clientNum);
+        _writeRaw(clientNum, buf, len);
+        return;
+    }
+    uint8_t  cmd;
+    uint16_t target;
+    const uint8_t lane = frameHead(buf, len, cmd, target) ? _laneOf(cmd, target) : TX_LANE_STATE;
+    _txRoom(clientNum, lane, (uint16_t)len);
+    memcpy(_txBuf[clientNum] + _txLen[clientNum], buf, len);
+    _txClaim(clientNum, lane, (uint16_t)len);
+}
+
+void PardaloteClass::_flushTx(uint8_t clientNum) {
+    if (clientNum >= MAX_WS_CLIENTS || _txLen[clientNum] == 0) return;
+    uint16_t len = _txLen[clientNum];
+#if PARDALOTE_DATAGRAM
+    // A client bound to the datagram lane gets the telemetry lane as one
+    // datagram. If that send fails the lane lets the client go, and the
+    // bytes stay in this write.
+    const uint16_t tel = _txLane[clientNum][TX_LANE_STATE];
+    if (tel < len && _udpLane.bound(clientNum) &&
+        _udpLane.send(clientNum, _txBuf[clientNum] + tel, len - tel))
+        len = tel;
+#endif
+    const uint16_t control = _txLane[clientNum][TX_LANE_CONTROL];
+    const uint16_t state   = _txLane[clientNum][TX_LANE_STATE];
+    _txLen[clientNum] = 0;   // cleared first — a write that drops the client re-enters
+    _txLane[clientNum][0] = _txLane[clientNum][1] = 0;
+    if (len && !_writeRaw(clientNum, _txBuf[clientNum], len)) _txHold(clientNum, control, state);
+}
+
+// The link refused a batch without dropping the client (a sequenced
+// serial session whose store is full). Its control and state lanes —
+// DONE, limits, replies — stay for the next flush; the telemetry goes,
+// and the next reading carries the current value anyway.
+void PardaloteClass::_txHold(uint8_t clientNum, uint16_t control, uint16_t state) {
+    if (!_clientReady(clientNum)) return;
+    _txLane[clientNum][TX_LANE_CONTROL] = control;
+    _txLane[clientNum][TX_LANE_STATE]   = state;
+    _txLen[clientNum] = state;
+}
+
+// No room even after a flush: the link is refusing what it holds. The
+// held batch is lost — counted, and reported on the first and every
+// hundredth.
+void PardaloteClass::_txDrop(uint8_t clientNum) {
+    _txLen[clientNum] = 0;
+    _txLane[clientNum][0] = _txLane[clientNum][1] = 0;
+    if (Stats::txDropped++ % 100 == 0)
+        Serial.println(F("[Pardalote] link refused a batch and there's no room to hold it — dropped"));
+}
+
+// Makes `need` bytes (plus a clock stamp's worth, for FEATURE_CLOCK)
+// free at the batch tail. A control or state frame that would otherwise
+// flush the whole batch sends just the control and state lanes when that
+// frees enough — the telemetry waits for the end of the pass, behind
+// whatever the pass still has to say. Only while it is a small share of
+// the batch, though: kept any bigger, it would leave so little room that
+// every frame or two forced another write.
+void PardaloteClass::_txRoom(uint8_t clientNum, uint8_t lane, uint16_t need) {
+    if (_features[clientNum] & FEATURE_CLOCK) need += TX_CLOCK_SIZE;
+    if (need > PARDALOTE_TX_BATCH) need = PARDALOTE_TX_BATCH;
+    const uint16_t total = _txLen[clientNum];
+    const uint16_t free  = PARDALOTE_TX_BATCH - total;
+    if (free >= need) return;
+    const uint16_t held = _txLane[clientNum][TX_LANE_STATE];
+    if (lane == TX_LANE_TELEMETRY || held == 0 || free + held < need ||
+        total - held > PARDALOTE_TX_BATCH / 4) {
+        _flushTx(clientNum);
+    } else {
+        const uint16_t control = _txLane[clientNum][TX_LANE_CONTROL];
+        _txLen[clientNum] = 0;   // as _flushTx — the write may drop the client
+        _txLane[clientNum][0] = _txLane[clientNum][1] = 0;
+        if (_writeRaw(clientNum, _txBuf[clientNum], held)) {
+            if (!_clientReady(clientNum)) return;
+            memmove(_txBuf[clientNum], _txBuf[clientNum] + held, total - held);
+            _txLen[clientNum] = total - held;
+        } else {
+            _txHold(clientNum, control, held);
+        }
+    }
+    if (PARDALOTE_TX_BATCH - _txLen[clientNum] < need) _txDrop(clientNum);
+}
+
+// Claims the `len` bytes just written at the batch tail into `lane`,
+// moving them back past the later lanes. FEATURE_CLOCK: a CMD_CLOCK
+// [micros] goes ahead of the frame when the lane is empty or its last
+// stamp is PARDALOTE_CLOCK_RESTAMP_US old, so each lane carries its own
+// time and a stamp never arrives without the frames it dates. A stamp
+// that doesn't fit sends the batch ahead of the frame first, and the
+// frame starts the next one behind its stamp.
+uint8_t* PardaloteClass::_txClaim(uint8_t clientNum, uint8_t lane, uint16_t len) {
+    uint8_t* const buf  = _txBuf[clientNum];
+    uint8_t*       tail = buf + _txLen[clientNum];
+    uint16_t chunk = len;
+    if (_features[clientNum] & FEATURE_CLOCK) {
+        const uint32_t now = micros();
+        if (_laneEmpty(clientNum, lane) ||
+            now - _stampUs[clientNum][lane] >= PARDALOTE_CLOCK_RESTAMP_US) {
+            if (_txLen[clientNum] + len + TX_CLOCK_SIZE > PARDALOTE_TX_BATCH) {
+                const uint16_t ahead = _txLen[clientNum];
+                _flushTx(clientNum);   // the frame sits past _txLen — not sent
+                if (_txLen[clientNum]) _txDrop(clientNum);   // refused, and in the way
+                memmove(buf, buf + ahead, len);
+                tail = buf;
+                if (!_clientReady(clientNum)) return buf;   // the write dropped it
+            }
+            FrameWriter fw(tail + len, TX_CLOCK_SIZE);
+            fw.begin(CMD_CLOCK, 0x0000);
+            fw.addInt((int32_t)now);
+            chunk += fw.finish();
+            rotateBytes(tail, tail + len, tail + chunk);
+            _stampUs[clientNum][lane] = now;
+        }
+    }
+    const uint16_t at = _laneEnd(clientNum, lane);
+    rotateBytes(buf + at, tail, tail + chunk);   // no-op for the last lane
+    _txLen[clientNum] += chunk;
+    for (uint8_t l = lane; l < TX_LANE_TELEMETRY; l++) _txLane[clientNum][l] += chunk;
+    return buf + at + (chunk - len);
+}
+
+uint8_t* PardaloteClass::_reserveFrame(uint8_t clientNum, uint8_t cmd, uint16_t target,
+                                       uint16_t& cap) {
+    uint8_t home = clientNum;
+    if (clientNum == PARDALOTE_ALL_CLIENTS) {
+        home = 0xFF;
+        for (uint8_t c = 0; c < MAX_WS_CLIENTS; c++)
+            if (_clientReady(c)) { home = c; break; }
+    }
+    if (_batching && home < MAX_WS_CLIENTS && _clientReady(home)) {
+        _txRoom(home, _laneOf(cmd, target), FRAME_MAX_SIZE);
+        cap = FRAME_MAX_SIZE;
+        return _txBuf[home] + _txLen[home];
+    }
+    cap = sizeof(_frameScratch);
+    return _frameScratch;
+}
+
+// A frame still sitting at a client's batch tail was built in place —
+// claiming it is just moving it into its lane (after compacting it where
+// it sits, for a compact client). Anything else (scratch-built, or a
+// broadcast's other clients) goes through _sendFrameTo — first, while
+// the in-place copy is still in the standard layout.
+void PardaloteClass::_commitFrame(uint8_t clientNum, FrameWriter& fw) {
+    size_t len = fw.finish();
+    if (len == 0) return;
+    uint8_t home = 0xFF;
+    bool    sent = false;
+    for (uint8_t c = 0; c < MAX_WS_CLIENTS; c++) {
+        if (clientNum != PARDALOTE_ALL_CLIENTS && c != clientNum) continue;
+        if (!_clientReady(c)) continue;
+        sent = true;
+        if (fw.buf == _txBuf[c] + _txLen[c]) home = c;
+        else                                 _sendFrameTo(c, fw.buf, len);
+    }
+    // The loopback client (a sketch command's reply) and a client that
+    // isn't ready get nothing — and the monitor sees nothing either.
+    if (!sent) return;
+    if (home == 0xFF) {
+        _emitFrameOut(fw.buf, len);
+        return;
+    }
+    const uint8_t lane = _laneOf(fw.buf[0], (uint16_t)((fw.buf[1] << 8) | fw.buf[2]));
+    if (_features[home] & FEATURE_COMPACT) {
+        const size_t n = compactFrame(fw.buf, len, fw.buf);
+        if (n) len = n;
+    }
+    uint8_t* at = _txClaim(home, lane, (uint16_t)len);
+    Stats::tx(home, (uint16_t)len);
+    if (_frameHandler) {
+        // After the claim, so a monitor that sends lands behind it — and
+        // from a copy, since that send can move the lanes under it.
+        uint8_t copy[FRAME_MAX_SIZE];
+        memcpy(copy, at, len);
+        _emitFrameOut(copy, len);
+    }
+}
+
+// The ONLY place bytes leave the board — routes to the active transport.
+// What a FEATURE_ACK client is handed joins its backlog.
+bool PardaloteClass::_writeRaw(uint8_t clientNum, uint8_t* buf, size_t len) {
+    const bool sent = _link && _link->send(clientNum, buf, len);
+    if (sent && clientNum < MAX_WS_CLIENTS && (_features[clientNum] & FEATURE_ACK))
+        _addBacklog(clientNum, (int32_t)len);
+    return sent;
+}
+
+// Backlog = bytes written minus bytes acknowledged, floored at 0 (an ACK
+// can cover messages that were in flight when counting started).
+void PardaloteClass::_addBacklog(uint8_t clientNum, int32_t bytes) {
+    if (clientNum >= MAX_WS_CLIENTS) return;
+    int32_t b = _txBacklog[clientNum] + bytes;
+    if (b < 0) b = 0;
+    _txBacklog[clientNum] = b;
+    _refreshBackedUp(clientNum);
+}
+
+void PardaloteClass::_clearBacklog(uint8_t clientNum) {
+    _txBacklog[clientNum] = 0;
+    _refreshBackedUp(clientNum);
+}
+
+// A client is backed up past PARDALOTE_TX_BACKLOG, or while its link
+// can't take another full batch: periodic readings skip it
+// (ExtReadPoll::gate, _offerToClients) until ACKs or the link catch up.
+// Checked again every pass, after the transport has had its turn.
+void PardaloteClass::_refreshBackedUp(uint8_t clientNum) {
+    bool full = false;
+    if (_link && (_connectedClients & (1 << clientNum))) {
+        const size_t room = _link->capacity(clientNum);
+        full = room != PARDALOTE_CAPACITY_UNKNOWN && room < PARDALOTE_TX_BATCH;
+    }
+    setClientBackedUp(clientNum, _txBacklog[clientNum] > PARDALOTE_TX_BACKLOG || full);
+}
+
+// -------------------------------------------------------------------
+// Datagram lane (FEATURE_DATAGRAM) — see internal/datagram_lane.h.
+// -------------------------------------------------------------------
+void PardaloteClass::_startDatagrams() {
+#if PARDALOTE_DATAGRAM
+    if (_datagramPort) _udpLane.begin(_datagramPort);
+#endif
+}
+
+// On: a fresh token for the client to bind with, over the WebSocket.
+// Off: its telemetry stays in the batch.
+void PardaloteClass::_setDatagram(uint8_t clientNum, bool on) {
+#if PARDALOTE_DATAGRAM
+    if (!on) { _udpLane.release(clientNum); return; }
+    PardaloteFrame fb(clientNum, CMD_DATAGRAM, 0x0000);
+    fb.addInt(_udpLane.grant(clientNum, _features[clientNum] & FEATURE_COMPACT));
+    fb.send();
+#else
+    (void)clientNum;
+    (void)on;
+#endif
+}
+
+uint8_t PardaloteClass::_offeredFeatures() const {
+#if PARDALOTE_DATAGRAM
+    if (_udpLane.port()) return PARDALOTE_FEATURES | FEATURE_DATAGRAM;
 #endif
+    return PARDALOTE_FEATURES;
 }
 
 // -------------------------------------------------------------------
@@ -1153,13 +1991,13 @@ void PardaloteClass::_command(uint16_t deviceId, uint8_t cmd, const int32_t* par
     dispatchExtension(0xFF, deviceId, cmd, 0, buf, n, nullptr, 0);
 }
 
-void PardaloteClass::broadcastFrame(FrameBuilder& fb) {
+void PardaloteClass::broadcastFrame(FrameWriter& fb) {
     size_t len = fb.finish();
     if (len == 0) return;
     _emitFrameOut(fb.buf, len);
     for (int c = 0; c < MAX_WS_CLIENTS; c++) {
         if (_clientReady((uint8_t)c))
-            _sendRaw((uint8_t)c, fb.buf, len);
+            _sendFrameTo((uint8_t)c, fb.buf, len);
     }
 }
 
@@ -1178,7 +2016,7 @@ int PardaloteClass::_getSlot(int id) {
 
 void PardaloteClass::_unregisterAction(int id) {
     for (int i = 0; i < NUM_ACTIONS; i++) {
-        if (_actions[i].id == id) { _actions[i].id = -1; return; }
+        if (_actions[i].id == id) { _releaseAction(_actions[i]); return; }
     }
 }
 
@@ -25,9 +25,15 @@
 #include "internal/protocol.h"
 #include "internal/frame_names.h"
 #include "internal/extensions.h"
+#include "internal/at_queue.h"
+#include "internal/stats.h"
+#include "internal/transport.h"
 #include "internal/serial_transport.h"
+#include "internal/loopback_transport.h"
+#include "internal/datagram_lane.h"
+#include "internal/spsc_queue.h"
 #ifndef PARDALOTE_NO_WIFI
-  #include <WebSocketsServer.h>
+  #include "internal/ws_transport.h"
   #include "internal/wifi_config.h"
 #endif
 
@@ -124,6 +130,12 @@ public:
     // the only transport the hardware can have.
     void begin();
     void begin(int transport);
+    //   begin(transport)         — any other PardaloteTransport
+    //                              (internal/transport.h): the in-memory
+    //                              PardaloteLoopbackTransport for host
+    //                              builds and tests, or one of your own.
+    //                              No WiFi and no USB listen.
+    void begin(PardaloteTransport& transport);
 
     // Optional — call BEFORE begin(). Require a connection key on EITHER
     // transport. Over WiFi it latches against connecting to the wrong board
@@ -134,14 +146,32 @@ public:
     // in cleartext. Composes with every begin() form.
     void requireKey(const char* key);
 
+    // Optional — call BEFORE begin(). ESP32 over WiFi: service the
+    // WebSocket in its own task on the other core, handing messages to
+    // run() through lock-free queues, so a burst of network traffic can't
+    // delay servo interpolation or step pulses on the loop core. Costs
+    // 2 × PARDALOTE_NET_QUEUE bytes of heap. Ignored on other boards and
+    // over USB.
+    void splitCores() { _splitCores = true; }
+
+    // Optional — call BEFORE begin(). Open the datagram lane on UDP
+    // `port`: a client that asks for it (FEATURE_DATAGRAM) gets its
+    // periodic readings as datagrams, so one lost packet can't hold up
+    // the readings behind it. Everything else stays on the WebSocket.
+    // Browsers can't use UDP — this is for native tools and test rigs
+    // (see internal/datagram_lane.h). Ignored over USB and on boards
+    // built without it.
+    void datagrams(uint16_t port = PARDALOTE_DATAGRAM_PORT) { _datagramPort = port; }
+
     // Call from loop() — services the WebSocket, runs periodic reads,
     // dispatches per-extension housekeeping.
     void run();
 
-    // Used by extensions to push frames back to clients.
+    // Used by extensions to push frames back to clients. These copy the
+    // frame into the transport; PardaloteFrame (below) builds it in place.
     // Phase 5 makes these the only API (the free-function wrappers go away).
-    void sendFrame(uint8_t clientNum, FrameBuilder& fb);
-    void broadcastFrame(FrameBuilder& fb);
+    void sendFrame(uint8_t clientNum, FrameWriter& fb);
+    void broadcastFrame(FrameWriter& fb);
 
     // Run an extension command locally from the sketch — the same code path a
     // browser command takes. Used by the PardaloteServo / PardaloteStepper
@@ -180,9 +210,13 @@ public:
     // Optional interval (ms) starts board-driven periodic reads of the pin —
     // values flow to every browser with no JS call needed. Optional
     // threshold sets what counts as a meaningful change (0 = board default:
-    // 1 for digital pins, the ADC noise floor for analog).
+    // 1 for digital pins, the ADC noise floor for analog). flags READ_EDGES
+    // watches a digital input with a pin-change interrupt instead: every
+    // edge goes out, undebounced, stamped with the board's micros().
+    //
+    //   Pardalote.share(2, INPUT_PULLUP, 1, 0, READ_EDGES);
     void share(uint8_t pin, uint8_t mode,
-               uint16_t interval = 0, uint16_t threshold = 0);
+               uint16_t interval = 0, uint16_t threshold = 0, uint8_t flags = 0);
     void send (uint8_t pin, int     value);
 
     // -----------------------------------------------------------------------
@@ -213,7 +247,20 @@ public:
     // nothing until a handler is registered.
     void onFrame(PardaloteFrameHandler cb);
 
+    // Loop and command timing, frame and byte counts — see internal/stats.h
+    // (the tables are readable directly as Stats::…). The browser reads the
+    // same numbers with arduino.stats() (CMD_STATS).
+    //
+    //   Pardalote.printStats();     // summary to Serial
+    void printStats(Print& out = Serial);
+    void resetStats() { Stats::reset(); }
+
 private:
+#ifdef PARDALOTE_HOST
+    friend struct PardaloteHostProbe;   // host benchmarks drive the inbound path directly
+#endif
+    friend class PardaloteFrame;
+
     void _command(uint16_t deviceId, uint8_t cmd, const int32_t* params, uint8_t n);
 
     static constexpr uint8_t  MAX_WS_CLIENTS  = PARDALOTE_MAX_CLIENTS;
@@ -232,7 +279,9 @@ private:
     //   short bounce lockout) is transmitted IMMEDIATELY to every client
     //   whose threshold it clears — a client's interval does NOT delay
     //   edges (buttons must not lose or lag their presses). Idle pins
-    //   transmit nothing.
+    //   transmit nothing. With READ_EDGES the pin is interrupt-watched
+    //   instead (edgeSlot >= 0): no loop reads, no lockout, and each edge
+    //   carries its micros() timestamp.
     //
     //   ANALOG — sampled every ANALOG_SAMPLE_MS (an ADC read has real
     //   cost; the loop also generates stepper pulses). Each client hears
@@ -256,6 +305,7 @@ private:
         unsigned long lastSample;     // analog: last ADC read
         int32_t       lastLevel;      // digital: last accepted level (-1 = none yet)
         unsigned long lockoutUntil;   // digital: bounce lockout deadline
+        int8_t        edgeSlot;       // digital: EdgeWatch slot (READ_EDGES), -1 = polled
 
         // Sketch-side registration (share with an interval).
         bool          boardOwned;
@@ -299,21 +349,24 @@ private:
     };
 
 #ifndef PARDALOTE_NO_WIFI
-    WebSocketsServer _ws{81};
-    WifiStore        _wifiStore;
+    PardaloteWsTransport _wsT{81};
+    WifiStore            _wifiStore;
 #endif
 
-    // Transport selection — set once in begin(). The serial transport's
-    // single client is permanently client 0; all the per-client machinery
-    // below serves it as a degenerate case (only bit 0 ever set).
-    enum : uint8_t { TRANSPORT_WIFI = 0, TRANSPORT_SERIAL = 1 };
-    uint8_t                  _transport = TRANSPORT_WIFI;
+    // The active transport — set in begin(), and moved to _serialT by a
+    // USB takeover. The serial transport's single client is permanently
+    // client 0; all the per-client machinery below serves it as a
+    // degenerate case (only bit 0 ever set).
     PardaloteSerialTransport _serialT;
+    PardaloteTransport*      _link = nullptr;
+    bool _onSerial() const { return _link == &_serialT; }
 
     // begin() (default) sets this: WiFi is active but the board also sniffs
     // USB for a takeover probe and switches on a gesture-backed one.
     // begin(PARDALOTE_WIFI) leaves it false (no USB listen).
     bool _serialListen = false;
+    bool _splitCores = false;   // splitCores() — see ws_transport.h
+    uint16_t _datagramPort = 0; // datagrams() — 0 = no lane
     bool _begun = false;   // a begin() form has run — requireKey() too late now
     bool _rebootAnnounced = false;   // CMD_REBOOT sent once per boot (see _announceReboot)
     // Listen-window auth state for the prospective serial client (kept apart
@@ -346,12 +399,80 @@ private:
     bool     _pendingHello[MAX_WS_CLIENTS] = {};
     uint32_t _helloAfter[MAX_WS_CLIENTS]   = {};
 
+    // Continuous analog stream (CMD_ANALOG_STREAM) — one per board,
+    // owned by the client that started it. Blocks go to that client only.
+    static constexpr uint8_t NO_STREAM = 0xFF;
+    uint8_t  _streamClient = NO_STREAM;
+    uint16_t _streamBlock  = 0;    // frames per CMD_ANALOG_BLOCK
+    uint32_t _streamSeq    = 0;
+
+    // Frames parked by CMD_AT until their board time. _replayingAt is
+    // set while one is replayed, so a nested CMD_AT is ignored.
+    AtQueue  _atQueue;
+    bool     _replayingAt = false;
+
+    // Optional encodings each client switched on with CMD_FEATURES
+    // (FEATURE_* bits). Cleared on connect and on a HELLO probe.
+    uint8_t  _features[MAX_WS_CLIENTS]     = {};
+
     // Boot id — random 31-bit token generated once in begin(), sent in
     // HELLO. Lets the browser distinguish "board rebooted (possibly new
     // firmware)" from "same board-run, network blip" and drop stale
     // board-originated state on reboot. Never 0 (0 = "unknown" JS-side).
     uint32_t _bootId = 0;
 
+    // Outbound frame coalescing. Every frame a run() pass produces for a
+    // client — replies, extension DONE/READ frames, the HELLO/announce burst,
+    // pin reads — is appended to that client's batch and flushed as ONE
+    // transport message when the pass ends (one sendBIN / one serial
+    // envelope instead of one per frame). The JS side already walks every
+    // frame in a message. A frame that doesn't fit flushes the batch first.
+    //
+    // The batch is kept in three lanes (TX_LANE_* in extensions.h) —
+    // control, then state, then telemetry — so a frame is inserted at the
+    // end of its lane rather than the end of the batch. _txLane holds the
+    // end offsets of the first two; _txLen is the end of the third. When
+    // a control or state frame doesn't fit, only those two lanes are
+    // written and the telemetry stays for the end of the pass.
+    static_assert(PARDALOTE_TX_BATCH >= FRAME_MAX_SIZE + FRAME_HEADER_SIZE + 4,
+                  "PARDALOTE_TX_BATCH must hold a full frame and its clock stamp");
+    uint8_t  _txBuf[MAX_WS_CLIENTS][PARDALOTE_TX_BATCH];
+    uint16_t _txLen[MAX_WS_CLIENTS] = {};
+    uint16_t _txLane[MAX_WS_CLIENTS][2] = {};
+    bool     _batching = false;   // inside run() — _sendRaw queues
+    bool     _inOrder  = false;   // the connect burst — every frame in the state lane
+
+    // micros() of the CMD_CLOCK most recently put in each lane of each
+    // client's batch (FEATURE_CLOCK clients only — see _txClaim).
+    static constexpr uint16_t TX_CLOCK_SIZE = FRAME_HEADER_SIZE + 4;
+    uint32_t _stampUs[MAX_WS_CLIENTS][3] = {};
+
+    // FEATURE_ACK: bytes written to each client that it hasn't yet
+    // acknowledged with CMD_ACK (see _addBacklog).
+    int32_t  _txBacklog[MAX_WS_CLIENTS] = {};
+
+#if PARDALOTE_DATAGRAM
+    // FEATURE_DATAGRAM: the telemetry lane of a bound client's batch
+    // goes out here instead (see _flushTx). Running over WiFi, and over
+    // begin(transport), when the sketch asked with datagrams().
+    PardaloteDatagramLane _udpLane;
+#endif
+
+    // millis() of run()'s last blocking yield (ESP32 — see _runPass).
+    uint32_t _lastBlockMs = 0;
+
+    // Inbound queue. Transport callbacks only copy a message in; run()
+    // handles it (see _drainInbound). Each record carries its client's
+    // _rxGen, bumped on disconnect, so a dead connection's leftovers are
+    // skipped. _rxPos is how far into the oldest record run() has got.
+    static_assert((PARDALOTE_RX_QUEUE & (PARDALOTE_RX_QUEUE - 1)) == 0,
+                  "PARDALOTE_RX_QUEUE must be a power of two");
+    uint8_t    _rxRing[PARDALOTE_RX_QUEUE];
+    SpscQueue  _rxQueue;
+    uint16_t   _rxPos = 0;
+    uint8_t    _rxGen[MAX_WS_CLIENTS] = {};
+    bool       _rxDraining = false;
+
     Watcher  _watchers[NUM_WATCHERS];
     uint8_t  _watcherCount = 0;
     Retained _retained[NUM_RETAINED];
@@ -359,13 +480,6 @@ private:
     PardaloteFrameHandler   _frameHandler   = nullptr;
 
 #ifndef PARDALOTE_NO_WIFI
-    // WebSocket library wants a free/static function pointer — this
-    // trampoline forwards to the global Pardalote instance.
-    static void _wsEventTrampoline(uint8_t num, WStype_t type,
-                                   uint8_t* payload, size_t length);
-
-    void _handleWsEvent(uint8_t num, WStype_t type,
-                        uint8_t* payload, size_t length);
     void _beginWifi();
     // Runtime WiFi→serial switch (a USB takeover): drop the WS server and the
     // WiFi association (radio stays powered — the sketch may want WiFi), then
@@ -386,48 +500,109 @@ private:
     // browser still holding the port resumes probing and recovers fast.
     void _announceReboot();
 
-    // Serial transport sinks (free-function trampolines, same pattern as
-    // the WS event trampoline).
-    static void _serialMessageTrampoline(uint8_t* data, size_t len);
-    static void _serialConnectTrampoline();
-    static void _serialDisconnectTrampoline();
+    // Make `t` the active transport, its events routed to the sinks
+    // below (free-function trampolines to the global instance).
+    void _attach(PardaloteTransport& t);
+    static void _messageSink(uint8_t client, uint8_t* data, size_t len);
+    static void _connectSink(uint8_t client);
+    static void _disconnectSink(uint8_t client);
     void _onClientConnected(uint8_t num);
     void _onClientDisconnected(uint8_t num);
 
     // Shared inbound path — one binary message (one frame, or a batch),
-    // from either transport.
+    // from any transport. _queueInbound is what the transports call;
+    // _handleBinary/_handleFrame do the work, now or from _drainInbound.
+    void _queueInbound(uint8_t num, uint8_t* payload, size_t length);
+    void _drainInbound(bool all);
+    bool _superseded(uint8_t num, const Frame& f,
+                     uint8_t* payload, size_t pos, size_t length);
     void _handleBinary(uint8_t num, uint8_t* payload, size_t length);
+    void _handleFrame(uint8_t num, const Frame& f, uint8_t* frameStart);
     void _handleAuthFrame(uint8_t num, const Frame& f);
     void _rejectClient(uint8_t num, int32_t reason);
     bool _clientReady(uint8_t c) const {
         return (_connectedClients & (1 << c)) && _authed[c];
     }
 
-    // Raw transport write — the ONLY place bytes leave the board.
+    // Outbound path. _sendRaw is where every frame goes out: during a
+    // run() pass it appends to the client's TX batch; outside one it writes
+    // straight through. _writeRaw is the ONLY place bytes leave the board.
     void _sendRaw(uint8_t clientNum, uint8_t* buf, size_t len);
+    bool _writeRaw(uint8_t clientNum, uint8_t* buf, size_t len);   // false: refused
+    void _flushTx(uint8_t clientNum);
+    void _txHold(uint8_t clientNum, uint16_t control, uint16_t state);
+    void _txDrop(uint8_t clientNum);
+    void _addBacklog(uint8_t clientNum, int32_t bytes);
+    void _clearBacklog(uint8_t clientNum);
+    void _refreshBackedUp(uint8_t clientNum);
+    void _startDatagrams();
+    void _setDatagram(uint8_t clientNum, bool on);   // CMD_DATAGRAM [token] when on
+    uint8_t _offeredFeatures() const;                // PARDALOTE_FEATURES + the lane
+
+    // TX lanes. _txRoom makes `need` bytes free at the batch tail; a
+    // frame written there is then moved to the end of its lane by
+    // _txClaim, which returns where it landed.
+    uint16_t _laneEnd(uint8_t c, uint8_t lane) const {
+        return lane < TX_LANE_TELEMETRY ? _txLane[c][lane] : _txLen[c];
+    }
+    bool     _laneEmpty(uint8_t c, uint8_t lane) const {
+        return _laneEnd(c, lane) == (lane ? _laneEnd(c, lane - 1) : 0);
+    }
+    uint8_t  _laneOf(uint8_t cmd, uint16_t target) const;
+    void     _txRoom(uint8_t clientNum, uint8_t lane, uint16_t need);
+    uint8_t* _txClaim(uint8_t clientNum, uint8_t lane, uint16_t len);
+    void _scheduleAt(uint8_t clientNum, const Frame& f);
+    void _sendStats(uint8_t clientNum, uint8_t flags);
+    void _runDueAt();
+    void _runPass();
+
+    // PardaloteFrame arena. _reserveFrame hands out the tail of the home
+    // client's TX batch (making room first if less than a full frame is
+    // free), or _frameScratch when there is no batch to build in (outside
+    // run(), loopback client, nobody ready). _commitFrame finishes the
+    // frame and claims those bytes into their lane; other recipients of
+    // a broadcast get a copy.
+    uint8_t* _reserveFrame(uint8_t clientNum, uint8_t cmd, uint16_t target, uint16_t& cap);
+    void     _commitFrame(uint8_t clientNum, FrameWriter& fw);
+    uint8_t  _frameScratch[FRAME_MAX_SIZE];
+
+    // One finished standard frame to one client, in the layout that client
+    // negotiated (compacted into _frameAlt for FEATURE_COMPACT).
+    void     _sendFrameTo(uint8_t clientNum, uint8_t* buf, size_t len);
+    uint8_t  _frameAlt[FRAME_MAX_SIZE];
 
     void _handleCoreFrame(uint8_t clientNum, const Frame& f);
     void _pollActions(unsigned long now);
-    void _sendReadTo(uint8_t clientNum, int pin, uint8_t cmd, int32_t val);
+    void _drainEdges(unsigned long now);
+    int32_t _analogSample(uint8_t pin);
+    void _startStream(uint8_t clientNum, const Frame& f);
+    void _stopStream();
+    void _sendStreamStatus(uint8_t clientNum, int8_t status);
+    void _pumpStream();
+    void _sendReadTo(uint8_t clientNum, int pin, uint8_t cmd, int32_t val,
+                     bool stamped = false, uint32_t stampUs = 0);
     void _seedActions(uint8_t clientNum);
     void _sendHello(uint8_t clientNum);
     void _announcePins(uint8_t clientNum);
     void _sendSyncComplete(uint8_t clientNum);
     int  _getSlot(int id);
     void _initAction(int slot, int pin, uint8_t cmd);
+    void _releaseAction(Action& a);
+    void _watchEdges(int slot);
     void _registerClientRead(uint8_t clientNum, int pin, uint8_t cmd,
                              uint16_t interval, uint16_t threshold,
-                             int32_t seedVal);
+                             int32_t seedVal, uint8_t flags);
     void _unregisterAction(int id);
     void _unregisterClient(uint8_t clientNum);
-    void _offerToClients(Action& a, int32_t val, unsigned long now, bool respectSpacing);
+    void _offerToClients(Action& a, int32_t val, unsigned long now, bool respectSpacing,
+                         uint32_t stampUs = 0);
     static uint16_t _defaultThreshold(uint8_t cmd);
 
     // Message channel internals.
     void _emitMessage(uint8_t type, uint8_t flags, const char* key,
                       int32_t intVal, float floatVal,
                       const uint8_t* value, uint16_t valueLen);
-    void _buildMessageFrame(FrameBuilder& fb, uint8_t type, uint8_t flags,
+    void _buildMessageFrame(FrameWriter& fb, uint8_t type, uint8_t flags,
                             const char* key, uint8_t keyLen,
                             int32_t intVal, float floatVal,
                             const uint8_t* value, uint16_t valueLen);
@@ -446,4 +621,37 @@ private:
 
 extern PardaloteClass Pardalote;
 
+// -------------------------------------------------------------------
+// PardaloteFrame — a FrameWriter that builds the frame directly in the
+// transport's outbound batch (see _txBuf), so it is written exactly
+// once, in the place it is sent from: no stack buffer, no copy into the
+// transport. A broadcast is built once and copied only for the second
+// and later clients.
+//
+//   PardaloteFrame f(clientNum, CMD_SERVO_READ, DEVICE_SERVO);
+//   f.addInt(instanceId);
+//   f.addInt(angle);
+//   f.send();
+//
+// Pass PARDALOTE_ALL_CLIENTS to broadcast. Keep ONE frame open at a
+// time and send() it before anything else sends — the frame occupies
+// the batch tail, so a send in between would overwrite it. A frame that
+// is never sent (or overflowed) is simply dropped.
+// -------------------------------------------------------------------
+class PardaloteFrame : public FrameWriter {
+public:
+    PardaloteFrame(uint8_t clientNum, uint8_t cmd, uint16_t target)
+        : FrameWriter(nullptr, 0), _client(clientNum) {
+        uint16_t cap;
+        uint8_t* at = Pardalote._reserveFrame(clientNum, cmd, target, cap);
+        _bind(at, cap);
+        begin(cmd, target);
+    }
+
+    void send() { Pardalote._commitFrame(_client, *this); }
+
+private:
+    uint8_t _client;
+};
+
 #endif
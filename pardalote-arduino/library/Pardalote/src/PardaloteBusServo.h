@@ -389,22 +389,20 @@ public:
     // Send the cached firmware limits to one client: [id, min, max] (raw
     // counts; -1 = unknown). JS interprets min==max==0 as "disabled".
     static void sendFwLimits(uint8_t clientNum, int id) {
-        FrameBuilder fb;
-        fb.begin(CMD_BUSSERVO_READ_LIMITS, DEVICE_BUSSERVO);
+        PardaloteFrame fb(clientNum, CMD_BUSSERVO_READ_LIMITS, DEVICE_BUSSERVO);
         fb.addInt(id);
         fb.addInt(_fwLimitMin[id]);
         fb.addInt(_fwLimitMax[id]);
-        Pardalote.sendFrame(clientNum, fb);
+        fb.send();
     }
 
     // Send the cached attach-time presence to one client: [id, servoId, present].
     static void sendPresence(uint8_t clientNum, int id) {
-        FrameBuilder fb;
-        fb.begin(CMD_BUSSERVO_PRESENT, DEVICE_BUSSERVO);
+        PardaloteFrame fb(clientNum, CMD_BUSSERVO_PRESENT, DEVICE_BUSSERVO);
         fb.addInt(id);
         fb.addInt(_servoId[id]);
         fb.addInt(_found[id]);
-        Pardalote.sendFrame(clientNum, fb);
+        fb.send();
     }
 
     // Echo a sketch-issued write to the browser so it sets its cached target
@@ -416,22 +414,20 @@ public:
         // actually applied — physical range always, soft limits when set.
         position = constrain(position, 0, isSC(id) ? 1023 : 4095);
         if (_limitSet[id]) position = constrain(position, _minPos[id], _maxPos[id]);
-        FrameBuilder fb;
-        fb.begin(CMD_BUSSERVO_WRITE, DEVICE_BUSSERVO);
+        PardaloteFrame fb(PARDALOTE_ALL_CLIENTS, CMD_BUSSERVO_WRITE, DEVICE_BUSSERVO);
         fb.addInt(id);
         fb.addInt(position);
-        Pardalote.broadcastFrame(fb);
+        fb.send();
     }
 
     // Echo a sketch-issued torque change so the browser's cached torque state
     // stays in sync (teach-by-demonstration reads it). Addressed by logical id.
     static void echoTorque(int id, bool on) {
         if (!validId(id) || !_attached[id]) return;
-        FrameBuilder fb;
-        fb.begin(CMD_BUSSERVO_TORQUE, DEVICE_BUSSERVO);
+        PardaloteFrame fb(PARDALOTE_ALL_CLIENTS, CMD_BUSSERVO_TORQUE, DEVICE_BUSSERVO);
         fb.addInt(id);
         fb.addInt(on ? 1 : 0);
-        Pardalote.broadcastFrame(fb);
+        fb.send();
     }
 
     // -------------------------------------------------------------------
@@ -489,11 +485,10 @@ public:
     }
 
     static void broadcastShare(int id) {
-        FrameBuilder fb;
-        fb.begin(CMD_SHARE, DEVICE_BUSSERVO);
+        PardaloteFrame fb(PARDALOTE_ALL_CLIENTS, CMD_SHARE, DEVICE_BUSSERVO);
         fb.addInt(id);
         fb.addString(_names[id]);
-        Pardalote.broadcastFrame(fb);
+        fb.send();
     }
 
     // Emit this instance's attach frame (servo ID + series) followed by its
@@ -501,25 +496,16 @@ public:
     // and announce (unicast to one joining client) so the two stay in
     // lockstep. When `unicast` is false, `clientNum` is ignored.
     static void sendAttachState(int id, bool unicast, uint8_t clientNum) {
-        FrameBuilder fa;
-        fa.begin(CMD_BUSSERVO_ATTACH, DEVICE_BUSSERVO);
+        const uint8_t to = unicast ? clientNum : PARDALOTE_ALL_CLIENTS;
+        PardaloteFrame fa(to, CMD_BUSSERVO_ATTACH, DEVICE_BUSSERVO);
         fa.addInt(id); fa.addInt(_servoId[id]); fa.addInt(_series[id]);
-        FrameBuilder fm;
-        fm.begin(CMD_BUSSERVO_SET_MODE, DEVICE_BUSSERVO);
+        fa.send();
+        PardaloteFrame fm(to, CMD_BUSSERVO_SET_MODE, DEVICE_BUSSERVO);
         fm.addInt(id); fm.addInt(_mode[id]);
-        FrameBuilder ft;
-        ft.begin(CMD_BUSSERVO_TORQUE, DEVICE_BUSSERVO);
+        fm.send();
+        PardaloteFrame ft(to, CMD_BUSSERVO_TORQUE, DEVICE_BUSSERVO);
         ft.addInt(id); ft.addInt(_torque[id] ? 1 : 0);
-
-        if (unicast) {
-            Pardalote.sendFrame(clientNum, fa);
-            Pardalote.sendFrame(clientNum, fm);
-            Pardalote.sendFrame(clientNum, ft);
-        } else {
-            Pardalote.broadcastFrame(fa);
-            Pardalote.broadcastFrame(fm);
-            Pardalote.broadcastFrame(ft);
-        }
+        ft.send();
     }
 
     // -------------------------------------------------------------------
@@ -551,19 +537,15 @@ public:
             ensureBus();
             if (nparams < 1 || payloadLen < 6) return;
             int series = (int)paramInt(params, 0);
-            const int REC = 6;                    // servoId(1) pos(2) speed(2) acc(1)
-            int count = payloadLen / REC;
+            using SyncRecord = RecordSchema<uint8_t, int16_t, uint16_t, uint8_t>;   // servoId pos speed acc
+            const int count = SyncRecord::countIn(payloadLen);
             static uint8_t  ids[MAX_BUS_SERVOS];
             static int16_t  positions[MAX_BUS_SERVOS];
             static uint16_t speeds[MAX_BUS_SERVOS];
             static uint8_t  accs[MAX_BUS_SERVOS];
             int n = 0;
             for (int i = 0; i < count && n < MAX_BUS_SERVOS; i++) {
-                uint8_t* r   = payload + i * REC;
-                ids[n]       = r[0];
-                positions[n] = (int16_t)(((uint16_t)r[1] << 8) | r[2]);
-                speeds[n]    = (uint16_t)(((uint16_t)r[3] << 8) | r[4]);
-                accs[n]      = r[5];
+                SyncRecord::read(payload + i * SyncRecord::size, ids[n], positions[n], speeds[n], accs[n]);
                 // Clamp to the series' physical range first (SyncWrite skips
                 // writePos, so it needs its own guard against the mod-wrap
                 // lurch), then apply the bound instance's soft limits.
@@ -595,20 +577,18 @@ public:
         if (cmd == CMD_BUSSERVO_GESTURE) {
             ensureBus();
             uint16_t off = 0;
-            while (off + 3 <= payloadLen) {
-                int     sid   = payload[off];
-                uint8_t flags = payload[off + 1];
-                uint8_t count = payload[off + 2];
-                off += 3;
-                if ((uint32_t)off + (uint32_t)count * 7 > payloadLen) break;   // malformed — stop
+            while (off + GestureChannelRecord::size <= payloadLen) {
+                uint8_t sid, flags, count;
+                GestureChannelRecord::read(payload + off, sid, flags, count);
+                off += GestureChannelRecord::size;
+                const uint32_t block = (uint32_t)count * GestureSegRecord::size;
+                if (off + block > payloadLen) break;   // malformed — stop
                 if (validId(sid) && _attached[sid] && count > 0) {
                     uint8_t nseg = count > MAX_BUS_SERVO_SEGMENTS ? MAX_BUS_SERVO_SEGMENTS : count;
                     for (uint8_t i = 0; i < nseg; i++) {
-                        const uint8_t* r = payload + off + i * 7;
-                        _bsegs[sid][i].curve = r[0];
-                        _bsegs[sid][i].dur   = (uint16_t)(((uint16_t)r[1] << 8) | r[2]);
-                        _bsegs[sid][i].value = (int32_t)(((uint32_t)r[3] << 24) | ((uint32_t)r[4] << 16) |
-                                                         ((uint32_t)r[5] <<  8) |  (uint32_t)r[6]);
+                        auto& g = _bsegs[sid][i];
+                        GestureSegRecord::read(payload + off + i * GestureSegRecord::size,
+                                               g.curve, g.dur, g.value);
                     }
                     _bsegCount[sid] = nseg;
                     _bsegFlags[sid] = flags;
@@ -617,7 +597,7 @@ public:
                     _bsegFrom[sid] = from;
                     loadBusSegment(sid, 0);
                 }
-                off += (uint16_t)count * 7;                       // skip the whole declared block
+                off += (uint16_t)block;                           // skip the whole declared block
             }
             return;
         }
@@ -727,9 +707,9 @@ public:
                 }
 
                 if (!_attached[id]) return;
-                FrameBuilder fb;
+                PardaloteFrame fb(clientNum, CMD_BUSSERVO_READ, DEVICE_BUSSERVO);
                 int32_t pos = buildRead(fb, id);
-                Pardalote.sendFrame(clientNum, fb);
+                fb.send();
 
                 if (ms > 0) {
                     ExtReadPoll* p = extPollGet(_polls, MAX_BUS_SERVOS, id);
@@ -802,10 +782,9 @@ public:
                 uint8_t sid = (uint8_t)paramInt(params, 1);
                 bool sc = _attached[id] ? isSC(id) : false;
                 int found = sc ? _sc.Ping(sid) : _st.Ping(sid);
-                FrameBuilder fb;
-                fb.begin(CMD_BUSSERVO_PING, DEVICE_BUSSERVO);
+                PardaloteFrame fb(PARDALOTE_ALL_CLIENTS, CMD_BUSSERVO_PING, DEVICE_BUSSERVO);
                 fb.addInt(id); fb.addInt(sid); fb.addInt(found != -1 ? 1 : 0);
-                Pardalote.broadcastFrame(fb);
+                fb.send();
                 break;
             }
 
@@ -821,7 +800,7 @@ public:
     // buildRead() does the transaction and fills the frame; returns the
     // present position (or -1) for threshold gating.
     // -------------------------------------------------------------------
-    static int32_t buildRead(FrameBuilder& fb, int id) {
+    static int32_t buildRead(FrameWriter& fb, int id) {
         uint8_t sid = _servoId[id];
         int pos = -1, speed = 0, load = 0, voltage = 0, temp = 0, current = 0;
         bool sc = isSC(id);
@@ -858,8 +837,7 @@ public:
     // first up-to-15 found in a single frame [count, id1, ...].
     // -------------------------------------------------------------------
     static void scan(int first, int last) {
-        FrameBuilder fb;
-        fb.begin(CMD_BUSSERVO_SCAN, DEVICE_BUSSERVO);
+        PardaloteFrame fb(PARDALOTE_ALL_CLIENTS, CMD_BUSSERVO_SCAN, DEVICE_BUSSERVO);
         uint8_t found[15];
         int n = 0;
         for (int sid = first; sid <= last && n < 15; sid++) {
@@ -868,20 +846,22 @@ public:
         }
         fb.addInt(n);
         for (int i = 0; i < n; i++) fb.addInt(found[i]);
-        Pardalote.broadcastFrame(fb);
+        fb.send();
         Serial.print(F("BusServo: scan found ")); Serial.print(n); Serial.println(F(" servo(s)"));
     }
 
     // -------------------------------------------------------------------
-    // Loop hook — polls the Moving flag of any servo awaiting arrival (after
-    // a position write) at ~30 Hz, and broadcasts CMD_BUSSERVO_DONE when it
-    // settles (or after a timeout). Reading doesn't interrupt the servo's
-    // motion — it's a status query, run concurrently with its control loop.
+    // Loop hook — timed: runs only when a Moving poll or a read is due.
+    // Polls the Moving flag of any servo awaiting arrival (after a position
+    // write) at ~30 Hz, and broadcasts CMD_BUSSERVO_DONE when it settles (or
+    // after a timeout). Reading doesn't interrupt the servo's motion — it's
+    // a status query, run concurrently with its control loop.
     // -------------------------------------------------------------------
-    static void loop() {
-        uint32_t now = millis();
+    static uint32_t loop(uint32_t now) {
+        uint32_t next = EXT_LOOP_IDLE;
         for (int id = 0; id < MAX_BUS_SERVOS; id++) {
             if (!_attached[id] || !_awaitDone[id]) continue;
+
             if (now - _awaitStartMs[id]   < MOVE_STARTUP_MS) continue;   // let it start moving
             if (now - _lastMovePollMs[id] < MOVE_POLL_MS)    continue;   // ~30 Hz
             _lastMovePollMs[id] = now;
@@ -916,11 +896,19 @@ public:
             }
 
             int pos = readPos(_servoId[id]);
-            FrameBuilder fb;
-            fb.begin(CMD_BUSSERVO_DONE, DEVICE_BUSSERVO);
+            PardaloteFrame fb(PARDALOTE_ALL_CLIENTS, CMD_BUSSERVO_DONE, DEVICE_BUSSERVO);
             fb.addInt(id);
             fb.addInt(pos);
-            Pardalote.broadcastFrame(fb);
+            fb.send();
+        }
+
+        // Anything still awaiting arrival polls again once both the startup
+        // and the poll spacing have passed.
+        for (int id = 0; id < MAX_BUS_SERVOS; id++) {
+            if (!_attached[id] || !_awaitDone[id]) continue;
+            const uint32_t startup = extMsUntil(now, _awaitStartMs[id],   MOVE_STARTUP_MS);
+            const uint32_t poll    = extMsUntil(now, _lastMovePollMs[id], MOVE_POLL_MS);
+            extDueIn(next, startup > poll ? startup : poll);
         }
 
         // Board-side periodic reads — ONE FeedBack() transaction per due
@@ -964,6 +952,8 @@ public:
             for (uint8_t c = 0; c < PARDALOTE_MAX_CLIENTS; c++)
                 if (p.gate(c, pos, now)) Pardalote.sendFrame(c, fb);
         }
+        extDueIn(next, extPollNextDue(_polls, MAX_BUS_SERVOS, now));
+        return next;
     }
 
     // Client disconnect — drop its read registrations.
@@ -977,18 +967,16 @@ public:
     // replayed here.
     // -------------------------------------------------------------------
     static void announce(uint8_t clientNum) {
-        FrameBuilder fb;
-        fb.begin(CMD_ANNOUNCE, DEVICE_BUSSERVO);
+        PardaloteFrame fb(clientNum, CMD_ANNOUNCE, DEVICE_BUSSERVO);
         fb.addInt(PROTOCOL_VERSION_MAJOR);
         fb.addInt(MAX_BUS_SERVOS);
-        Pardalote.sendFrame(clientNum, fb);
+        fb.send();
 
         if (_busConfigured) {
-            FrameBuilder fc;
-            fc.begin(CMD_BUSSERVO_BUS_CONFIG, DEVICE_BUSSERVO);
+            PardaloteFrame fc(clientNum, CMD_BUSSERVO_BUS_CONFIG, DEVICE_BUSSERVO);
             fc.addInt(_serialIndex); fc.addInt((int32_t)_baud);
             fc.addInt(_rxPin); fc.addInt(_txPin);
-            Pardalote.sendFrame(clientNum, fc);
+            fc.send();
         }
 
         for (int i = 0; i < MAX_BUS_SERVOS; i++) {
@@ -998,21 +986,19 @@ public:
             // browser materialises arduino.<name> before the attach/state
             // frames below arrive to sync it.
             if (_sketchOwned[i]) {
-                FrameBuilder fsh;
-                fsh.begin(CMD_SHARE, DEVICE_BUSSERVO);
+                PardaloteFrame fsh(clientNum, CMD_SHARE, DEVICE_BUSSERVO);
                 fsh.addInt(i);
                 fsh.addString(_names[i]);
-                Pardalote.sendFrame(clientNum, fsh);
+                fsh.send();
             }
 
             // Replay attach (servo ID + series), mode, and torque.
             sendAttachState(i, true, clientNum);
 
             if (_limitSet[i]) {
-                FrameBuilder fl;
-                fl.begin(CMD_BUSSERVO_SET_LIMITS, DEVICE_BUSSERVO);
+                PardaloteFrame fl(clientNum, CMD_BUSSERVO_SET_LIMITS, DEVICE_BUSSERVO);
                 fl.addInt(i); fl.addInt(_minPos[i]); fl.addInt(_maxPos[i]); fl.addInt(1);
-                Pardalote.sendFrame(clientNum, fl);
+                fl.send();
             }
 
             // Replay the cached firmware limits (read once at attach) — no
@@ -1095,4 +1081,7 @@ inline PardaloteBusServoAccess PardaloteBusServo;
 INSTALL_EXTENSION(DEVICE_BUSSERVO, BusServoExt::handle, BusServoExt::announce,
                   BusServoExt::disconnect, BusServoExt::loop)
 
+OUTBOUND_LANE(DEVICE_BUSSERVO, CMD_BUSSERVO_DONE, TX_LANE_CONTROL)
+OUTBOUND_LANE(DEVICE_BUSSERVO, CMD_BUSSERVO_READ, TX_LANE_TELEMETRY)
+
 #endif
@@ -604,11 +604,10 @@ public:
 
                 // Echo confirmed port back to all clients so every browser
                 // connecting after the first also learns the stream URL.
-                FrameBuilder fb;
-                fb.begin(CMD_CAMERA_INIT, DEVICE_CAMERA);
+                PardaloteFrame fb(PARDALOTE_ALL_CLIENTS, CMD_CAMERA_INIT, DEVICE_CAMERA);
                 fb.addInt(id);
                 fb.addInt((int)_port);
-                Pardalote.broadcastFrame(fb);
+                fb.send();
                 break;
             }
 
@@ -659,11 +658,10 @@ public:
         _clientCount++;
         _shutdownPending = false;  // cancel idle shutdown if a new client arrived
 
-        FrameBuilder fa;
-        fa.begin(CMD_ANNOUNCE, DEVICE_CAMERA);
+        PardaloteFrame fa(clientNum, CMD_ANNOUNCE, DEVICE_CAMERA);
         fa.addInt(PROTOCOL_VERSION_MAJOR);
         fa.addInt(1);   // max instances
-        Pardalote.sendFrame(clientNum, fa);
+        fa.send();
     }
 
     // ----------------------------------------------------------------
@@ -687,14 +685,16 @@ public:
     }
 
     // ----------------------------------------------------------------
-    // Called every loop() iteration. Deinits the camera hardware once
-    // the timeout has elapsed with no clients reconnecting.
+    // Timed loop hook — woken by disconnect(). Deinits the camera
+    // hardware once the timeout has elapsed with no clients reconnecting.
     // ----------------------------------------------------------------
-    static void loop() {
-        if (!_shutdownPending) return;
-        if (millis() - _shutdownStart < CAMERA_IDLE_TIMEOUT_MS) return;
+    static uint32_t loop(uint32_t now) {
+        if (!_shutdownPending) return EXT_LOOP_IDLE;
+        const uint32_t wait = extMsUntil(now, _shutdownStart, CAMERA_IDLE_TIMEOUT_MS);
+        if (wait) return wait;
         _shutdownPending = false;
         _stopCamera();
+        return EXT_LOOP_IDLE;
     }
 };
 
@@ -110,19 +110,17 @@ private:
     }
 
     static void sendReadTo(uint8_t clientNum, int id, int32_t pos) {
-        FrameBuilder fb;
-        fb.begin(CMD_ENCODER_READ, DEVICE_ENCODER);
+        PardaloteFrame fb(clientNum, CMD_ENCODER_READ, DEVICE_ENCODER);
         fb.addInt(id);
         fb.addInt(pos);
-        Pardalote.sendFrame(clientNum, fb);
+        fb.send();
     }
 
     static void broadcastRead(int id, int32_t pos) {
-        FrameBuilder fb;
-        fb.begin(CMD_ENCODER_READ, DEVICE_ENCODER);
+        PardaloteFrame fb(PARDALOTE_ALL_CLIENTS, CMD_ENCODER_READ, DEVICE_ENCODER);
         fb.addInt(id);
         fb.addInt(pos);
-        Pardalote.broadcastFrame(fb);
+        fb.send();
     }
 
     static void doAttach(int id, int a, int b) {
@@ -154,11 +152,10 @@ private:
     }
 
     static void broadcastShare(int id) {
-        FrameBuilder fb;
-        fb.begin(CMD_SHARE, DEVICE_ENCODER);
+        PardaloteFrame fb(PARDALOTE_ALL_CLIENTS, CMD_SHARE, DEVICE_ENCODER);
         fb.addInt(id);
         fb.addString(_names[id]);
-        Pardalote.broadcastFrame(fb);
+        fb.send();
     }
 
 public:
@@ -213,10 +210,9 @@ public:
 
         // Tell any connected browsers now (announce() covers future connects).
         broadcastShare(id);
-        FrameBuilder fa;
-        fa.begin(CMD_ENCODER_ATTACH, DEVICE_ENCODER);
+        PardaloteFrame fa(PARDALOTE_ALL_CLIENTS, CMD_ENCODER_ATTACH, DEVICE_ENCODER);
         fa.addInt(id); fa.addInt(a); fa.addInt(b);
-        Pardalote.broadcastFrame(fa);
+        fa.send();
         return id;
     }
 
@@ -298,10 +294,11 @@ public:
     // client's gate: interval = rate limit, threshold in steps. A spin
     // suppressed by the rate limit self-resolves — the next pass after
     // the spacing expires still sees position != lastSent and transmits
-    // the latest value.
+    // the latest value. Timed, but the ISRs can't wake it, so it asks
+    // for every pass while anyone is registered and sleeps otherwise.
     // -------------------------------------------------------------------
-    static void loop() {
-        const unsigned long now = millis();
+    static uint32_t loop(uint32_t now) {
+        uint32_t next = EXT_LOOP_IDLE;
         for (int i = 0; i < MAX_ENCODERS; i++) {
             ExtReadPoll& p = _polls[i];
             if (p.instance == -1 || !p.clientMask) continue;
@@ -309,7 +306,9 @@ public:
             const int32_t pos = _count[p.instance];
             for (uint8_t c = 0; c < PARDALOTE_MAX_CLIENTS; c++)
                 if (p.gate(c, pos, now)) sendReadTo(c, p.instance, pos);
+            next = 0;
         }
+        return next;
     }
 
     // Client disconnect — drop its read registrations.
@@ -323,29 +322,26 @@ public:
     // without waiting for the knob to move.
     // -------------------------------------------------------------------
     static void announce(uint8_t clientNum) {
-        FrameBuilder fb;
-        fb.begin(CMD_ANNOUNCE, DEVICE_ENCODER);
+        PardaloteFrame fb(clientNum, CMD_ANNOUNCE, DEVICE_ENCODER);
         fb.addInt(PROTOCOL_VERSION_MAJOR);
         fb.addInt(MAX_ENCODERS);
-        Pardalote.sendFrame(clientNum, fb);
+        fb.send();
 
         for (int i = 0; i < MAX_ENCODERS; i++) {
             if (!_attached[i]) continue;
 
             if (_sketchOwned[i]) {
-                FrameBuilder fsh;
-                fsh.begin(CMD_SHARE, DEVICE_ENCODER);
+                PardaloteFrame fsh(clientNum, CMD_SHARE, DEVICE_ENCODER);
                 fsh.addInt(i);
                 fsh.addString(_names[i]);
-                Pardalote.sendFrame(clientNum, fsh);
+                fsh.send();
             }
 
-            FrameBuilder fa;
-            fa.begin(CMD_ENCODER_ATTACH, DEVICE_ENCODER);
+            PardaloteFrame fa(clientNum, CMD_ENCODER_ATTACH, DEVICE_ENCODER);
             fa.addInt(i);
             fa.addInt(_pinA[i]);
             fa.addInt(_pinB[i]);
-            Pardalote.sendFrame(clientNum, fa);
+            fa.send();
 
             sendReadTo(clientNum, i, _count[i]);
         }
@@ -381,5 +377,6 @@ inline PardaloteEncoderAccess PardaloteEncoder;
 
 INSTALL_EXTENSION(DEVICE_ENCODER, EncoderExt::handle, EncoderExt::announce,
                   EncoderExt::disconnect, EncoderExt::loop)
+OUTBOUND_LANE(DEVICE_ENCODER, CMD_ENCODER_READ, TX_LANE_TELEMETRY)
 
 #endif
@@ -212,7 +212,7 @@ private:
     inline static ExtReadPoll _polls[MAX_IMUS] = {};
 
     // One I2C read, frame filled for sending. False if the read failed.
-    static bool buildRead(FrameBuilder& fb, int id) {
+    static bool buildRead(FrameWriter& fb, int id) {
         float ax, ay, az, gx, gy, gz, temp;
         if (!readSensor(id, ax, ay, az, gx, gy, gz, temp)) return false;
         fb.begin(CMD_IMU_READ, DEVICE_IMU);
@@ -405,28 +405,24 @@ public:
         // Tell any connected browsers now (announce() covers future connects):
         // name → attach (model in payload) → ranges.
         broadcastShare(id);
-        FrameBuilder fa;
-        fa.begin(CMD_IMU_ATTACH, DEVICE_IMU);
+        PardaloteFrame fa(PARDALOTE_ALL_CLIENTS, CMD_IMU_ATTACH, DEVICE_IMU);
         fa.addInt(id); fa.addInt(a); fa.addString(_def[id]->name);
-        Pardalote.broadcastFrame(fa);
-        FrameBuilder fr;
-        fr.begin(CMD_IMU_SET_ACCEL_RANGE, DEVICE_IMU);
+        fa.send();
+        PardaloteFrame fr(PARDALOTE_ALL_CLIENTS, CMD_IMU_SET_ACCEL_RANGE, DEVICE_IMU);
         fr.addInt(id); fr.addInt(_accelRange[id]);
-        Pardalote.broadcastFrame(fr);
-        FrameBuilder fg;
-        fg.begin(CMD_IMU_SET_GYRO_RANGE, DEVICE_IMU);
+        fr.send();
+        PardaloteFrame fg(PARDALOTE_ALL_CLIENTS, CMD_IMU_SET_GYRO_RANGE, DEVICE_IMU);
         fg.addInt(id); fg.addInt(_gyroRange[id]);
-        Pardalote.broadcastFrame(fg);
+        fg.send();
 
         return id;
     }
 
     static void broadcastShare(int id) {
-        FrameBuilder fb;
-        fb.begin(CMD_SHARE, DEVICE_IMU);
+        PardaloteFrame fb(PARDALOTE_ALL_CLIENTS, CMD_SHARE, DEVICE_IMU);
         fb.addInt(id);
         fb.addString(_names[id]);
-        Pardalote.broadcastFrame(fb);
+        fb.send();
     }
 
     // -------------------------------------------------------------------
@@ -508,9 +504,9 @@ public:
                 }
 
                 if (!_attached[id]) return;
-                FrameBuilder fb;
+                PardaloteFrame fb(clientNum, CMD_IMU_READ, DEVICE_IMU);
                 if (!buildRead(fb, id)) return;
-                Pardalote.sendFrame(clientNum, fb);
+                fb.send();
 
                 if (ms > 0) {
                     ExtReadPoll* p = extPollGet(_polls, MAX_IMUS, id);
@@ -587,12 +583,11 @@ public:
                 _calibrated[id] = true;
                 Serial.println(F("IMU: calibration complete"));
 
-                FrameBuilder fb;
-                fb.begin(CMD_IMU_CALIBRATE, DEVICE_IMU);
+                PardaloteFrame fb(PARDALOTE_ALL_CLIENTS, CMD_IMU_CALIBRATE, DEVICE_IMU);
                 fb.addInt(id);
                 fb.addFloat(_calAx[id]); fb.addFloat(_calAy[id]); fb.addFloat(_calAz[id]);
                 fb.addFloat(_calGx[id]); fb.addFloat(_calGy[id]); fb.addFloat(_calGz[id]);
-                Pardalote.broadcastFrame(fb);
+                fb.send();
                 break;
             }
 
@@ -606,11 +601,10 @@ public:
     // Called on each new client connection
     // -------------------------------------------------------------------
     static void announce(uint8_t clientNum) {
-        FrameBuilder fb;
-        fb.begin(CMD_ANNOUNCE, DEVICE_IMU);
+        PardaloteFrame fb(clientNum, CMD_ANNOUNCE, DEVICE_IMU);
         fb.addInt(PROTOCOL_VERSION_MAJOR);
         fb.addInt(MAX_IMUS);
-        Pardalote.sendFrame(clientNum, fb);
+        fb.send();
 
         for (int i = 0; i < MAX_IMUS; i++) {
             if (!_attached[i] || !_def[i]) continue;
@@ -618,50 +612,44 @@ public:
             // Sketch-created sensor: send its SHARE frame FIRST so the browser
             // materialises arduino.<name> before the state frames below.
             if (_sketchOwned[i]) {
-                FrameBuilder fsh;
-                fsh.begin(CMD_SHARE, DEVICE_IMU);
+                PardaloteFrame fsh(clientNum, CMD_SHARE, DEVICE_IMU);
                 fsh.addInt(i);
                 fsh.addString(_names[i]);
-                Pardalote.sendFrame(clientNum, fsh);
+                fsh.send();
             }
 
             // Re-send attach state. Model name is carried in the payload so
             // the JS side can identify the sensor by its string key.
-            FrameBuilder fa;
-            fa.begin(CMD_IMU_ATTACH, DEVICE_IMU);
+            PardaloteFrame fa(clientNum, CMD_IMU_ATTACH, DEVICE_IMU);
             fa.addInt(i);
             fa.addInt(_addr[i]);
             fa.addString(_def[i]->name);
-            Pardalote.sendFrame(clientNum, fa);
+            fa.send();
 
-            FrameBuilder fr;
-            fr.begin(CMD_IMU_SET_ACCEL_RANGE, DEVICE_IMU);
+            PardaloteFrame fr(clientNum, CMD_IMU_SET_ACCEL_RANGE, DEVICE_IMU);
             fr.addInt(i); fr.addInt(_accelRange[i]);
-            Pardalote.sendFrame(clientNum, fr);
+            fr.send();
 
-            FrameBuilder fg;
-            fg.begin(CMD_IMU_SET_GYRO_RANGE, DEVICE_IMU);
+            PardaloteFrame fg(clientNum, CMD_IMU_SET_GYRO_RANGE, DEVICE_IMU);
             fg.addInt(i); fg.addInt(_gyroRange[i]);
-            Pardalote.sendFrame(clientNum, fg);
+            fg.send();
 
             if (_calibrated[i]) {
-                FrameBuilder fc;
-                fc.begin(CMD_IMU_CALIBRATE, DEVICE_IMU);
+                PardaloteFrame fc(clientNum, CMD_IMU_CALIBRATE, DEVICE_IMU);
                 fc.addInt(i);
                 fc.addFloat(_calAx[i]); fc.addFloat(_calAy[i]); fc.addFloat(_calAz[i]);
                 fc.addFloat(_calGx[i]); fc.addFloat(_calGy[i]); fc.addFloat(_calGz[i]);
-                Pardalote.sendFrame(clientNum, fc);
+                fc.send();
             }
         }
     }
 
     // -------------------------------------------------------------------
-    // Loop hook — board-side periodic reads. ONE I2C transaction per due
-    // registration; every registered client at its own interval (no
-    // threshold — see the _polls comment).
+    // Loop hook (timed) — board-side periodic reads. ONE I2C transaction
+    // per due registration; every registered client at its own interval
+    // (no threshold — see the _polls comment).
     // -------------------------------------------------------------------
-    static void loop() {
-        const unsigned long now = millis();
+    static uint32_t loop(uint32_t now) {
         for (int i = 0; i < MAX_IMUS; i++) {
             ExtReadPoll& p = _polls[i];
             if (!p.due(now)) continue;
@@ -671,6 +659,7 @@ public:
             for (uint8_t c = 0; c < PARDALOTE_MAX_CLIENTS; c++)
                 if (p.gate(c, 0, now)) Pardalote.sendFrame(c, fb);
         }
+        return extPollNextDue(_polls, MAX_IMUS, now);
     }
 
     // Client disconnect — drop its read registrations.
@@ -726,5 +715,6 @@ inline PardaloteIMUAccess PardaloteIMU;
 
 INSTALL_EXTENSION(DEVICE_IMU, ImuExt::handle, ImuExt::announce,
                   ImuExt::disconnect, ImuExt::loop)
+OUTBOUND_LANE(DEVICE_IMU, CMD_IMU_READ, TX_LANE_TELEMETRY)
 
 #endif
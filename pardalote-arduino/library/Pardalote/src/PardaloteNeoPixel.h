@@ -88,21 +88,19 @@ public:
         // Tell any connected browsers now (no-op when none are connected;
         // announce() covers future connects): name → init.
         broadcastShare(id);
-        FrameBuilder fi;
-        fi.begin(CMD_NEO_INIT, DEVICE_NEO_PIXEL);
+        PardaloteFrame fi(PARDALOTE_ALL_CLIENTS, CMD_NEO_INIT, DEVICE_NEO_PIXEL);
         fi.addInt(id); fi.addInt(_pins[id]);
         fi.addInt(_numPixels[id]); fi.addInt((int32_t)_types[id]);
-        Pardalote.broadcastFrame(fi);
+        fi.send();
 
         return id;
     }
 
     static void broadcastShare(int id) {
-        FrameBuilder fb;
-        fb.begin(CMD_SHARE, DEVICE_NEO_PIXEL);
+        PardaloteFrame fb(PARDALOTE_ALL_CLIENTS, CMD_SHARE, DEVICE_NEO_PIXEL);
         fb.addInt(id);
         fb.addString(_names[id]);
-        Pardalote.broadcastFrame(fb);
+        fb.send();
     }
 
     // -------------------------------------------------------------------
@@ -197,11 +195,10 @@ public:
     // colour — so connecting clients immediately reflect the live state.
     // -------------------------------------------------------------------
     static void announce(uint8_t clientNum) {
-        FrameBuilder fb;
-        fb.begin(CMD_ANNOUNCE, DEVICE_NEO_PIXEL);
+        PardaloteFrame fb(clientNum, CMD_ANNOUNCE, DEVICE_NEO_PIXEL);
         fb.addInt(PROTOCOL_VERSION_MAJOR);
         fb.addInt(MAX_STRIPS);
-        Pardalote.sendFrame(clientNum, fb);
+        fb.send();
 
         for (int i = 0; i < MAX_STRIPS; i++) {
             if (!_initialized[i]) continue;
@@ -209,28 +206,25 @@ public:
             // Sketch-created strip: send its SHARE frame FIRST so the browser
             // materialises arduino.<name> before the state frames below.
             if (_sketchOwned[i]) {
-                FrameBuilder fsh;
-                fsh.begin(CMD_SHARE, DEVICE_NEO_PIXEL);
+                PardaloteFrame fsh(clientNum, CMD_SHARE, DEVICE_NEO_PIXEL);
                 fsh.addInt(i);
                 fsh.addString(_names[i]);
-                Pardalote.sendFrame(clientNum, fsh);
+                fsh.send();
             }
 
             // Init frame — tells JS the pin, length, and pixel type
-            FrameBuilder fi;
-            fi.begin(CMD_NEO_INIT, DEVICE_NEO_PIXEL);
+            PardaloteFrame fi(clientNum, CMD_NEO_INIT, DEVICE_NEO_PIXEL);
             fi.addInt(i);
             fi.addInt(_pins[i]);
             fi.addInt(_numPixels[i]);
             fi.addInt((int32_t)_types[i]);
-            Pardalote.sendFrame(clientNum, fi);
+            fi.send();
 
             // Brightness frame
-            FrameBuilder fbr;
-            fbr.begin(CMD_NEO_BRIGHTNESS, DEVICE_NEO_PIXEL);
+            PardaloteFrame fbr(clientNum, CMD_NEO_BRIGHTNESS, DEVICE_NEO_PIXEL);
             fbr.addInt(i);
             fbr.addInt(_strips[i]->getBrightness());
-            Pardalote.sendFrame(clientNum, fbr);
+            fbr.send();
 
             // One SET_PIXEL frame per pixel using getPixelColor() readback.
             // Adafruit stores colours in its own software buffer so this is
@@ -242,15 +236,14 @@ public:
                 uint8_t g = (c >>  8) & 0xFF;
                 uint8_t b =  c        & 0xFF;
 
-                FrameBuilder fp;
-                fp.begin(CMD_NEO_SET_PIXEL, DEVICE_NEO_PIXEL);
+                PardaloteFrame fp(clientNum, CMD_NEO_SET_PIXEL, DEVICE_NEO_PIXEL);
                 fp.addInt(i);
                 fp.addInt(j);
                 fp.addInt(r);
                 fp.addInt(g);
                 fp.addInt(b);
                 if (w > 0) fp.addInt(w);
-                Pardalote.sendFrame(clientNum, fp);
+                fp.send();
             }
         }
     }
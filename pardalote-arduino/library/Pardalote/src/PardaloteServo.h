@@ -79,6 +79,15 @@ private:
 
     static bool validId(int id) { return id >= 0 && id < MAX_SERVOS; }
 
+    // Wire layouts — one declaration per frame shape, used by the handler
+    // and the emitters alike (see internal/frame_schema.h).
+    using AttachParams = ParamSchema<2, int, int, int, int>;   // id, pin, [minPulse, maxPulse]
+    using IdValue      = ParamSchema<2, int, int>;             // id, angle|µs|0/1 — WRITE, READ/DONE/ATTACHED replies
+    using TimedParams  = ParamSchema<3, int, int, uint32_t>;   // id, angle, durationMs
+    using LimitParams  = ParamSchema<4, int, int, int, int>;   // id, minAngle, maxAngle, enabled
+    using ReadParams   = ParamSchema<1, int, long, long>;      // id, [interval, threshold]
+    using SyncRecord   = RecordSchema<uint8_t, uint8_t>;       // SYNC_TIMED payload: id, angle
+
     // Easing shared with every other extension — see pardaloteEase() in
     // defs.h (matches curveShape() in pardalote.js). CURVE_BACK returns >1
     // mid-flight (the overshoot), which loadSegment's write re-clamps.
@@ -122,11 +131,9 @@ private:
     }
 
     static void sendReadTo(uint8_t clientNum, int id, int32_t angle) {
-        FrameBuilder fb;
-        fb.begin(CMD_SERVO_READ, DEVICE_SERVO);
-        fb.addInt(id);
-        fb.addInt(angle);
-        Pardalote.sendFrame(clientNum, fb);
+        PardaloteFrame fb(clientNum, CMD_SERVO_READ, DEVICE_SERVO);
+        IdValue::write(fb, id, angle);
+        fb.send();
     }
 
     // Clamp an angle to 0–180 and, if set, the soft limits.
@@ -157,11 +164,9 @@ private:
     }
 
     static void broadcastDone(int id, int angle) {
-        FrameBuilder fb;
-        fb.begin(CMD_SERVO_DONE, DEVICE_SERVO);
-        fb.addInt(id);
-        fb.addInt(angle);
-        Pardalote.broadcastFrame(fb);
+        PardaloteFrame fb(PARDALOTE_ALL_CLIENTS, CMD_SERVO_DONE, DEVICE_SERVO);
+        IdValue::write(fb, id, angle);
+        fb.send();
     }
 
 public:
@@ -180,11 +185,9 @@ public:
     // exactly as if the browser had written it (CMD_SERVO_WRITE — silent sync).
     static void echoAngle(int id, int angle) {
         if (!validId(id) || !_attached[id]) return;
-        FrameBuilder fb;
-        fb.begin(CMD_SERVO_WRITE, DEVICE_SERVO);
-        fb.addInt(id);
-        fb.addInt(clampAngle(id, angle));   // echo what was actually applied
-        Pardalote.broadcastFrame(fb);
+        PardaloteFrame fb(PARDALOTE_ALL_CLIENTS, CMD_SERVO_WRITE, DEVICE_SERVO);
+        IdValue::write(fb, id, clampAngle(id, angle));   // echo what was actually applied
+        fb.send();
     }
 
     // -------------------------------------------------------------------
@@ -233,25 +236,21 @@ public:
         // announce() covers future connects): name → attach → angle, the
         // same order announce() replays.
         broadcastShare(id);
-        FrameBuilder fa;
-        fa.begin(CMD_SERVO_ATTACH, DEVICE_SERVO);
-        fa.addInt(id); fa.addInt(_pins[id]);
-        fa.addInt(_minPulse[id]); fa.addInt(_maxPulse[id]);
-        Pardalote.broadcastFrame(fa);
-        FrameBuilder fw;
-        fw.begin(CMD_SERVO_WRITE, DEVICE_SERVO);
-        fw.addInt(id); fw.addInt(_angles[id]);
-        Pardalote.broadcastFrame(fw);
+        PardaloteFrame fa(PARDALOTE_ALL_CLIENTS, CMD_SERVO_ATTACH, DEVICE_SERVO);
+        AttachParams::write(fa, id, _pins[id], _minPulse[id], _maxPulse[id]);
+        fa.send();
+        PardaloteFrame fw(PARDALOTE_ALL_CLIENTS, CMD_SERVO_WRITE, DEVICE_SERVO);
+        IdValue::write(fw, id, _angles[id]);
+        fw.send();
 
         return id;
     }
 
     static void broadcastShare(int id) {
-        FrameBuilder fb;
-        fb.begin(CMD_SHARE, DEVICE_SERVO);
+        PardaloteFrame fb(PARDALOTE_ALL_CLIENTS, CMD_SHARE, DEVICE_SERVO);
         fb.addInt(id);
         fb.addString(_names[id]);
-        Pardalote.broadcastFrame(fb);
+        fb.send();
     }
 
     // -------------------------------------------------------------------
@@ -265,12 +264,13 @@ public:
 
         // Global (multi-servo) command — handled before per-instance id read.
         if (cmd == CMD_SERVO_SYNC_TIMED) {
-            uint32_t dur = (nparams >= 1) ? (uint32_t)paramInt(params, 0) : 0;
+            uint32_t dur = 0;
+            ParamSchema<0, uint32_t>::read(params, nparams, typeMask, dur);
             uint32_t now = millis();
-            int count = payloadLen / 2;                 // { logicalId u8, angle u8 }
-            for (int i = 0; i < count; i++) {
-                int sid = payload[i * 2];
-                int ang = payload[i * 2 + 1];
+            const uint16_t count = SyncRecord::countIn(payloadLen);
+            for (uint16_t i = 0; i < count; i++) {
+                uint8_t sid, ang;
+                SyncRecord::read(payload + i * SyncRecord::size, sid, ang);
                 if (validId(sid) && _attached[sid]) startTimed(sid, ang, dur, now);
             }
             return;
@@ -281,26 +281,24 @@ public:
         if (cmd == CMD_SERVO_GESTURE) {
             uint32_t now = millis();
             uint16_t off = 0;
-            while (off + 3 <= payloadLen) {
-                int     sid   = payload[off];
-                uint8_t flags = payload[off + 1];
-                uint8_t count = payload[off + 2];
-                off += 3;
-                if ((uint32_t)off + (uint32_t)count * 7 > payloadLen) break;   // malformed — stop
+            while (off + GestureChannelRecord::size <= payloadLen) {
+                uint8_t sid, flags, count;
+                GestureChannelRecord::read(payload + off, sid, flags, count);
+                off += GestureChannelRecord::size;
+                const uint32_t block = (uint32_t)count * GestureSegRecord::size;
+                if (off + block > payloadLen) break;   // malformed — stop
                 if (validId(sid) && _attached[sid] && count > 0) {
                     uint8_t n = count > MAX_SERVO_SEGMENTS ? MAX_SERVO_SEGMENTS : count;
                     for (uint8_t i = 0; i < n; i++) {
-                        const uint8_t* r = payload + off + i * 7;
-                        _segs[sid][i].curve = r[0];
-                        _segs[sid][i].dur   = (uint16_t)(((uint16_t)r[1] << 8) | r[2]);
-                        _segs[sid][i].value = (int32_t)(((uint32_t)r[3] << 24) | ((uint32_t)r[4] << 16) |
-                                                        ((uint32_t)r[5] <<  8) |  (uint32_t)r[6]);
+                        Seg& g = _segs[sid][i];
+                        GestureSegRecord::read(payload + off + i * GestureSegRecord::size,
+                                               g.curve, g.dur, g.value);
                     }
                     _segCount[sid] = n;
                     _segFlags[sid] = flags;
                     loadSegment(sid, 0, now);
                 }
-                off += (uint16_t)count * 7;             // skip the whole declared block, even if capped
+                off += (uint16_t)block;                 // skip the whole declared block, even if capped
             }
             return;
         }
@@ -315,10 +313,8 @@ public:
         switch (cmd) {
 
             case CMD_SERVO_ATTACH: {
-                if (nparams < 2) return;
-                int pin  = (int)paramInt(params, 1);
-                int minP = (nparams > 2) ? (int)paramInt(params, 2) : 544;
-                int maxP = (nparams > 3) ? (int)paramInt(params, 3) : 2400;
+                int pin, minP = 544, maxP = 2400;
+                if (!AttachParams::read(params, nparams, typeMask, id, pin, minP, maxP)) return;
 
                 // Skip the detach/attach cycle (and the Serial print) when the
                 // state is already what was requested. JS's reconnect logic and
@@ -358,18 +354,20 @@ public:
                 break;
 
             case CMD_SERVO_WRITE: {
-                if (!_attached[id] || nparams < 2) return;
+                int angle;
+                if (!_attached[id] || !IdValue::read(params, nparams, typeMask, id, angle)) return;
                 _moving[id] = false; _segCount[id] = 0;   // an immediate write cancels a timed move / gesture
-                int angle = clampAngle(id, (int)paramInt(params, 1));
+                angle = clampAngle(id, angle);
                 _servos[id].write(angle);
                 _angles[id] = (int16_t)angle;
                 break;
             }
 
             case CMD_SERVO_WRITE_MICROSECONDS: {
-                if (!_attached[id] || nparams < 2) return;
+                int us;
+                if (!_attached[id] || !IdValue::read(params, nparams, typeMask, id, us)) return;
                 _moving[id] = false; _segCount[id] = 0;   // an immediate write cancels a timed move / gesture
-                int us = constrain((int)paramInt(params, 1), 544, 2400);
+                us = constrain(us, 544, 2400);
                 if (_limitSet[id]) {
                     // Translate the angle limits into the pulse domain.
                     long span  = _maxPulse[id] - _minPulse[id];
@@ -382,9 +380,9 @@ public:
             }
 
             case CMD_SERVO_WRITE_TIMED: {
-                if (!_attached[id] || nparams < 3) return;
-                int angle    = (int)paramInt(params, 1);
-                uint32_t dur = (uint32_t)paramInt(params, 2);
+                int angle;
+                uint32_t dur;
+                if (!_attached[id] || !TimedParams::read(params, nparams, typeMask, id, angle, dur)) return;
                 startTimed(id, angle, dur, millis());
                 break;
             }
@@ -394,12 +392,13 @@ public:
                 break;
 
             case CMD_SERVO_SET_LIMITS: {
-                if (!_attached[id] || nparams < 4) return;
-                int lo = constrain((int)paramInt(params, 1), 0, 180);
-                int hi = constrain((int)paramInt(params, 2), 0, 180);
+                int lo, hi, enabled;
+                if (!_attached[id] || !LimitParams::read(params, nparams, typeMask, id, lo, hi, enabled)) return;
+                lo = constrain(lo, 0, 180);
+                hi = constrain(hi, 0, 180);
                 _limitMin[id] = (int16_t)min(lo, hi);
                 _limitMax[id] = (int16_t)max(lo, hi);
-                _limitSet[id] = paramInt(params, 3) != 0;
+                _limitSet[id] = enabled != 0;
                 break;
             }
 
@@ -411,8 +410,8 @@ public:
             // registers a board-side per-client periodic read; interval < 0
             // (JS END) removes this client's registration; absent/0 = one-shot.
             case CMD_SERVO_READ: {
-                long ms  = (nparams > 1) ? paramInt(params, 1) : 0;
-                long thr = (nparams > 2) ? paramInt(params, 2) : 0;
+                long ms = 0, thr = 0;
+                ReadParams::read(params, nparams, typeMask, id, ms, thr);
 
                 if (ms < 0) {   // END — unregister this client
                     ExtReadPoll* p = extPollFind(_polls, MAX_SERVOS, id);
@@ -438,11 +437,9 @@ public:
             case CMD_SERVO_ATTACHED: {
                 bool isAttached = _attached[id] && _servos[id].attached();
 
-                FrameBuilder fb;
-                fb.begin(CMD_SERVO_ATTACHED, DEVICE_SERVO);
-                fb.addInt(id);
-                fb.addInt(isAttached ? 1 : 0);
-                Pardalote.sendFrame(clientNum, fb);
+                PardaloteFrame fb(clientNum, CMD_SERVO_ATTACHED, DEVICE_SERVO);
+                IdValue::write(fb, id, isAttached ? 1 : 0);
+                fb.send();
                 break;
             }
 
@@ -460,11 +457,10 @@ public:
     // in sync.
     // -------------------------------------------------------------------
     static void announce(uint8_t clientNum) {
-        FrameBuilder fb;
-        fb.begin(CMD_ANNOUNCE, DEVICE_SERVO);
+        PardaloteFrame fb(clientNum, CMD_ANNOUNCE, DEVICE_SERVO);
         fb.addInt(PROTOCOL_VERSION_MAJOR);
         fb.addInt(MAX_SERVOS);
-        Pardalote.sendFrame(clientNum, fb);
+        fb.send();
 
         // Send full attach state for any currently attached servos:
         // pin, pulse range, and last known angle.
@@ -475,45 +471,38 @@ public:
             // browser materialises arduino.<name> before the attach/state
             // frames below arrive to sync it.
             if (_sketchOwned[i]) {
-                FrameBuilder fs;
-                fs.begin(CMD_SHARE, DEVICE_SERVO);
+                PardaloteFrame fs(clientNum, CMD_SHARE, DEVICE_SERVO);
                 fs.addInt(i);
                 fs.addString(_names[i]);
-                Pardalote.sendFrame(clientNum, fs);
+                fs.send();
             }
 
-            FrameBuilder fa;
-            fa.begin(CMD_SERVO_ATTACH, DEVICE_SERVO);
-            fa.addInt(i);
-            fa.addInt(_pins[i]);
-            fa.addInt(_minPulse[i]);
-            fa.addInt(_maxPulse[i]);
-            Pardalote.sendFrame(clientNum, fa);
+            PardaloteFrame fa(clientNum, CMD_SERVO_ATTACH, DEVICE_SERVO);
+            AttachParams::write(fa, i, _pins[i], _minPulse[i], _maxPulse[i]);
+            fa.send();
 
-            FrameBuilder fw;
-            fw.begin(CMD_SERVO_WRITE, DEVICE_SERVO);
-            fw.addInt(i);
-            fw.addInt(_angles[i]);
-            Pardalote.sendFrame(clientNum, fw);
+            PardaloteFrame fw(clientNum, CMD_SERVO_WRITE, DEVICE_SERVO);
+            IdValue::write(fw, i, _angles[i]);
+            fw.send();
 
             // Replay soft limits if set.
             if (_limitSet[i]) {
-                FrameBuilder fl;
-                fl.begin(CMD_SERVO_SET_LIMITS, DEVICE_SERVO);
-                fl.addInt(i); fl.addInt(_limitMin[i]); fl.addInt(_limitMax[i]); fl.addInt(1);
-                Pardalote.sendFrame(clientNum, fl);
+                PardaloteFrame fl(clientNum, CMD_SERVO_SET_LIMITS, DEVICE_SERVO);
+                LimitParams::write(fl, i, _limitMin[i], _limitMax[i], 1);
+                fl.send();
             }
         }
     }
 
     // -------------------------------------------------------------------
-    // Loop hook — runs every Pardalote.run(). Advances any in-progress
-    // timed moves. The angle is computed from true elapsed time (millis()),
-    // so a group of servos sharing one duration stays in phase regardless of
-    // loop-rate jitter, and they all finish on the same tick.
+    // Loop hook — timed: runs only while a move or a read is due. Advances
+    // any in-progress timed moves. The angle is computed from true elapsed
+    // time (millis()), so a group of servos sharing one duration stays in
+    // phase regardless of loop-rate jitter, and they all finish on the same
+    // tick.
     // -------------------------------------------------------------------
-    static void loop() {
-        uint32_t now = millis();
+    static uint32_t loop(uint32_t now) {
+        uint32_t next = EXT_LOOP_IDLE;
         for (int i = 0; i < MAX_SERVOS; i++) {
             if (!_attached[i] || !_moving[i]) continue;
             uint32_t elapsed = now - _startMs[i];
@@ -537,6 +526,11 @@ public:
                 _angles[i]     = (int16_t)ang;
                 _lastStepMs[i] = now;
             }
+            // Next interpolation write, or the segment end if sooner.
+            if (_moving[i]) {
+                extDueIn(next, extMsUntil(now, _lastStepMs[i], STEP_MS));
+                extDueIn(next, extMsUntil(now, _startMs[i], _durMs[i]));
+            }
         }
 
         // Board-side periodic reads — per-client gating.
@@ -548,6 +542,8 @@ public:
             for (uint8_t c = 0; c < PARDALOTE_MAX_CLIENTS; c++)
                 if (p.gate(c, angle, now)) sendReadTo(c, p.instance, angle);
         }
+        extDueIn(next, extPollNextDue(_polls, MAX_SERVOS, now));
+        return next;
     }
 
     // Client disconnect — drop its read registrations.
@@ -601,9 +597,19 @@ public:
 };
 inline PardaloteServoAccess PardaloteServo;
 
-// Self-register — runs before setup(). Passes nullptr for the disconnect
-// hook and ServoExt::loop for the per-iteration interpolation.
+// Self-register — runs before setup(). ServoExt::loop is a timed hook:
+// it runs only while an interpolation step or a read is due.
 INSTALL_EXTENSION(DEVICE_SERVO, ServoExt::handle, ServoExt::announce,
                   ServoExt::disconnect, ServoExt::loop)
 
+// A slider sends a stream of absolute writes; while they queue up only
+// the newest per servo matters. (Timed writes and stop keep their order.)
+COALESCE_COMMAND(DEVICE_SERVO, CMD_SERVO_WRITE)
+COALESCE_COMMAND(DEVICE_SERVO, CMD_SERVO_WRITE_MICROSECONDS)
+
+// A finished timed move is what a sequence waits on — it goes ahead of
+// any readings the same pass produced.
+OUTBOUND_LANE(DEVICE_SERVO, CMD_SERVO_DONE, TX_LANE_CONTROL)
+OUTBOUND_LANE(DEVICE_SERVO, CMD_SERVO_READ, TX_LANE_TELEMETRY)
+
 #endif
@@ -11,6 +11,11 @@
 // Requires the AccelStepper library (by Mike McCauley):
 //   Arduino IDE → Tools → Manage Libraries → search "AccelStepper".
 //
+// Hardware-timer stepping (opt-in): define PARDALOTE_STEP_TIMER before
+// the include and step pulses come from a timer ISR instead of the loop
+// hook (internal/step_engine.h) — steadier pulses and higher step rates,
+// independent of WiFi and loop() load. AccelStepper is then not needed.
+//
 // Supports up to MAX_STEPPERS simultaneously attached steppers driven
 // by STEP/DIR drivers (TMC2208/2209, A4988, EasyDriver, ...) or by
 // 4-wire coil drivers (28BYJ-48 via ULN2003, bipolar via H-bridge).
@@ -30,11 +35,22 @@
 #ifndef PARDALOTE_STEPPER_H
 #define PARDALOTE_STEPPER_H
 
-#include <AccelStepper.h>
 #include "Pardalote.h"
 
+#if defined(PARDALOTE_STEP_TIMER)
+  #include "internal/step_engine.h"
+  typedef TimerStepper StepperMotor;
+#else
+  #include <AccelStepper.h>
+  typedef AccelStepper StepperMotor;
+#endif
+
 #define MAX_STEPPERS 6
 
+#if defined(PARDALOTE_STEP_TIMER)
+static_assert(MAX_STEPPERS <= STEP_ENGINE_MAX_MOTORS, "step engine has fewer slots than MAX_STEPPERS");
+#endif
+
 class StepperExt {
 private:
     // Motion mode per instance.
@@ -49,7 +65,7 @@ private:
     //              from the same curve (see loop() + loadStepperSegment()).
     enum Mode : uint8_t { MODE_POSITION = 0, MODE_VELOCITY = 1, MODE_TIMED = 2, MODE_STOPPING = 3, MODE_EASED = 4 };
 
-    inline static AccelStepper* _steppers[MAX_STEPPERS] = {};
+    inline static StepperMotor* _steppers[MAX_STEPPERS] = {};
     inline static bool          _attached[MAX_STEPPERS] = {};
     inline static Mode          _mode[MAX_STEPPERS]     = {};
     inline static bool          _wasRunning[MAX_STEPPERS] = {};
@@ -154,7 +170,7 @@ private:
     }
 
     static bool isRunning(int id) {
-        AccelStepper* s = _steppers[id];
+        StepperMotor* s = _steppers[id];
         if (!s) return false;
         return (_mode[id] == MODE_VELOCITY || _mode[id] == MODE_STOPPING)
                    ? (s->speed() != 0.0f)
@@ -171,7 +187,7 @@ private:
     // Moving toward this end? Speed sign is authoritative; fall back to
     // distanceToGo for a position move that hasn't taken its first step yet.
     static bool movingToward(int id, int end) {
-        AccelStepper* s = _steppers[id];
+        StepperMotor* s = _steppers[id];
         float spd = s->speed();
         long  dtg = s->distanceToGo();
         return (end == LIMIT_MIN) ? (spd < 0 || (spd == 0 && dtg < 0))
@@ -182,7 +198,7 @@ private:
     // distanceToGo in one call (no decel ramp: momentum past a hard limit
     // is exactly what the switch protects against).
     static void hardStop(int id) {
-        AccelStepper* s = _steppers[id];
+        StepperMotor* s = _steppers[id];
         s->setCurrentPosition(s->currentPosition());
         _mode[id] = MODE_POSITION;
     }
@@ -193,7 +209,7 @@ private:
     // One iteration of the homing routine. Owns the motor entirely while
     // active — the generic switch/DONE logic in loop() is skipped.
     static void homingStep(int id) {
-        AccelStepper* s = _steppers[id];
+        StepperMotor* s = _steppers[id];
         int end = _homeEnd[id];
 
         // Safety cap on SEEK + BACKOFF: if the switch never trips (unplugged,
@@ -205,16 +221,14 @@ private:
             hardStop(id);
             _homing[id]     = HOME_IDLE;
             _wasRunning[id] = false;
-            FrameBuilder ff;
-            ff.begin(CMD_STEPPER_HOME, DEVICE_STEPPER);
+            PardaloteFrame ff(PARDALOTE_ALL_CLIENTS, CMD_STEPPER_HOME, DEVICE_STEPPER);
             ff.addInt(id);
             ff.addInt(s->currentPosition());
-            Pardalote.broadcastFrame(ff);
-            FrameBuilder fd;
-            fd.begin(CMD_STEPPER_DONE, DEVICE_STEPPER);
+            ff.send();
+            PardaloteFrame fd(PARDALOTE_ALL_CLIENTS, CMD_STEPPER_DONE, DEVICE_STEPPER);
             fd.addInt(id);
             fd.addInt(s->currentPosition());
-            Pardalote.broadcastFrame(fd);
+            fd.send();
             Serial.print(F("Stepper ")); Serial.print(id);
             Serial.println(F(" homing timed out — switch never responded"));
             return;
@@ -230,10 +244,10 @@ private:
                     int32_t swPos = _swPosition[id][end];
                     s->setCurrentPosition(swPos);             // kills motion too
                     _swLatched[id][end] = true;               // generic latch stays consistent
-                    FrameBuilder fp;                          // silent JS position sync
-                    fp.begin(CMD_STEPPER_SET_POSITION, DEVICE_STEPPER);
+                    PardaloteFrame fp(PARDALOTE_ALL_CLIENTS,  // silent JS position sync
+                                      CMD_STEPPER_SET_POSITION, DEVICE_STEPPER);
                     fp.addInt(id); fp.addInt(swPos);
-                    Pardalote.broadcastFrame(fp);
+                    fp.send();
                     // Back off (away from the switch) until it releases.
                     s->setSpeed(end == LIMIT_MIN ? _homeSpeed[id] : -_homeSpeed[id]);
                     _homing[id] = HOME_BACKOFF;
@@ -259,11 +273,10 @@ private:
                     _homing[id]     = HOME_IDLE;
                     _mode[id]       = MODE_POSITION;
                     _wasRunning[id] = false;   // suppress a duplicate edge DONE
-                    FrameBuilder fb;
-                    fb.begin(CMD_STEPPER_DONE, DEVICE_STEPPER);
+                    PardaloteFrame fb(PARDALOTE_ALL_CLIENTS, CMD_STEPPER_DONE, DEVICE_STEPPER);
                     fb.addInt(id);
                     fb.addInt(s->currentPosition());
-                    Pardalote.broadcastFrame(fb);
+                    fb.send();
                 }
                 break;
 
@@ -276,7 +289,7 @@ private:
     // itself — a group sharing one duration arrives together. AccelStepper's
     // setSpeed() is clamped to maxSpeed(), so raise the cap for this move.
     static void startTimedMove(int id, int32_t target, uint32_t durationMs) {
-        AccelStepper* s = _steppers[id];
+        StepperMotor* s = _steppers[id];
         if (!s) return;
         cancelEased(id);           // a timed move supersedes any running gesture
         _homing[id] = HOME_IDLE;   // explicit move cancels homing
@@ -309,7 +322,7 @@ private:
     // (absolute), clamped to soft limits. Raises the live speed cap to fit the
     // curve's velocity peak inside `dur`. _maxSpeed[id] keeps the USER value.
     static void loadStepperSegment(int id, uint8_t idx, uint32_t startMs) {
-        AccelStepper* s = _steppers[id];
+        StepperMotor* s = _steppers[id];
         const Seg& seg  = _segs[id][idx];
         int32_t from    = s->currentPosition();
         int32_t target  = (_segFlags[id] & GESTURE_FLAG_ABSOLUTE) ? seg.value : from + seg.value;
@@ -333,18 +346,17 @@ private:
     // End a gesture: stop, restore the user's speed cap, drop the schedule,
     // and announce completion via the normal DONE frame (whenDone()).
     static void finishStepperGesture(int id) {
-        AccelStepper* s = _steppers[id];
+        StepperMotor* s = _steppers[id];
         s->setSpeed(0);
         s->moveTo(s->currentPosition());      // no residual target
         s->setMaxSpeed(_maxSpeed[id]);        // restore the user-configured cap
         _mode[id]       = MODE_POSITION;
         _segCount[id]   = 0;
         _wasRunning[id] = false;              // suppress the generic DONE edge — we send it here
-        FrameBuilder fb;
-        fb.begin(CMD_STEPPER_DONE, DEVICE_STEPPER);
+        PardaloteFrame fb(PARDALOTE_ALL_CLIENTS, CMD_STEPPER_DONE, DEVICE_STEPPER);
         fb.addInt(id);
         fb.addInt(s->currentPosition());
-        Pardalote.broadcastFrame(fb);
+        fb.send();
     }
 
     // Abandon a running gesture WITHOUT a DONE frame (a new explicit motion
@@ -373,11 +385,10 @@ public:
     // target exactly as if the browser had issued the move.
     static void echoTarget(int id) {
         if (!validId(id) || !_steppers[id]) return;
-        FrameBuilder fb;
-        fb.begin(CMD_STEPPER_MOVE_TO, DEVICE_STEPPER);
+        PardaloteFrame fb(PARDALOTE_ALL_CLIENTS, CMD_STEPPER_MOVE_TO, DEVICE_STEPPER);
         fb.addInt(id);
         fb.addInt(_steppers[id]->targetPosition());
-        Pardalote.broadcastFrame(fb);
+        fb.send();
     }
 
     // -------------------------------------------------------------------
@@ -435,11 +446,10 @@ public:
     }
 
     static void broadcastShare(int id) {
-        FrameBuilder fb;
-        fb.begin(CMD_SHARE, DEVICE_STEPPER);
+        PardaloteFrame fb(PARDALOTE_ALL_CLIENTS, CMD_SHARE, DEVICE_STEPPER);
         fb.addInt(id);
         fb.addString(_names[id]);
-        Pardalote.broadcastFrame(fb);
+        fb.send();
     }
 
     // Emit this stepper's attach frame (interface + pins) followed by its
@@ -447,8 +457,8 @@ public:
     // everyone) and announce (unicast to one joining client) so the two stay
     // in lockstep. When `unicast` is false, `clientNum` is ignored.
     static void sendAttachState(int id, bool unicast, uint8_t clientNum) {
-        FrameBuilder fa;
-        fa.begin(CMD_STEPPER_ATTACH, DEVICE_STEPPER);
+        const uint8_t to = unicast ? clientNum : PARDALOTE_ALL_CLIENTS;
+        PardaloteFrame fa(to, CMD_STEPPER_ATTACH, DEVICE_STEPPER);
         fa.addInt(id);
         fa.addInt(_interface[id]);
         if (_interface[id] == STEPPER_FULL4WIRE) {
@@ -458,20 +468,13 @@ public:
             fa.addInt(_pins[id][0]); fa.addInt(_pins[id][1]);
             fa.addInt(_enPin[id]);   fa.addInt(_invert[id]);
         }
-        FrameBuilder fs; fs.begin(CMD_STEPPER_SET_MAX_SPEED, DEVICE_STEPPER);
+        fa.send();
+        PardaloteFrame fs(to, CMD_STEPPER_SET_MAX_SPEED, DEVICE_STEPPER);
         fs.addInt(id); fs.addFloat(_maxSpeed[id]);
-        FrameBuilder fac; fac.begin(CMD_STEPPER_SET_ACCEL, DEVICE_STEPPER);
+        fs.send();
+        PardaloteFrame fac(to, CMD_STEPPER_SET_ACCEL, DEVICE_STEPPER);
         fac.addInt(id); fac.addFloat(_accel[id]);
-
-        if (unicast) {
-            Pardalote.sendFrame(clientNum, fa);
-            Pardalote.sendFrame(clientNum, fs);
-            Pardalote.sendFrame(clientNum, fac);
-        } else {
-            Pardalote.broadcastFrame(fa);
-            Pardalote.broadcastFrame(fs);
-            Pardalote.broadcastFrame(fac);
-        }
+        fac.send();
     }
 
     // -------------------------------------------------------------------
@@ -485,14 +488,14 @@ public:
 
         // Global (multi-stepper) command — handled before per-instance id read.
         if (cmd == CMD_STEPPER_SYNC_MOVE) {
-            uint32_t dur = (nparams >= 1) ? (uint32_t)paramInt(params, 0) : 0;
-            const int REC = 5;                          // { logicalId u8, target i32 }
-            int count = payloadLen / REC;
-            for (int i = 0; i < count; i++) {
-                uint8_t* r = payload + i * REC;
-                int sid = r[0];
-                int32_t target = (int32_t)(((uint32_t)r[1] << 24) | ((uint32_t)r[2] << 16) |
-                                           ((uint32_t)r[3] <<  8) |  (uint32_t)r[4]);
+            uint32_t dur = 0;
+            ParamSchema<0, uint32_t>::read(params, nparams, typeMask, dur);
+            using SyncRecord = RecordSchema<uint8_t, int32_t>;   // { logicalId u8, target i32 }
+            const uint16_t count = SyncRecord::countIn(payloadLen);
+            for (uint16_t i = 0; i < count; i++) {
+                uint8_t sid;
+                int32_t target;
+                SyncRecord::read(payload + i * SyncRecord::size, sid, target);
                 if (validId(sid) && _attached[sid] && _steppers[sid]) startTimedMove(sid, target, dur);
             }
             return;
@@ -503,27 +506,25 @@ public:
         if (cmd == CMD_STEPPER_GESTURE) {
             uint32_t now = millis();
             uint16_t off = 0;
-            while (off + 3 <= payloadLen) {
-                int     sid   = payload[off];
-                uint8_t flags = payload[off + 1];
-                uint8_t count = payload[off + 2];
-                off += 3;
-                if ((uint32_t)off + (uint32_t)count * 7 > payloadLen) break;   // malformed — stop
+            while (off + GestureChannelRecord::size <= payloadLen) {
+                uint8_t sid, flags, count;
+                GestureChannelRecord::read(payload + off, sid, flags, count);
+                off += GestureChannelRecord::size;
+                const uint32_t block = (uint32_t)count * GestureSegRecord::size;
+                if (off + block > payloadLen) break;   // malformed — stop
                 if (validId(sid) && _attached[sid] && _steppers[sid] && count > 0) {
                     _homing[sid] = HOME_IDLE;              // a gesture supersedes homing
                     uint8_t n = count > MAX_STEPPER_SEGMENTS ? MAX_STEPPER_SEGMENTS : count;
                     for (uint8_t i = 0; i < n; i++) {
-                        const uint8_t* r = payload + off + i * 7;
-                        _segs[sid][i].curve = r[0];
-                        _segs[sid][i].dur   = (uint16_t)(((uint16_t)r[1] << 8) | r[2]);
-                        _segs[sid][i].value = (int32_t)(((uint32_t)r[3] << 24) | ((uint32_t)r[4] << 16) |
-                                                        ((uint32_t)r[5] <<  8) |  (uint32_t)r[6]);
+                        Seg& g = _segs[sid][i];
+                        GestureSegRecord::read(payload + off + i * GestureSegRecord::size,
+                                               g.curve, g.dur, g.value);
                     }
                     _segCount[sid] = n;
                     _segFlags[sid] = flags;
                     loadStepperSegment(sid, 0, now);
                 }
-                off += (uint16_t)count * 7;               // skip the whole declared block, even if capped
+                off += (uint16_t)block;                   // skip the whole declared block, even if capped
             }
             return;
         }
@@ -550,13 +551,13 @@ public:
                 int p4 = (nparams > 5) ? (int)paramInt(params, 5) : -1;
 
                 if (iface == STEPPER_FULL4WIRE) {
-                    _steppers[id] = new AccelStepper(AccelStepper::FULL4WIRE, p1, p2, p3, p4);
+                    _steppers[id] = new StepperMotor(StepperMotor::FULL4WIRE, p1, p2, p3, p4);
                     _enPin[id]  = -1;
                     _invert[id] = 0;
                     _pins[id][0] = p1; _pins[id][1] = p2; _pins[id][2] = p3; _pins[id][3] = p4;
                 } else {
                     // STEPPER_DRIVER (default): p1=STEP, p2=DIR.
-                    _steppers[id] = new AccelStepper(AccelStepper::DRIVER, p1, p2);
+                    _steppers[id] = new StepperMotor(StepperMotor::DRIVER, p1, p2);
                     int enPin  = (nparams > 4) ? (int)paramInt(params, 4) : -1;
                     int invert = (nparams > 5) ? (int)paramInt(params, 5) : 0x04; // enable active-LOW
                     _enPin[id]  = (int16_t)enPin;
@@ -742,16 +743,15 @@ public:
                 if (end != LIMIT_MIN && end != LIMIT_MAX) return;
                 _swPosition[id][end] = (int32_t)paramInt(params, 2);
                 // Echo so JS (and other clients) sync.
-                FrameBuilder fb;
-                fb.begin(CMD_STEPPER_SET_SWITCH_POS, DEVICE_STEPPER);
+                PardaloteFrame fb(PARDALOTE_ALL_CLIENTS, CMD_STEPPER_SET_SWITCH_POS, DEVICE_STEPPER);
                 fb.addInt(id); fb.addInt(end); fb.addInt(_swPosition[id][end]);
-                Pardalote.broadcastFrame(fb);
+                fb.send();
                 break;
             }
 
             case CMD_STEPPER_SET_HOME: {
                 if (!_attached[id]) return;
-                AccelStepper* s = _steppers[id];
+                StepperMotor* s = _steppers[id];
                 // Re-zero the coordinate frame. The current physical position
                 // BECOMES `value` (default 0 = the origin/home). Everything
                 // that carries a coordinate — the soft limits and the switch
@@ -765,17 +765,17 @@ public:
                 _wasRunning[id] = false;
 
                 // Position echo.
-                FrameBuilder fp; fp.begin(CMD_STEPPER_SET_POSITION, DEVICE_STEPPER);
+                PardaloteFrame fp(PARDALOTE_ALL_CLIENTS, CMD_STEPPER_SET_POSITION, DEVICE_STEPPER);
                 fp.addInt(id); fp.addInt(value);
-                Pardalote.broadcastFrame(fp);
+                fp.send();
 
                 // Shift + echo the soft limits (only when in use).
                 if (_limitEnabled[id]) {
                     _limitMin[id] += offset;
                     _limitMax[id] += offset;
-                    FrameBuilder fl; fl.begin(CMD_STEPPER_SET_LIMITS, DEVICE_STEPPER);
+                    PardaloteFrame fl(PARDALOTE_ALL_CLIENTS, CMD_STEPPER_SET_LIMITS, DEVICE_STEPPER);
                     fl.addInt(id); fl.addInt(_limitMin[id]); fl.addInt(_limitMax[id]); fl.addInt(1);
-                    Pardalote.broadcastFrame(fl);
+                    fl.send();
                 }
 
                 // Shift + echo each switch coordinate that's in use (configured
@@ -783,9 +783,9 @@ public:
                 for (int e = 0; e < 2; e++) {
                     if (_swPin[id][e] < 0 && _swPosition[id][e] == 0) continue;
                     _swPosition[id][e] += offset;
-                    FrameBuilder fs; fs.begin(CMD_STEPPER_SET_SWITCH_POS, DEVICE_STEPPER);
+                    PardaloteFrame fs(PARDALOTE_ALL_CLIENTS, CMD_STEPPER_SET_SWITCH_POS, DEVICE_STEPPER);
                     fs.addInt(id); fs.addInt(e); fs.addInt(_swPosition[id][e]);
-                    Pardalote.broadcastFrame(fs);
+                    fs.send();
                 }
                 break;
             }
@@ -793,7 +793,7 @@ public:
             case CMD_STEPPER_HOME: {
                 if (!_attached[id]) return;
                 cancelEased(id);   // homing supersedes any running gesture
-                AccelStepper* s = _steppers[id];
+                StepperMotor* s = _steppers[id];
                 // Pick the switch: MIN if configured, else MAX.
                 int end = (_swPin[id][LIMIT_MIN] >= 0) ? LIMIT_MIN
                         : (_swPin[id][LIMIT_MAX] >= 0) ? LIMIT_MAX : -1;
@@ -864,7 +864,7 @@ public:
     static void loop() {
         for (int id = 0; id < MAX_STEPPERS; id++) {
             if (!_attached[id] || !_steppers[id]) continue;
-            AccelStepper* s = _steppers[id];
+            StepperMotor* s = _steppers[id];
 
             // Homing routine owns the motor while active — the generic
             // switch/DONE logic below is bypassed (it would emit spurious
@@ -889,12 +889,11 @@ public:
                         hardStop(id);
                         if (!_swLatched[id][end]) {
                             _swLatched[id][end] = true;
-                            FrameBuilder fb;
-                            fb.begin(CMD_STEPPER_LIMIT, DEVICE_STEPPER);
+                            PardaloteFrame fb(PARDALOTE_ALL_CLIENTS, CMD_STEPPER_LIMIT, DEVICE_STEPPER);
                             fb.addInt(id);
                             fb.addInt(end);
                             fb.addInt(s->currentPosition());
-                            Pardalote.broadcastFrame(fb);
+                            fb.send();
                             // Force the _wasRunning edge below to send
                             // CMD_STEPPER_DONE even if the move tripped
                             // before its first step (move commanded into an
@@ -996,11 +995,10 @@ public:
             if (_wasRunning[id] && !running &&
                 (_mode[id] == MODE_POSITION || _mode[id] == MODE_TIMED)) {
                 // Target reached — tell the browser once.
-                FrameBuilder fb;
-                fb.begin(CMD_STEPPER_DONE, DEVICE_STEPPER);
+                PardaloteFrame fb(PARDALOTE_ALL_CLIENTS, CMD_STEPPER_DONE, DEVICE_STEPPER);
                 fb.addInt(id);
                 fb.addInt(s->currentPosition());
-                Pardalote.broadcastFrame(fb);
+                fb.send();
             }
             _wasRunning[id] = running;
         }
@@ -1029,8 +1027,8 @@ public:
     // -------------------------------------------------------------------
     // Poll response — current position, remaining distance, speed, state.
     // -------------------------------------------------------------------
-    static void buildRead(FrameBuilder& fb, int id) {
-        AccelStepper* s = _steppers[id];
+    static void buildRead(FrameWriter& fb, int id) {
+        StepperMotor* s = _steppers[id];
         fb.begin(CMD_STEPPER_READ, DEVICE_STEPPER);
         fb.addInt(id);
         fb.addInt(s->currentPosition());
@@ -1040,9 +1038,9 @@ public:
     }
 
     static void sendReadTo(uint8_t clientNum, int id) {
-        FrameBuilder fb;
+        PardaloteFrame fb(clientNum, CMD_STEPPER_READ, DEVICE_STEPPER);
         buildRead(fb, id);
-        Pardalote.sendFrame(clientNum, fb);
+        fb.send();
     }
 
     // -------------------------------------------------------------------
@@ -1051,11 +1049,10 @@ public:
     // a running system sees true configuration and live position.
     // -------------------------------------------------------------------
     static void announce(uint8_t clientNum) {
-        FrameBuilder fb;
-        fb.begin(CMD_ANNOUNCE, DEVICE_STEPPER);
+        PardaloteFrame fb(clientNum, CMD_ANNOUNCE, DEVICE_STEPPER);
         fb.addInt(PROTOCOL_VERSION_MAJOR);
         fb.addInt(MAX_STEPPERS);
-        Pardalote.sendFrame(clientNum, fb);
+        fb.send();
 
         for (int i = 0; i < MAX_STEPPERS; i++) {
             if (!_attached[i] || !_steppers[i]) continue;
@@ -1064,11 +1061,10 @@ public:
             // materialises arduino.<name> before the attach/state frames below
             // arrive to sync it.
             if (_sketchOwned[i]) {
-                FrameBuilder fsh;
-                fsh.begin(CMD_SHARE, DEVICE_STEPPER);
+                PardaloteFrame fsh(clientNum, CMD_SHARE, DEVICE_STEPPER);
                 fsh.addInt(i);
                 fsh.addString(_names[i]);
-                Pardalote.sendFrame(clientNum, fsh);
+                fsh.send();
             }
 
             // Replay attach (interface + pins + enable + invert) and profile.
@@ -1076,17 +1072,17 @@ public:
 
             // Replay soft limits if set.
             if (_limitEnabled[i]) {
-                FrameBuilder fl; fl.begin(CMD_STEPPER_SET_LIMITS, DEVICE_STEPPER);
+                PardaloteFrame fl(clientNum, CMD_STEPPER_SET_LIMITS, DEVICE_STEPPER);
                 fl.addInt(i); fl.addInt(_limitMin[i]); fl.addInt(_limitMax[i]); fl.addInt(1);
-                Pardalote.sendFrame(clientNum, fl);
+                fl.send();
             }
 
             // Replay limit-switch config (one frame per configured switch).
             for (int e = 0; e < 2; e++) {
                 if (_swPin[i][e] < 0) continue;
-                FrameBuilder fw; fw.begin(CMD_STEPPER_SET_SWITCH, DEVICE_STEPPER);
+                PardaloteFrame fw(clientNum, CMD_STEPPER_SET_SWITCH, DEVICE_STEPPER);
                 fw.addInt(i); fw.addInt(e); fw.addInt(_swPin[i][e]); fw.addInt(_swTrig[i][e]);
-                Pardalote.sendFrame(clientNum, fw);
+                fw.send();
             }
 
             // Replay each switch coordinate that's in use (absolute value —
@@ -1094,21 +1090,21 @@ public:
             // is always the origin (0), so there's nothing else to replay.
             for (int e = 0; e < 2; e++) {
                 if (_swPin[i][e] < 0 && _swPosition[i][e] == 0) continue;
-                FrameBuilder fsp; fsp.begin(CMD_STEPPER_SET_SWITCH_POS, DEVICE_STEPPER);
+                PardaloteFrame fsp(clientNum, CMD_STEPPER_SET_SWITCH_POS, DEVICE_STEPPER);
                 fsp.addInt(i); fsp.addInt(e); fsp.addInt(_swPosition[i][e]);
-                Pardalote.sendFrame(clientNum, fsp);
+                fsp.send();
             }
 
             // Sync live position.
-            FrameBuilder fp; fp.begin(CMD_STEPPER_SET_POSITION, DEVICE_STEPPER);
+            PardaloteFrame fp(clientNum, CMD_STEPPER_SET_POSITION, DEVICE_STEPPER);
             fp.addInt(i); fp.addInt(_steppers[i]->currentPosition());
-            Pardalote.sendFrame(clientNum, fp);
+            fp.send();
 
             // If mid-move, replay the current target so the client knows the goal.
             if (_mode[i] == MODE_POSITION && _steppers[i]->distanceToGo() != 0) {
-                FrameBuilder ft; ft.begin(CMD_STEPPER_MOVE_TO, DEVICE_STEPPER);
+                PardaloteFrame ft(clientNum, CMD_STEPPER_MOVE_TO, DEVICE_STEPPER);
                 ft.addInt(i); ft.addInt(_steppers[i]->targetPosition());
-                Pardalote.sendFrame(clientNum, ft);
+                ft.send();
             }
         }
     }
@@ -1176,10 +1172,9 @@ public:
     // Pin -1 clears the switch. Echoed to browsers so their record syncs.
     void setLimitSwitch(int id, int end, int pin, int trigger = LOW) const {
         Pardalote.command(DEVICE_STEPPER, CMD_STEPPER_SET_SWITCH, id, end, pin, trigger);
-        FrameBuilder fb;
-        fb.begin(CMD_STEPPER_SET_SWITCH, DEVICE_STEPPER);
+        PardaloteFrame fb(PARDALOTE_ALL_CLIENTS, CMD_STEPPER_SET_SWITCH, DEVICE_STEPPER);
         fb.addInt(id); fb.addInt(end); fb.addInt(pin); fb.addInt(trigger ? 1 : 0);
-        Pardalote.broadcastFrame(fb);
+        fb.send();
     }
     void clearLimitSwitch(int id, int end) const { setLimitSwitch(id, end, -1); }
 
@@ -1208,4 +1203,10 @@ inline PardaloteStepperAccess PardaloteStepper;
 INSTALL_EXTENSION(DEVICE_STEPPER, StepperExt::handle, StepperExt::announce,
                   StepperExt::disconnect, StepperExt::loop)
 
+// Move-complete and limit trips ahead of position readings.
+OUTBOUND_LANE(DEVICE_STEPPER, CMD_STEPPER_DONE,  TX_LANE_CONTROL)
+OUTBOUND_LANE(DEVICE_STEPPER, CMD_STEPPER_LIMIT, TX_LANE_CONTROL)
+OUTBOUND_LANE(DEVICE_STEPPER, CMD_STEPPER_HOME,  TX_LANE_CONTROL)
+OUTBOUND_LANE(DEVICE_STEPPER, CMD_STEPPER_READ,  TX_LANE_TELEMETRY)
+
 #endif
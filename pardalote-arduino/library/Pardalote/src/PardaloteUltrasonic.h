@@ -51,11 +51,10 @@ private:
     static bool validId(int id) { return id >= 0 && id < MAX_ULTRASONIC; }
 
     static void sendReadTo(uint8_t clientNum, int id, int32_t dist) {
-        FrameBuilder fb;
-        fb.begin(CMD_ULTRASONIC_READ, DEVICE_ULTRASONIC);
+        PardaloteFrame fb(clientNum, CMD_ULTRASONIC_READ, DEVICE_ULTRASONIC);
         fb.addInt(id);
         fb.addInt(dist);
-        Pardalote.sendFrame(clientNum, fb);
+        fb.send();
     }
 
     // Returns distance in tenths of the requested unit, or -1 on timeout.
@@ -141,21 +140,19 @@ public:
         // announce() covers future connects): name → attach. Echo pin only for
         // 4-wire, matching the browser's own attach frame.
         broadcastShare(id);
-        FrameBuilder fa;
-        fa.begin(CMD_ULTRASONIC_ATTACH, DEVICE_ULTRASONIC);
+        PardaloteFrame fa(PARDALOTE_ALL_CLIENTS, CMD_ULTRASONIC_ATTACH, DEVICE_ULTRASONIC);
         fa.addInt(id); fa.addInt(_trigPins[id]);
         if (_echoPins[id] != -1) fa.addInt(_echoPins[id]);
-        Pardalote.broadcastFrame(fa);
+        fa.send();
 
         return id;
     }
 
     static void broadcastShare(int id) {
-        FrameBuilder fb;
-        fb.begin(CMD_SHARE, DEVICE_ULTRASONIC);
+        PardaloteFrame fb(PARDALOTE_ALL_CLIENTS, CMD_SHARE, DEVICE_ULTRASONIC);
         fb.addInt(id);
         fb.addString(_names[id]);
-        Pardalote.broadcastFrame(fb);
+        fb.send();
     }
 
     // -------------------------------------------------------------------
@@ -259,11 +256,10 @@ public:
     // Called on each new client connection
     // -------------------------------------------------------------------
     static void announce(uint8_t clientNum) {
-        FrameBuilder fb;
-        fb.begin(CMD_ANNOUNCE, DEVICE_ULTRASONIC);
+        PardaloteFrame fb(clientNum, CMD_ANNOUNCE, DEVICE_ULTRASONIC);
         fb.addInt(PROTOCOL_VERSION_MAJOR);
         fb.addInt(MAX_ULTRASONIC);
-        Pardalote.sendFrame(clientNum, fb);
+        fb.send();
 
         // Send full attach state for any currently attached sensors:
         // pins, and echo timeout.
@@ -273,34 +269,31 @@ public:
             // Sketch-created sensor: send its SHARE frame FIRST so the browser
             // materialises arduino.<name> before the state frames below.
             if (_sketchOwned[i]) {
-                FrameBuilder fsh;
-                fsh.begin(CMD_SHARE, DEVICE_ULTRASONIC);
+                PardaloteFrame fsh(clientNum, CMD_SHARE, DEVICE_ULTRASONIC);
                 fsh.addInt(i);
                 fsh.addString(_names[i]);
-                Pardalote.sendFrame(clientNum, fsh);
+                fsh.send();
             }
 
-            FrameBuilder fa;
-            fa.begin(CMD_ULTRASONIC_ATTACH, DEVICE_ULTRASONIC);
+            PardaloteFrame fa(clientNum, CMD_ULTRASONIC_ATTACH, DEVICE_ULTRASONIC);
             fa.addInt(i);
             fa.addInt(_trigPins[i]);
             if (_echoPins[i] != -1) fa.addInt(_echoPins[i]);
-            Pardalote.sendFrame(clientNum, fa);
+            fa.send();
 
-            FrameBuilder ft;
-            ft.begin(CMD_ULTRASONIC_SET_TIMEOUT, DEVICE_ULTRASONIC);
+            PardaloteFrame ft(clientNum, CMD_ULTRASONIC_SET_TIMEOUT, DEVICE_ULTRASONIC);
             ft.addInt(i);
             ft.addInt(_timeoutMs[i]);
-            Pardalote.sendFrame(clientNum, ft);
+            ft.send();
         }
     }
 
     // -------------------------------------------------------------------
-    // Loop hook — board-side periodic reads. One blocking measure per due
-    // registration (at the fastest requested rate), then per-client gating.
+    // Loop hook (timed) — board-side periodic reads. One blocking measure
+    // per due registration (at the fastest requested rate), then per-client
+    // gating.
     // -------------------------------------------------------------------
-    static void loop() {
-        const unsigned long now = millis();
+    static uint32_t loop(uint32_t now) {
         for (int i = 0; i < MAX_ULTRASONIC; i++) {
             ExtReadPoll& p = _polls[i];
             if (!p.due(now)) continue;
@@ -309,6 +302,7 @@ public:
             for (uint8_t c = 0; c < PARDALOTE_MAX_CLIENTS; c++)
                 if (p.gate(c, dist, now)) sendReadTo(c, p.instance, dist);
         }
+        return extPollNextDue(_polls, MAX_ULTRASONIC, now);
     }
 
     // Client disconnect — drop its read registrations.
@@ -360,5 +354,6 @@ inline PardaloteUltrasonicAccess PardaloteUltrasonic;
 
 INSTALL_EXTENSION(DEVICE_ULTRASONIC, UltrasonicExt::handle, UltrasonicExt::announce,
                   UltrasonicExt::disconnect, UltrasonicExt::loop)
+OUTBOUND_LANE(DEVICE_ULTRASONIC, CMD_ULTRASONIC_READ, TX_LANE_TELEMETRY)
 
 #endif
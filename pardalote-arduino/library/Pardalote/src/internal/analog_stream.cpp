@@ -0,0 +1,257 @@
+// ==============================================================
+// internal/analog_stream.cpp
+// Continuous ADC streaming. See the design notes in analog_stream.h.
+// ==============================================================
+
+#include "analog_stream.h"
+
+#if PARDALOTE_ANALOG_STREAM && defined(PLATFORM_ESP32)
+  #include <esp_adc/adc_continuous.h>
+
+  // Result layout differs by chip: TYPE1 on the ESP32 / ESP32-S2,
+  // TYPE2 everywhere else.
+  #if CONFIG_IDF_TARGET_ESP32 || CONFIG_IDF_TARGET_ESP32S2
+    #define STREAM_FORMAT       ADC_DIGI_OUTPUT_FORMAT_TYPE1
+    #define STREAM_CHANNEL(r)   ((r)->type1.channel)
+    #define STREAM_DATA(r)      ((r)->type1.data)
+  #else
+    #define STREAM_FORMAT       ADC_DIGI_OUTPUT_FORMAT_TYPE2
+    #define STREAM_CHANNEL(r)   ((r)->type2.channel)
+    #define STREAM_DATA(r)      ((r)->type2.data)
+  #endif
+
+  // One DMA conversion frame, and the driver pool that buffers them
+  // between run() passes.
+  #define STREAM_CONV_BYTES  256
+  #define STREAM_POOL_BYTES  4096
+
+  static adc_continuous_handle_t _adc = nullptr;
+  static uint8_t                 _chanIdx[SOC_ADC_MAX_CHANNEL_NUM];   // channel → pin index, 0xFF = not ours
+  static volatile uint32_t       _poolOverflows = 0;
+
+  static bool IRAM_ATTR _onPoolOvf(adc_continuous_handle_t, const adc_continuous_evt_data_t*, void*) {
+      _poolOverflows = _poolOverflows + 1;
+      return false;
+  }
+#elif PARDALOTE_ANALOG_STREAM
+  // Host: frames are due every 1/_hwRate s of shim time.
+  static uint32_t _hwRate = 0;
+  static uint32_t _nextUs = 0;
+#endif
+
+bool     AnalogStream::_running = false;
+uint8_t  AnalogStream::_n       = 0;
+uint8_t  AnalogStream::_pins[ANALOG_STREAM_MAX_PINS] = {};
+uint32_t AnalogStream::_rate    = 0;
+uint32_t AnalogStream::_dropped = 0;
+uint16_t AnalogStream::_decim   = 1;
+uint16_t AnalogStream::_accFrames = 0;
+uint32_t AnalogStream::_acc[ANALOG_STREAM_MAX_PINS]    = {};
+uint16_t AnalogStream::_accCnt[ANALOG_STREAM_MAX_PINS] = {};
+uint16_t AnalogStream::_cur[ANALOG_STREAM_MAX_PINS]  = {};
+uint16_t AnalogStream::_last[ANALOG_STREAM_MAX_PINS] = {};
+#if PARDALOTE_ANALOG_STREAM
+uint16_t (*AnalogStream::_ring)[ANALOG_STREAM_MAX_PINS] = nullptr;
+#endif
+uint16_t AnalogStream::_head  = 0;
+uint16_t AnalogStream::_count = 0;
+
+// -------------------------------------------------------------------
+// Start / stop
+// -------------------------------------------------------------------
+
+int8_t AnalogStream::start(const uint8_t* pins, uint8_t n, uint32_t rateHz) {
+    stop();
+#if !PARDALOTE_ANALOG_STREAM
+    (void)pins; (void)n; (void)rateHz;
+    return STREAM_ERR_UNSUPPORTED;
+#else
+    if (n < 1 || n > ANALOG_STREAM_MAX_PINS || rateHz == 0) return STREAM_ERR_PIN;
+    if (rateHz > ANALOG_STREAM_MAX_HZ) rateHz = ANALOG_STREAM_MAX_HZ;
+    if (!_ring) {
+        _ring = (uint16_t (*)[ANALOG_STREAM_MAX_PINS])malloc(
+            (size_t)PARDALOTE_STREAM_RING * sizeof(*_ring));
+        if (!_ring) {
+            Serial.println(F("[Pardalote] analog stream: out of memory for the frame ring"));
+            return STREAM_ERR_DRIVER;
+        }
+    }
+
+  #if defined(PLATFORM_ESP32)
+    // The hardware has a floor on its total conversion rate; below it,
+    // convert at the floor and average down (decimate) to the request.
+    uint32_t total = rateHz * n;
+    if (total < SOC_ADC_SAMPLE_FREQ_THRES_LOW) total = SOC_ADC_SAMPLE_FREQ_THRES_LOW;
+    const uint32_t hwPerPin = total / n;
+    _decim = (uint16_t)((hwPerPin + rateHz / 2) / rateHz);
+    if (_decim < 1) _decim = 1;
+
+    memset(_chanIdx, 0xFF, sizeof(_chanIdx));
+    adc_digi_pattern_config_t pattern[ANALOG_STREAM_MAX_PINS] = {};
+    for (uint8_t i = 0; i < n; i++) {
+        adc_unit_t    unit;
+        adc_channel_t ch;
+        if (adc_continuous_io_to_channel(pins[i], &unit, &ch) != ESP_OK ||
+            unit != ADC_UNIT_1 || _chanIdx[ch] != 0xFF)
+            return STREAM_ERR_PIN;
+        _chanIdx[ch]         = i;
+        pattern[i].atten     = ADC_ATTEN_DB_12;
+        pattern[i].channel   = ch;
+        pattern[i].unit      = ADC_UNIT_1;
+        pattern[i].bit_width = SOC_ADC_DIGI_MAX_BITWIDTH;
+    }
+
+    adc_continuous_handle_cfg_t hcfg = {};
+    hcfg.max_store_buf_size = STREAM_POOL_BYTES;
+    hcfg.conv_frame_size    = STREAM_CONV_BYTES;
+    if (adc_continuous_new_handle(&hcfg, &_adc) != ESP_OK) { _adc = nullptr; return STREAM_ERR_DRIVER; }
+
+    adc_continuous_config_t cfg = {};
+    cfg.pattern_num    = n;
+    cfg.adc_pattern    = pattern;
+    cfg.sample_freq_hz = hwPerPin * n;
+    cfg.conv_mode      = ADC_CONV_SINGLE_UNIT_1;
+    cfg.format         = STREAM_FORMAT;
+
+    adc_continuous_evt_cbs_t cbs = {};
+    cbs.on_pool_ovf = _onPoolOvf;
+    _poolOverflows = 0;
+
+    if (adc_continuous_config(_adc, &cfg) != ESP_OK ||
+        adc_continuous_register_event_callbacks(_adc, &cbs, nullptr) != ESP_OK ||
+        adc_continuous_start(_adc) != ESP_OK) {
+        adc_continuous_deinit(_adc);
+        _adc = nullptr;
+        return STREAM_ERR_DRIVER;
+    }
+    _rate = hwPerPin / _decim;
+  #else
+    _decim  = 1;
+    _hwRate = rateHz;
+    _nextUs = micros();
+    _rate   = rateHz;
+  #endif
+
+    _n = n;
+    memcpy(_pins, pins, n);
+    _dropped   = 0;
+    _accFrames = 0;
+    _head      = 0;
+    _count     = 0;
+    memset(_acc,    0, sizeof(_acc));
+    memset(_accCnt, 0, sizeof(_accCnt));
+    _running = true;
+    return STREAM_RUNNING;
+#endif
+}
+
+void AnalogStream::stop() {
+    if (!_running) return;
+#if PARDALOTE_ANALOG_STREAM && defined(PLATFORM_ESP32)
+    adc_continuous_stop(_adc);
+    adc_continuous_deinit(_adc);
+    _adc = nullptr;
+#endif
+    _running = false;
+    _n       = 0;
+    _count   = 0;
+}
+
+uint8_t AnalogStream::bits() {
+#if PARDALOTE_ANALOG_STREAM && defined(PLATFORM_ESP32)
+    return SOC_ADC_DIGI_MAX_BITWIDTH;
+#else
+    return ADC_RESOLUTION_BITS;
+#endif
+}
+
+bool AnalogStream::latest(uint8_t pin, int32_t& val) {
+    if (!_running) return false;
+    for (uint8_t i = 0; i < _n; i++) {
+        if (_pins[i] != pin) continue;
+        val = _last[i];
+        return true;
+    }
+    return false;
+}
+
+// -------------------------------------------------------------------
+// Loop side
+// -------------------------------------------------------------------
+
+void AnalogStream::poll() {
+    if (!_running) return;
+#if PARDALOTE_ANALOG_STREAM && defined(PLATFORM_ESP32)
+    // Each overflow lost one conversion frame's worth of results.
+    const uint32_t ovf = _poolOverflows;
+    if (ovf) {
+        _poolOverflows = 0;
+        _dropped += ovf * (STREAM_CONV_BYTES / SOC_ADC_DIGI_RESULT_BYTES) / (_n * _decim);
+    }
+
+    uint8_t  raw[STREAM_CONV_BYTES];
+    uint32_t got = 0;
+    // Bounded by the pool size — the loop never spins on a fast stream.
+    for (uint8_t pass = 0; pass < STREAM_POOL_BYTES / STREAM_CONV_BYTES; pass++) {
+        if (adc_continuous_read(_adc, raw, sizeof(raw), &got, 0) != ESP_OK) break;
+        for (uint32_t i = 0; i + SOC_ADC_DIGI_RESULT_BYTES <= got; i += SOC_ADC_DIGI_RESULT_BYTES) {
+            const adc_digi_output_data_t* r = (const adc_digi_output_data_t*)&raw[i];
+            const uint32_t ch = STREAM_CHANNEL(r);
+            if (ch >= SOC_ADC_MAX_CHANNEL_NUM || _chanIdx[ch] == 0xFF) continue;
+            _sample(_chanIdx[ch], (uint16_t)STREAM_DATA(r));
+        }
+    }
+#elif PARDALOTE_ANALOG_STREAM
+    // Every frame that fell due since the last pass, read from the shim.
+    const uint32_t periodUs = 1000000UL / _hwRate;
+    for (uint16_t k = 0; k < PARDALOTE_STREAM_RING && (int32_t)(micros() - _nextUs) >= 0; k++) {
+        for (uint8_t i = 0; i < _n; i++) _sample(i, (uint16_t)analogRead(_pins[i]));
+        _nextUs += periodUs;
+    }
+#endif
+}
+
+// Results arrive in pattern order, so the last pin's sample closes a
+// hardware frame. Each pin averages only the results it actually got —
+// one lost mid-frame leaves the average unbiased, and a pin that got
+// none repeats its previous sample.
+void AnalogStream::_sample(uint8_t idx, uint16_t v) {
+    _acc[idx] += v;
+    _accCnt[idx]++;
+    if (idx != _n - 1) return;
+    if (++_accFrames < _decim) return;
+    for (uint8_t i = 0; i < _n; i++) {
+        _cur[i]    = _accCnt[i] ? (uint16_t)(_acc[i] / _accCnt[i]) : _last[i];
+        _acc[i]    = 0;
+        _accCnt[i] = 0;
+    }
+    _accFrames = 0;
+    _commit();
+}
+
+void AnalogStream::_commit() {
+    memcpy(_last, _cur, sizeof(_last));
+#if PARDALOTE_ANALOG_STREAM
+    if (_count == PARDALOTE_STREAM_RING) { _dropped++; return; }   // full — keep the older frames
+    uint16_t at = (uint16_t)((_head + _count) % PARDALOTE_STREAM_RING);
+    memcpy(_ring[at], _cur, sizeof(_cur));
+    _count++;
+#endif
+}
+
+void AnalogStream::take(uint8_t* out, uint16_t frames) {
+#if PARDALOTE_ANALOG_STREAM
+    if (frames > _count) frames = _count;
+    for (uint16_t f = 0; f < frames; f++) {
+        const uint16_t* s = _ring[_head];
+        for (uint8_t i = 0; i < _n; i++) {
+            *out++ = (uint8_t)(s[i] >> 8);
+            *out++ = (uint8_t)(s[i] & 0xFF);
+        }
+        _head = (uint16_t)((_head + 1) % PARDALOTE_STREAM_RING);
+    }
+    _count -= frames;
+#else
+    (void)out; (void)frames;
+#endif
+}
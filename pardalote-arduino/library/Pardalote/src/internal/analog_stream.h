@@ -0,0 +1,115 @@
+// ==============================================================
+// internal/analog_stream.h
+// Continuous ADC streaming (CMD_ANALOG_STREAM / CMD_ANALOG_BLOCK).
+// Part of Pardalote — version in library.properties
+// by Scott Mitchell
+// GPL-3.0-or-later License
+//
+// A polled analog watch samples once per ANALOG_SAMPLE_MS with a
+// blocking analogRead(), so nothing faster than ~100 Hz is visible and
+// every read costs loop time. A stream instead runs the ESP32's
+// continuous ADC driver: the hardware converts the pins in a fixed
+// pattern and DMAs the results into the driver's pool, with no CPU per
+// sample. The split is:
+//
+//   - DMA (adc_continuous): converts and stores. Overruns are counted
+//     by the pool-overflow callback.
+//   - loop() (poll, each run() pass): moves the pool's results into a
+//     frame ring — one frame = one sample per streamed pin, in request
+//     order — averaging when the requested rate sits below what the
+//     hardware can go down to (the classic ESP32 won't convert slower
+//     than 20 kHz in total).
+//   - PardaloteClass::_pumpStream: ships whole blocks of frames to the
+//     client that asked, as CMD_ANALOG_BLOCK.
+//
+// ESP32 on Arduino core 3.x only (the IDF 5 driver). Every other board
+// answers STREAM_ERR_UNSUPPORTED; the host build simulates the stream
+// from analogRead() on the shim's clock.
+//
+// While a stream runs, the ADC1 unit belongs to it: a polled watch on
+// a streamed pin takes the stream's latest sample instead of calling
+// analogRead(), and analogRead() on other ADC1 pins is unavailable.
+// ==============================================================
+
+#pragma once
+
+#include <Arduino.h>
+#include "platform.h"
+#include "defs.h"
+
+#if defined(PLATFORM_ESP32)
+  #include <esp_arduino_version.h>
+  #if ESP_ARDUINO_VERSION_MAJOR >= 3
+    #define PARDALOTE_ANALOG_STREAM 1
+  #endif
+#elif defined(PLATFORM_HOST)
+  #define PARDALOTE_ANALOG_STREAM 1
+#endif
+#ifndef PARDALOTE_ANALOG_STREAM
+  #define PARDALOTE_ANALOG_STREAM 0
+#endif
+
+// Frame ring capacity (one frame = one sample per pin). At 8 kHz that
+// is 64 ms of slack between run() passes, on top of the driver pool.
+// The ring (capacity × ANALOG_STREAM_MAX_PINS × 2 bytes, 4 KB by
+// default) comes from the heap on the first start() and is kept, so a
+// sketch that never streams doesn't pay for it.
+#ifndef PARDALOTE_STREAM_RING
+  #define PARDALOTE_STREAM_RING 512
+#endif
+
+// Fastest rate a stream may ask for, per pin.
+#define ANALOG_STREAM_MAX_HZ 20000UL
+
+class AnalogStream {
+public:
+    // STREAM_RUNNING, or a STREAM_ERR_* code (nothing left running).
+    // rateHz is samples per second per pin; rate() reports what the
+    // hardware could actually do.
+    static int8_t start(const uint8_t* pins, uint8_t n, uint32_t rateHz);
+    static void   stop();
+
+    static bool     running()  { return _running; }
+    static uint8_t  pinCount() { return _n; }
+    static uint32_t rate()     { return _rate; }
+    static uint8_t  bits();
+
+    // True (and the most recent sample) when `pin` is being streamed.
+    static bool latest(uint8_t pin, int32_t& val);
+
+    // Move finished conversions into the ring. Call every run() pass.
+    static void poll();
+
+    // Whole frames waiting in the ring.
+    static uint16_t available() { return _count; }
+
+    // Take `frames` (<= available()) frames as uint16 big-endian,
+    // interleaved in pin order — the CMD_ANALOG_BLOCK payload.
+    static void take(uint8_t* out, uint16_t frames);
+
+    // Frames lost since start() — driver overruns and a full ring.
+    static uint32_t dropped() { return _dropped; }
+
+private:
+    static bool     _running;
+    static uint8_t  _n;
+    static uint8_t  _pins[ANALOG_STREAM_MAX_PINS];
+    static uint32_t _rate;
+    static uint32_t _dropped;
+
+    // Decimation: `_decim` hardware frames average into one.
+    static uint16_t _decim;
+    static uint16_t _accFrames;
+    static uint32_t _acc[ANALOG_STREAM_MAX_PINS];
+    static uint16_t _accCnt[ANALOG_STREAM_MAX_PINS];
+    static uint16_t _cur[ANALOG_STREAM_MAX_PINS];   // frame being assembled
+    static uint16_t _last[ANALOG_STREAM_MAX_PINS];  // newest committed frame
+
+#if PARDALOTE_ANALOG_STREAM
+    static uint16_t (*_ring)[ANALOG_STREAM_MAX_PINS];   // PARDALOTE_STREAM_RING frames, on first start()
+#endif
+    static uint16_t _head, _count;
+
+    static void _sample(uint8_t idx, uint16_t v);
+    static void _commit();
+};
@@ -0,0 +1,119 @@
+// ==============================================================
+// internal/at_queue.h
+// Frames parked until a board time (CMD_AT).
+// Part of Pardalote — version in library.properties
+// by Scott Mitchell
+// GPL-3.0-or-later License
+//
+// A CMD_AT frame carries a micros() deadline and, as its payload,
+// the frames to run then. The core parks the payload here and
+// replays it through the normal inbound path once the deadline
+// passes, so a group write, a sync move or a gesture starts at a
+// chosen board time instead of whenever the network delivers it.
+//
+// Entries are kept earliest-first (insertion into a short index
+// array), so run() only ever looks at the head. Equal deadlines run
+// in arrival order. Times compare as signed differences, so the
+// queue is safe across the micros() wrap as long as every deadline
+// is within PARDALOTE_AT_MAX_AHEAD_MS of now.
+// ==============================================================
+
+#ifndef PARDALOTE_AT_QUEUE_H
+#define PARDALOTE_AT_QUEUE_H
+
+#include <Arduino.h>
+#include "platform.h"
+#include "protocol.h"
+
+// Parked CMD_AT payloads. Each slot holds one full payload, so this
+// costs about 250 bytes of RAM per slot, inside PardaloteClass. Sizes
+// a member — compiler flag only (-DPARDALOTE_AT_SLOTS=…), like
+// PARDALOTE_TX_BATCH.
+#ifndef PARDALOTE_AT_SLOTS
+  #if defined(PLATFORM_ESP32)
+    #define PARDALOTE_AT_SLOTS 8
+  #else
+    #define PARDALOTE_AT_SLOTS 4
+  #endif
+#endif
+
+// Furthest ahead a deadline may be — further is refused (AT_ERR_RANGE).
+#ifndef PARDALOTE_AT_MAX_AHEAD_MS
+  #define PARDALOTE_AT_MAX_AHEAD_MS 60000
+#endif
+
+// Largest payload a CMD_AT can carry: a full frame less its header
+// and the deadline param.
+#define AT_MAX_BYTES (FRAME_MAX_SIZE - FRAME_HEADER_SIZE - 4)
+
+static_assert(PARDALOTE_AT_SLOTS >= 1 && PARDALOTE_AT_SLOTS <= 255,
+              "PARDALOTE_AT_SLOTS must be 1..255");
+
+class AtQueue {
+public:
+    struct Entry {
+        uint32_t due;      // micros()
+        uint8_t  client;
+        uint16_t len;
+        uint8_t  data[AT_MAX_BYTES];
+    };
+
+    // False when every slot is taken or len exceeds AT_MAX_BYTES.
+    bool push(uint32_t due, uint8_t client, const uint8_t* data, uint16_t len) {
+        if (_count >= PARDALOTE_AT_SLOTS || len > AT_MAX_BYTES) return false;
+        uint8_t slot = 0;
+        while (_used[slot]) slot++;
+        Entry& e = _slots[slot];
+        e.due    = due;
+        e.client = client;
+        e.len    = len;
+        memcpy(e.data, data, len);
+        _used[slot] = true;
+
+        // After every entry due no later than this one.
+        uint8_t at = _count;
+        while (at > 0 && (int32_t)(due - _slots[_order[at - 1]].due) < 0) {
+            _order[at] = _order[at - 1];
+            at--;
+        }
+        _order[at] = slot;
+        _count++;
+        return true;
+    }
+
+    // Copies the earliest entry out and removes it, if it is due by `now`.
+    bool popDue(uint32_t now, Entry& out) {
+        if (_count == 0) return false;
+        const Entry& head = _slots[_order[0]];
+        if ((int32_t)(now - head.due) < 0) return false;
+        out.due    = head.due;
+        out.client = head.client;
+        out.len    = head.len;
+        memcpy(out.data, head.data, head.len);
+        _remove(0);
+        return true;
+    }
+
+    // Forget a client's entries — it disconnected, or a new page took
+    // its slot.
+    void dropClient(uint8_t client) {
+        for (uint8_t i = _count; i-- > 0; )
+            if (_slots[_order[i]].client == client) _remove(i);
+    }
+
+    uint8_t size() const { return _count; }
+
+private:
+    void _remove(uint8_t i) {
+        _used[_order[i]] = false;
+        for (uint8_t k = i; k + 1 < _count; k++) _order[k] = _order[k + 1];
+        _count--;
+    }
+
+    Entry   _slots[PARDALOTE_AT_SLOTS];
+    bool    _used[PARDALOTE_AT_SLOTS]  = {};
+    uint8_t _order[PARDALOTE_AT_SLOTS] = {};   // slot indices, earliest first
+    uint8_t _count = 0;
+};
+
+#endif
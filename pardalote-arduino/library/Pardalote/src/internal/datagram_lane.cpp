@@ -0,0 +1,127 @@
+// ==============================================================
+// internal/datagram_lane.cpp
+// Datagram lane implementation. See datagram_lane.h.
+// ==============================================================
+
+#include "datagram_lane.h"
+
+#if PARDALOTE_DATAGRAM
+
+#include "protocol.h"
+#ifdef PLATFORM_ESP32
+  #include <esp_system.h>   // esp_random()
+#endif
+
+// Binding datagrams taken per pass — they are tiny, and a flood of them
+// mustn't become a way to stall run().
+static constexpr uint8_t DATAGRAM_RX_PER_PASS = 4;
+
+bool PardaloteDatagramLane::begin(uint16_t port) {
+    end();
+    if (!_udp.begin(port)) {
+        Serial.println(F("[Pardalote] datagrams(): UDP port unavailable — WebSocket only"));
+        return false;
+    }
+    _port = port;
+    Serial.print(F("Datagram lane on UDP port "));
+    Serial.println(port);
+    return true;
+}
+
+void PardaloteDatagramLane::end() {
+    if (!_port) return;
+    _udp.stop();
+    _port = 0;
+    _lost = 0;
+    for (uint8_t c = 0; c < PARDALOTE_MAX_CLIENTS; c++) release(c);
+}
+
+int32_t PardaloteDatagramLane::grant(uint8_t c, bool compact) {
+    if (c >= PARDALOTE_MAX_CLIENTS || !_port) return 0;
+#ifdef PLATFORM_ESP32
+    int32_t token = (int32_t)(esp_random() & 0x7FFFFFFF);
+#else
+    int32_t token = (int32_t)random(0x7FFFFFFF);
+#endif
+    if (token == 0) token = 1;   // 0 means "no lane"
+    Peer& p = _peers[c];
+    p = Peer();
+    p.token   = token;
+    p.compact = compact;
+    return token;
+}
+
+void PardaloteDatagramLane::release(uint8_t c) {
+    if (c >= PARDALOTE_MAX_CLIENTS) return;
+    _peers[c] = Peer();
+    _lost &= ~(1u << c);   // the core let go itself — nothing to report
+}
+
+uint8_t PardaloteDatagramLane::loop(unsigned long now) {
+    if (!_port) return 0;
+
+    // Binding and keepalive: one CMD_DATAGRAM [token] frame, in either
+    // layout. Anything else is ignored — commands go by WebSocket.
+    for (uint8_t n = 0; n < DATAGRAM_RX_PER_PASS; n++) {
+        const int size = _udp.parsePacket();
+        if (size <= 0) break;
+        uint8_t buf[FRAME_HEADER_SIZE + MAX_PARAMS * 4];
+        uint8_t scratch[MAX_PARAMS * 4];
+        const int len = _udp.read(buf, sizeof buf);
+        if (len != size) continue;   // too long to be a binding frame
+        const Frame f = parseFrame(buf, 0, (size_t)len, scratch);
+        if (!f.valid || f.cmd != CMD_DATAGRAM || f.target != 0 || f.nparams < 1) continue;
+        const int32_t token = paramInt(f.params, 0);
+        for (uint8_t c = 0; c < PARDALOTE_MAX_CLIENTS; c++) {
+            Peer& p = _peers[c];
+            if (token == 0 || p.token != token) continue;
+            p.remoteIP   = _udp.remoteIP();
+            p.remotePort = _udp.remotePort();
+            p.seenMs     = now;
+            if (_open(c)) _udp.endPacket();   // the answer: a header on its own
+            break;
+        }
+    }
+
+    for (uint8_t c = 0; c < PARDALOTE_MAX_CLIENTS; c++) {
+        const Peer& p = _peers[c];
+        if (p.remotePort && now - p.seenMs > PARDALOTE_DATAGRAM_TIMEOUT_MS) {
+            _peers[c] = Peer();
+            _lost |= 1u << c;
+        }
+    }
+    const uint8_t lost = _lost;
+    _lost = 0;
+    return lost;
+}
+
+// A failed send leaves that batch to the WebSocket; a run of them
+// (the stack out of buffers, the route gone) lets the client go.
+bool PardaloteDatagramLane::send(uint8_t c, const uint8_t* frames, size_t len) {
+    if (!bound(c)) return false;
+    Peer& p = _peers[c];
+    if (_open(c) && _udp.write(frames, len) == len && _udp.endPacket()) {
+        p.fails = 0;
+        return true;
+    }
+    if (++p.fails >= PARDALOTE_DATAGRAM_FAILS) {
+        p = Peer();
+        _lost |= 1u << c;
+    }
+    return false;
+}
+
+bool PardaloteDatagramLane::_open(uint8_t c) {
+    Peer& p = _peers[c];
+    FrameBuilder fb;
+    fb.begin(CMD_DATAGRAM, 0x0000);
+    fb.addInt((int32_t)++p.seq);
+    size_t n = fb.finish();
+    if (p.compact) {
+        const size_t m = compactFrame(fb.buf, n, fb.buf);
+        if (m) n = m;
+    }
+    return _udp.beginPacket(p.remoteIP, p.remotePort) && _udp.write(fb.buf, n) == n;
+}
+
+#endif   // PARDALOTE_DATAGRAM
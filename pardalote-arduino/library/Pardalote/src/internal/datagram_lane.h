@@ -0,0 +1,121 @@
+// ==============================================================
+// internal/datagram_lane.h
+// Datagram lane — periodic readings over UDP, beside the WebSocket.
+// Part of Pardalote — version in library.properties
+// by Scott Mitchell
+// GPL-3.0-or-later License
+//
+// A reading that goes missing is replaced by the next one, but over
+// TCP one lost segment holds back every reading after it until it is
+// retransmitted, and they then arrive in a burst. The lane carries just
+// the telemetry lane of a client's batch (TX_LANE_TELEMETRY: pin polls,
+// ExtReadPoll readings, analog blocks) as datagrams, where a loss costs
+// only itself. Replies, announces, DONE and LIMIT events and everything
+// the client sends stay on the WebSocket.
+//
+// Opt-in on both ends. The sketch calls Pardalote.datagrams() before
+// begin(); HELLO then offers FEATURE_DATAGRAM (param 4) and the UDP
+// port (param 6). A client that wants the lane:
+//
+//   1. switches FEATURE_DATAGRAM on with CMD_FEATURES. The board
+//      answers over the WebSocket with CMD_DATAGRAM [token].
+//   2. sends CMD_DATAGRAM [token] in a datagram to the board's port,
+//      from the socket it will read on, and again at least every
+//      PARDALOTE_DATAGRAM_TIMEOUT_MS / 2. Each one is answered with a
+//      header-only datagram, so the client knows the path works.
+//   3. from then on gets each batch's telemetry as one datagram:
+//      CMD_DATAGRAM [seq] and then the frames. seq counts up from 1 per
+//      binding; drop a datagram whose seq is older than one already seen.
+//
+// Until the client is bound, and once the lane lets it go (no datagram
+// within the timeout, or sends keep failing), its telemetry rides the
+// WebSocket batch as before. Letting go is reported with CMD_DATAGRAM
+// [0] over the WebSocket; CMD_FEATURES again asks for a new token.
+//
+// Browsers can't open a UDP socket, so pardalote.js never asks; the
+// lane is for native tools, test rigs and a host build (the shim's
+// WiFiUDP is a real socket).
+// ==============================================================
+
+#pragma once
+
+#include <Arduino.h>
+#include "platform.h"
+#include "defs.h"
+
+// Build with -DPARDALOTE_DATAGRAM=0 to leave the lane out. Needs a
+// network stack — or the host shim's.
+#ifndef PARDALOTE_DATAGRAM
+  #if !defined(PARDALOTE_NO_WIFI) || defined(PARDALOTE_HOST)
+    #define PARDALOTE_DATAGRAM 1
+  #else
+    #define PARDALOTE_DATAGRAM 0
+  #endif
+#endif
+
+// UDP port datagrams() listens on — the WebSocket's number, in the
+// other port space.
+#ifndef PARDALOTE_DATAGRAM_PORT
+  #define PARDALOTE_DATAGRAM_PORT 81
+#endif
+
+// A bound client that sends nothing for this long goes back to the
+// WebSocket.
+#ifndef PARDALOTE_DATAGRAM_TIMEOUT_MS
+  #define PARDALOTE_DATAGRAM_TIMEOUT_MS 5000
+#endif
+
+// Sends in a row that may fail before a client goes back to the
+// WebSocket; a single failure only sends that batch by WebSocket.
+#ifndef PARDALOTE_DATAGRAM_FAILS
+  #define PARDALOTE_DATAGRAM_FAILS 8
+#endif
+
+#if PARDALOTE_DATAGRAM
+
+#include <WiFiUdp.h>
+
+class PardaloteDatagramLane {
+public:
+    bool     begin(uint16_t port);
+    void     end();
+    uint16_t port() const { return _port; }   // 0 = not running
+
+    // A fresh token for client `c` (never 0), unbinding it until the
+    // client sends that token from its socket. release() forgets it.
+    // `compact`: the client's datagram headers go in the compact layout.
+    int32_t grant(uint8_t c, bool compact);
+    void    release(uint8_t c);
+    bool    bound(uint8_t c) const {
+        return c < PARDALOTE_MAX_CLIENTS && _peers[c].remotePort != 0;
+    }
+
+    // Once per run() pass: takes the binding datagrams that arrived and
+    // expires silent clients. Returns a bit per client the lane has let
+    // go of since the last call — timed out, or too many failed send()s.
+    uint8_t loop(unsigned long now);
+
+    // One batch's telemetry to a bound client, behind the CMD_DATAGRAM
+    // header. False if it didn't go; PARDALOTE_DATAGRAM_FAILS of those
+    // in a row release the client.
+    bool send(uint8_t c, const uint8_t* frames, size_t len);
+
+private:
+    struct Peer {
+        int32_t   token;
+        IPAddress remoteIP;
+        uint16_t  remotePort;   // 0 = not bound
+        uint32_t  seenMs;
+        uint32_t  seq;
+        uint8_t   fails;        // send()s failed in a row
+        bool      compact;
+    };
+    bool _open(uint8_t c);   // beginPacket + header
+
+    WiFiUDP  _udp;
+    uint16_t _port = 0;
+    uint8_t  _lost = 0;
+    Peer     _peers[PARDALOTE_MAX_CLIENTS] = {};
+};
+
+#endif   // PARDALOTE_DATAGRAM
@@ -17,7 +17,7 @@
 // MAJOR product release); MINOR marks backward-compatible additions.
 // Independent of the product version below.
 #define PROTOCOL_VERSION_MAJOR 1
-#define PROTOCOL_VERSION_MINOR 0
+#define PROTOCOL_VERSION_MINOR 1
 
 // Product version — the release humans see. Canonical copies live in
 // library.properties (Arduino) and package.json (JS); this string lets
@@ -45,24 +45,37 @@
 // for the core — extension commands start at 0x10 (see the rule at the
 // Extension Device IDs section).
 // -------------------------------------------------------------------
-#define CMD_HELLO         0x00  // Arduino → JS on connect: [major, minor, adcBits, bootId] + board string
+#define CMD_HELLO         0x00  // Arduino → JS on connect: [major, minor, adcBits, bootId, features,
+                                // serialBaud, datagramPort] + board string
                                 // bootId (param 3): random 31-bit token generated once
                                 // per boot — JS compares it across reconnects to tell "board
                                 // rebooted" (drop board-originated state) from "network blip"
                                 // (keep everything). Older firmware omits it; JS treats absent as 0.
+                                // features (param 4, protocol 1.1): PARDALOTE_FEATURES — what this
+                                // firmware can switch on per client (see CMD_FEATURES). Absent = 0.
+                                // serialBaud (param 5): PARDALOTE_SERIAL_MAX_BAUD — the fastest
+                                // rate CMD_BAUD accepts; SERIAL_BAUD_NATIVE (-1) = native USB,
+                                // where the rate doesn't apply. Absent = no switching.
+                                // datagramPort (param 6): the UDP port of the datagram lane, 0
+                                // when it isn't running (see internal/datagram_lane.h).
 #define CMD_ANNOUNCE      0x01  // Arduino → JS per extension: [version, maxInstances]
 #define CMD_PIN_MODE      0x02  // JS → Arduino: set pin mode [mode]; Arduino → JS: announce pin
                                 // config [mode] or [mode, interval, threshold] when the board
                                 // itself polls the pin (share() with an interval)
 #define CMD_DIGITAL_WRITE 0x03  // JS → Arduino: write value; Arduino → JS: announce output state
-#define CMD_DIGITAL_READ  0x04  // JS → Arduino: [interval?, threshold?] read/register (threshold;
-                                // 0 = board default); Arduino → JS: [value]
+#define CMD_DIGITAL_READ  0x04  // JS → Arduino: [interval?, threshold?, flags?] read/register
+                                // (threshold 0 = board default; flags READ_EDGES below);
+                                // Arduino → JS: [value] or, from an interrupt-watched pin,
+                                // [value, micros] — the board's micros() at the edge (uint32,
+                                // wraps every ~71 min). Older JS ignores the second param.
 #define CMD_ANALOG_WRITE  0x05
 #define CMD_ANALOG_READ   0x06  // params as CMD_DIGITAL_READ; analog default threshold = ADC
                                 // noise floor (analogMax >> 8, min 1)
 #define CMD_END           0x07  // Stop a periodic read (per requesting client)
-#define CMD_PING          0x08  // JS → Arduino: heartbeat request
-#define CMD_PONG          0x09  // Arduino → JS: heartbeat response
+#define CMD_PING          0x08  // JS → Arduino: heartbeat request, [seq?]
+#define CMD_PONG          0x09  // Arduino → JS: heartbeat response, [seq, micros] — seq echoed
+                                // (0 if absent), micros() when the PING was handled. The JS
+                                // clock estimator pairs it with its send/receive times.
 #define CMD_SYNC_COMPLETE 0x0A  // Arduino → JS: all announce frames sent; JS fires 'ready'
 #define CMD_MESSAGE       0x0B  // Both ways: user-defined key/value message (see Message Channel below)
 #define CMD_AUTH          0x0C  // Connection key — set on the board with requireKey(), works over
@@ -90,7 +103,154 @@
                                 // session sees it and immediately resumes takeover-probing, so its probe
                                 // lands in the boot-watch window and the board switches straight back to
                                 // serial — the fast recovery from a reset while USB-connected.
-// Next free core cmd: 0x0F.
+#define CMD_FEATURES      0x0F  // JS → Arduino (protocol 1.1): [mask] — switch on the optional
+                                // encodings this browser understands, a subset of the HELLO features.
+                                // Per client; cleared on connect and by a HELLO probe (a reloaded
+                                // page starts plain). No reply. Frames from JS may use any feature
+                                // the HELLO advertised without asking — only board → JS waits.
+// The core CMD range (0x00–0x0F) is now full — further core commands
+// take the 0x70 block below.
+
+// Core commands, second block (0x70–0x7F). These are still core frames —
+// routed by target < RESERVED_START, never by cmd alone — so they can't
+// be mistaken for an extension's codes. Keep extension blocks below 0x70
+// anyway so monitor names stay unambiguous.
+#define CMD_ANALOG_STREAM 0x70  // JS → Arduino (target 0): [rateHz, blockFrames, pin0, pin1?, …]
+                                // start a continuous-ADC stream of up to ANALOG_STREAM_MAX_PINS
+                                // pins at rateHz samples/s per pin; rateHz 0 = stop. One stream
+                                // per board, owned by the client that started it (stopped when
+                                // it disconnects).
+                                // Arduino → JS: [status, rateHz, blockFrames, bits] — status is
+                                // STREAM_RUNNING / STREAM_STOPPED or a STREAM_ERR_* below; rate
+                                // and block size as actually configured (clamped).
+#define CMD_ANALOG_BLOCK  0x71  // Arduino → JS (target 0): [seq, pinCount, dropped] + payload:
+                                // blockFrames × pinCount samples, uint16 big-endian, interleaved
+                                // in request pin order. seq counts blocks from 0 per stream;
+                                // dropped = frames lost since the stream started.
+#define CMD_CLOCK         0x72  // Arduino → JS (target 0): [micros] — board time for the frames
+                                // that follow it in the same message. Sent only to a client that
+                                // switched on FEATURE_CLOCK: at the head of each outbound batch,
+                                // and again mid-batch once PARDALOTE_CLOCK_RESTAMP_US has passed.
+#define CMD_AT            0x73  // JS → Arduino (target 0): [atMicros] + payload: frames (either
+                                // layout) to run when the board's micros() reaches atMicros, as if
+                                // this client had just sent them — see internal/at_queue.h. A past
+                                // deadline runs on the next pass. Nested CMD_AT frames are ignored.
+                                // Arduino → JS, only on refusal: [status] — AT_ERR_* below.
+#define CMD_STATS         0x74  // JS → Arduino (target 0): [flags?] — STATS_RESET zeroes the counters
+                                // after this report. Arduino → JS: a run of frames [kind, …] +
+                                // payload records (big-endian), closed by STATS_KIND_END:
+                                //   LOOP     [kind, passes, maxUs, windowMs, coalesced] + STATS_BINS
+                                //            × u32 — run() period histogram (log2 µs, see stats.h);
+                                //            coalesced = inbound frames superseded while queued
+                                //   SECTION  [kind] + { id u8, calls u32, totalUs u32, maxUs u32 }
+                                //   EXT_LOOP [kind] + { deviceId u16, calls, totalUs, maxUs }
+                                //   COMMAND  [kind, overflow] + { deviceId u16, cmd u8, calls,
+                                //            totalUs, maxUs } — handler time in dispatchExtension
+                                //   CLIENT   [kind] + { client u8, framesIn, bytesIn, framesOut,
+                                //            bytesOut }
+                                //   END      [kind]
+#define CMD_ACK           0x75  // JS → Arduino (target 0, FEATURE_ACK): [bytes] — message bytes
+                                // received from the board since this client's previous ACK. The
+                                // board's unacknowledged total is that client's backlog; over
+                                // PARDALOTE_TX_BACKLOG its periodic readings pause. No reply.
+#define CMD_BAUD          0x76  // JS → Arduino (serial, target 0): [baud] — switch the link to this
+                                // rate. Arduino → JS: [baud], or [0] if refused, as the last
+                                // message at the old rate; the board then switches and waits for
+                                // the page to probe at the new one (see serial_transport.h).
+#define CMD_DATAGRAM      0x77  // FEATURE_DATAGRAM (target 0). Arduino → JS over the WebSocket:
+                                // [token] after CMD_FEATURES switched the lane on, [0] when the
+                                // lane lets this client go. JS → Arduino by datagram: [token] —
+                                // bind and keep alive. Arduino → JS by datagram: [seq] at the head
+                                // of each one, then telemetry frames (see datagram_lane.h).
+
+#define STREAM_STOPPED          0
+#define STREAM_RUNNING          1
+#define STREAM_ERR_UNSUPPORTED  -1   // no continuous ADC on this board / core
+#define STREAM_ERR_PIN          -2   // a pin isn't on a streamable ADC unit (ESP32: ADC1)
+#define STREAM_ERR_BUSY         -3   // another client's stream is running
+#define STREAM_ERR_DRIVER       -4   // the ADC driver refused the configuration
+
+#define AT_ERR_FULL             -1   // every PARDALOTE_AT_SLOTS slot is taken
+#define AT_ERR_RANGE            -2   // deadline more than PARDALOTE_AT_MAX_AHEAD_MS ahead
+
+// CMD_STATS request flags and reply kinds.
+#define STATS_RESET             0x01
+#define STATS_KIND_LOOP         0
+#define STATS_KIND_SECTION      1
+#define STATS_KIND_EXT_LOOP     2
+#define STATS_KIND_COMMAND      3
+#define STATS_KIND_CLIENT       4
+#define STATS_KIND_END          5
+
+// run() pass phases timed by CMD_STATS (SECTION record ids).
+#define STATS_SEC_TRANSPORT     0   // WebSocket / serial service, queueing inbound messages
+#define STATS_SEC_AT            1   // CMD_AT replays
+#define STATS_SEC_EXT_LOOP      2   // every extension loop() hook
+#define STATS_SEC_YIELD         3   // the ESP32 watchdog yield
+#define STATS_SEC_CLIENTS       4   // auth timeouts and connect-time HELLO/announce
+#define STATS_SEC_PINS          5   // watched pins and edges
+#define STATS_SEC_STREAM        6   // analog stream blocks
+#define STATS_SEC_FLUSH         7   // sending the pass's TX batches
+#define STATS_SEC_INBOUND       8   // handling queued inbound frames
+#define STATS_SECTIONS          9
+
+#define ANALOG_STREAM_MAX_PINS  4
+#define ANALOG_BLOCK_MAX_BYTES  224  // sample payload per CMD_ANALOG_BLOCK frame
+
+// Feature bits (HELLO param 4 / CMD_FEATURES param 0).
+#define FEATURE_COMPACT   0x01  // compact frame encoding — see protocol.h
+#define FEATURE_CLOCK     0x02  // CMD_CLOCK time stamps on outbound batches
+#define FEATURE_ACK       0x04  // the client acknowledges what it receives (CMD_ACK)
+#define FEATURE_RELIABLE  0x08  // USB serial: sequenced, acknowledged envelopes (serial_transport.h)
+#define FEATURE_DATAGRAM  0x10  // telemetry by UDP beside the WebSocket (datagram_lane.h) — offered
+                                // only while Pardalote.datagrams() has the lane running
+
+// Build with -DPARDALOTE_SERIAL_RELIABLE=0 to stop offering
+// FEATURE_RELIABLE — pages then keep to plain, best-effort envelopes.
+#ifndef PARDALOTE_SERIAL_RELIABLE
+  #define PARDALOTE_SERIAL_RELIABLE 1
+#endif
+#define PARDALOTE_FEATURES (FEATURE_COMPACT | FEATURE_CLOCK | FEATURE_ACK | \
+                            (PARDALOTE_SERIAL_RELIABLE ? FEATURE_RELIABLE : 0))
+
+// FEATURE_ACK: bytes a client may leave unacknowledged before it counts
+// as backed up (clientBackedUp() in extensions.h). A backed-up client
+// gets no periodic readings until it catches up; replies, events and
+// DONE frames still go out.
+#ifndef PARDALOTE_TX_BACKLOG
+  #define PARDALOTE_TX_BACKLOG 4096
+#endif
+
+// A batch gets a fresh CMD_CLOCK when this long has passed since its
+// last one, so a slow run() pass doesn't stamp late frames early.
+#ifndef PARDALOTE_CLOCK_RESTAMP_US
+  #define PARDALOTE_CLOCK_RESTAMP_US 1000
+#endif
+
+// ESP32: run() blocks for one FreeRTOS tick at most this often (ms), so
+// the idle task gets the CPU and feeds the task watchdog; passes in
+// between only yield to equal-priority tasks. 0 blocks every pass — the
+// old delay(1), which held run() under the 1 kHz tick rate.
+#ifndef PARDALOTE_YIELD_MS
+  #define PARDALOTE_YIELD_MS 50
+#endif
+
+// splitCores() (ESP32): bytes in each of the two queues between the
+// network task and run() — a power of two, allocated only when split.
+// A WebSocket message over half of it is dropped.
+#ifndef PARDALOTE_NET_QUEUE
+  #define PARDALOTE_NET_QUEUE 16384
+#endif
+
+// splitCores(): inbound messages run() takes per pass, so a burst is
+// spread over several passes instead of delaying one.
+#ifndef PARDALOTE_NET_RX_PER_PASS
+  #define PARDALOTE_NET_RX_PER_PASS 8
+#endif
+
+#ifndef PARDALOTE_NET_STACK
+  #define PARDALOTE_NET_STACK 6144
+#endif
 
 // -------------------------------------------------------------------
 // WebSocket client capacity — shared by the core (per-client pin read
@@ -100,6 +260,43 @@
 // -------------------------------------------------------------------
 #define PARDALOTE_MAX_CLIENTS 4
 
+// Client number meaning "every ready client" — PardaloteFrame's broadcast
+// target. (0xFF is the loopback client of a sketch-side command.)
+#define PARDALOTE_ALL_CLIENTS 0xFE
+
+// Per-client outbound batch (bytes). Frames produced during one run()
+// pass are coalesced into a single transport message up to this size.
+// RAM cost is PARDALOTE_MAX_CLIENTS × this. Override with a compiler flag
+// (-DPARDALOTE_TX_BATCH=…), not a sketch #define — it sizes a member of
+// PardaloteClass, so every translation unit must agree.
+#ifndef PARDALOTE_TX_BATCH
+  #define PARDALOTE_TX_BATCH 512
+#endif
+
+// Inbound queue (bytes, a power of two). Transport callbacks copy each
+// message in; run() handles them. A message over half of it is handled
+// in place instead. Sizes a member of PardaloteClass — compiler flag
+// only, like PARDALOTE_TX_BATCH.
+#ifndef PARDALOTE_RX_QUEUE
+  #if defined(PLATFORM_ESP32)
+    #define PARDALOTE_RX_QUEUE 4096
+  #else
+    #define PARDALOTE_RX_QUEUE 1024
+  #endif
+#endif
+
+// Time (µs) one run() pass spends handling queued inbound frames before
+// leaving the rest for the next pass. At least one frame always runs.
+#ifndef PARDALOTE_RX_BUDGET_US
+  #define PARDALOTE_RX_BUDGET_US 2000
+#endif
+
+// How many queued frames behind a coalescable one run() looks through
+// for a replacement — bounds the cost of a long queue.
+#ifndef PARDALOTE_COALESCE_WINDOW
+  #define PARDALOTE_COALESCE_WINDOW 32
+#endif
+
 // -------------------------------------------------------------------
 // Transport selection — tokens for begin(int). Values are API tokens,
 // not wire constants.
@@ -150,9 +347,15 @@
 // (const ANALOG_INPUT_MODE = 8); this value is the wire constant and must match
 // on both sides.
 
+// Read flags (CMD_DIGITAL_READ param 2 / share() flags).
+#define READ_EDGES  0x01   // watch the pin with a CHANGE interrupt instead of
+                           // polling it; every edge is sent, undebounced, with
+                           // its micros() timestamp. Falls back to polling on a
+                           // pin with no interrupt (see internal/edge_watch.h).
+
 // -------------------------------------------------------------------
-// RULE: extension CMD values MUST be >= 0x10. 0x00–0x0F is reserved for
-// core commands — CMD_MESSAGE (0x0B) is routed by its cmd byte ALONE
+// RULE: extension CMD values MUST be >= 0x10 (and below 0x70, the second
+// core block). 0x00–0x0F is reserved for core commands — CMD_MESSAGE (0x0B) is routed by its cmd byte ALONE
 // (message flags in the target high byte can exceed RESERVED_START), so
 // an extension cmd that collides with a core cmd routed this way is
 // silently misdispatched on both sides of the wire.
@@ -0,0 +1,112 @@
+// ==============================================================
+// internal/edge_watch.cpp
+// Interrupt-driven pin watching. See the design notes in edge_watch.h.
+// ==============================================================
+
+#include "edge_watch.h"
+
+#if defined(PLATFORM_ESP32)
+  #define EDGE_WATCH_ISR IRAM_ATTR
+#else
+  #define EDGE_WATCH_ISR
+#endif
+
+#ifndef NOT_AN_INTERRUPT
+  #define NOT_AN_INTERRUPT -1
+#endif
+
+static_assert(PARDALOTE_EDGE_PINS >= 1 && PARDALOTE_EDGE_PINS <= 8,
+              "PARDALOTE_EDGE_PINS: 1..8 (one trampoline per slot)");
+static_assert((PARDALOTE_EDGE_RING & (PARDALOTE_EDGE_RING - 1)) == 0,
+              "PARDALOTE_EDGE_RING must be a power of two");
+
+EdgeWatch::Slot     EdgeWatch::_slots[PARDALOTE_EDGE_PINS] = {};
+EdgeWatch::Edge     EdgeWatch::_ring[PARDALOTE_EDGE_RING]  = {};
+volatile uint16_t   EdgeWatch::_head     = 0;
+volatile uint16_t   EdgeWatch::_tail     = 0;
+volatile bool       EdgeWatch::_overflow = false;
+volatile uint32_t   EdgeWatch::_dropped  = 0;
+
+// -------------------------------------------------------------------
+// ISR side
+// -------------------------------------------------------------------
+
+// The edge is written before _head moves (release), and loop() reads
+// _head before the edge (acquire), so a popped edge is always whole.
+void EDGE_WATCH_ISR EdgeWatch::push(uint8_t slot) {
+    const uint32_t us   = micros();
+    const uint16_t head = _head;
+    const uint16_t next = (uint16_t)((head + 1) & (PARDALOTE_EDGE_RING - 1));
+    if (next == __atomic_load_n(&_tail, __ATOMIC_ACQUIRE)) {
+        _overflow = true;
+        _dropped  = _dropped + 1;
+        return;
+    }
+    Edge& e = _ring[head];
+    e.tag   = _slots[slot].tag;
+    e.level = (uint8_t)digitalRead(_slots[slot].pin);
+    e.us    = us;
+    __atomic_store_n(&_head, next, __ATOMIC_RELEASE);
+}
+
+// attachInterrupt() takes a plain function, so each slot gets its own.
+static void EDGE_WATCH_ISR _edgeIsr0() { EdgeWatch::push(0); }
+static void EDGE_WATCH_ISR _edgeIsr1() { EdgeWatch::push(1); }
+static void EDGE_WATCH_ISR _edgeIsr2() { EdgeWatch::push(2); }
+static void EDGE_WATCH_ISR _edgeIsr3() { EdgeWatch::push(3); }
+static void EDGE_WATCH_ISR _edgeIsr4() { EdgeWatch::push(4); }
+static void EDGE_WATCH_ISR _edgeIsr5() { EdgeWatch::push(5); }
+static void EDGE_WATCH_ISR _edgeIsr6() { EdgeWatch::push(6); }
+static void EDGE_WATCH_ISR _edgeIsr7() { EdgeWatch::push(7); }
+
+static void (* const EDGE_ISRS[8])() = {
+    _edgeIsr0, _edgeIsr1, _edgeIsr2, _edgeIsr3,
+    _edgeIsr4, _edgeIsr5, _edgeIsr6, _edgeIsr7,
+};
+
+// -------------------------------------------------------------------
+// Loop side
+// -------------------------------------------------------------------
+
+int8_t EdgeWatch::attach(uint8_t pin, uint8_t tag) {
+    const int irq = digitalPinToInterrupt(pin);
+    if (irq == NOT_AN_INTERRUPT || irq < 0) return -1;
+    for (int8_t s = 0; s < PARDALOTE_EDGE_PINS; s++) {
+        if (_slots[s].used) continue;
+        _slots[s].used = true;
+        _slots[s].pin  = pin;
+        _slots[s].tag  = tag;
+        attachInterrupt(irq, EDGE_ISRS[s], CHANGE);
+        return s;
+    }
+    return -1;
+}
+
+// Edges this slot already queued are marked dead in place — the span
+// between _tail and _head belongs to loop() until pop() moves past it —
+// so a tag reused straight away never inherits the old pin's edges.
+void EdgeWatch::detach(int8_t slot) {
+    if (slot < 0 || slot >= PARDALOTE_EDGE_PINS || !_slots[slot].used) return;
+    detachInterrupt(digitalPinToInterrupt(_slots[slot].pin));
+    _slots[slot].used = false;
+
+    const uint16_t head = __atomic_load_n(&_head, __ATOMIC_ACQUIRE);
+    for (uint16_t i = _tail; i != head; i = (uint16_t)((i + 1) & (PARDALOTE_EDGE_RING - 1)))
+        if (_ring[i].tag == _slots[slot].tag) _ring[i].tag = DEAD_TAG;
+}
+
+bool EdgeWatch::pop(Edge& e) {
+    for (;;) {
+        const uint16_t tail = _tail;
+        if (tail == __atomic_load_n(&_head, __ATOMIC_ACQUIRE)) return false;
+        e = _ring[tail];
+        __atomic_store_n(&_tail, (uint16_t)((tail + 1) & (PARDALOTE_EDGE_RING - 1)), __ATOMIC_RELEASE);
+        if (e.tag != DEAD_TAG) return true;
+    }
+}
+
+bool EdgeWatch::overflowed() {
+    if (!_overflow) return false;
+    _overflow = false;
+    return true;
+}
@@ -0,0 +1,91 @@
+// ==============================================================
+// internal/edge_watch.h
+// Interrupt-driven digital pin watching with microsecond timestamps.
+// Part of Pardalote — version in library.properties
+// by Scott Mitchell
+// GPL-3.0-or-later License
+//
+// A polled digital watch reads the pin once per Pardalote.run() pass
+// and stamps edges with millis(), so both latency and timing accuracy
+// depend on the loop rate. A pin handed to EdgeWatch gets a CHANGE
+// interrupt instead. The split is:
+//
+//   - ISR (a trampoline per slot, calling push()): reads the level,
+//     stamps it with micros() and queues {tag, level, time} in a ring
+//     shared by all watched pins. Nothing else — no allocation, no
+//     frames, no locks.
+//   - loop() (PardaloteClass::_drainEdges): pops the ring and turns
+//     each edge into a timestamped read frame. An idle pin costs the
+//     loop nothing.
+//
+// The ring is single-producer/single-consumer: pin interrupts don't
+// nest with each other on either board (the ESP32 runs every GPIO
+// through one handler; the R4's ICU channels share one priority), and
+// only loop() pops. When the ring overflows, the newest edges are
+// dropped and overflowed() reports it once, so the caller can re-read
+// the pins and resynchronise.
+//
+// Edges are raw — no debounce. This mode is for measuring pulse
+// trains and press timing; a bouncy contact shows every bounce.
+// ==============================================================
+
+#pragma once
+
+#include <Arduino.h>
+#include "platform.h"
+
+// Pins that can be interrupt-watched at once (one ISR trampoline
+// each, so at most 8).
+#ifndef PARDALOTE_EDGE_PINS
+  #define PARDALOTE_EDGE_PINS 8
+#endif
+
+// Ring capacity in edges, shared by every watched pin. Power of two.
+#ifndef PARDALOTE_EDGE_RING
+  #define PARDALOTE_EDGE_RING 64
+#endif
+
+class EdgeWatch {
+public:
+    static const uint8_t DEAD_TAG = 0xFF;
+
+    struct Edge {
+        uint8_t  tag;      // the caller's tag for this pin (see attach)
+        uint8_t  level;    // HIGH / LOW just after the change
+        uint32_t us;       // micros() when the ISR ran
+    };
+
+    // Attach a CHANGE interrupt to `pin`. `tag` (below DEAD_TAG) comes
+    // back with every edge from it. Returns the slot, or -1 when the pin has no
+    // interrupt or every slot is taken (the caller keeps polling).
+    static int8_t attach(uint8_t pin, uint8_t tag);
+    static void   detach(int8_t slot);
+
+    // Oldest queued edge. False when the ring is empty.
+    static bool pop(Edge& e);
+
+    // True once after edges were dropped for want of ring space.
+    static bool overflowed();
+
+    // Edges dropped since boot.
+    static uint32_t dropped() { return _dropped; }
+
+private:
+    struct Slot {
+        bool    used;
+        uint8_t pin;
+        uint8_t tag;
+    };
+
+    static Slot              _slots[PARDALOTE_EDGE_PINS];
+    static Edge              _ring[PARDALOTE_EDGE_RING];
+    static volatile uint16_t _head;      // written by the ISR
+    static volatile uint16_t _tail;      // written by loop()
+    static volatile bool     _overflow;
+    static volatile uint32_t _dropped;
+
+public:
+    // The ISR body — public so the per-slot trampolines (and a host
+    // build) can reach it.
+    static void push(uint8_t slot);
+};
@@ -4,34 +4,146 @@
 // ==============================================================
 
 #include "extensions.h"
+#include "stats.h"
 #include <Wire.h>
 
 static ExtEntry _extRegistry[MAX_EXTENSIONS];
 static uint8_t  _numExtensions   = 0;
+static uint8_t  _droppedExtensions = 0;
 static bool     _wireInitialised = false;
 
+// deviceId - RESERVED_START → registry index + 1 (0 = none). Zero-filled
+// before any dynamic initialisation, so registration order across
+// translation units doesn't matter.
+static uint8_t  _extDirect[EXT_DIRECT_IDS];
+
+// Timed loop hooks, earliest deadline first: a binary min-heap of
+// registry indices keyed on _extDue, so loopAll() only looks at the
+// top while nothing is due. Deadlines compare as signed differences
+// (safe across the millis() wrap). An idle hook is not in the heap.
+static uint8_t  _timerHeap[MAX_EXTENSIONS];
+static uint8_t  _timerPos[MAX_EXTENSIONS];   // heap index + 1; 0 = not queued
+static uint8_t  _timerCount = 0;
+static uint32_t _extDue[MAX_EXTENSIONS];
+
+// Command traits (coalesceCommand, setOutboundLane). A handful, so a
+// linear scan — behind a by-cmd bitmap, because outboundLane() runs for
+// every frame sent and most commands have no trait at all.
+struct CmdTrait {
+    uint16_t deviceId;
+    uint8_t  cmd;
+    bool     coalesce;
+    uint8_t  lane;
+};
+static CmdTrait _traits[PARDALOTE_COMMAND_TRAITS];
+static uint8_t  _numTraits = 0;
+static uint32_t _traitCmds[8];   // bit cmd = some device has a trait for cmd
+
+static bool     _backedUp[PARDALOTE_MAX_CLIENTS] = {};
+
+// Longest sleep a hook may ask for — keeps the signed compare valid.
+#define EXT_MAX_SLEEP_MS 0x3FFFFFFFUL
+
+static bool _timerBefore(uint8_t a, uint8_t b) {
+    return (int32_t)(_extDue[_timerHeap[a]] - _extDue[_timerHeap[b]]) < 0;
+}
+
+static void _timerSwap(uint8_t a, uint8_t b) {
+    const uint8_t t = _timerHeap[a];
+    _timerHeap[a] = _timerHeap[b];
+    _timerHeap[b] = t;
+    _timerPos[_timerHeap[a]] = a + 1;
+    _timerPos[_timerHeap[b]] = b + 1;
+}
+
+static void _timerSift(uint8_t h) {
+    while (h > 0 && _timerBefore(h, (h - 1) / 2)) {
+        _timerSwap(h, (h - 1) / 2);
+        h = (h - 1) / 2;
+    }
+    for (;;) {
+        const uint8_t l = 2 * h + 1, r = l + 1;
+        uint8_t m = h;
+        if (l < _timerCount && _timerBefore(l, m)) m = l;
+        if (r < _timerCount && _timerBefore(r, m)) m = r;
+        if (m == h) return;
+        _timerSwap(h, m);
+        h = m;
+    }
+}
+
+// Queue registry index i for `due`, or move it if already queued.
+static void _timerSchedule(uint8_t i, uint32_t due) {
+    _extDue[i] = due;
+    if (!_timerPos[i]) {
+        _timerHeap[_timerCount] = i;
+        _timerPos[i] = ++_timerCount;
+    }
+    _timerSift(_timerPos[i] - 1);
+}
+
+static uint8_t _timerPop() {
+    const uint8_t i = _timerHeap[0];
+    _timerSwap(0, --_timerCount);
+    _timerPos[i] = 0;
+    if (_timerCount) _timerSift(0);
+    return i;
+}
+
 void registerExtension(uint16_t        deviceId,
                        ExtHandler      handle,
                        ExtAnnouncer    announce,
                        ExtDisconnecter disconnect,
                        ExtLooper       loop) {
-    if (_numExtensions < MAX_EXTENSIONS) {
-        _extRegistry[_numExtensions++] =
-            { deviceId, handle, announce, disconnect, loop };
+    if (_numExtensions >= MAX_EXTENSIONS) {
+        // Cannot use Serial here — static-init runs before Serial.begin().
+        _droppedExtensions++;
+        return;
     }
-    // Cannot use Serial here — static-init runs before Serial.begin().
+    _extRegistry[_numExtensions] = { deviceId, handle, announce, disconnect, loop, nullptr };
+    if (deviceId >= RESERVED_START && deviceId - RESERVED_START < EXT_DIRECT_IDS &&
+        !_extDirect[deviceId - RESERVED_START])   // first registration wins, as the scan did
+        _extDirect[deviceId - RESERVED_START] = _numExtensions + 1;
+    _numExtensions++;
+}
+
+// Timed form — due on the first run() pass.
+void registerExtension(uint16_t        deviceId,
+                       ExtHandler      handle,
+                       ExtAnnouncer    announce,
+                       ExtDisconnecter disconnect,
+                       ExtTimedLooper  loop) {
+    const uint8_t index = _numExtensions;
+    registerExtension(deviceId, handle, announce, disconnect, (ExtLooper)nullptr);
+    if (_numExtensions == index || !loop) return;   // dropped, or nothing to time
+    _extRegistry[index].timedLoop = loop;
+    _timerSchedule(index, 0);
+}
+
+uint8_t extensionsDropped() { return _droppedExtensions; }
+
+static ExtEntry* _findExtension(uint16_t deviceId) {
+    if (deviceId >= RESERVED_START && deviceId - RESERVED_START < EXT_DIRECT_IDS) {
+        const uint8_t slot = _extDirect[deviceId - RESERVED_START];
+        return slot ? &_extRegistry[slot - 1] : nullptr;
+    }
+    for (uint8_t i = 0; i < _numExtensions; i++)
+        if (_extRegistry[i].deviceId == deviceId) return &_extRegistry[i];
+    return nullptr;
 }
 
 void dispatchExtension(uint8_t clientNum, uint16_t deviceId,
                        uint8_t cmd, uint16_t typeMask,
                        uint8_t* params, uint8_t nparams,
                        uint8_t* payload, uint16_t payloadLen) {
-    for (uint8_t i = 0; i < _numExtensions; i++) {
-        if (_extRegistry[i].deviceId == deviceId) {
-            _extRegistry[i].handle(clientNum, cmd, typeMask,
-                                   params, nparams, payload, payloadLen);
-            return;
-        }
+    ExtEntry* e = _findExtension(deviceId);
+    if (e) {
+        const uint32_t t = Stats::ticks();
+        e->handle(clientNum, cmd, typeMask, params, nparams, payload, payloadLen);
+        Stats::command(deviceId, cmd, t);
+        // A command may have started a move or a poll.
+        if (e->timedLoop) _timerSchedule(e - _extRegistry, millis());
+        return;
     }
     Serial.print(F("Unknown extension deviceId: "));
     Serial.println(deviceId);
@@ -50,15 +162,92 @@ void disconnectAll(uint8_t clientNum) {
         if (_extRegistry[i].disconnect) {
             _extRegistry[i].disconnect(clientNum);
         }
+        if (_extRegistry[i].timedLoop) _timerSchedule(i, millis());
     }
 }
 
+void wakeExtension(uint16_t deviceId) {
+    ExtEntry* e = _findExtension(deviceId);
+    if (e && e->timedLoop) _timerSchedule(e - _extRegistry, millis());
+}
+
+static CmdTrait* _findTrait(uint16_t deviceId, uint8_t cmd) {
+    if (!(_traitCmds[cmd >> 5] & (1UL << (cmd & 31)))) return nullptr;
+    for (uint8_t i = 0; i < _numTraits; i++) {
+        if (_traits[i].deviceId == deviceId && _traits[i].cmd == cmd) return &_traits[i];
+    }
+    return nullptr;
+}
+
+static CmdTrait* _addTrait(uint16_t deviceId, uint8_t cmd) {
+    CmdTrait* t = _findTrait(deviceId, cmd);
+    if (t) return t;
+    if (_numTraits >= PARDALOTE_COMMAND_TRAITS) return nullptr;
+    t = &_traits[_numTraits++];
+    *t = { deviceId, cmd, false, TX_LANE_STATE };
+    _traitCmds[cmd >> 5] |= 1UL << (cmd & 31);
+    return t;
+}
+
+bool coalesceCommand(uint16_t deviceId, uint8_t cmd) {
+    CmdTrait* t = _addTrait(deviceId, cmd);
+    if (t) t->coalesce = true;
+    return t != nullptr;
+}
+
+bool commandCoalesces(uint16_t deviceId, uint8_t cmd) {
+    const CmdTrait* t = _findTrait(deviceId, cmd);
+    return t && t->coalesce;
+}
+
+bool setOutboundLane(uint16_t deviceId, uint8_t cmd, uint8_t lane) {
+    CmdTrait* t = _addTrait(deviceId, cmd);
+    if (t) t->lane = lane;
+    return t != nullptr;
+}
+
+uint8_t outboundLane(uint16_t deviceId, uint8_t cmd) {
+    const CmdTrait* t = _findTrait(deviceId, cmd);
+    return t ? t->lane : TX_LANE_STATE;
+}
+
+bool clientBackedUp(uint8_t clientNum) {
+    return clientNum < PARDALOTE_MAX_CLIENTS && _backedUp[clientNum];
+}
+
+void setClientBackedUp(uint8_t clientNum, bool backedUp) {
+    if (clientNum < PARDALOTE_MAX_CLIENTS) _backedUp[clientNum] = backedUp;
+}
+
 void loopAll() {
     for (uint8_t i = 0; i < _numExtensions; i++) {
         if (_extRegistry[i].loop) {
+            const uint32_t t = Stats::ticks();
             _extRegistry[i].loop();
+            Stats::extLoop(i, _extRegistry[i].deviceId, t);
         }
     }
+
+    if (!_timerCount) return;
+    const uint32_t now = millis();
+    if ((int32_t)(now - _extDue[_timerHeap[0]]) < 0) return;
+
+    // Take everything due first, so a hook asking for the next pass
+    // runs once per pass instead of looping here.
+    uint8_t due[MAX_EXTENSIONS];
+    uint8_t n = 0;
+    while (_timerCount && (int32_t)(now - _extDue[_timerHeap[0]]) >= 0)
+        due[n++] = _timerPop();
+
+    for (uint8_t k = 0; k < n; k++) {
+        const uint8_t i = due[k];
+        const uint32_t t = Stats::ticks();
+        uint32_t next = _extRegistry[i].timedLoop(now);
+        Stats::extLoop(i, _extRegistry[i].deviceId, t);
+        if (next == EXT_LOOP_IDLE) continue;     // unless a wake queued it meanwhile
+        if (next > EXT_MAX_SLEEP_MS) next = EXT_MAX_SLEEP_MS;
+        _timerSchedule(i, now + next);
+    }
 }
 
 // On ESP32, the default I2C timeout doesn't reliably stop Wire.requestFrom()
@@ -18,8 +18,17 @@
 #include <Arduino.h>
 #include "defs.h"
 #include "protocol.h"
+#include "frame_schema.h"
 
-#define MAX_EXTENSIONS 8
+// Registry capacity. The storage lives in extensions.cpp, so override
+// with a compiler flag (-DMAX_EXTENSIONS=…), not a sketch #define.
+#ifndef MAX_EXTENSIONS
+  #define MAX_EXTENSIONS 16
+#endif
+
+// Device ids RESERVED_START .. RESERVED_START + EXT_DIRECT_IDS - 1 are
+// looked up by direct index; an id beyond that falls back to a scan.
+#define EXT_DIRECT_IDS 56
 
 // -------------------------------------------------------------------
 // Extension handler signature.
@@ -46,12 +55,24 @@ typedef void (*ExtDisconnecter)(uint8_t clientNum);
 // Called every Arduino loop() iteration for time-based housekeeping.
 typedef void (*ExtLooper)();
 
+// Timed loop hook — called only when due, with millis(). Returns how
+// long until it next has work: ms (0 = the next run() pass), or
+// EXT_LOOP_IDLE to sleep until woken. The registry wakes an extension
+// after each of its commands (browser or sketch) and after any client
+// disconnects; wakeExtension() covers anything else. Declare it as
+// `static uint32_t loop(uint32_t now)` and INSTALL_EXTENSION picks the
+// timed form.
+typedef uint32_t (*ExtTimedLooper)(uint32_t now);
+
+#define EXT_LOOP_IDLE 0xFFFFFFFFUL
+
 struct ExtEntry {
     uint16_t        deviceId;
     ExtHandler      handle;
     ExtAnnouncer    announce;
     ExtDisconnecter disconnect;  // nullptr if not needed
     ExtLooper       loop;        // nullptr if not needed
+    ExtTimedLooper  timedLoop;   // nullptr unless registered with one
 };
 
 // -------------------------------------------------------------------
@@ -63,15 +84,80 @@ void registerExtension(uint16_t        deviceId,
                        ExtDisconnecter disconnect = nullptr,
                        ExtLooper       loop       = nullptr);
 
+void registerExtension(uint16_t        deviceId,
+                       ExtHandler      handle,
+                       ExtAnnouncer    announce,
+                       ExtDisconnecter disconnect,
+                       ExtTimedLooper  loop);
+
+// An explicit nullptr loop would match both forms.
+inline void registerExtension(uint16_t deviceId, ExtHandler handle,
+                              ExtAnnouncer announce, ExtDisconnecter disconnect,
+                              decltype(nullptr)) {
+    registerExtension(deviceId, handle, announce, disconnect, (ExtLooper)nullptr);
+}
+
 void dispatchExtension(uint8_t clientNum, uint16_t deviceId,
                        uint8_t cmd, uint16_t typeMask,
                        uint8_t* params, uint8_t nparams,
                        uint8_t* payload, uint16_t payloadLen);
 
+// Extensions that did not fit in the registry (MAX_EXTENSIONS) — static
+// init runs before Serial, so begin() reports it.
+uint8_t extensionsDropped();
+
 void announceAll(uint8_t clientNum);
 void disconnectAll(uint8_t clientNum);
 void loopAll();
 
+// Run an extension's timed loop hook on the next run() pass, whatever
+// it last asked for. For state changes that don't arrive as commands.
+void wakeExtension(uint16_t deviceId);
+
+// Commands whose effect the next one of the same kind fully replaces —
+// "servo 2 to 90°". While frames wait in the inbound queue, run()
+// handles only the newest (cmd, device, param 0) of a client and skips
+// the rest. Never for a command with a reply, a DONE, or an effect
+// that adds up. Use COALESCE_COMMAND below; false once the table's full.
+bool coalesceCommand(uint16_t deviceId, uint8_t cmd);
+bool commandCoalesces(uint16_t deviceId, uint8_t cmd);
+
+// Outbound lanes. A client's TX batch holds its frames in three lanes,
+// sent in this order: CONTROL (DONE, limit trips — what state machines
+// wait on), STATE (replies, echoes, announces — the default) and
+// TELEMETRY (readings). When the batch runs short, telemetry is
+// what waits. Use OUTBOUND_LANE below.
+#define TX_LANE_CONTROL   0
+#define TX_LANE_STATE     1
+#define TX_LANE_TELEMETRY 2
+bool    setOutboundLane(uint16_t deviceId, uint8_t cmd, uint8_t lane);
+uint8_t outboundLane(uint16_t deviceId, uint8_t cmd);
+
+// (deviceId, cmd) pairs with a trait above — coalescing or a lane.
+#ifndef PARDALOTE_COMMAND_TRAITS
+  #define PARDALOTE_COMMAND_TRAITS 32
+#endif
+
+// A client whose unacknowledged output passed PARDALOTE_TX_BACKLOG (a
+// throttled tab, a weak link). Periodic readings skip it until it has
+// caught up, then resume with the current value — so it gets the
+// latest reading, not a queue of stale ones. Set by the core; a
+// clientNum of PARDALOTE_MAX_CLIENTS or more is never backed up.
+bool clientBackedUp(uint8_t clientNum);
+void setClientBackedUp(uint8_t clientNum, bool backedUp);
+
+// ms from `now` until `since + period` (0 if already past) — the usual
+// timed-hook return value.
+inline uint32_t extMsUntil(uint32_t now, uint32_t since, uint32_t period) {
+    const uint32_t elapsed = now - since;
+    return elapsed >= period ? 0 : period - elapsed;
+}
+
+// Fold one work item's wait into a hook's return value.
+inline void extDueIn(uint32_t& next, uint32_t ms) {
+    if (ms < next) next = ms;
+}
+
 // -------------------------------------------------------------------
 // ExtReadPoll — per-instance periodic-read registration with per-client
 // gating, shared by every extension that supports read(interval,
@@ -144,10 +230,19 @@ struct ExtReadPoll {
         return true;
     }
 
-    // Should client c receive `val` now? Commits on true.
+    // ms until due() next returns true, for a timed loop hook.
+    uint32_t nextDue(unsigned long now) const {
+        if (instance == -1 || !clientMask) return EXT_LOOP_IDLE;
+        return extMsUntil((uint32_t)now, (uint32_t)lastPoll, (uint32_t)pollInterval);
+    }
+
+    // Should client c receive `val` now? Commits on true. Never while c
+    // is backed up — lastSent stays put, so the next gate after it
+    // catches up compares against what c really has.
     bool gate(uint8_t c, int32_t val, unsigned long now) {
         const uint8_t bit = 1 << c;
         if (!(clientMask & bit)) return false;
+        if (clientBackedUp(c)) return false;
         if (seededMask & bit) {
             if (now - lastSendTime[c] < interval[c]) return false;
             int32_t d = val - lastSent[c];
@@ -176,6 +271,13 @@ inline ExtReadPoll* extPollGet(ExtReadPoll* table, int n, int inst) {
     return nullptr;
 }
 
+// Earliest nextDue() across a table.
+inline uint32_t extPollNextDue(const ExtReadPoll* table, int n, unsigned long now) {
+    uint32_t next = EXT_LOOP_IDLE;
+    for (int i = 0; i < n; i++) extDueIn(next, table[i].nextDue(now));
+    return next;
+}
+
 // Drop a departing client from every slot in a table.
 inline void extPollDropClient(ExtReadPoll* table, int n, uint8_t c) {
     for (int i = 0; i < n; i++)
@@ -196,6 +298,7 @@ bool ensureWire(int sda, int scl);
 // INSTALL_EXTENSION(deviceId, handlerFn, announcerFn,
 //                   [disconnectFn], [loopFn])
 //
+// loopFn is either an ExtLooper (every pass) or an ExtTimedLooper.
 // Place at the bottom of an extension header.
 // The static bool triggers registerExtension() during static
 // initialisation — before setup() runs.
@@ -205,4 +308,16 @@ bool ensureWire(int sda, int scl);
         (registerExtension(deviceId, handlerFn, announcerFn,            \
                            ##__VA_ARGS__), true);
 
+// COALESCE_COMMAND(deviceId, cmd) — registers cmd with coalesceCommand()
+// the same way, next to the INSTALL_EXTENSION line.
+#define COALESCE_COMMAND(deviceId, cmd)                                 \
+    static bool _ext_coalesce_##deviceId##_##cmd =                      \
+        coalesceCommand(deviceId, cmd);
+
+// OUTBOUND_LANE(deviceId, cmd, lane) — the lane (TX_LANE_*) the board's
+// frames of this command travel in, registered the same way.
+#define OUTBOUND_LANE(deviceId, cmd, lane)                              \
+    static bool _ext_lane_##deviceId##_##cmd =                          \
+        setOutboundLane(deviceId, cmd, lane);
+
 #endif
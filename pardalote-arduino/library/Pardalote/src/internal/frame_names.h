@@ -37,6 +37,15 @@ inline const char* pardaloteFrameName(uint16_t target, uint8_t cmd) {
             case CMD_AUTH:          return "AUTH";
             case CMD_SERIAL_BUSY:   return "SERIAL_BUSY";
             case CMD_REBOOT:        return "REBOOT";
+            case CMD_FEATURES:      return "FEATURES";
+            case CMD_ANALOG_STREAM: return "ANALOG_STREAM";
+            case CMD_ANALOG_BLOCK:  return "ANALOG_BLOCK";
+            case CMD_CLOCK:         return "CLOCK";
+            case CMD_AT:            return "AT";
+            case CMD_STATS:         return "STATS";
+            case CMD_ACK:           return "ACK";
+            case CMD_BAUD:          return "BAUD";
+            case CMD_DATAGRAM:      return "DATAGRAM";
             default:                return nullptr;
         }
     }
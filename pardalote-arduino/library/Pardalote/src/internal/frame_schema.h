@@ -0,0 +1,130 @@
+// ==============================================================
+// internal/frame_schema.h
+// Typed frame layouts — one declaration drives both decode and
+// encode, so a handler and its emitter can't drift apart.
+// Part of Pardalote — version in library.properties
+// ==============================================================
+//
+// ParamSchema<Required, T...> — a frame's params, in order. Decoding
+// checks the count once (at least Required present), then converts
+// each param that arrived into its field; absent optional fields keep
+// the value the caller initialised them with (their default). A float
+// field takes an int param too (JS sends whole numbers as int32), and
+// an int field truncates a float param.
+//
+//   using ServoAttach = ParamSchema<2, int, int, int, int>;  // id, pin, [min, max]
+//   int id, pin, minP = 544, maxP = 2400;
+//   if (!ServoAttach::read(params, nparams, typeMask, id, pin, minP, maxP)) return;
+//
+//   using ServoRead = ParamSchema<2, int, int>;              // id, angle
+//   ServoRead::write(fb, id, angle);
+//
+// RecordSchema<T...> — a fixed-size big-endian record in a payload
+// (gesture segments, sync-write entries). `size` is a compile-time
+// constant, so a payload walk bounds-checks a whole record — or a
+// whole block of them — in one comparison.
+//
+//   using SegRecord = RecordSchema<uint8_t, uint16_t, int32_t>;   // 7 bytes
+//   SegRecord::read(payload + off, curve, dur, value);
+//
+// Param fields may be any integer type or float (int/long decode like
+// int32_t). Record fields are fixed-width integers only.
+// ==============================================================
+
+#ifndef PARDALOTE_FRAME_SCHEMA_H
+#define PARDALOTE_FRAME_SCHEMA_H
+
+#include <Arduino.h>
+#include "protocol.h"
+
+// -------------------------------------------------------------------
+// Param fields
+// -------------------------------------------------------------------
+inline void schemaReadParam(const uint8_t* p, uint16_t typeMask, uint8_t i, float& out) {
+    out = paramIsFloat(typeMask, i) ? paramFloat(p, i) : (float)paramInt(p, i);
+}
+
+template <typename T>
+inline void schemaReadParam(const uint8_t* p, uint16_t typeMask, uint8_t i, T& out) {
+    out = paramIsFloat(typeMask, i) ? (T)paramFloat(p, i) : (T)paramInt(p, i);
+}
+
+inline bool schemaWriteParam(FrameWriter& fw, float v) { return fw.addFloat(v); }
+
+template <typename T>
+inline bool schemaWriteParam(FrameWriter& fw, T v) { return fw.addInt((int32_t)v); }
+
+template <uint8_t Required, typename... Ts>
+struct ParamSchema {
+    static constexpr uint8_t count = sizeof...(Ts);
+    static_assert(Required <= sizeof...(Ts), "ParamSchema: more required params than fields");
+    static_assert(sizeof...(Ts) <= MAX_PARAMS, "ParamSchema: more fields than MAX_PARAMS");
+
+    // False (fields untouched) when fewer than Required params arrived.
+    static bool read(const uint8_t* params, uint8_t nparams, uint16_t typeMask, Ts&... out) {
+        if (nparams < Required) return false;
+        uint8_t i = 0;
+        auto field = [&](auto& o) {
+            if (i < nparams) schemaReadParam(params, typeMask, i, o);
+            i++;
+        };
+        (field(out), ...);
+        return true;
+    }
+
+    // Appends every field. False if the writer overflowed.
+    static bool write(FrameWriter& fw, const Ts&... in) {
+        return (schemaWriteParam(fw, in) && ...);
+    }
+};
+
+// -------------------------------------------------------------------
+// Payload records
+// -------------------------------------------------------------------
+template <typename T>
+inline void schemaReadField(const uint8_t* p, uint16_t& off, T& out) {
+    uint32_t v = 0;
+    for (uint8_t k = 0; k < sizeof(T); k++) v = (v << 8) | p[off + k];
+    out = (T)v;
+    off += sizeof(T);
+}
+
+template <typename T>
+inline void schemaWriteField(uint8_t* p, uint16_t& off, T in) {
+    uint32_t v = (uint32_t)in;
+    for (uint8_t k = sizeof(T); k-- > 0; ) { p[off + k] = v & 0xFF; v >>= 8; }
+    off += sizeof(T);
+}
+
+template <typename... Ts>
+struct RecordSchema {
+    static constexpr uint16_t size = (sizeof(Ts) + ...);
+
+    static void read(const uint8_t* p, Ts&... out) {
+        uint16_t off = 0;
+        (schemaReadField(p, off, out), ...);
+    }
+
+    static void write(uint8_t* p, const Ts&... in) {
+        uint16_t off = 0;
+        (schemaWriteField(p, off, in), ...);
+    }
+
+    // Whole records in a payload of len bytes.
+    static uint16_t countIn(uint16_t len) { return len / size; }
+};
+
+// -------------------------------------------------------------------
+// Shared layouts
+// -------------------------------------------------------------------
+
+// One gesture segment — [ curve u8 ][ dur u16, ms ][ value i32 ]
+// (see the gesture block layout in defs.h). Servo, stepper and bus
+// servo all read it.
+using GestureSegRecord = RecordSchema<uint8_t, uint16_t, int32_t>;
+static_assert(GestureSegRecord::size == 7, "gesture segment is 7 bytes on the wire");
+
+// A gesture channel header — [ logicalId u8 ][ flags u8 ][ count u8 ].
+using GestureChannelRecord = RecordSchema<uint8_t, uint8_t, uint8_t>;
+
+#endif
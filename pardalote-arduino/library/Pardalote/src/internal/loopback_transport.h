@@ -0,0 +1,127 @@
+// ==============================================================
+// internal/loopback_transport.h
+// In-memory transport — the clients are code in the same program.
+// Part of Pardalote — version in library.properties
+// by Scott Mitchell
+// GPL-3.0-or-later License
+//
+// For host builds and tests: drive the whole core (inbound queue,
+// handlers, extensions, TX batching, replies) with no hardware and no
+// clock but the one the caller advances.
+//
+//   static PardaloteLoopbackTransport link;
+//   link.onReply(gotReply);          // everything the board sends
+//   Pardalote.begin(link);
+//   link.connectClient(0);
+//   link.inject(0, hello, n);        // a message from "the page"
+//   Pardalote.run();                 // delivered, handled, answered
+//
+// connectClient(), disconnectClient() and inject() queue their event;
+// loop() (from run()) delivers everything queued, in order, the way a
+// WebSocket server reports what arrived since the last pass. send()
+// hands the message to the reply sink at once. capacity() reports
+// what setCapacity() last set (unknown until then), so a test can play
+// a congested link; send() still delivers.
+// ==============================================================
+
+#pragma once
+
+#include <Arduino.h>
+#include "defs.h"
+#include "spsc_queue.h"
+#include "transport.h"
+
+// Bytes of queued inbound events — a power of two. A message over half
+// of it is refused by inject().
+#ifndef PARDALOTE_LOOPBACK_QUEUE
+  #define PARDALOTE_LOOPBACK_QUEUE 4096
+#endif
+
+typedef void (*PardaloteLoopbackReply)(uint8_t client, const uint8_t* data, size_t len);
+
+class PardaloteLoopbackTransport : public PardaloteTransport {
+public:
+    PardaloteLoopbackTransport() {
+        _queue.begin(_ring, sizeof _ring);
+        for (size_t& c : _capacity) c = PARDALOTE_CAPACITY_UNKNOWN;
+    }
+
+    // -------- The clients' side --------
+    void connectClient(uint8_t c)    { _post(c, LB_CONNECT, nullptr, 0); }
+    void disconnectClient(uint8_t c) { _post(c, LB_DISCONNECT, nullptr, 0); }
+    bool inject(uint8_t c, const uint8_t* data, size_t len) {
+        return len > 0 && _post(c, LB_MESSAGE, data, len);
+    }
+    void onReply(PardaloteLoopbackReply sink) { _reply = sink; }
+    void setCapacity(uint8_t c, size_t bytes) { if (c < PARDALOTE_MAX_CLIENTS) _capacity[c] = bytes; }
+
+    bool     clientConnected(uint8_t c) const { return c < PARDALOTE_MAX_CLIENTS && (_open & (1u << c)); }
+    uint32_t messagesOut() const { return _messagesOut; }
+    uint32_t bytesOut()    const { return _bytesOut; }
+
+    // -------- PardaloteTransport --------
+    void begin(const PardaloteTransportSinks& sinks) override {
+        _sinks = sinks;
+        _open  = 0;
+    }
+
+    void end() override {
+        _sinks = PardaloteTransportSinks();
+        _open  = 0;
+    }
+
+    void loop(unsigned long now) override {
+        (void)now;
+        SpscQueue::Header h;
+        uint8_t* data;
+        while (_queue.peek(h, data)) {
+            const uint32_t bit = 1u << h.client;
+            if (h.type == LB_CONNECT && !(_open & bit)) {
+                _open |= bit;
+                _emitConnect(h.client);
+            } else if (h.type == LB_DISCONNECT && (_open & bit)) {
+                _open &= ~bit;
+                _emitDisconnect(h.client);
+            } else if (h.type == LB_MESSAGE && (_open & bit)) {
+                _emitMessage(h.client, data, h.len);
+            }
+            _queue.pop();
+        }
+    }
+
+    bool send(uint8_t client, const uint8_t* data, size_t len) override {
+        if (!clientConnected(client)) return false;
+        _messagesOut++;
+        _bytesOut += len;
+        if (_reply) _reply(client, data, len);
+        return true;
+    }
+
+    void disconnect(uint8_t client) override {
+        if (!clientConnected(client)) return;
+        _open &= ~(1u << client);
+        _emitDisconnect(client);
+    }
+
+    size_t capacity(uint8_t client) const override {
+        return client < PARDALOTE_MAX_CLIENTS ? _capacity[client] : 0;
+    }
+
+private:
+    enum : uint8_t { LB_CONNECT = 0, LB_DISCONNECT = 1, LB_MESSAGE = 2 };
+
+    bool _post(uint8_t c, uint8_t type, const uint8_t* data, size_t len) {
+        if (c >= PARDALOTE_MAX_CLIENTS || len > _queue.maxLen()) return false;
+        return _queue.push(c, type, data, (uint16_t)len);
+    }
+
+    static_assert((PARDALOTE_LOOPBACK_QUEUE & (PARDALOTE_LOOPBACK_QUEUE - 1)) == 0,
+                  "PARDALOTE_LOOPBACK_QUEUE must be a power of two");
+    uint8_t   _ring[PARDALOTE_LOOPBACK_QUEUE];
+    SpscQueue _queue;
+    uint32_t  _open = 0;                           // bit c = client c connected
+    size_t    _capacity[PARDALOTE_MAX_CLIENTS];
+    uint32_t  _messagesOut = 0;
+    uint32_t  _bytesOut    = 0;
+    PardaloteLoopbackReply _reply = nullptr;
+};
@@ -26,6 +26,12 @@
 #elif defined(ESP32)
   #include <WiFi.h>
   #define PLATFORM_ESP32
+#elif defined(PARDALOTE_HOST)
+  // Host (Linux/macOS) build against the Arduino shim in
+  // pardalote-arduino/host — benchmarks and off-board checks only.
+  // No radio: serial transport, like the Minima.
+  #define PLATFORM_HOST
+  #define PARDALOTE_NO_WIFI
 #else
   #error "Unsupported platform — only UNO R4 WiFi/Minima and ESP32 are supported"
 #endif
@@ -35,6 +41,8 @@
     #define PARDALOTE_BOARD "UNO R4 WiFi"
   #elif defined(ARDUINO_UNOR4_MINIMA)
     #define PARDALOTE_BOARD "UNO R4 Minima"
+  #elif defined(PARDALOTE_HOST)
+    #define PARDALOTE_BOARD "host"
   #elif defined(ARDUINO_DFROBOT_FIREBEETLE_2_ESP32C5)
     #define PARDALOTE_BOARD "FireBeetle 2 ESP32-C5"
   #elif defined(ARDUINO_ESP32_WROVER_KIT) || defined(ARDUINO_UPESY_WROVER) || defined(ARDUINO_ESP32_DEV)
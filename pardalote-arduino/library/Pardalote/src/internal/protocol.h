@@ -14,6 +14,24 @@
 //  Bytes 8+    PARAMS       NPARAMS × 4 bytes (big-endian int32 or float32)
 //  Bytes 8+N*4 PAYLOAD      PAYLOAD_LEN bytes (strings, bitmaps, etc.)
 //
+// Compact layout (protocol 1.1 — a client opts in with CMD_FEATURES):
+//
+//  Byte 0      0x80|X|NPARAMS  bit 7 marks a compact frame (every CMD is
+//                              < 0x80, so the two layouts never collide);
+//                              bit 6 (X) = TYPE_MASK and PAYLOAD_LEN follow;
+//                              bits 0–4 = NPARAMS
+//  Byte 1      CMD
+//  varint      TARGET
+//  varint      TYPE_MASK       } only when X is set
+//  varint      PAYLOAD_LEN     }
+//  PARAMS      int32 → zigzag varint (one byte for -64..63);
+//              float32 → 4 bytes big-endian, as above
+//  PAYLOAD
+//
+// varint = unsigned LEB128, low 7 bits first. A servo read reply
+// [id, angle] is 7 bytes instead of 16. Both layouts can share one
+// message; parseFrame reads either.
+//
 // ==============================================================
 
 #ifndef PROTOCOL_H
@@ -24,6 +42,10 @@
 #define FRAME_HEADER_SIZE 8
 #define MAX_PARAMS        16
 
+#define FRAME_COMPACT     0x80   // byte 0 of a compact frame
+#define FRAME_COMPACT_EXT 0x40   // TYPE_MASK + PAYLOAD_LEN follow
+#define FRAME_COMPACT_NP  0x1F   // NPARAMS bits
+
 // -------------------------------------------------------------------
 // Parsed frame — all pointers into the original WebSocket buffer.
 // Do not hold references past the webSocketEvent callback.
@@ -37,14 +59,110 @@ struct Frame {
     uint8_t* params;    // NPARAMS * 4 bytes
     uint8_t* payload;   // PAYLOAD_LEN bytes
     size_t   totalLen;  // full byte length of this frame
+    bool     compact;   // arrived in the compact layout (params are in scratch)
     bool     valid;
 };
 
+// -------------------------------------------------------------------
+// Varints (compact layout). readVarint fails on a truncated buffer or
+// one longer than maxBytes.
+// -------------------------------------------------------------------
+inline bool readVarint(const uint8_t* buf, size_t& pos, size_t len,
+                       uint8_t maxBytes, uint32_t& out) {
+    uint32_t v = 0;
+    for (uint8_t i = 0; i < maxBytes; i++) {
+        if (pos >= len) return false;
+        const uint8_t b = buf[pos++];
+        v |= (uint32_t)(b & 0x7F) << (7 * i);
+        if (!(b & 0x80)) { out = v; return true; }
+    }
+    return false;
+}
+
+// CMD and TARGET of the frame at buf, in either layout, without parsing
+// the rest.
+inline bool frameHead(const uint8_t* buf, size_t len, uint8_t& cmd, uint16_t& target) {
+    if (len < 3) return false;
+    if (!(buf[0] & FRAME_COMPACT)) {
+        cmd    = buf[0];
+        target = (uint16_t)((buf[1] << 8) | buf[2]);
+        return true;
+    }
+    size_t p = 2;
+    uint32_t t;
+    if (!readVarint(buf, p, len, 3, t) || t > 0xFFFF) return false;
+    cmd    = buf[1];
+    target = (uint16_t)t;
+    return true;
+}
+
+inline uint8_t writeVarint(uint8_t* p, uint32_t v) {
+    uint8_t n = 0;
+    while (v >= 0x80) { p[n++] = (uint8_t)(v | 0x80); v >>= 7; }
+    p[n++] = (uint8_t)v;
+    return n;
+}
+
+// -------------------------------------------------------------------
+// Parse one compact frame. Its params are unpacked into `scratch`
+// (MAX_PARAMS * 4 bytes) in the standard big-endian layout, so
+// paramInt/paramFloat and every handler read both layouts alike.
+// -------------------------------------------------------------------
+inline Frame parseCompactFrame(uint8_t* buf, size_t pos, size_t len, uint8_t* scratch) {
+    Frame f = {};
+    if (!scratch || pos + 2 > len) { f.valid = false; return f; }
+
+    const uint8_t lead = buf[pos];
+    const uint8_t n    = lead & FRAME_COMPACT_NP;
+    size_t   p = pos + 2;
+    uint32_t target = 0, mask = 0, plen = 0;
+    if (n > MAX_PARAMS)                                             { f.valid = false; return f; }
+    if (!readVarint(buf, p, len, 3, target) || target > 0xFFFF)     { f.valid = false; return f; }
+    if (lead & FRAME_COMPACT_EXT) {
+        if (!readVarint(buf, p, len, 3, mask) || mask > 0xFFFF)     { f.valid = false; return f; }
+        if (!readVarint(buf, p, len, 3, plen) || plen > 0xFFFF)     { f.valid = false; return f; }
+    }
+
+    for (uint8_t i = 0; i < n; i++) {
+        uint8_t* o = scratch + i * 4;
+        if ((mask >> i) & 1) {
+            if (p + 4 > len) { f.valid = false; return f; }
+            memcpy(o, buf + p, 4);
+            p += 4;
+        } else {
+            uint32_t z = 0;
+            if (!readVarint(buf, p, len, 5, z)) { f.valid = false; return f; }
+            const uint32_t v = (z >> 1) ^ (0u - (z & 1));   // un-zigzag
+            o[0] = (v >> 24) & 0xFF;
+            o[1] = (v >> 16) & 0xFF;
+            o[2] = (v >>  8) & 0xFF;
+            o[3] =  v        & 0xFF;
+        }
+    }
+    if (p + plen > len) { f.valid = false; return f; }
+
+    f.cmd        = buf[pos + 1];
+    f.target     = (uint16_t)target;
+    f.nparams    = n;
+    f.typeMask   = (uint16_t)mask;
+    f.payloadLen = (uint16_t)plen;
+    f.params     = scratch;
+    f.payload    = buf + p;
+    f.totalLen   = p + plen - pos;
+    f.compact    = true;
+    f.valid      = true;
+    return f;
+}
+
 // -------------------------------------------------------------------
 // Parse one frame from buf at position pos.
-// Returns an invalid Frame if the buffer is too short.
+// Returns an invalid Frame if the buffer is too short. A compact frame
+// needs `scratch` for its params (see parseCompactFrame); without one
+// it is invalid.
 // -------------------------------------------------------------------
-inline Frame parseFrame(uint8_t* buf, size_t pos, size_t len) {
+inline Frame parseFrame(uint8_t* buf, size_t pos, size_t len, uint8_t* scratch = nullptr) {
+    if (pos < len && (buf[pos] & FRAME_COMPACT)) return parseCompactFrame(buf, pos, len, scratch);
+
     Frame f = {};
     if (pos + FRAME_HEADER_SIZE > len) { f.valid = false; return f; }
 
@@ -68,14 +186,14 @@ inline Frame parseFrame(uint8_t* buf, size_t pos, size_t len) {
 // The extension author knows from the protocol definition which
 // params are int32 and which are float32.
 // -------------------------------------------------------------------
-inline int32_t paramInt(uint8_t* p, int i) {
+inline int32_t paramInt(const uint8_t* p, int i) {
     return ((int32_t)(uint8_t)p[i * 4]     << 24) |
            ((int32_t)(uint8_t)p[i * 4 + 1] << 16) |
            ((int32_t)(uint8_t)p[i * 4 + 2] <<  8) |
             (uint8_t)p[i * 4 + 3];
 }
 
-inline float paramFloat(uint8_t* p, int i) {
+inline float paramFloat(const uint8_t* p, int i) {
     uint32_t raw = ((uint32_t)(uint8_t)p[i * 4]     << 24) |
                    ((uint32_t)(uint8_t)p[i * 4 + 1] << 16) |
                    ((uint32_t)(uint8_t)p[i * 4 + 2] <<  8) |
@@ -90,7 +208,80 @@ inline bool paramIsFloat(uint16_t typeMask, int i) {
 }
 
 // -------------------------------------------------------------------
-// FrameBuilder — construct outgoing frames (Arduino → JS).
+// Layout conversion — the board always builds standard frames and
+// converts per client on the way out.
+//
+// compactFrame: re-encode one standard frame compactly into dst (which
+// may be src). Returns the new length, or 0 when compact would not be
+// shorter (large ints) — send the standard bytes then.
+// -------------------------------------------------------------------
+inline size_t compactFrame(const uint8_t* src, size_t len, uint8_t* dst) {
+    if (len < FRAME_HEADER_SIZE || (src[0] & FRAME_COMPACT)) return 0;
+    const uint8_t  n      = src[3];
+    const uint16_t target = ((uint16_t)src[1] << 8) | src[2];
+    const uint16_t mask   = ((uint16_t)src[4] << 8) | src[5];
+    const uint16_t plen   = ((uint16_t)src[6] << 8) | src[7];
+    const size_t   stdHead = FRAME_HEADER_SIZE + (size_t)n * 4;
+    if (n > MAX_PARAMS || len != stdHead + plen) return 0;
+
+    // Header + params are built aside, so dst may overlap src.
+    uint8_t head[2 + 3 * 3 + MAX_PARAMS * 5];
+    size_t  h = 0;
+    const bool ext = mask || plen;
+    head[h++] = FRAME_COMPACT | (ext ? FRAME_COMPACT_EXT : 0) | n;
+    head[h++] = src[0];
+    h += writeVarint(head + h, target);
+    if (ext) {
+        h += writeVarint(head + h, mask);
+        h += writeVarint(head + h, plen);
+    }
+    for (uint8_t i = 0; i < n; i++) {
+        const uint8_t* p = src + FRAME_HEADER_SIZE + i * 4;
+        if ((mask >> i) & 1) {
+            memcpy(head + h, p, 4);
+            h += 4;
+        } else {
+            const uint32_t v = ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) |
+                               ((uint32_t)p[2] <<  8) |  (uint32_t)p[3];
+            h += writeVarint(head + h, (v << 1) ^ (0u - (v >> 31)));   // zigzag
+        }
+    }
+    if (h >= stdHead) return 0;
+
+    memmove(dst + h, src + stdHead, plen);
+    memcpy(dst, head, h);
+    return h + plen;
+}
+
+// expandFrame: write a parsed frame (either layout) back out in the
+// standard layout. Returns 0 if it does not fit in cap.
+inline size_t expandFrame(const Frame& f, uint8_t* out, size_t cap) {
+    const size_t np  = (size_t)f.nparams * 4;
+    const size_t len = FRAME_HEADER_SIZE + np + f.payloadLen;
+    if (len > cap) return 0;
+    out[0] = f.cmd;
+    out[1] = (f.target     >> 8) & 0xFF;
+    out[2] =  f.target           & 0xFF;
+    out[3] =  f.nparams;
+    out[4] = (f.typeMask   >> 8) & 0xFF;
+    out[5] =  f.typeMask         & 0xFF;
+    out[6] = (f.payloadLen >> 8) & 0xFF;
+    out[7] =  f.payloadLen       & 0xFF;
+    memmove(out + FRAME_HEADER_SIZE, f.params, np);
+    memmove(out + FRAME_HEADER_SIZE + np, f.payload, f.payloadLen);
+    return len;
+}
+
+// -------------------------------------------------------------------
+// FrameWriter — construct outgoing frames (Arduino → JS) into a buffer
+// it does not own. Two concrete writers:
+//
+//   FrameBuilder   — carries its own FRAME_MAX_SIZE bytes (a stack
+//                    frame). Send with Pardalote.sendFrame /
+//                    broadcastFrame, which copy it to the transport.
+//   PardaloteFrame — (Pardalote.h) writes straight into the transport's
+//                    outbound batch, so the frame is built once, where
+//                    it is sent from. Preferred inside the library.
 //
 // Usage:
 //   FrameBuilder fb;
@@ -99,19 +290,27 @@ inline bool paramIsFloat(uint16_t typeMask, int i) {
 //   fb.addInt(angle);
 //   Pardalote.sendFrame(clientNum, fb);
 // -------------------------------------------------------------------
-class FrameBuilder {
+#define FRAME_MAX_SIZE 256
+
+class FrameWriter {
 public:
-    uint8_t  buf[256];
+    uint8_t* buf;
     uint8_t  nparams    = 0;
     uint16_t typeMask   = 0;
     uint16_t payloadLen = 0;
     bool     valid      = true;   // becomes false on overflow; finish() returns 0
 
+    FrameWriter(uint8_t* storage, uint16_t cap) : buf(storage), _cap(cap) {}
+    // Not copyable — a copy would alias the same storage.
+    FrameWriter(const FrameWriter&) = delete;
+    FrameWriter& operator=(const FrameWriter&) = delete;
+
     void begin(uint8_t cmd, uint16_t target) {
         nparams    = 0;
         typeMask   = 0;
         payloadLen = 0;
-        valid      = true;
+        valid      = _cap >= FRAME_HEADER_SIZE;
+        if (!valid) return;
         buf[0] = cmd;
         buf[1] = (target >> 8) & 0xFF;
         buf[2] =  target       & 0xFF;
@@ -124,7 +323,7 @@ public:
             Serial.println(MAX_PARAMS);
             valid = false; return false;
         }
-        if (FRAME_HEADER_SIZE + (nparams + 1) * 4 + payloadLen > sizeof(buf)) {
+        if ((size_t)FRAME_HEADER_SIZE + (nparams + 1) * 4 + payloadLen > _cap) {
             Serial.println(F("[FrameBuilder] addInt: buffer overflow"));
             valid = false; return false;
         }
@@ -144,7 +343,7 @@ public:
             Serial.println(MAX_PARAMS);
             valid = false; return false;
         }
-        if (FRAME_HEADER_SIZE + (nparams + 1) * 4 + payloadLen > sizeof(buf)) {
+        if ((size_t)FRAME_HEADER_SIZE + (nparams + 1) * 4 + payloadLen > _cap) {
             Serial.println(F("[FrameBuilder] addFloat: buffer overflow"));
             valid = false; return false;
         }
@@ -165,7 +364,7 @@ public:
     bool addString(const char* s) {
         if (!valid) return false;
         uint16_t len = (uint16_t)strlen(s);
-        if ((size_t)FRAME_HEADER_SIZE + nparams * 4 + payloadLen + len > sizeof(buf)) {
+        if ((size_t)FRAME_HEADER_SIZE + nparams * 4 + payloadLen + len > _cap) {
             Serial.print(F("[FrameBuilder] addString: buffer overflow ("));
             Serial.print(len); Serial.println(F(" bytes)"));
             valid = false; return false;
@@ -180,7 +379,7 @@ public:
     // Used by the message channel to pack [keyLen][key][value] into the payload.
     bool addBytes(const uint8_t* data, uint16_t len) {
         if (!valid) return false;
-        if ((size_t)FRAME_HEADER_SIZE + nparams * 4 + payloadLen + len > sizeof(buf)) {
+        if ((size_t)FRAME_HEADER_SIZE + nparams * 4 + payloadLen + len > _cap) {
             Serial.print(F("[FrameBuilder] addBytes: buffer overflow ("));
             Serial.print(len); Serial.println(F(" bytes)"));
             valid = false; return false;
@@ -194,6 +393,21 @@ public:
     // Append a single byte into the payload section.
     bool addByte(uint8_t b) { return addBytes(&b, 1); }
 
+    // Claim `len` payload bytes and return where to write them — for a
+    // payload produced straight into the frame (analog stream blocks).
+    // nullptr on overflow. After all addInt/addFloat, like addBytes.
+    uint8_t* reserveBytes(uint16_t len) {
+        if (!valid) return nullptr;
+        if ((size_t)FRAME_HEADER_SIZE + nparams * 4 + payloadLen + len > _cap) {
+            Serial.print(F("[FrameBuilder] reserveBytes: buffer overflow ("));
+            Serial.print(len); Serial.println(F(" bytes)"));
+            valid = false; return nullptr;
+        }
+        uint8_t* p = buf + FRAME_HEADER_SIZE + nparams * 4 + payloadLen;
+        payloadLen += len;
+        return p;
+    }
+
     // Call finish() to write the header fields and get the total frame size.
     // Returns 0 if any addInt/addFloat/addString reported overflow — callers
     // should treat 0 as "do not send."
@@ -206,9 +420,24 @@ public:
         buf[7] =  payloadLen       & 0xFF;
         return FRAME_HEADER_SIZE + nparams * 4 + payloadLen;
     }
+
+protected:
+    uint16_t _cap;
+
+    // Re-point at new storage (PardaloteFrame binds to its batch slot).
+    void _bind(uint8_t* storage, uint16_t cap) { buf = storage; _cap = cap; }
+};
+
+class FrameBuilder : public FrameWriter {
+public:
+    FrameBuilder() : FrameWriter(_storage, sizeof(_storage)) {}
+
+private:
+    uint8_t _storage[FRAME_MAX_SIZE];
 };
 
-// Outgoing frames are sent via Pardalote.sendFrame(num, fb) or
-// Pardalote.broadcastFrame(fb) — see Pardalote.h.
+// Outgoing frames are sent via Pardalote.sendFrame(num, fb) /
+// Pardalote.broadcastFrame(fb), or built in place with PardaloteFrame —
+// see Pardalote.h.
 
 #endif
@@ -7,30 +7,35 @@
 #include "serial_transport.h"
 
 // -------------------------------------------------------------------
-// CRC8, polynomial 0x07, init 0x00. Bytewise loop — message sizes are
-// small enough that a lookup table isn't worth its 256 bytes.
+// CRC8, polynomial 0x07, init 0x00 — one table lookup per byte. The
+// table is built at compile time, so it sits in flash, not RAM.
 // -------------------------------------------------------------------
-uint8_t PardaloteSerialTransport::_crc8(const uint8_t* data, size_t len) {
-    uint8_t crc = 0;
-    for (size_t i = 0; i < len; i++) {
-        crc ^= data[i];
-        for (uint8_t b = 0; b < 8; b++)
-            crc = (crc & 0x80) ? (uint8_t)((crc << 1) ^ 0x07) : (uint8_t)(crc << 1);
-    }
-    return crc;
-}
-
-void PardaloteSerialTransport::begin(PardaloteSerialMessageSink onMessage,
-                                     PardaloteSerialEventSink   onConnect,
-                                     PardaloteSerialEventSink   onDisconnect) {
-    _onMessage    = onMessage;
-    _onConnect    = onConnect;
-    _onDisconnect = onDisconnect;
+namespace {
+struct Crc8Table {
+    uint8_t t[256];
+    constexpr Crc8Table() : t() {
+        for (int i = 0; i < 256; i++) {
+            uint8_t c = (uint8_t)i;
+            for (uint8_t b = 0; b < 8; b++)
+                c = (c & 0x80) ? (uint8_t)((c << 1) ^ 0x07) : (uint8_t)(c << 1);
+            t[i] = c;
+        }
+    }
+};
+constexpr Crc8Table CRC8;
+}
+
+void PardaloteSerialTransport::begin(const PardaloteTransportSinks& sinks) {
+    _sinks = sinks;
     _state = ST_TEXT;
     _len = 0;
     _overflow  = false;
     _connected = false;
     _listening = false;   // full connected mode — promote out of listen
+    _relReset();
+    _retransmits = 0;
+    if (_baud != PARDALOTE_SERIAL_BAUD) _switchBaud(PARDALOTE_SERIAL_BAUD, millis());
+    _baudNext = 0;
 }
 
 void PardaloteSerialTransport::beginListen(PardaloteSerialMessageSink onListen) {
@@ -43,33 +48,79 @@ void PardaloteSerialTransport::beginListen(PardaloteSerialMessageSink onListen)
 }
 
 void PardaloteSerialTransport::loop(unsigned long now) {
-    while (Serial.available() > 0) {
-        int c = Serial.read();
-        if (c < 0) break;
-        _feed((uint8_t)c, now);
+    if (_baudNext) {
+        _pumpTx();
+        if (_txTail == _txHead) _switchBaud(_baudNext, now);
     }
+    if (_ackDue) _sendAck();   // nothing went back last pass to carry it
+    _pumpTx();
+    _drain(now);
+
+    // A raised rate nobody is talking at: back to the one pages open at.
+    if (_baud != PARDALOTE_SERIAL_BAUD && !_baudNext &&
+        ((!_baudHeard && now - _baudAt > PARDALOTE_SERIAL_BAUD_TRIAL_MS) ||
+         _lastByte - _lastRx > PARDALOTE_SERIAL_BAUD_TRIAL_MS))
+        _switchBaud(PARDALOTE_SERIAL_BAUD, now);
+    if (_ackNow) _sendAck();
+
+    // No progress for an RTO: send everything unacknowledged again.
+    if (_relTx && _txSent != _txBase && now - _rtxAt >= _rto) {
+        _rto = (_rto * 2 < PARDALOTE_SERIAL_RTO_MAX_MS) ? _rto * 2 : PARDALOTE_SERIAL_RTO_MAX_MS;
+        _relResend();
+    }
+    _relPump();
+    _pumpTx();
 
     // Liveness: the JS side pings every 3 s once connected (and probes
     // every 500 ms before that), so a long silence means the page is
     // gone or the cable is out.
-    if (_connected && now - _lastRx > PARDALOTE_SERIAL_TIMEOUT_MS) {
-        _connected = false;
-        if (_onDisconnect) _onDisconnect();
-    }
+    if (_connected && now - _lastRx > PARDALOTE_SERIAL_TIMEOUT_MS) _drop(now);
+}
+
+void PardaloteSerialTransport::disconnect(uint8_t client) {
+    if (client == 0 && _connected) _drop(millis());
+}
+
+void PardaloteSerialTransport::_drop(unsigned long now) {
+    _connected = false;
+    _txHead = _txTail;   // nobody left to read it (the ring is between envelopes)
+    _relReset();
+    _baudNext = 0;
+    if (_baud != PARDALOTE_SERIAL_BAUD) _switchBaud(PARDALOTE_SERIAL_BAUD, now);
+    _emitDisconnect(0);
 }
 
 // Listen-mode drain: decode probes but never connect. The listen sink may
 // call begin() to promote to connected mode (a takeover) — that clears
-// _listening, so the while-guard exits and leftover bytes are left for the
-// connected loop() to re-read from a fresh decoder.
+// _listening, so the drain stops after the chunk in hand (whose rest goes
+// to the fresh, connected decoder) and the connected loop() reads on.
 void PardaloteSerialTransport::loopListen(unsigned long now) {
-    while (_listening && Serial.available() > 0) {
-        int c = Serial.read();
-        if (c < 0) break;
-        _feed((uint8_t)c, now);
+    _pumpTx();
+    if (_listening) _drain(now);
+}
+
+// Everything Serial has buffered, a chunk per readBytes() call rather
+// than a call per byte. readBytes() is only asked for what available()
+// reports, so its timeout never comes into play.
+void PardaloteSerialTransport::_drain(unsigned long now) {
+    uint8_t chunk[64];
+    const bool listen = _listening;
+    int avail;
+    while (_listening == listen && (avail = Serial.available()) > 0) {
+        const size_t want = (size_t)avail < sizeof(chunk) ? (size_t)avail : sizeof(chunk);
+        const size_t n = Serial.readBytes(chunk, want);
+        if (n == 0) break;
+        _lastByte = now;
+        for (size_t i = 0; i < n; i++) _feed(chunk[i], now);
     }
 }
 
+// COBS is decoded as the bytes arrive, so a message is complete the
+// moment its closing delimiter is read. _code counts the data bytes left
+// in the current block (0 = the next byte is a code byte); the zero a
+// block of code < 0xFF stands for is only written once another block
+// follows, since the last block's implied zero isn't data. The CRC runs
+// one byte behind, as the last byte decoded is the CRC itself.
 void PardaloteSerialTransport::_feed(uint8_t b, unsigned long now) {
     switch (_state) {
 
@@ -82,9 +133,13 @@ void PardaloteSerialTransport::_feed(uint8_t b, unsigned long now) {
             break;
 
         case ST_DELIM:
-            if (b == PARDALOTE_SERIAL_MAGIC) {
+            if (b == PARDALOTE_SERIAL_MAGIC || b == PARDALOTE_SERIAL_REL_MAGIC) {
                 _state = ST_FRAME;
+                _magic = b;
                 _len = 0;
+                _code = 0;
+                _zero = false;
+                _crc  = 0;
                 _overflow = false;
             } else if (b != 0x00) {
                 _state = ST_TEXT;   // back-to-back 0x00s stay in DELIM
@@ -92,98 +147,351 @@ void PardaloteSerialTransport::_feed(uint8_t b, unsigned long now) {
             break;
 
         case ST_FRAME:
-            if (b == 0x00) {        // closing delimiter — decode
+            if (b == 0x00) {        // closing delimiter — deliver
                 _state = ST_DELIM;  // the closer doubles as the next opener —
-                                    // set BEFORE decode so a listen-sink switch
+                                    // set BEFORE delivery so a listen-sink switch
                                     // (which re-begin()s and resets _state) wins
                 _envelopeDone(now);
-            } else if (_len < sizeof(_buf)) {
-                _buf[_len++] = b;
+            } else if (_code == 0) {
+                if (_zero) _put(0x00);
+                _code = b - 1;
+                _zero = (b != 0xFF);
             } else {
-                _overflow = true;   // swallow to the delimiter, then discard
+                _put(b);
+                _code--;
             }
             break;
     }
 }
 
-// COBS-decode _buf in place, check the CRC, deliver. In-place is safe:
-// the write index always trails the read index.
-void PardaloteSerialTransport::_envelopeDone(unsigned long now) {
-    if (_overflow || _len < 2) return;   // minimum: 1 COBS code + CRC
+void PardaloteSerialTransport::_put(uint8_t b) {
+    if (_len >= sizeof(_buf)) { _overflow = true; return; }   // swallow to the delimiter, then discard
+    if (_len) _crc = CRC8.t[_crc ^ _buf[_len - 1]];
+    _buf[_len++] = b;
+}
 
-    size_t r = 0, w = 0;
-    while (r < _len) {
-        uint8_t code = _buf[r++];
-        if (code == 0 || r + (size_t)(code - 1) > _len) return;   // malformed
-        for (uint8_t i = 1; i < code; i++) _buf[w++] = _buf[r++];
-        if (code != 0xFF && r < _len) _buf[w++] = 0x00;
-    }
-    if (w < 1) return;
+// Closing delimiter: check the CRC and deliver the decoded message.
+void PardaloteSerialTransport::_envelopeDone(unsigned long now) {
+    if (_overflow || _code != 0 || _len < 1) return;   // too big, truncated block, or empty
 
-    const size_t msgLen = w - 1;                       // last byte is the CRC
-    if (_crc8(_buf, msgLen) != _buf[msgLen]) return;   // corrupted — drop, stay synced
+    size_t msgLen = _len - 1;                          // last byte is the CRC
+    if (_crc != _buf[msgLen]) return;                  // corrupted — drop, stay synced
+    const bool rel = (_magic == PARDALOTE_SERIAL_REL_MAGIC);
 
     // Listen mode: hand the message to the core's listen handler and never
     // connect. The handler may promote us to connected mode (a takeover).
+    // Probes are plain envelopes; sequenced ones belong to a session.
     if (_listening) {
-        if (msgLen > 0 && _onListen) _onListen(_buf, msgLen);
+        if (!rel && msgLen > 0 && _onListen) _onListen(_buf, msgLen);
         return;
     }
+    if (rel && msgLen < SERIAL_REL_HEADER) return;
 
     _lastRx = now;
+    _baudHeard = true;
     if (!_connected) {
         _connected = true;
-        if (_onConnect) _onConnect();
+        _emitConnect(0);
+    }
+    uint8_t* msg = _buf;
+    if (rel) {
+        msgLen -= SERIAL_REL_HEADER;
+        msg    += SERIAL_REL_HEADER;
+        if (!_relAccept(_buf[0], _buf[1], _buf[2], msgLen, now)) return;
+    }
+    if (msgLen > 0) _emitMessage(0, msg, msgLen);
+}
+
+// -------------------------------------------------------------------
+// FEATURE_RELIABLE — see the header notes.
+// -------------------------------------------------------------------
+
+// An inbound 0xA6 envelope: take its ack, then say whether its message
+// is the next one in order (and so to be delivered).
+bool PardaloteSerialTransport::_relAccept(uint8_t seq, uint8_t ack, uint8_t flags,
+                                          size_t len, unsigned long now) {
+    if (flags & SERIAL_REL_ACK) _relAck(ack, len == 0, now);
+    if (len == 0) return false;                        // a bare ACK
+    if ((flags & SERIAL_REL_SYN) && !_rxSynced) {
+        _rxSynced = true;
+        _rxNext   = seq;
+    }
+    if (!_rxSynced || seq != _rxNext) {                // gap or duplicate
+        if (_rxSynced) _ackNow = true;
+        return false;
+    }
+    _rxNext++;
+    _ackDue = true;
+    return true;
+}
+
+// Cumulative ACK: everything before `ack` has arrived. Only bare ACKs
+// count as duplicates — a piggybacked one repeats on every message.
+void PardaloteSerialTransport::_relAck(uint8_t ack, bool bare, unsigned long now) {
+    if (!_relTx) return;
+    const uint8_t n = ack - _txBase;
+    if (n > (uint8_t)(_txHigh - _txBase)) return;      // not for anything we sent
+    if (n == 0) {
+        if (bare && _txSent != _txBase && !_fastRtx && ++_dupAcks >= 2) {
+            _fastRtx = true;
+            _relResend();
+        }
+        return;
+    }
+    const bool behind = (uint8_t)(_txSent - _txBase) < n;   // acked past what we're resending
+    SpscQueue::Header h;
+    uint8_t* data;
+    for (uint8_t i = 0; i < n && _rtx.peek(h, data); i++) _rtx.pop();
+    _txBase = ack;
+    if (behind) {
+        _txSent    = ack;
+        _rtxCursor = _rtx.cursor();
+    }
+    _synPending = false;
+    _fastRtx    = false;
+    _dupAcks    = 0;
+    _rto        = PARDALOTE_SERIAL_RTO_MS;
+    _rtxAt      = now;
+}
+
+// Go-back-N: the next message out is the oldest unacknowledged one.
+void PardaloteSerialTransport::_relResend() {
+    _txSent    = _txBase;
+    _rtxCursor = _rtx.cursor();
+    _rtxAt     = millis();
+    _retransmits++;
+}
+
+// Sends stored messages while the window and the TX ring have room.
+// Each carries our ack.
+void PardaloteSerialTransport::_relPump() {
+    if (!_relTx || _baudNext) return;
+    SpscQueue::Header h;
+    uint8_t* data;
+    while ((uint8_t)(_txSent - _txBase) < PARDALOTE_SERIAL_WINDOW) {
+        uint32_t c = _rtxCursor;
+        if (!_rtx.next(c, h, data)) return;
+        const uint32_t need = h.len + SERIAL_REL_HEADER + (h.len + SERIAL_REL_HEADER + 1) / 254 + 5;
+        if (need > PARDALOTE_SERIAL_TX_BUF - txPending() && txPending()) return;   // next pass
+        if (_txSent == _txBase) _rtxAt = millis();
+        const uint8_t head[SERIAL_REL_HEADER] = {
+            _txSent, _rxNext,
+            (uint8_t)((_rxSynced ? SERIAL_REL_ACK : 0) |
+                      (_synPending && _txSent == 0 ? SERIAL_REL_SYN : 0))
+        };
+        _writeEnvelope(PARDALOTE_SERIAL_REL_MAGIC, head, data, h.len);
+        _ackDue = false;   // (_ackNow still goes out bare — it has to count as a duplicate)
+        _rtxCursor = c;
+        _txSent++;
+        if ((uint8_t)(_txSent - _txBase) > (uint8_t)(_txHigh - _txBase)) _txHigh = _txSent;
     }
-    if (msgLen > 0 && _onMessage) _onMessage(_buf, msgLen);
+}
+
+// A bare ACK — for a peer we have nothing to send to just now.
+void PardaloteSerialTransport::_sendAck() {
+    _ackDue = _ackNow = false;
+    if (!_rxSynced || _baudNext) return;
+    const uint8_t head[SERIAL_REL_HEADER] = { _txSent, _rxNext, SERIAL_REL_ACK };
+    _writeEnvelope(PARDALOTE_SERIAL_REL_MAGIC, head, nullptr, 0);
+    _pumpTx();
+}
+
+// Off also ends the session the other way (HELLO: maybe a new page);
+// on leaves the receive side alone — the CMD_FEATURES that turns it on
+// arrived in the page's session.
+void PardaloteSerialTransport::setReliable(bool on) {
+    if (!on) { _relReset(); return; }
+    _relStopTx();
+    if (!_rtxBuf) {
+        _rtxBuf = (uint8_t*)malloc(PARDALOTE_SERIAL_RTX_BUF);
+        if (!_rtxBuf) {
+            Serial.println(F("[Pardalote] serial: out of memory for sequenced delivery"));
+            return;
+        }
+    }
+    _rtx.begin(_rtxBuf, PARDALOTE_SERIAL_RTX_BUF);
+    _rtxCursor  = _rtx.cursor();
+    _relTx      = true;
+    _synPending = true;
+}
+
+// Ends the session both ways; the store's contents are abandoned.
+void PardaloteSerialTransport::_relReset() {
+    _relStopTx();
+    _rxSynced = _ackDue = _ackNow = false;
+    _rxNext = 0;
+}
+
+void PardaloteSerialTransport::_relStopTx() {
+    _relTx = _synPending = _fastRtx = false;
+    _txBase = _txSent = _txHigh = 0;
+    _dupAcks = 0;
+    _rto = PARDALOTE_SERIAL_RTO_MS;
 }
 
 // -------------------------------------------------------------------
-// Outbound: 0x00, 0xA5, COBS(data + crc), 0x00 — COBS is generated on
-// the fly (scan ahead to the next zero, emit the code, emit the run),
-// treating the CRC as a virtual final byte so no send buffer is needed.
+// Line rate (CMD_BAUD) — see the header notes.
 // -------------------------------------------------------------------
-void PardaloteSerialTransport::send(const uint8_t* data, size_t len) {
-    if (!_connected || len == 0) return;
-    _writeEnvelope(data, len);
+// Only ever between envelopes, with the ring empty: the reply the page
+// is waiting for has gone, and the port's own buffer is flushed first.
+void PardaloteSerialTransport::_switchBaud(uint32_t baud, unsigned long now) {
+    Serial.flush();
+#if defined(ESP32) && !ARDUINO_USB_CDC_ON_BOOT
+    Serial.updateBaudRate(baud);   // a UART — no need to tear the driver down
+#else
+    Serial.end();
+    Serial.begin(baud);
+#endif
+    _baud      = baud;
+    _baudNext  = 0;
+    _baudAt    = now;
+    _baudHeard = (baud == PARDALOTE_SERIAL_BAUD);
+    _lastByte  = _lastRx;
+    _state = ST_TEXT;   // whatever was mid-envelope was at the old rate
+}
+
+// -------------------------------------------------------------------
+// Outbound: 0x00, 0xA5, COBS(data + crc), 0x00 — encoded into the TX
+// ring, then written out by _pumpTx as the port makes room. Sequenced,
+// the message is stored and goes out as the window allows — or, with
+// the store full, refused: sent plain it would overtake the stored ones
+// and never be resent.
+// -------------------------------------------------------------------
+bool PardaloteSerialTransport::send(uint8_t client, const uint8_t* data, size_t len) {
+    if (client != 0 || !_connected || len == 0 || _baudNext) return false;
+    if (_relTx) {
+        if (!_rtx.push(0, 0, data, (uint16_t)len)) return false;
+        _relPump();
+    } else {
+        _writeEnvelope(PARDALOTE_SERIAL_MAGIC, nullptr, data, len);
+    }
+    _pumpTx();
+    return true;
+}
+
+// Sequenced, the store's room too — whichever is less.
+size_t PardaloteSerialTransport::capacity(uint8_t client) const {
+    if (client != 0 || !_connected) return 0;
+    const size_t room = PARDALOTE_SERIAL_TX_BUF - txPending();
+    const size_t overhead = SERIAL_REL_HEADER + 5 + room / 254;   // header, framing, COBS codes
+    size_t cap = room > overhead ? room - overhead : 0;
+    if (_relTx && _rtx.room() < cap) cap = _rtx.room();
+    return cap;
 }
 
 // Emit one envelope regardless of _connected — used for the listen-mode
 // nudges before any client is committed.
 void PardaloteSerialTransport::sendUnconnected(const uint8_t* data, size_t len) {
     if (len == 0) return;
-    _writeEnvelope(data, len);
+    _writeEnvelope(PARDALOTE_SERIAL_MAGIC, nullptr, data, len);
+    _drainTx();
 }
 
-void PardaloteSerialTransport::_writeEnvelope(const uint8_t* data, size_t len) {
-    const uint8_t crc = _crc8(data, len);
-    const size_t  total = len + 1;                       // data + CRC
-    auto at = [&](size_t i) -> uint8_t { return i < len ? data[i] : crc; };
-
-    Serial.write((uint8_t)0x00);
-    Serial.write((uint8_t)PARDALOTE_SERIAL_MAGIC);
+// Canonical COBS, one pass: each block is a code byte (run+1) then the
+// run of non-zero bytes; a code < 0xFF encodes one consumed zero. The
+// code byte's slot is reserved when its block opens and filled in when
+// it closes. The CRC is accumulated as the data goes by and encoded as
+// a final byte. A message that ends on a zero (or a full 254-run) ends
+// with an empty block (code 0x01), so the decoder reproduces it exactly.
+// `head` (0xA6 only) is the SERIAL_REL_HEADER bytes encoded ahead of
+// the data.
+void PardaloteSerialTransport::_writeEnvelope(uint8_t magic, const uint8_t* head,
+                                              const uint8_t* data, size_t len) {
+    const size_t hl = head ? SERIAL_REL_HEADER : 0;
+    const size_t body = hl + len;
+    const uint32_t need = (uint32_t)body + (uint32_t)(body + 1) / 254 + 5;   // 00 magic codes body CRC 00
+    if (need > PARDALOTE_SERIAL_TX_BUF - txPending()) {
+        _pumpTx();
+        if (need > PARDALOTE_SERIAL_TX_BUF - txPending()) _drainTx();   // ring full — wait on the port
+    }
+    // Bigger than the whole ring: finished blocks are written out as the
+    // ring fills, and the rest of the envelope right after.
+    const bool big = need > PARDALOTE_SERIAL_TX_BUF;
+    bool spilled = false;
 
-    // Canonical COBS: each block is a code byte (run+1) then the run of
-    // non-zero bytes; a code < 0xFF encodes one consumed zero. A message
-    // that ends on a zero (or a full 254-run) gets a final empty block
-    // (code 0x01) so the decoder reproduces it exactly.
-    size_t pos = 0;
-    while (true) {
-        size_t run = 0;
-        while (run < 254 && pos + run < total && at(pos + run) != 0x00) run++;
+    uint32_t h = _txHead;
+    _tx[h++ & TX_MASK] = 0x00;
+    _tx[h++ & TX_MASK] = magic;
+    uint32_t codeAt = h++;
+    uint8_t  code = 1;
+    uint8_t  crc  = 0;
+    for (size_t i = 0; i <= body; i++) {
+        uint8_t b;
+        if (i < body) { b = (i < hl) ? head[i] : data[i - hl]; crc = CRC8.t[crc ^ b]; }
+        else          b = crc;
+        if (big && PARDALOTE_SERIAL_TX_BUF - (h - _txTail) < 3) {
+            _writeTx(codeAt);
+            spilled = true;
+        }
+        if (b == 0x00) {
+            _tx[codeAt & TX_MASK] = code;
+            codeAt = h++;
+            code = 1;
+        } else {
+            _tx[h++ & TX_MASK] = b;
+            if (++code == 0xFF) {
+                _tx[codeAt & TX_MASK] = code;
+                codeAt = h++;
+                code = 1;
+            }
+        }
+    }
+    _tx[codeAt & TX_MASK] = code;
+    _tx[h++ & TX_MASK] = 0x00;
+    _txHead = h;
+    if (spilled) _drainTx();   // part of it is on the wire — finish it
+}
 
-        Serial.write((uint8_t)(run + 1));                // COBS code
-        for (size_t i = 0; i < run; i++) Serial.write(at(pos + i));
-        pos += run;
+// How much the port will take without blocking. A port that has never
+// reported any room (availableForWrite() not implemented) is written
+// to freely, as before.
+int PardaloteSerialTransport::_txRoom() {
+    const int room = Serial.availableForWrite();
+    if (room > 0) _txRoomKnown = true;
+    return _txRoomKnown ? room : 0x7FFF;
+}
 
-        if (run == 254) {                                // full block — no zero consumed
-            if (pos >= total) { Serial.write((uint8_t)0x01); break; }
-            continue;
+// Writes out queued envelopes while the port has room, and returns
+// between envelopes. One the port has started is finished here even if
+// that means waiting — at most one envelope's worth.
+void PardaloteSerialTransport::_pumpTx() {
+    while (_txTail != _txHead) {
+        const int room = _txRoom();
+        if (_txTail == _txEnvEnd) {
+            if (room <= 0) return;   // port full — try again next pass
+            _txEnvEnd = _envelopeEnd(_txTail);
         }
-        if (pos >= total) break;                         // ended at the data end
-        pos++;                                           // consume the 0x00 this block encodes
-        if (pos == total) { Serial.write((uint8_t)0x01); break; }   // trailing zero
+        uint32_t end = _txEnvEnd;
+        if (room > 0 && (uint32_t)room < end - _txTail) end = _txTail + room;
+        _writeTx(end);
     }
+}
 
-    Serial.write((uint8_t)0x00);
+void PardaloteSerialTransport::_drainTx() {
+    _writeTx(_txHead);
+    _txEnvEnd = _txTail;
+}
+
+// Ring bytes up to `end` to Serial, in at most two bulk writes.
+void PardaloteSerialTransport::_writeTx(uint32_t end) {
+    while (_txTail != end) {
+        const uint32_t off = _txTail & TX_MASK;
+        uint32_t n = end - _txTail;
+        if (n > PARDALOTE_SERIAL_TX_BUF - off) n = PARDALOTE_SERIAL_TX_BUF - off;
+        Serial.write(_tx + off, n);
+        _txTail += n;
+    }
+}
+
+// End of the envelope starting at `pos`: one past its closing 0x00, the
+// first zero after the 0x00 0xA5 opener (COBS leaves none in the body).
+uint32_t PardaloteSerialTransport::_envelopeEnd(uint32_t pos) const {
+    uint32_t p = pos + 2;
+    while (true) {
+        const uint32_t off  = p & TX_MASK;
+        const size_t   span = PARDALOTE_SERIAL_TX_BUF - off;
+        const uint8_t* z = (const uint8_t*)memchr(_tx + off, 0x00, span);
+        if (z) return p + (uint32_t)(z - (_tx + off)) + 1;
+        p += span;
+    }
 }
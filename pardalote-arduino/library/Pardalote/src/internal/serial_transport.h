@@ -34,41 +34,209 @@
 //     unplugged cable is declared dead well inside the timeout. This
 //     also stops us writing into a port nobody is draining (which can
 //     block Serial.write on native-USB boards and stall loop()).
+//
+// Outbound envelopes are COBS-encoded (CRC included, in the same pass)
+// into a TX ring, and the ring is written out in bulk only as fast as
+// Serial.availableForWrite() says the port will take — so a busy or
+// slow port delays messages instead of stalling loop(). The ring is
+// only ever left between envelopes: once one is started it is finished
+// in the same call, so the sketch's Serial.print text can never land
+// inside an envelope. Only when the ring itself is full does a send
+// wait on the port, as every write used to.
+//
+// Sequenced delivery (FEATURE_RELIABLE). The CRC only drops a damaged
+// message; once a page switches this on, each direction carries its
+// messages in a second envelope that gets them there:
+//
+//   0x00  0xA6  COBS( seq, ack, flags, message bytes + CRC8 )  0x00
+//
+//   - seq numbers the messages (mod 256); the receiver delivers them
+//     strictly in order and drops anything else — a damaged message
+//     loses the ones behind it too, until they're sent again.
+//   - ack (valid when flags has REL_ACK) is cumulative: the next seq
+//     the sender of the envelope expects. It rides on every 0xA6
+//     envelope going the other way; with nothing to carry it, a bare
+//     ACK (header only, no seq used) goes out the next pass.
+//   - REL_SYN marks a session's first message, seq 0 — the receiver
+//     starts counting there. HELLO, begin() and the rx timeout end a
+//     session on the board; the page starts one per HELLO.
+//   - Up to PARDALOTE_SERIAL_WINDOW messages may be unacknowledged.
+//     A gap or duplicate is answered at once with a bare ACK; the
+//     second repeat of an ACK sends everything from the first unACKed
+//     message again (go-back-N), as does PARDALOTE_SERIAL_RTO_MS with
+//     no progress (doubling each time, to RTO_MAX_MS).
+//
+// Sent messages wait in a store until they're acknowledged, and
+// send() returns at once — loop() never waits for an ACK. A message
+// the store has no room for is refused (send() returns false) and the
+// core holds it for the next pass; capacity() counts the store's room,
+// so periodic readings back off before it fills. Sent plain instead, it
+// would overtake the stored messages and never be resent. 0xA5
+// envelopes are accepted at all times (the HELLO probe is one), and the
+// receive side of 0xA6 is always on.
+//
+// Line rate. Every page opens the port at PARDALOTE_SERIAL_BAUD; the
+// HELLO reports how fast this board will go (PARDALOTE_SERIAL_MAX_BAUD,
+// or SERIAL_BAUD_NATIVE where Serial is the chip's own USB and the rate
+// doesn't apply). A page that can go faster sends CMD_BAUD; setBaud()
+// answers at the old rate, stops sending, and switches once the TX ring
+// has drained. If no valid envelope then arrives within
+// PARDALOTE_SERIAL_BAUD_TRIAL_MS — or later, bytes keep arriving that
+// never make one (a new page probing at the opening rate) — the board
+// drops back to PARDALOTE_SERIAL_BAUD. So does a disconnect.
 // ==============================================================
 
 #pragma once
 
 #include <Arduino.h>
+#include "defs.h"
+#include "spsc_queue.h"
+#include "transport.h"
 
-// Decoded-message capacity — must hold the largest JS batch (a group
-// write is a handful of ~24-byte frames; a text message tops out near
-// the WS path's limits). Raw COBS input is at most decoded+overhead,
-// so the raw accumulator adds a small margin.
+// Decoded-message capacity (message + CRC) — must hold the largest JS
+// batch (a group write is a handful of ~24-byte frames; a text message
+// tops out near the WS path's limits).
 #ifndef PARDALOTE_SERIAL_RX_BUF
 #define PARDALOTE_SERIAL_RX_BUF 520
 #endif
 
+// Outbound ring (bytes, a power of two). Holds the envelopes the port
+// hasn't taken yet — a run() pass's batch, plus whatever is still
+// waiting from earlier passes. A whole batch must fit in one envelope
+// (see the check below), so a batch raised past 1000 bytes gets the
+// bigger ring by default.
+#ifndef PARDALOTE_SERIAL_TX_BUF
+  #if PARDALOTE_TX_BATCH > 1000
+    #define PARDALOTE_SERIAL_TX_BUF 2048
+  #else
+    #define PARDALOTE_SERIAL_TX_BUF 1024
+  #endif
+#endif
+static_assert((PARDALOTE_SERIAL_TX_BUF & (PARDALOTE_SERIAL_TX_BUF - 1)) == 0 &&
+              PARDALOTE_SERIAL_TX_BUF >= 512,
+              "PARDALOTE_SERIAL_TX_BUF must be a power of two, at least 512");
+
+// FEATURE_RELIABLE: messages in flight at once. Enough to keep a fast
+// port busy for a round trip (USB adds ~1 ms each way, plus a run()
+// pass to answer) without the retransmits of a loss growing long.
+#ifndef PARDALOTE_SERIAL_WINDOW
+#define PARDALOTE_SERIAL_WINDOW 16
+#endif
+static_assert(PARDALOTE_SERIAL_WINDOW >= 1 && PARDALOTE_SERIAL_WINDOW <= 64,
+              "PARDALOTE_SERIAL_WINDOW must be 1..64");
+
+// FEATURE_RELIABLE: the store for sent-but-unacknowledged (and not yet
+// sent) messages, in bytes (a power of two; allocated when a page
+// first switches the mode on). Half of it is the largest message it
+// can hold, so it must take a full PARDALOTE_TX_BATCH — a batch raised
+// past 1 KB gets the bigger store by default.
+#ifndef PARDALOTE_SERIAL_RTX_BUF
+  #if defined(ESP32) || PARDALOTE_TX_BATCH > 2048 / 2 - 4
+    #define PARDALOTE_SERIAL_RTX_BUF 4096
+  #else
+    #define PARDALOTE_SERIAL_RTX_BUF 2048
+  #endif
+#endif
+static_assert((PARDALOTE_SERIAL_RTX_BUF & (PARDALOTE_SERIAL_RTX_BUF - 1)) == 0 &&
+              PARDALOTE_SERIAL_RTX_BUF >= 2048,
+              "PARDALOTE_SERIAL_RTX_BUF must be a power of two, at least 2048");
+static_assert(PARDALOTE_SERIAL_RTX_BUF / 2 - 4 >= PARDALOTE_TX_BATCH,
+              "PARDALOTE_SERIAL_RTX_BUF must hold a full PARDALOTE_TX_BATCH");
+
+// FEATURE_RELIABLE: resend after this long without progress.
+#ifndef PARDALOTE_SERIAL_RTO_MS
+#define PARDALOTE_SERIAL_RTO_MS 50UL
+#endif
+#define PARDALOTE_SERIAL_RTO_MAX_MS  1000UL
+
+// The rate every page opens the port at, and the board falls back to.
+#define PARDALOTE_SERIAL_BAUD        115200UL
+#define SERIAL_BAUD_NATIVE           -1
+
+// The fastest rate CMD_BAUD may switch to. ESP32 UARTs run 2 Mbaud
+// (bridge chips permitting — the page asks for what its bridge takes);
+// on native USB (UNO R4 Minima, ESP32 USB-CDC) the rate is only a
+// label; the UNO R4 WiFi's bridge link stays at the opening rate.
+#ifndef PARDALOTE_SERIAL_MAX_BAUD
+  #if defined(ARDUINO_UNOR4_MINIMA) || (defined(ESP32) && ARDUINO_USB_CDC_ON_BOOT)
+    #define PARDALOTE_SERIAL_MAX_BAUD SERIAL_BAUD_NATIVE
+  #elif defined(ESP32) || defined(PARDALOTE_HOST)
+    #define PARDALOTE_SERIAL_MAX_BAUD 2000000L
+  #else
+    #define PARDALOTE_SERIAL_MAX_BAUD ((long)PARDALOTE_SERIAL_BAUD)
+  #endif
+#endif
+
+// After a switch: how long to wait for the page at the new rate.
+#ifndef PARDALOTE_SERIAL_BAUD_TRIAL_MS
+#define PARDALOTE_SERIAL_BAUD_TRIAL_MS 2000UL
+#endif
+
 #define PARDALOTE_SERIAL_MAGIC       0xA5
+#define PARDALOTE_SERIAL_REL_MAGIC   0xA6   // sequenced envelope
 #define PARDALOTE_SERIAL_TIMEOUT_MS  8000UL
 
+#define SERIAL_REL_SYN     0x01   // the session's first message — start counting here
+#define SERIAL_REL_ACK     0x02   // the ack byte is valid
+#define SERIAL_REL_HEADER  3      // seq, ack, flags
+
+// With the ring empty, capacity() — the ring less a sequenced envelope's
+// header, framing and COBS codes — must reach a full batch. Short of
+// that, the core would see the client as backed up for good and hold
+// back its periodic readings.
+static_assert(PARDALOTE_SERIAL_TX_BUF - (SERIAL_REL_HEADER + 5 + PARDALOTE_SERIAL_TX_BUF / 254)
+                  >= PARDALOTE_TX_BATCH,
+              "PARDALOTE_SERIAL_TX_BUF must take a full PARDALOTE_TX_BATCH in one envelope");
+
+// Listen mode's sink — no client yet, just the message.
 typedef void (*PardaloteSerialMessageSink)(uint8_t* data, size_t len);
-typedef void (*PardaloteSerialEventSink)();
 
-class PardaloteSerialTransport {
+// The page on the other end of the cable is always client 0.
+class PardaloteSerialTransport : public PardaloteTransport {
 public:
-    // Sinks are plain function pointers (same pattern as the WS event
-    // trampoline) so this file needs no knowledge of PardaloteClass.
-    void begin(PardaloteSerialMessageSink onMessage,
-               PardaloteSerialEventSink   onConnect,
-               PardaloteSerialEventSink   onDisconnect);
+    // Connected mode (see transport.h). Resets the decoder, the
+    // sequenced session and the line rate.
+    void begin(const PardaloteTransportSinks& sinks) override;
+
+    // Call every loop() pass: writes out what the TX ring is holding,
+    // drains Serial through the decoder and runs the rx-timeout
+    // disconnect check.
+    void loop(unsigned long now) override;
+
+    // Envelope one outbound message into the TX ring and write out what
+    // the port will take now. False until connected, and while a line
+    // rate switch is pending.
+    bool send(uint8_t client, const uint8_t* data, size_t len) override;
+
+    // The board can't close the page's port; this forgets the page as
+    // the rx timeout does, and the next envelope connects it afresh.
+    void disconnect(uint8_t client) override;
+
+    // Room left in the TX ring, less one envelope's overhead.
+    size_t capacity(uint8_t client) const override;
+
+    // Bytes still waiting in the TX ring.
+    size_t txPending() const { return _txHead - _txTail; }
 
-    // Call every loop() pass: drains Serial through the decoder and
-    // runs the rx-timeout disconnect check.
-    void loop(unsigned long now);
+    // FEATURE_RELIABLE for what we send (CMD_FEATURES). Either way ends
+    // our current session: unacknowledged messages are dropped, and a
+    // fresh one starts at seq 0. Stays off when the store can't be
+    // allocated.
+    void setReliable(bool on);
+    bool reliable() const { return _relTx; }
 
-    // Envelope + write one outbound message. COBS is stream-encoded
-    // straight to Serial (no send buffer). No-op until connected.
-    void send(const uint8_t* data, size_t len);
+    // Go-back-N resends (duplicate ACKs and timeouts) since begin().
+    uint32_t retransmits() const { return _retransmits; }
+
+    // CMD_BAUD. A rate in PARDALOTE_SERIAL_BAUD..PARDALOTE_SERIAL_MAX_BAUD,
+    // before sequenced delivery starts, is allowed. setBaud() goes right
+    // after the reply: nothing more is sent until the switch.
+    bool baudAllowed(uint32_t baud) const {
+        return !_relTx && baud >= PARDALOTE_SERIAL_BAUD &&
+               (long)baud <= (long)PARDALOTE_SERIAL_MAX_BAUD;
+    }
+    void setBaud(uint32_t baud) { _baudNext = (baud != _baud) ? baud : 0; }
+    uint32_t baud() const { return _baud; }
 
     bool connected() const { return _connected; }
 
@@ -93,32 +261,90 @@ public:
 
     // Emit one envelope while NOT connected — the listen-mode nudges
     // (CMD_SERIAL_BUSY / CMD_AUTH reject). Normal send() no-ops until
-    // connected; this bypasses that guard.
+    // connected; this bypasses that guard, and writes the envelope out
+    // before returning (these go out during boot and mode switches,
+    // when nothing may call loop() for a while).
     void sendUnconnected(const uint8_t* data, size_t len);
 
 private:
+    void _drain(unsigned long now);
     void _feed(uint8_t b, unsigned long now);
+    void _put(uint8_t b);
     void _envelopeDone(unsigned long now);
-    void _writeEnvelope(const uint8_t* data, size_t len);
-    static uint8_t _crc8(const uint8_t* data, size_t len);
+    void _writeEnvelope(uint8_t magic, const uint8_t* head,
+                        const uint8_t* data, size_t len);
+
+    // FEATURE_RELIABLE. Sequence numbers are mod 256: _txBase is the
+    // oldest unacknowledged message (the _rtx tail), _txSent the next
+    // to go out (at _rtxCursor), _txHigh one past the furthest sent.
+    bool _relAccept(uint8_t seq, uint8_t ack, uint8_t flags, size_t len, unsigned long now);
+    void _relAck(uint8_t ack, bool bare, unsigned long now);
+    void _relPump();
+    void _relResend();
+    void _relReset();
+    void _relStopTx();
+    void _sendAck();
+    void _drop(unsigned long now);
+
+    void _switchBaud(uint32_t baud, unsigned long now);
+
+    // TX ring. Positions are free-running; _txEnvEnd is the end of the
+    // envelope the port is part-way through (== _txTail between
+    // envelopes).
+    static const uint32_t TX_MASK = PARDALOTE_SERIAL_TX_BUF - 1;
+    void     _pumpTx();
+    void     _drainTx();
+    void     _writeTx(uint32_t end);
+    uint32_t _envelopeEnd(uint32_t pos) const;
+    int      _txRoom();
 
     // Decoder states. TEXT swallows the sketch's own debug bytes (the
     // board never receives text from JS — anything outside an envelope
     // is discarded); DELIM has just consumed a 0x00 and decides what
-    // the next byte starts; FRAME accumulates COBS bytes to the
-    // closing 0x00.
+    // the next byte starts; FRAME decodes COBS bytes to the closing
+    // 0x00.
     enum State : uint8_t { ST_TEXT, ST_DELIM, ST_FRAME };
 
     uint8_t  _state = ST_TEXT;
+    uint8_t  _magic = 0;     // of the envelope being decoded
     uint8_t  _buf[PARDALOTE_SERIAL_RX_BUF];
-    size_t   _len  = 0;
+    size_t   _len  = 0;      // decoded bytes so far
+    uint8_t  _code = 0;      // data bytes left in the current COBS block
+    bool     _zero = false;  // the current block ends in an implied zero
+    uint8_t  _crc  = 0;      // CRC8 of all but the last decoded byte
     bool     _overflow  = false;
     bool     _connected = false;
     bool     _listening = false;
     unsigned long _lastRx = 0;
 
-    PardaloteSerialMessageSink _onMessage    = nullptr;
-    PardaloteSerialEventSink   _onConnect    = nullptr;
-    PardaloteSerialEventSink   _onDisconnect = nullptr;
-    PardaloteSerialMessageSink _onListen     = nullptr;
+    uint8_t  _tx[PARDALOTE_SERIAL_TX_BUF];
+    uint32_t _txHead   = 0;
+    uint32_t _txTail   = 0;
+    uint32_t _txEnvEnd = 0;
+    bool     _txRoomKnown = false;   // the port has reported room at least once
+
+    SpscQueue _rtx;                  // sent and waiting messages, oldest first
+    uint8_t*  _rtxBuf    = nullptr;
+    uint32_t  _rtxCursor = 0;
+    bool      _relTx     = false;
+    bool      _synPending = false;   // seq 0 not acknowledged yet — it carries SYN
+    bool      _fastRtx   = false;    // resent on duplicate ACKs; more are ignored
+    uint8_t   _txBase = 0, _txSent = 0, _txHigh = 0;
+    uint8_t   _dupAcks = 0;
+    unsigned long _rtxAt = 0;        // last transmit or progress
+    unsigned long _rto   = PARDALOTE_SERIAL_RTO_MS;
+    uint32_t  _retransmits = 0;
+
+    bool      _rxSynced = false;     // seen the peer's SYN
+    uint8_t   _rxNext   = 0;         // next seq to deliver — our ack
+    bool      _ackDue   = false;     // delivered since our last ack
+    bool      _ackNow   = false;     // a gap or duplicate — ack this pass
+
+    uint32_t  _baud     = PARDALOTE_SERIAL_BAUD;
+    uint32_t  _baudNext = 0;         // switch pending, once the TX ring drains
+    bool      _baudHeard = true;     // a valid envelope since the switch
+    unsigned long _baudAt   = 0;
+    unsigned long _lastByte = 0;     // anything at all arrived
+
+    PardaloteSerialMessageSink _onListen = nullptr;
 };
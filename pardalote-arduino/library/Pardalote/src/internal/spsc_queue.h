@@ -0,0 +1,137 @@
+// ==============================================================
+// internal/spsc_queue.h
+// Lock-free single-producer / single-consumer message queue.
+// Part of Pardalote — version in library.properties
+// by Scott Mitchell
+// GPL-3.0-or-later License
+//
+// Carries whole transport messages between two tasks (on ESP32, the
+// network task on core 0 and the loop task on core 1 — see
+// Pardalote::splitCores()). One side only ever pushes, the other only
+// ever peeks and pops, so two atomic indices are all the
+// synchronisation needed: no locks, no critical sections, and neither
+// side can block the other. The inbound queue run() drains uses it
+// too, with both ends on the loop task.
+//
+// Records are stored contiguously — a 4-byte header then the bytes,
+// padded to 4 — so the consumer reads a message in place, without a
+// copy. A record that won't fit before the end of the buffer is
+// preceded by a wrap marker and starts again at offset 0. The buffer
+// is supplied by the caller (allocated only when the queue is used).
+// ==============================================================
+
+#ifndef PARDALOTE_SPSC_QUEUE_H
+#define PARDALOTE_SPSC_QUEUE_H
+
+#include <Arduino.h>
+#include <atomic>
+
+class SpscQueue {
+public:
+    struct Header {
+        uint16_t len;
+        uint8_t  client;
+        uint8_t  type;
+    };
+
+    // The wrap marker's type. push() refuses it — a record carrying it
+    // would read back as a wrap.
+    static const uint8_t WRAP = 0xFF;
+
+    // `size` must be a power of two. Call before either side starts.
+    void begin(uint8_t* buf, uint32_t size) {
+        _buf  = buf;
+        _mask = size - 1;
+        _head.store(0, std::memory_order_relaxed);
+        _tail.store(0, std::memory_order_relaxed);
+    }
+
+    bool ready() const { return _buf != nullptr; }
+
+    // Detaches the buffer and hands it back for the caller to free.
+    // Only once neither side will touch the queue again.
+    uint8_t* release() {
+        uint8_t* buf = _buf;
+        _buf  = nullptr;
+        _mask = 0;
+        return buf;
+    }
+
+    // Largest message push() can ever accept.
+    uint32_t maxLen() const { return _buf ? (_mask + 1) / 2 - sizeof(Header) : 0; }
+
+    // Producer. The longest message push() would take right now — in
+    // one piece before the end of the buffer, or after a wrap to 0.
+    uint32_t room() const {
+        if (!_buf) return 0;
+        const uint32_t head  = _head.load(std::memory_order_relaxed);
+        const uint32_t tail  = _tail.load(std::memory_order_acquire);
+        const uint32_t free  = (_mask + 1) - (head - tail);
+        const uint32_t toEnd = (_mask + 1) - (head & _mask);
+        uint32_t rec = free < toEnd ? free : toEnd;
+        if (free > toEnd && free - toEnd > rec) rec = free - toEnd;
+        if (rec <= sizeof(Header)) return 0;
+        const uint32_t len = rec - sizeof(Header);
+        return len < maxLen() ? len : maxLen();
+    }
+
+    // Producer. False when the queue is too full (or len > maxLen(), or
+    // type is WRAP).
+    bool push(uint8_t client, uint8_t type, const uint8_t* data, uint16_t len) {
+        if (len > maxLen() || type == WRAP) return false;
+        const uint32_t rec  = _recSize(len);
+        const uint32_t head = _head.load(std::memory_order_relaxed);
+        const uint32_t tail = _tail.load(std::memory_order_acquire);
+        const uint32_t off  = head & _mask;
+        const uint32_t pad  = (off + rec > _mask + 1) ? _mask + 1 - off : 0;
+        if (pad + rec > (_mask + 1) - (head - tail)) return false;
+
+        if (pad) _header(off) = { 0, 0, WRAP };
+        const uint32_t at = (head + pad) & _mask;
+        _header(at) = { len, client, type };
+        if (len) memcpy(_buf + at + sizeof(Header), data, len);
+        _head.store(head + pad + rec, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer. The oldest message, left in place until pop().
+    bool peek(Header& h, uint8_t*& data) {
+        uint32_t c = cursor();
+        if (!next(c, h, data)) return false;
+        _next = c;
+        return true;
+    }
+
+    // Consumer. Walks the queued messages oldest first without removing
+    // any:  for (uint32_t c = q.cursor(); q.next(c, h, data); ) …
+    uint32_t cursor() const { return _tail.load(std::memory_order_relaxed); }
+
+    bool next(uint32_t& cursor, Header& h, uint8_t*& data) {
+        const uint32_t head = _head.load(std::memory_order_acquire);
+        if (cursor == head) return false;
+        uint32_t off = cursor & _mask;
+        if (_header(off).type == WRAP) {
+            cursor += _mask + 1 - off;      // the record itself is at 0
+            off = 0;
+        }
+        h      = _header(off);
+        data   = _buf + off + sizeof(Header);
+        cursor += _recSize(h.len);
+        return true;
+    }
+
+    // Consumer. Releases the message peek() returned.
+    void pop() { _tail.store(_next, std::memory_order_release); }
+
+private:
+    static uint32_t _recSize(uint16_t len) { return (sizeof(Header) + len + 3) & ~3u; }
+    Header& _header(uint32_t off) { return *reinterpret_cast<Header*>(_buf + off); }
+
+    uint8_t*              _buf  = nullptr;
+    uint32_t              _mask = 0;
+    std::atomic<uint32_t> _head{0};   // producer: next write (free-running)
+    std::atomic<uint32_t> _tail{0};   // consumer: next read (free-running)
+    uint32_t              _next = 0;  // consumer: tail after the peeked record
+};
+
+#endif
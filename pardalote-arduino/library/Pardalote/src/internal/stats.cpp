@@ -0,0 +1,71 @@
+// ==============================================================
+// internal/stats.cpp
+// Storage for the Stats tables (shared by Pardalote.cpp and the
+// extension registry), and the cycle-counter setup.
+// ==============================================================
+
+#include "stats.h"
+
+StatHist         Stats::period;
+uint32_t         Stats::passes = 0;
+StatCost         Stats::sections[STATS_SECTIONS];
+Stats::Ext       Stats::ext[MAX_EXTENSIONS];
+Stats::Cmd       Stats::cmds[PARDALOTE_STATS_CMDS];
+uint8_t          Stats::cmdCount    = 0;
+uint32_t         Stats::cmdOverflow = 0;
+Stats::Client    Stats::clients[PARDALOTE_MAX_CLIENTS];
+uint32_t         Stats::coalesced   = 0;
+uint32_t         Stats::rxRefused   = 0;
+uint32_t         Stats::txDropped   = 0;
+uint32_t         Stats::sinceMs     = 0;
+uint32_t         Stats::_ticksPerUs = 1;
+uint32_t         Stats::_lastPass   = 0;
+
+void Stats::begin() {
+#if PARDALOTE_STATS
+  #if defined(PLATFORM_ESP32)
+    _ticksPerUs = getCpuFrequencyMhz();
+  #elif defined(PLATFORM_UNO_R4) || defined(PLATFORM_UNO_R4_MINIMA)
+    // The DWT cycle counter is off out of reset.
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CYCCNT = 0;
+    DWT->CTRL  |= DWT_CTRL_CYCCNTENA_Msk;
+    _ticksPerUs = SystemCoreClock / 1000000;
+  #endif
+    if (_ticksPerUs == 0) _ticksPerUs = 1;
+#endif
+    reset();
+}
+
+void Stats::reset() {
+    period = StatHist();
+    passes = 0;
+    for (auto& s : sections) s = StatCost();
+    for (auto& e : ext)      e.loop = StatCost();
+    for (auto& c : clients)  c = Client();
+    cmdCount    = 0;
+    cmdOverflow = 0;
+    coalesced   = 0;
+    rxRefused   = 0;
+    txDropped   = 0;
+    sinceMs     = millis();
+}
+
+// Linear scan — a sketch drives a handful of (deviceId, cmd) pairs,
+// and the busiest ones register first.
+void Stats::command(uint16_t deviceId, uint8_t cmd, uint32_t since) {
+#if PARDALOTE_STATS
+    const uint32_t us = toUs(ticks() - since);
+    for (uint8_t i = 0; i < cmdCount; i++) {
+        if (cmds[i].deviceId == deviceId && cmds[i].cmd == cmd) { cmds[i].cost.add(us); return; }
+    }
+    if (cmdCount >= PARDALOTE_STATS_CMDS) { cmdOverflow++; return; }
+    Cmd& c = cmds[cmdCount++];
+    c.deviceId = deviceId;
+    c.cmd      = cmd;
+    c.cost     = StatCost();
+    c.cost.add(us);
+#else
+    (void)deviceId; (void)cmd; (void)since;
+#endif
+}
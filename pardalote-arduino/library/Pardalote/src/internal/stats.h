@@ -0,0 +1,168 @@
+// ==============================================================
+// internal/stats.h
+// Loop and command timing, frame and byte counts (CMD_STATS).
+// Part of Pardalote — version in library.properties
+// by Scott Mitchell
+// GPL-3.0-or-later License
+//
+// Cheap enough to leave on: each measurement is two cycle-counter
+// reads, a divide and a few adds into fixed tables — no allocation,
+// no floats. Collected:
+//
+//   - the run() period, as a log2 histogram of microseconds;
+//   - each phase of a run() pass (transport, CMD_AT replay, extension
+//     loops, pin polling, …) — calls, total and worst time;
+//   - each extension's loop() hook, and each (deviceId, cmd) handler
+//     dispatchExtension() runs — same three numbers;
+//   - frames and bytes in and out, per client, and inbound frames
+//     skipped because a newer one replaced them (coalesceCommand()).
+//
+// Everything counts since boot or the last reset(). Totals are
+// uint32 microseconds, so read (and reset) at least hourly if you
+// care about them; max and histograms don't wrap.
+//
+// Build with -DPARDALOTE_STATS=0 to compile the collection out.
+// ==============================================================
+
+#pragma once
+
+#include <Arduino.h>
+#include "platform.h"
+#include "defs.h"
+#include "extensions.h"
+
+#ifndef PARDALOTE_STATS
+  #define PARDALOTE_STATS 1
+#endif
+
+// (deviceId, cmd) pairs with their own handler timing. Pairs beyond
+// this are counted in Stats::cmdOverflow only.
+#ifndef PARDALOTE_STATS_CMDS
+  #define PARDALOTE_STATS_CMDS 24
+#endif
+
+// Log2 buckets: bin 0 = 0 µs, bin k = [2^(k-1), 2^k) µs, the last bin
+// everything from 2^(STATS_BINS-2) µs (16 ms) up.
+#define STATS_BINS 16
+
+struct StatCost {
+    uint32_t calls   = 0;
+    uint32_t totalUs = 0;
+    uint32_t maxUs   = 0;
+
+    void add(uint32_t us) {
+        calls++;
+        totalUs += us;
+        if (us > maxUs) maxUs = us;
+    }
+};
+
+struct StatHist {
+    uint32_t bins[STATS_BINS] = {};
+    uint32_t maxUs = 0;
+
+    void add(uint32_t us) {
+        uint8_t b = us ? 32 - __builtin_clz(us) : 0;
+        if (b >= STATS_BINS) b = STATS_BINS - 1;
+        bins[b]++;
+        if (us > maxUs) maxUs = us;
+    }
+};
+
+class Stats {
+public:
+    struct Ext {
+        uint16_t deviceId = 0;
+        StatCost loop;
+    };
+    struct Cmd {
+        uint16_t deviceId = 0;
+        uint8_t  cmd      = 0;
+        StatCost cost;
+    };
+    struct Client {
+        uint32_t framesIn = 0, bytesIn = 0, framesOut = 0, bytesOut = 0;
+    };
+
+    static StatHist period;                        // run() start to start
+    static uint32_t passes;
+    static StatCost sections[STATS_SECTIONS];      // STATS_SEC_* in defs.h
+    static Ext      ext[MAX_EXTENSIONS];           // by registry index
+    static Cmd      cmds[PARDALOTE_STATS_CMDS];
+    static uint8_t  cmdCount;
+    static uint32_t cmdOverflow;
+    static Client   clients[PARDALOTE_MAX_CLIENTS];
+    static uint32_t coalesced;                     // inbound frames superseded
+    static uint32_t rxRefused;                     // inbound messages refused mid-drain
+    static uint32_t txDropped;                     // outbound batches refused and lost
+    static uint32_t sinceMs;                       // millis() at the last reset
+
+    static void begin();
+    static void reset();
+
+    // Free-running cycle counter, and its conversion to microseconds.
+    static uint32_t ticks() {
+#if !PARDALOTE_STATS
+        return 0;
+#elif defined(PLATFORM_ESP32)
+        return ESP.getCycleCount();
+#elif defined(PLATFORM_UNO_R4) || defined(PLATFORM_UNO_R4_MINIMA)
+        return DWT->CYCCNT;
+#else
+        return (uint32_t)micros();
+#endif
+    }
+    static uint32_t toUs(uint32_t t) { return t / _ticksPerUs; }
+
+    // Marks the start of a run() pass.
+    static void passStart() {
+#if PARDALOTE_STATS
+        const uint32_t now = (uint32_t)micros();
+        if (passes++) period.add(now - _lastPass);
+        _lastPass = now;
+#endif
+    }
+
+    // Charges the time since `since` to a pass phase; returns now, so
+    // consecutive phases chain: t = Stats::section(STATS_SEC_X, t);
+    static uint32_t section(uint8_t id, uint32_t since) {
+#if PARDALOTE_STATS
+        const uint32_t now = ticks();
+        sections[id].add(toUs(now - since));
+        return now;
+#else
+        (void)id; (void)since; return 0;
+#endif
+    }
+
+    static void extLoop(uint8_t index, uint16_t deviceId, uint32_t since) {
+#if PARDALOTE_STATS
+        ext[index].deviceId = deviceId;
+        ext[index].loop.add(toUs(ticks() - since));
+#else
+        (void)index; (void)deviceId; (void)since;
+#endif
+    }
+
+    static void command(uint16_t deviceId, uint8_t cmd, uint32_t since);
+
+    static void rx(uint8_t c, uint16_t bytes) {
+#if PARDALOTE_STATS
+        if (c < PARDALOTE_MAX_CLIENTS) { clients[c].framesIn++; clients[c].bytesIn += bytes; }
+#else
+        (void)c; (void)bytes;
+#endif
+    }
+
+    static void tx(uint8_t c, uint16_t bytes) {
+#if PARDALOTE_STATS
+        if (c < PARDALOTE_MAX_CLIENTS) { clients[c].framesOut++; clients[c].bytesOut += bytes; }
+#else
+        (void)c; (void)bytes;
+#endif
+    }
+
+private:
+    static uint32_t _ticksPerUs;
+    static uint32_t _lastPass;
+};
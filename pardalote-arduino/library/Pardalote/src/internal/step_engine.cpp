@@ -0,0 +1,434 @@
+// ==============================================================
+// internal/step_engine.cpp
+// Hardware-timer step engine. See the design notes in step_engine.h.
+//
+// Compiled and linked into every build: Arduino links a library's
+// objects directly, and PARDALOTE_STEP_TIMER is a sketch #define this
+// file never sees. Without the opt-in nothing calls into it, so the
+// cores' --gc-sections drops its code and data. Nothing here runs at
+// startup either — the statics below are constant-initialised, and the
+// UNO R4's FspTimer is built on first use, not by a static constructor
+// that .init_array would keep.
+// ==============================================================
+
+#include "step_engine.h"
+
+#if defined(PLATFORM_ESP32)
+  #include <esp_arduino_version.h>
+  #define STEP_ENGINE_ISR IRAM_ATTR
+  // The timer ISR and loop() can run on different cores on dual-core
+  // parts, so loop-side updates take a spinlock rather than just
+  // masking local interrupts.
+  static portMUX_TYPE _stepMux = portMUX_INITIALIZER_UNLOCKED;
+  #define STEP_LOCK()       portENTER_CRITICAL(&_stepMux)
+  #define STEP_UNLOCK()     portEXIT_CRITICAL(&_stepMux)
+  #define STEP_LOCK_ISR()   portENTER_CRITICAL_ISR(&_stepMux)
+  #define STEP_UNLOCK_ISR() portEXIT_CRITICAL_ISR(&_stepMux)
+  static hw_timer_t* _hwTimer = nullptr;
+#elif defined(PLATFORM_UNO_R4) || defined(PLATFORM_UNO_R4_MINIMA)
+  #include <FspTimer.h>
+  #define STEP_ENGINE_ISR
+  #define STEP_LOCK()       noInterrupts()
+  #define STEP_UNLOCK()     interrupts()
+  #define STEP_LOCK_ISR()
+  #define STEP_UNLOCK_ISR()
+  static FspTimer& fspTimer() {
+      static FspTimer timer;   // not at startup — see the top of the file
+      return timer;
+  }
+#else
+  // No hardware timer — tick() must be driven by the caller.
+  #define STEP_ENGINE_ISR
+  #define STEP_LOCK()
+  #define STEP_UNLOCK()
+  #define STEP_LOCK_ISR()
+  #define STEP_UNLOCK_ISR()
+#endif
+
+StepEngine::Motor      StepEngine::_m[STEP_ENGINE_MAX_MOTORS] = {};
+uint8_t                StepEngine::_heap[STEP_ENGINE_MAX_MOTORS] = {};
+uint8_t                StepEngine::_heapLen      = 0;
+volatile uint32_t      StepEngine::_now          = 0;
+volatile uint8_t       StepEngine::_pulseHigh    = 0;
+bool                   StepEngine::_timerRunning = false;
+
+// FULL4WIRE coil patterns, bit i = coil pin i — the same sequence as
+// AccelStepper::step4(), indexed by position & 3, so a motor can swap
+// engines without its phase jumping.
+static const uint8_t COIL_PHASE[4] = { 0b0101, 0b0110, 0b1010, 0b1001 };
+
+// -------------------------------------------------------------------
+// ISR side
+// -------------------------------------------------------------------
+
+void STEP_ENGINE_ISR StepEngine::_siftDown(uint8_t i) {
+    for (;;) {
+        uint8_t l = (uint8_t)(2 * i + 1), r = (uint8_t)(l + 1), m = i;
+        if (l < _heapLen && _earlier(_heap[l], _heap[m])) m = l;
+        if (r < _heapLen && _earlier(_heap[r], _heap[m])) m = r;
+        if (m == i) return;
+        uint8_t t = _heap[i]; _heap[i] = _heap[m]; _heap[m] = t;
+        i = m;
+    }
+}
+
+void STEP_ENGINE_ISR StepEngine::_writeCoils(Motor& m) {
+    const uint8_t mask = COIL_PHASE[m.pos & 3];
+    for (uint8_t p = 0; p < 4; p++)
+        if (m.pins[p] >= 0) digitalWrite(m.pins[p], (mask >> p) & 1 ? HIGH : LOW);
+}
+
+void STEP_ENGINE_ISR StepEngine::tick() {
+    STEP_LOCK_ISR();
+    const uint32_t now = _now + TICK_UNIT;
+    _now = now;
+
+    // Finish the pulses raised on the previous tick.
+    if (_pulseHigh) {
+        for (uint8_t i = 0; i < STEP_ENGINE_MAX_MOTORS; i++)
+            if (_pulseHigh & (1u << i)) digitalWrite(_m[i].pins[0], _m[i].invStep ? HIGH : LOW);
+        _pulseHigh = 0;
+    }
+
+    // Service every due motor, earliest first.
+    while (_heapLen) {
+        const uint8_t i = _heap[0];
+        Motor& m = _m[i];
+        if ((int32_t)(m.due - now) > 0) break;
+
+        if (m.bounded && m.pos == m.stopAt) {          // arrived — drop out of the heap
+            m.interval = 0;
+            _heap[0] = _heap[--_heapLen];
+            _siftDown(0);
+            continue;
+        }
+
+        if (m.iface == IFACE_FULL4WIRE) {
+            m.pos += m.dir;
+            _writeCoils(m);
+        } else if (m.pinDir != m.dir) {
+            // Direction change: set DIR now, step on the next tick so the
+            // driver sees its DIR-to-STEP setup time.
+            digitalWrite(m.pins[1], ((m.dir > 0) != m.invDir) ? HIGH : LOW);
+            m.pinDir = m.dir;
+            m.due    = now + TICK_UNIT;
+            _siftDown(0);
+            continue;
+        } else {
+            digitalWrite(m.pins[0], m.invStep ? LOW : HIGH);
+            _pulseHigh |= (uint8_t)(1u << i);
+            m.pos += m.dir;
+        }
+
+        // Next step. Never schedule into the past — a motor that fell a
+        // whole interval behind resumes at its rate instead of bursting.
+        uint32_t due = m.due + m.interval;
+        if ((int32_t)(due - now) <= 0) due = now + TICK_UNIT;
+        m.due = due;
+        _siftDown(0);
+    }
+    STEP_UNLOCK_ISR();
+}
+
+#if defined(PLATFORM_ESP32)
+static void STEP_ENGINE_ISR _onTimer() { StepEngine::tick(); }
+#elif defined(PLATFORM_UNO_R4) || defined(PLATFORM_UNO_R4_MINIMA)
+static void _onTimer(timer_callback_args_t*) { StepEngine::tick(); }
+#endif
+
+// -------------------------------------------------------------------
+// Timer setup
+// -------------------------------------------------------------------
+
+bool StepEngine::_startTimer() {
+    if (_timerRunning) return true;
+#if defined(PLATFORM_ESP32)
+  #if ESP_ARDUINO_VERSION_MAJOR >= 3
+    _hwTimer = timerBegin(1000000);                  // 1 MHz timebase
+    if (!_hwTimer) return false;
+    timerAttachInterrupt(_hwTimer, &_onTimer);
+    timerAlarm(_hwTimer, 1000000UL / TICK_HZ, true, 0);
+  #else
+    _hwTimer = timerBegin(0, 80, true);              // 80 MHz APB / 80 = 1 MHz
+    if (!_hwTimer) return false;
+    timerAttachInterrupt(_hwTimer, &_onTimer, true);
+    timerAlarmWrite(_hwTimer, 1000000UL / TICK_HZ, true);
+    timerAlarmEnable(_hwTimer);
+  #endif
+#elif defined(PLATFORM_UNO_R4) || defined(PLATFORM_UNO_R4_MINIMA)
+    uint8_t type = 0;
+    int8_t  ch   = FspTimer::get_available_timer(type);
+    if (ch < 0) return false;
+    if (!fspTimer().begin(TIMER_MODE_PERIODIC, type, (uint8_t)ch, (float)TICK_HZ, 0.0f, _onTimer))
+        return false;
+    fspTimer().setup_overflow_irq();
+    fspTimer().open();
+    fspTimer().start();
+#endif
+    _timerRunning = true;
+    return true;
+}
+
+void StepEngine::_stopTimer() {
+    if (!_timerRunning) return;
+#if defined(PLATFORM_ESP32)
+    timerEnd(_hwTimer);
+    _hwTimer = nullptr;
+#elif defined(PLATFORM_UNO_R4) || defined(PLATFORM_UNO_R4_MINIMA)
+    fspTimer().stop();
+    fspTimer().end();
+#endif
+    _timerRunning = false;
+}
+
+// -------------------------------------------------------------------
+// Loop side
+// -------------------------------------------------------------------
+
+void StepEngine::_rebuildHeap() {
+    _heapLen = 0;
+    for (uint8_t i = 0; i < STEP_ENGINE_MAX_MOTORS; i++)
+        if (_m[i].used && _m[i].interval) _heap[_heapLen++] = i;
+    for (int8_t i = (int8_t)(_heapLen / 2) - 1; i >= 0; i--) _siftDown((uint8_t)i);
+}
+
+int8_t StepEngine::claim(uint8_t iface, const int16_t pins[4], bool invDir, bool invStep) {
+    int8_t slot = -1;
+    for (uint8_t i = 0; i < STEP_ENGINE_MAX_MOTORS; i++)
+        if (!_m[i].used) { slot = (int8_t)i; break; }
+    if (slot < 0) return -1;
+
+    Motor& m = _m[slot];
+    m.pos = 0; m.stopAt = 0; m.due = 0; m.interval = 0;
+    m.dir = 1; m.pinDir = 0; m.bounded = true;
+    m.iface = iface; m.invDir = invDir; m.invStep = invStep;
+    for (uint8_t p = 0; p < 4; p++) {
+        m.pins[p] = pins[p];
+        if (pins[p] >= 0) pinMode(pins[p], OUTPUT);
+    }
+    if (iface == IFACE_FULL4WIRE) _writeCoils(m);
+    else digitalWrite(m.pins[0], invStep ? HIGH : LOW);
+
+    if (!_startTimer()) return -1;
+    STEP_LOCK();
+    m.used = true;
+    STEP_UNLOCK();
+    return slot;
+}
+
+void StepEngine::release(int8_t slot) {
+    if (slot < 0 || slot >= STEP_ENGINE_MAX_MOTORS) return;
+    STEP_LOCK();
+    _m[slot].used     = false;
+    _m[slot].interval = 0;
+    _pulseHigh &= (uint8_t)~(1u << slot);
+    _rebuildHeap();
+    STEP_UNLOCK();
+
+    bool any = false;
+    for (uint8_t i = 0; i < STEP_ENGINE_MAX_MOTORS; i++) any |= _m[i].used;
+    if (!any) _stopTimer();
+}
+
+void StepEngine::program(int8_t slot, int8_t dir, uint32_t interval, bool bounded, int32_t stopAt) {
+    if (slot < 0) return;
+    Motor& m = _m[slot];
+    STEP_LOCK();
+    m.dir     = dir;
+    m.bounded = bounded;
+    m.stopAt  = stopAt;
+    if (interval == 0) {
+        m.interval = 0;
+    } else {
+        const uint32_t now = _now;
+        // Idle → first step on the next tick; running → re-time from the
+        // last step (due - old interval) at the new rate.
+        uint32_t due = m.interval ? (m.due - m.interval + interval) : (now + TICK_UNIT);
+        if ((int32_t)(due - now) <= 0) due = now + TICK_UNIT;
+        m.due      = due;
+        m.interval = interval;
+    }
+    _rebuildHeap();
+    STEP_UNLOCK();
+}
+
+int32_t StepEngine::position(int8_t slot) {
+    return slot < 0 ? 0 : _m[slot].pos;   // aligned 32-bit read — atomic on these MCUs
+}
+
+void StepEngine::setPosition(int8_t slot, int32_t pos) {
+    if (slot < 0) return;
+    STEP_LOCK();
+    _m[slot].pos      = pos;
+    _m[slot].stopAt   = pos;
+    _m[slot].interval = 0;
+    _rebuildHeap();
+    STEP_UNLOCK();
+}
+
+bool StepEngine::stepping(int8_t slot) {
+    return slot >= 0 && _m[slot].interval != 0;
+}
+
+void StepEngine::setInvert(int8_t slot, bool invDir, bool invStep) {
+    if (slot < 0) return;
+    STEP_LOCK();
+    Motor& m = _m[slot];
+    m.invDir  = invDir;
+    m.invStep = invStep;
+    m.pinDir  = 0;                                   // rewrite DIR before the next step
+    if (m.iface != IFACE_FULL4WIRE) digitalWrite(m.pins[0], invStep ? HIGH : LOW);
+    STEP_UNLOCK();
+}
+
+uint32_t StepEngine::intervalFor(float stepsPerSec) {
+    if (stepsPerSec < 0) stepsPerSec = -stepsPerSec;
+    // Floor: keeps the fixed-point interval under 2^28, far from the
+    // wrap. Ceiling: a DRIVER pulse needs a tick up and a tick down.
+    const float minSps = (float)TICK_HZ * TICK_UNIT / 2147483648.0f * 8.0f;
+    if (stepsPerSec < minSps) stepsPerSec = minSps;
+    float iv = (float)TICK_HZ * TICK_UNIT / stepsPerSec;
+    if (iv < 2.0f * TICK_UNIT) iv = 2.0f * TICK_UNIT;
+    return (uint32_t)iv;
+}
+
+// -------------------------------------------------------------------
+// TimerStepper — profile planning (float math, loop context)
+// -------------------------------------------------------------------
+
+TimerStepper::TimerStepper(uint8_t iface, int16_t p1, int16_t p2, int16_t p3, int16_t p4)
+    : _iface(iface) {
+    _pins[0] = p1; _pins[1] = p2; _pins[2] = p3; _pins[3] = p4;
+    if (iface != FULL4WIRE) { _pins[2] = -1; _pins[3] = -1; }
+    _slot = StepEngine::claim(iface == FULL4WIRE ? StepEngine::IFACE_FULL4WIRE
+                                                 : StepEngine::IFACE_DRIVER,
+                              _pins, false, false);
+    if (_slot < 0) Serial.println(F("[Pardalote] step engine: no free motor slot or timer"));
+    _lastUs = micros();
+}
+
+TimerStepper::~TimerStepper() {
+    StepEngine::release(_slot);
+}
+
+long TimerStepper::currentPosition() { return StepEngine::position(_slot); }
+
+void TimerStepper::setMaxSpeed(float speed) {
+    if (speed < 0.0f) speed = -speed;
+    _maxSpeed = speed;
+    if (_speed >  _maxSpeed) _speed =  _maxSpeed;
+    if (_speed < -_maxSpeed) _speed = -_maxSpeed;
+}
+
+void TimerStepper::setAcceleration(float accel) {
+    if (accel == 0.0f) return;                       // AccelStepper ignores 0 too
+    _accel = accel < 0.0f ? -accel : accel;
+}
+
+void TimerStepper::setSpeed(float speed) {
+    if (speed >  _maxSpeed) speed =  _maxSpeed;
+    if (speed < -_maxSpeed) speed = -_maxSpeed;
+    _speed = speed;
+}
+
+void TimerStepper::setCurrentPosition(long position) {
+    StepEngine::setPosition(_slot, (int32_t)position);
+    _target = position;
+    _speed  = 0.0f;
+}
+
+// Same stopping distance AccelStepper::stop() uses.
+void TimerStepper::stop() {
+    if (_speed == 0.0f) return;
+    long toStop = (long)((_speed * _speed) / (2.0f * _accel)) + 1;
+    move(_speed > 0 ? toStop : -toStop);
+}
+
+// Hand the ISR constant-speed motion at v. Bounded motion stops on
+// _target; unbounded (runSpeed) runs until the next update.
+void TimerStepper::_drive(float v, bool bounded) {
+    if (v == 0.0f) { StepEngine::program(_slot, 1, 0, true, 0); return; }
+    StepEngine::program(_slot, v > 0 ? 1 : -1, StepEngine::intervalFor(v),
+                        bounded, (int32_t)_target);
+}
+
+bool TimerStepper::runSpeed() {
+    _drive(_speed, false);
+    return _speed != 0.0f;
+}
+
+bool TimerStepper::runSpeedToPosition() {
+    long dist = distanceToGo();
+    if (dist == 0) { _drive(0.0f, true); return false; }
+    // Direction comes from the target, magnitude from setSpeed() — the
+    // AccelStepper contract StepperExt's timed and eased moves rely on.
+    _speed = dist > 0 ? fabsf(_speed) : -fabsf(_speed);
+    _drive(_speed, true);
+    return true;
+}
+
+// Trapezoid planner. Advances speed by accel × elapsed time since the
+// last call, decelerating once the stopping distance covers what is
+// left (or when heading away from the target). The ISR's hard stop at
+// the target means a late update can cost smoothness, never overshoot.
+bool TimerStepper::run() {
+    const uint32_t nowUs = micros();
+    float dt = (nowUs - _lastUs) * 1e-6f;
+    _lastUs = nowUs;
+    if (dt > 0.05f) dt = 0.05f;                       // after a stall, don't leap
+
+    const long  dist  = distanceToGo();
+    const float vMin  = fminf(sqrtf(2.0f * _accel), _maxSpeed);   // speed after one step from rest
+    float       v     = _speed;
+    float       mag   = fabsf(v);
+
+    // At the target: stop there, however fast. A loop() stall can let the
+    // ISR's bounded run arrive at speed, and braking from here would be
+    // braking past the target.
+    if (dist == 0) {
+        _speed = 0.0f;
+        _drive(0.0f, true);
+        return false;
+    }
+
+    const bool toward = (dist > 0 && v >= 0.0f) || (dist < 0 && v <= 0.0f);
+    if (!toward) {
+        // Overshooting direction (target moved behind us): brake through 0.
+        mag -= _accel * dt;
+        v = mag <= 0.0f ? 0.0f : (v > 0 ? mag : -mag);
+        _speed = v;
+        _drive(v, false);
+        return true;
+    }
+
+    const float stopDist = (mag * mag) / (2.0f * _accel);
+    if (stopDist >= (float)labs(dist)) mag -= _accel * dt;
+    else                               mag += _accel * dt;
+    if (mag > _maxSpeed) mag = _maxSpeed;
+    if (mag < vMin)      mag = vMin;
+
+    _speed = dist > 0 ? mag : -mag;
+    _drive(_speed, true);
+    return true;
+}
+
+void TimerStepper::setPinsInverted(bool directionInvert, bool stepInvert, bool enableInvert) {
+    _invEn = enableInvert;
+    StepEngine::setInvert(_slot, directionInvert, stepInvert);
+}
+
+void TimerStepper::setEnablePin(uint8_t enablePin) {
+    _enPin = (int16_t)enablePin;
+    pinMode(enablePin, OUTPUT);
+    digitalWrite(enablePin, _invEn ? LOW : HIGH);
+}
+
+void TimerStepper::enableOutputs() {
+    if (_enPin >= 0) digitalWrite(_enPin, _invEn ? LOW : HIGH);
+}
+
+void TimerStepper::disableOutputs() {
+    if (_enPin >= 0) digitalWrite(_enPin, _invEn ? HIGH : LOW);
+    if (_iface == FULL4WIRE)                         // de-energise the coils, as AccelStepper does
+        for (uint8_t p = 0; p < 4; p++) if (_pins[p] >= 0) digitalWrite(_pins[p], LOW);
+}
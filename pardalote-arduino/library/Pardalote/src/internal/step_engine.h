@@ -0,0 +1,167 @@
+// ==============================================================
+// internal/step_engine.h
+// Hardware-timer step generation for PardaloteStepper (opt-in).
+// Part of Pardalote — version in library.properties
+// by Scott Mitchell
+// GPL-3.0-or-later License
+//
+// By default PardaloteStepper generates step pulses with AccelStepper
+// from the extension loop hook, so the step rate is capped by how often
+// Pardalote.run() comes round — and every WiFi stall, JSON-sized frame
+// or slow handler shows up as step jitter. Defining
+//
+//   #define PARDALOTE_STEP_TIMER
+//   #include <PardaloteStepper.h>
+//
+// swaps AccelStepper for TimerStepper below. The split is:
+//
+//   - ISR (StepEngine::tick, fixed-rate hardware timer): owns the step
+//     pins. Each tick services every motor whose next step is due,
+//     taking them in order from a min-heap keyed by next-step time —
+//     one ISR multiplexes all MAX_STEPPERS motors. Integer-only (no FPU
+//     in ESP32 ISRs) and bounded: a motor with a hard stop position
+//     never steps past it, however late loop() is.
+//   - loop() (TimerStepper::run / runSpeed / runSpeedToPosition): the
+//     motion profile. Speeds, the accel/decel trapezoid and gesture
+//     feed-forward are still float math on the loop side; each call
+//     just hands the ISR a direction, a step interval and a stop
+//     position. So loop() feeds targets and profiles, never pulses.
+//
+// Step times are kept in 1/256-tick fixed point, so the AVERAGE rate
+// is exact at any speed; individual edges land on the tick grid
+// (TICK_HZ, ±1 tick of jitter). A STEP pulse is raised on one tick and
+// lowered on the next (pulse width = 1 tick, well above every driver's
+// minimum), so a DRIVER motor tops out at TICK_HZ / 2 steps/s.
+//
+// TimerStepper mirrors the subset of the AccelStepper API that
+// StepperExt uses, with the same semantics, so the extension compiles
+// against either through the StepperMotor alias.
+// ==============================================================
+
+#pragma once
+
+#include <Arduino.h>
+#include "platform.h"
+
+#define STEP_ENGINE_MAX_MOTORS 6
+
+// Tick rate. The R4's 48 MHz M4 pays more per tick (digitalWrite is
+// slower there), so it ticks at half the ESP32 rate by default.
+#ifndef PARDALOTE_STEP_TICK_HZ
+  #if defined(PLATFORM_ESP32)
+    #define PARDALOTE_STEP_TICK_HZ 40000UL
+  #else
+    #define PARDALOTE_STEP_TICK_HZ 20000UL
+  #endif
+#endif
+
+class StepEngine {
+public:
+    static const uint32_t TICK_HZ   = PARDALOTE_STEP_TICK_HZ;
+    static const uint32_t TICK_UNIT = 256;   // fixed-point scale of step times
+
+    // Interface codes match AccelStepper::MotorInterfaceType.
+    static const uint8_t IFACE_DRIVER    = 1;
+    static const uint8_t IFACE_FULL4WIRE = 4;
+
+    // Claim a motor slot (starts the timer on the first claim). Returns
+    // the slot, or -1 when every slot is taken or no timer is available.
+    static int8_t claim(uint8_t iface, const int16_t pins[4], bool invDir, bool invStep);
+    static void   release(int8_t slot);
+
+    // Hand the ISR a new plan for `slot`. dir = +1/-1; interval in
+    // 1/TICK_UNIT ticks per step (0 = idle); when `bounded`, the motor
+    // stops on reaching stopAt. Re-times from the motor's last step so a
+    // speed change never produces a double step or a gap.
+    static void program(int8_t slot, int8_t dir, uint32_t interval, bool bounded, int32_t stopAt);
+
+    static int32_t position(int8_t slot);
+    static void    setPosition(int8_t slot, int32_t pos);   // also idles the motor
+    static bool    stepping(int8_t slot);
+    static void    setInvert(int8_t slot, bool invDir, bool invStep);
+
+    // Convert a speed (steps/s, magnitude) to a program() interval,
+    // clamped to what the tick rate can render.
+    static uint32_t intervalFor(float stepsPerSec);
+
+    // The ISR body — public so a host build can drive it directly.
+    static void tick();
+
+private:
+    struct Motor {
+        volatile int32_t  pos;
+        volatile int32_t  stopAt;
+        volatile uint32_t due;        // next step time (1/TICK_UNIT ticks)
+        volatile uint32_t interval;   // 0 = idle
+        volatile int8_t   dir;
+        int8_t            pinDir;     // direction last written to DIR (0 = unknown)
+        volatile bool     bounded;
+        bool              used;
+        uint8_t           iface;
+        bool              invDir, invStep;
+        int16_t           pins[4];
+    };
+
+    static Motor    _m[STEP_ENGINE_MAX_MOTORS];
+    static uint8_t  _heap[STEP_ENGINE_MAX_MOTORS];   // stepping slots, earliest due first
+    static uint8_t  _heapLen;
+    static volatile uint32_t _now;                   // current tick (1/TICK_UNIT)
+    static volatile uint8_t  _pulseHigh;             // slots whose STEP pin is up
+    static bool     _timerRunning;
+
+    static bool _earlier(uint8_t a, uint8_t b) { return (int32_t)(_m[a].due - _m[b].due) < 0; }
+    static void _siftDown(uint8_t i);
+    static void _rebuildHeap();
+    static void _writeCoils(Motor& m);
+    static bool _startTimer();
+    static void _stopTimer();
+};
+
+// -------------------------------------------------------------------
+// TimerStepper — AccelStepper-compatible facade over a StepEngine slot.
+// -------------------------------------------------------------------
+class TimerStepper {
+public:
+    enum MotorInterfaceType { DRIVER = 1, FULL4WIRE = 4 };
+
+    TimerStepper(uint8_t iface, int16_t p1, int16_t p2, int16_t p3 = -1, int16_t p4 = -1);
+    ~TimerStepper();
+
+    long  currentPosition();
+    long  targetPosition() { return _target; }
+    long  distanceToGo()   { return _target - currentPosition(); }
+    float speed()          { return _speed; }
+    float maxSpeed()       { return _maxSpeed; }
+
+    void setMaxSpeed(float speed);
+    void setAcceleration(float accel);
+    void setSpeed(float speed);
+    void moveTo(long absolute) { _target = absolute; }
+    void move(long relative)   { moveTo(currentPosition() + relative); }
+    void setCurrentPosition(long position);
+    void stop();
+
+    // Profile updaters — call every loop pass, like AccelStepper's.
+    bool run();
+    bool runSpeed();
+    bool runSpeedToPosition();
+
+    void setPinsInverted(bool directionInvert, bool stepInvert, bool enableInvert);
+    void setEnablePin(uint8_t enablePin);
+    void enableOutputs();
+    void disableOutputs();
+
+private:
+    void _drive(float v, bool bounded);
+
+    int8_t   _slot;
+    uint8_t  _iface;
+    int16_t  _pins[4];
+    int16_t  _enPin   = -1;
+    bool     _invEn   = false;
+    float    _maxSpeed = 1.0f;
+    float    _accel    = 1.0f;
+    float    _speed    = 0.0f;     // signed, steps/s
+    long     _target   = 0;
+    uint32_t _lastUs   = 0;
+};
@@ -0,0 +1,73 @@
+// ==============================================================
+// internal/transport.h
+// What the core needs from a transport — the WebSocket server, the
+// USB serial link, or the in-memory loopback a host build drives.
+// Part of Pardalote — version in library.properties
+// by Scott Mitchell
+// GPL-3.0-or-later License
+//
+// A transport carries whole messages (one frame, or a batch) between
+// the board and its clients, numbered 0..PARDALOTE_MAX_CLIENTS-1. It
+// reports what happens through three sinks — a client connected, a
+// client went away, a message arrived — and the core answers with
+// send(). Sinks are plain function pointers (the WebSocket library's
+// callback pattern), so no transport needs to know PardaloteClass;
+// they may fire from loop(), and from send() or disconnect() when the
+// write is what finds the client gone.
+//
+// The core holds one active transport and only ever calls it from
+// run() and the sketch's own calls, on the loop task.
+// ==============================================================
+
+#pragma once
+
+#include <Arduino.h>
+
+typedef void (*PardaloteClientSink)(uint8_t client);
+typedef void (*PardaloteMessageSink)(uint8_t client, uint8_t* data, size_t len);
+
+struct PardaloteTransportSinks {
+    PardaloteMessageSink onMessage    = nullptr;
+    PardaloteClientSink  onConnect    = nullptr;
+    PardaloteClientSink  onDisconnect = nullptr;
+};
+
+// capacity() of a transport that can't tell how much it could take.
+#define PARDALOTE_CAPACITY_UNKNOWN ((size_t)-1)
+
+class PardaloteTransport {
+public:
+    // Start accepting clients; events from here on go to `sinks`.
+    virtual void begin(const PardaloteTransportSinks& sinks) { _sinks = sinks; }
+
+    // Stop: no more events, nothing more sent. Clients are dropped
+    // without their disconnect sink — the caller has already let go.
+    virtual void end() {}
+
+    // Once per run() pass: service the link and deliver what arrived.
+    virtual void loop(unsigned long now) = 0;
+
+    // One outbound message. False if it didn't go (no such client, or
+    // the transport had to drop it).
+    virtual bool send(uint8_t client, const uint8_t* data, size_t len) = 0;
+
+    // Drop a client. Its disconnect sink fires, now or from loop().
+    virtual void disconnect(uint8_t client) = 0;
+
+    // Bytes send() can take for `client` right now without waiting on
+    // the link or dropping anything — PARDALOTE_CAPACITY_UNKNOWN when
+    // the transport can't tell.
+    virtual size_t capacity(uint8_t client) const {
+        (void)client;
+        return PARDALOTE_CAPACITY_UNKNOWN;
+    }
+
+protected:
+    void _emitConnect(uint8_t c)    { if (_sinks.onConnect)    _sinks.onConnect(c); }
+    void _emitDisconnect(uint8_t c) { if (_sinks.onDisconnect) _sinks.onDisconnect(c); }
+    void _emitMessage(uint8_t c, uint8_t* data, size_t len) {
+        if (_sinks.onMessage) _sinks.onMessage(c, data, len);
+    }
+
+    PardaloteTransportSinks _sinks;
+};
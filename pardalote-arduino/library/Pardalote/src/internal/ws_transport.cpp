@@ -0,0 +1,224 @@
+// ==============================================================
+// internal/ws_transport.cpp
+// WebSocket transport implementation. See ws_transport.h.
+// ==============================================================
+
+#include "ws_transport.h"
+
+#ifndef PARDALOTE_NO_WIFI
+
+PardaloteWsTransport* PardaloteWsTransport::_self = nullptr;
+
+void PardaloteWsTransport::begin(const PardaloteTransportSinks& sinks) {
+    _sinks = sinks;
+    _self  = this;
+    _ws.begin();
+    _ws.onEvent(_eventTrampoline);
+    Serial.println(F("WebSocket server started on port 81"));
+#ifdef PLATFORM_ESP32
+    if (_splitWanted) _startNetTask();
+#endif
+}
+
+void PardaloteWsTransport::end() {
+#ifdef PLATFORM_ESP32
+    _stopNetTask();       // the server is ours again before it is closed below
+#endif
+    _sinks = PardaloteTransportSinks();
+    _ws.close();
+}
+
+void PardaloteWsTransport::loop(unsigned long now) {
+    (void)now;
+#ifdef PLATFORM_ESP32
+    // splitCores(): the queued events, a few per pass
+    // (PARDALOTE_NET_RX_PER_PASS).
+    if (_netActive) {
+        SpscQueue::Header h;
+        uint8_t* data;
+        for (uint8_t n = 0; n < PARDALOTE_NET_RX_PER_PASS && _rx.peek(h, data); n++) {
+            _event(h.client, (WStype_t)h.type, data, h.len);
+            _rx.pop();
+        }
+        _netReport();
+        return;
+    }
+#endif
+    _ws.loop();
+}
+
+bool PardaloteWsTransport::send(uint8_t client, const uint8_t* data, size_t len) {
+#ifdef PLATFORM_ESP32
+    if (_netActive) return _netPost(client, NET_SEND, data, len);
+#endif
+    return _ws.sendBIN(client, data, len);
+}
+
+void PardaloteWsTransport::disconnect(uint8_t client) {
+#ifdef PLATFORM_ESP32
+    if (_netActive) { _netPost(client, NET_CLOSE, nullptr, 0); return; }
+#endif
+    _ws.disconnect(client);   // fires WStype_DISCONNECTED → the sink
+}
+
+// Only the splitCores() queue can say; the library's own send buffers
+// can't.
+size_t PardaloteWsTransport::capacity(uint8_t client) const {
+    (void)client;
+#ifdef PLATFORM_ESP32
+    if (_netActive) return _tx.room();
+#endif
+    return PARDALOTE_CAPACITY_UNKNOWN;
+}
+
+void PardaloteWsTransport::_eventTrampoline(uint8_t num, WStype_t type,
+                                            uint8_t* payload, size_t length) {
+    if (!_self) return;
+#ifdef PLATFORM_ESP32
+    if (_self->_netActive) { _self->_netEvent(num, type, payload, length); return; }
+#endif
+    _self->_event(num, type, payload, length);
+}
+
+// The core dedupes connects and disconnects (the UNO R4's WiFiS3 stack
+// fires spurious DISCONNECTED events for slots that were never
+// connected), so each event is passed straight on.
+void PardaloteWsTransport::_event(uint8_t num, WStype_t type,
+                                  uint8_t* payload, size_t length) {
+    switch (type) {
+        case WStype_DISCONNECTED: _emitDisconnect(num);                 break;
+        case WStype_CONNECTED:    _emitConnect(num);                    break;
+        case WStype_BIN:          _emitMessage(num, payload, length);   break;
+        default:                                                        break;
+    }
+}
+
+#ifdef PLATFORM_ESP32
+// -------------------------------------------------------------------
+// splitCores() — the WebSocket on its own core (see the header notes).
+// -------------------------------------------------------------------
+void PardaloteWsTransport::_startNetTask() {
+    if (portNUM_PROCESSORS < 2) {
+        Serial.println(F("[Pardalote] splitCores(): single-core chip — ignored"));
+        return;
+    }
+    uint8_t* rx = (uint8_t*)malloc(PARDALOTE_NET_QUEUE);
+    uint8_t* tx = (uint8_t*)malloc(PARDALOTE_NET_QUEUE);
+    if (!rx || !tx) {
+        free(rx);
+        free(tx);
+        Serial.println(F("[Pardalote] splitCores(): out of memory — staying on one core"));
+        return;
+    }
+    _rx.begin(rx, PARDALOTE_NET_QUEUE);
+    _tx.begin(tx, PARDALOTE_NET_QUEUE);
+    _netStop   = false;
+    _netActive = true;   // before the task exists — its first event must queue
+    const BaseType_t core = 1 - xPortGetCoreID();   // whichever core loop() isn't on
+    if (xTaskCreatePinnedToCore(_netTaskMain, "pardalote-net", PARDALOTE_NET_STACK,
+                                this, 1, nullptr, core) != pdPASS) {
+        _netActive = false;
+        free(_rx.release());
+        free(_tx.release());
+        Serial.println(F("[Pardalote] splitCores(): task create failed — staying on one core"));
+        return;
+    }
+    Serial.print(F("WebSocket on core "));
+    Serial.print((int)core);
+    Serial.print(F(", run() on core "));
+    Serial.println((int)xPortGetCoreID());
+}
+
+// Called from the loop core. Waits for the task to let go of the
+// server; events it queued but loop() never took are dropped with it,
+// and the queues go back to the heap.
+void PardaloteWsTransport::_stopNetTask() {
+    if (!_netActive) return;
+    _netStop = true;
+    while (_netActive) delay(1);
+    _netReport();
+    free(_rx.release());
+    free(_tx.release());
+}
+
+void PardaloteWsTransport::_netTaskMain(void* arg) {
+    static_cast<PardaloteWsTransport*>(arg)->_netLoop();
+}
+
+void PardaloteWsTransport::_netLoop() {
+    uint32_t lastBlock = millis();
+    while (!_netStop) {
+        _ws.loop();
+
+        SpscQueue::Header h;
+        uint8_t* data;
+        while (_tx.peek(h, data)) {
+            if (h.type == NET_CLOSE) _ws.disconnect(h.client);   // → WStype_DISCONNECTED
+            else                     _ws.sendBIN(h.client, data, h.len);
+            _tx.pop();
+        }
+
+        // The same idle-task budget as run() (see PardaloteClass::_runPass).
+        const uint32_t ms = millis();
+        if (ms - lastBlock >= PARDALOTE_YIELD_MS) {
+            lastBlock = ms;
+            vTaskDelay(1);
+        } else {
+            taskYIELD();
+        }
+    }
+    _netActive = false;
+    vTaskDelete(nullptr);
+}
+
+// Network task: one WebSocket event for loop(). A full queue means run()
+// is behind — wait for it rather than lose a frame, up to a point.
+void PardaloteWsTransport::_netEvent(uint8_t num, WStype_t type,
+                                     uint8_t* payload, size_t length) {
+    if (type != WStype_CONNECTED && type != WStype_DISCONNECTED && type != WStype_BIN) return;
+    if (length > _rx.maxLen()) { _netDrop(F("inbound message too large")); return; }
+    const bool lifecycle = (type != WStype_BIN);   // never dropped
+    for (uint8_t waited = 0; !_rx.push(num, (uint8_t)type, payload, (uint16_t)length); waited++) {
+        if (_netStop) return;   // the loop core is waiting for this task to exit
+        if (!lifecycle && waited >= 100) { _netDrop(F("inbound queue full")); return; }
+        vTaskDelay(1);
+    }
+}
+
+// Loop core: hand one message (or a close) to the network task. The
+// task drains continuously, so a full queue clears within microseconds
+// unless the network itself is stalled — then drop rather than stall
+// motion.
+bool PardaloteWsTransport::_netPost(uint8_t client, uint8_t type, const uint8_t* buf, size_t len) {
+    if (len > _tx.maxLen()) { _netDrop(F("outbound message too large")); return false; }
+    const uint32_t start = micros();
+    while (!_tx.push(client, type, buf, (uint16_t)len)) {
+        if (micros() - start > 2000) { _netDrop(F("outbound queue full")); return false; }
+    }
+    return true;
+}
+
+// Either core. Counts only — the network task must not write to Serial
+// while the loop core may be.
+void PardaloteWsTransport::_netDrop(const __FlashStringHelper* what) {
+    _netDropWhat.store(what, std::memory_order_relaxed);
+    _netDropped.fetch_add(1, std::memory_order_relaxed);
+}
+
+// Loop core. The first drop and every hundredth after it, with the
+// latest reason.
+void PardaloteWsTransport::_netReport() {
+    const uint32_t dropped = _netDropped.load(std::memory_order_relaxed);
+    if (dropped == _netReported) return;
+    if (_netReported == 0 || dropped / 100 != _netReported / 100) {
+        Serial.print(F("[Pardalote] splitCores(): "));
+        Serial.print(_netDropWhat.load(std::memory_order_relaxed));
+        Serial.print(F(" — message dropped ("));
+        Serial.print(dropped);
+        Serial.println(F(" so far)"));
+    }
+    _netReported = dropped;
+}
+#endif   // PLATFORM_ESP32
+
+#endif   // PARDALOTE_NO_WIFI
@@ -0,0 +1,78 @@
+// ==============================================================
+// internal/ws_transport.h
+// WebSocket transport — the server on port 81 that pages reach with
+// arduino.connect(ip). Each WebSocket slot is a client.
+// Part of Pardalote — version in library.properties
+// by Scott Mitchell
+// GPL-3.0-or-later License
+//
+// ESP32 splitCores(): the WebSocket runs on its own core. The network
+// task is the only code that touches the server while it runs: it
+// services it, pushes each event into _rx and writes out whatever the
+// loop core left in _tx. loop() drains _rx on the loop core, so the
+// sinks — and every handler, every extension and all per-client state
+// behind them — stay single-threaded. Each queue has exactly one
+// producer and one consumer, so neither needs a lock.
+// ==============================================================
+
+#pragma once
+
+#include "platform.h"
+
+#ifndef PARDALOTE_NO_WIFI
+
+#include <WebSocketsServer.h>
+#include <atomic>
+#include "defs.h"
+#include "spsc_queue.h"
+#include "transport.h"
+
+class PardaloteWsTransport : public PardaloteTransport {
+public:
+    explicit PardaloteWsTransport(uint16_t port) : _ws(port) {}
+
+    // Call before begin(). ESP32 only; ignored elsewhere, and on a
+    // single-core chip or when the queues can't be allocated.
+    void setSplitCores(bool on) { _splitWanted = on; }
+
+    void   begin(const PardaloteTransportSinks& sinks) override;
+    void   end() override;   // stops the network task, then the server
+    void   loop(unsigned long now) override;
+    bool   send(uint8_t client, const uint8_t* data, size_t len) override;
+    void   disconnect(uint8_t client) override;   // → the disconnect sink
+    size_t capacity(uint8_t client) const override;
+
+private:
+    // The WebSocket library wants a free/static function pointer; there
+    // is only ever one server.
+    static PardaloteWsTransport* _self;
+    static void _eventTrampoline(uint8_t num, WStype_t type,
+                                 uint8_t* payload, size_t length);
+    void _event(uint8_t num, WStype_t type, uint8_t* payload, size_t length);
+
+    WebSocketsServer _ws;
+    bool _splitWanted = false;
+
+#ifdef PLATFORM_ESP32
+    enum : uint8_t { NET_SEND = 0, NET_CLOSE = 1 };   // _tx record types
+    SpscQueue     _rx;   // type = WStype_t
+    SpscQueue     _tx;
+    volatile bool _netActive = false;
+    volatile bool _netStop   = false;
+    // Drops are counted on either core and reported from the loop core
+    // only (_netReport), so Serial has one writer.
+    std::atomic<uint32_t>                   _netDropped{0};
+    std::atomic<const __FlashStringHelper*> _netDropWhat{nullptr};
+    uint32_t                                _netReported = 0;   // loop core
+    void _startNetTask();
+    void _stopNetTask();
+    void _netLoop();
+    static void _netTaskMain(void* arg);
+    void _netEvent(uint8_t num, WStype_t type, uint8_t* payload, size_t length);
+    bool _netPost(uint8_t client, uint8_t type, const uint8_t* buf, size_t len);
+    void _netDrop(const __FlashStringHelper* what);
+    void _netReport();
+#endif
+};
+
+#endif   // PARDALOTE_NO_WIFI